@@ -0,0 +1,97 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "alloc_count.h"
+
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#if defined(__SANITIZE_ADDRESS__)
+#define COUNTING 0
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define COUNTING 0
+#endif
+#endif
+
+#ifndef COUNTING
+#ifdef __GLIBC__
+#define COUNTING 1
+#else
+#define COUNTING 0
+#endif
+#endif
+
+static atomic_size_t calls;
+static atomic_size_t bytes;
+
+#if COUNTING
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *pointer, size_t size);
+extern void __libc_free(void *pointer);
+
+static void count(size_t size)
+{
+	atomic_fetch_add_explicit(&calls, 1, memory_order_relaxed);
+	atomic_fetch_add_explicit(&bytes, size, memory_order_relaxed);
+}
+
+void *malloc(size_t size)
+{
+	count(size);
+	return __libc_malloc(size);
+}
+
+void *calloc(size_t number, size_t size)
+{
+	count(number * size);
+	return __libc_calloc(number, size);
+}
+
+void *realloc(void *pointer, size_t size)
+{
+	count(size);
+	return __libc_realloc(pointer, size);
+}
+
+void free(void *pointer)
+{
+	__libc_free(pointer);
+}
+
+#endif
+
+bool bench_alloc_counting(void)
+{
+	return COUNTING;
+}
+
+void bench_alloc_reset(void)
+{
+	atomic_store(&calls, 0);
+	atomic_store(&bytes, 0);
+}
+
+struct bench_alloc_stats bench_alloc_stats(void)
+{
+	return (struct bench_alloc_stats) {
+		.calls = atomic_load(&calls),
+		.bytes = atomic_load(&bytes),
+	};
+}
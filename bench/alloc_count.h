@@ -0,0 +1,53 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef DESCENT_XML_BENCH_ALLOC_COUNT
+#define DESCENT_XML_BENCH_ALLOC_COUNT
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * \file
+ *
+ * Counts calls to malloc(), calloc() and realloc() made by the
+ * benchmark and the libraries it loads, by replacing them with
+ * wrappers around the C library's own allocator. Only available with
+ * glibc, and not under AddressSanitizer, which replaces them itself.
+ */
+
+struct bench_alloc_stats {
+	size_t calls;
+	size_t bytes;
+};
+
+/**
+ * \returns True if allocations are being counted.
+ */
+bool bench_alloc_counting(void);
+
+/**
+ * \brief Resets the counters to zero.
+ */
+void bench_alloc_reset(void);
+
+/**
+ * \returns The allocations made since the last reset.
+ */
+struct bench_alloc_stats bench_alloc_stats(void);
+
+#endif // DESCENT_XML_BENCH_ALLOC_COUNT
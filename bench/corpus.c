@@ -0,0 +1,233 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "corpus.h"
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct buffer {
+	char *data;
+	size_t length;
+	size_t capacity;
+	bool error;
+};
+
+static void append(struct buffer *buffer, const char *format, ...)
+{
+	if (buffer->error)
+		return;
+
+	va_list args;
+	va_start(args, format);
+	const int needed = vsnprintf(
+		buffer->data + buffer->length,
+		buffer->capacity - buffer->length,
+		format,
+		args
+	);
+	va_end(args);
+	if (needed < 0) {
+		buffer->error = true;
+		return;
+	}
+
+	if (buffer->length + (size_t)needed >= buffer->capacity) {
+		size_t capacity = buffer->capacity ? buffer->capacity : 4096;
+		while (buffer->length + (size_t)needed >= capacity)
+			capacity *= 2;
+		char *const data = realloc(buffer->data, capacity);
+		if (!data) {
+			buffer->error = true;
+			return;
+		}
+		buffer->data = data;
+		buffer->capacity = capacity;
+
+		va_start(args, format);
+		vsnprintf(buffer->data + buffer->length, capacity - buffer->length, format, args);
+		va_end(args);
+	}
+	buffer->length += (size_t)needed;
+}
+
+static char *finish(struct buffer *buffer, size_t *length)
+{
+	if (buffer->error) {
+		free(buffer->data);
+		return NULL;
+	}
+	*length = buffer->length;
+	return buffer->data;
+}
+
+// Elements nested a few hundred deep, over and over.
+static char *deep(size_t size, size_t *length)
+{
+	enum { DEPTH = 256 };
+	struct buffer buffer = { 0 };
+	append(&buffer, "<?xml version=\"1.0\"?>\n<root>");
+	while (!buffer.error && buffer.length < size) {
+		for (int i = 0; i < DEPTH; i++)
+			append(&buffer, "<level n=\"%d\">", i);
+		append(&buffer, "leaf");
+		for (int i = 0; i < DEPTH; i++)
+			append(&buffer, "</level>");
+		append(&buffer, "\n");
+	}
+	append(&buffer, "</root>\n");
+	return finish(&buffer, length);
+}
+
+// Empty elements with long attribute lists.
+static char *wide(size_t size, size_t *length)
+{
+	enum { ATTRIBUTES = 64 };
+	struct buffer buffer = { 0 };
+	append(&buffer, "<?xml version=\"1.0\"?>\n<root>\n");
+	for (unsigned record = 0; !buffer.error && buffer.length < size; record++) {
+		append(&buffer, "<row");
+		for (int i = 0; i < ATTRIBUTES; i++)
+			append(&buffer, " attribute%d=\"value %u.%d\"", i, record, i);
+		append(&buffer, "/>\n");
+	}
+	append(&buffer, "</root>\n");
+	return finish(&buffer, length);
+}
+
+// Few elements, each holding a long run of prose.
+static char *text(size_t size, size_t *length)
+{
+	static const char words[] =
+		"The quick brown fox jumps over the lazy dog, and then it "
+		"naps for a while in the late afternoon sun. ";
+	struct buffer buffer = { 0 };
+	append(&buffer, "<?xml version=\"1.0\"?>\n<root>\n");
+	while (!buffer.error && buffer.length < size) {
+		append(&buffer, "<paragraph>");
+		for (int i = 0; i < 512; i++)
+			append(&buffer, "%s", words);
+		append(&buffer, "</paragraph>\n");
+	}
+	append(&buffer, "</root>\n");
+	return finish(&buffer, length);
+}
+
+// Text broken up by entity and character references.
+static char *entities(size_t size, size_t *length)
+{
+	struct buffer buffer = { 0 };
+	append(&buffer, "<?xml version=\"1.0\"?>\n<root>\n");
+	while (!buffer.error && buffer.length < size)
+		append(&buffer,
+			"<expression a=\"x &lt; y &amp;&amp; y &gt; z\">"
+			"if (a &lt; b &amp;&amp; c &gt; d) &quot;quoted&quot; &apos;it&apos;s&apos;"
+			" &#65;&#x42;&#67; &amp; more &#x3C;tags&#x3E;"
+			"</expression>\n"
+		);
+	append(&buffer, "</root>\n");
+	return finish(&buffer, length);
+}
+
+// Large CDATA sections full of markup-like characters.
+static char *cdata(size_t size, size_t *length)
+{
+	struct buffer buffer = { 0 };
+	append(&buffer, "<?xml version=\"1.0\"?>\n<root>\n");
+	while (!buffer.error && buffer.length < size) {
+		append(&buffer, "<script><![CDATA[");
+		for (int i = 0; i < 256; i++)
+			append(&buffer, "if (a < b && c > d) { x = \"<tag>\" + y; } // %d\n", i);
+		append(&buffer, "]]></script>\n");
+	}
+	append(&buffer, "</root>\n");
+	return finish(&buffer, length);
+}
+
+// More comment than content.
+static char *comments(size_t size, size_t *length)
+{
+	struct buffer buffer = { 0 };
+	append(&buffer, "<?xml version=\"1.0\"?>\n<!-- header comment -->\n<root>\n");
+	for (unsigned i = 0; !buffer.error && buffer.length < size; i++)
+		append(&buffer,
+			"<!-- record %u: this comment explains the record below in far"
+			" more detail than anyone needs, as comments tend to do -->\n"
+			"<item>%u</item>\n",
+			i, i
+		);
+	append(&buffer, "</root>\n<!-- trailer comment -->\n");
+	return finish(&buffer, length);
+}
+
+// Many small records, like a typical data feed.
+static char *records(size_t size, size_t *length)
+{
+	struct buffer buffer = { 0 };
+	append(&buffer, "<?xml version=\"1.0\"?>\n<records>\n");
+	for (unsigned i = 0; !buffer.error && buffer.length < size; i++)
+		append(&buffer,
+			"<record id=\"%u\" type=\"%s\"><name>Name %u</name>"
+			"<value>%u.%02u</value><flag/></record>\n",
+			i, i % 3 ? "plain" : "special", i, i * 7, i % 100
+		);
+	append(&buffer, "</records>\n");
+	return finish(&buffer, length);
+}
+
+// The records again, pretty-printed, so a good third of the document
+// is indentation.
+static char *indented(size_t size, size_t *length)
+{
+	struct buffer buffer = { 0 };
+	append(&buffer, "<?xml version=\"1.0\"?>\n<records>\n");
+	for (unsigned i = 0; !buffer.error && buffer.length < size; i++)
+		append(&buffer,
+			"    <record id=\"%u\" type=\"%s\">\n"
+			"        <name>Name %u</name>\n"
+			"        <value>%u.%02u</value>\n"
+			"        <flag/>\n"
+			"    </record>\n",
+			i, i % 3 ? "plain" : "special", i, i * 7, i % 100
+		);
+	append(&buffer, "</records>\n");
+	return finish(&buffer, length);
+}
+
+const struct bench_corpus bench_corpora[] = {
+	{ "deep", "elements nested 256 deep", deep },
+	{ "wide", "elements with 64 attributes", wide },
+	{ "text", "large text nodes", text },
+	{ "entities", "text and attributes full of references", entities },
+	{ "cdata", "large CDATA sections", cdata },
+	{ "comments", "more comments than content", comments },
+	{ "records", "many small records", records },
+	{ "indented", "small records, pretty-printed", indented },
+};
+
+const size_t bench_corpus_count = sizeof(bench_corpora) / sizeof(bench_corpora[0]);
+
+const struct bench_corpus *bench_corpus_find(const char *name)
+{
+	for (size_t i = 0; i < bench_corpus_count; i++)
+		if (strcmp(bench_corpora[i].name, name) == 0)
+			return &bench_corpora[i];
+	return NULL;
+}
@@ -0,0 +1,56 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef DESCENT_XML_BENCH_CORPUS
+#define DESCENT_XML_BENCH_CORPUS
+
+#include <stddef.h>
+
+/**
+ * \file
+ *
+ * Synthetic documents for the benchmark suite, each stressing one
+ * part of the grammar. All of them are well-formed, and only use
+ * ASCII so they lex the same in any locale.
+ */
+
+/**
+ * \brief A corpus generator.
+ */
+struct bench_corpus {
+	const char *name;
+	const char *description;
+
+	/**
+	 * \brief Generates a document of roughly size bytes.
+	 *
+	 * \returns The document, to be released with free(), with its
+	 * 	length in *length, or a NULL pointer if memory couldn't be
+	 * 	allocated.
+	 */
+	char *(*generate)(size_t size, size_t *length);
+};
+
+extern const struct bench_corpus bench_corpora[];
+extern const size_t bench_corpus_count;
+
+/**
+ * \returns The corpus with the given name, or a NULL pointer.
+ */
+const struct bench_corpus *bench_corpus_find(const char *name);
+
+#endif // DESCENT_XML_BENCH_CORPUS
@@ -0,0 +1,197 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Decodes a fixed-format feed with descent-xml/bind.h descriptor
+// tables, compared with generic C-string callbacks that dispatch on
+// strcmp().
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "descent-xml.h"
+
+#define ITEMS 64
+#define ROUNDS 20000
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void report(const char *name, double elapsed, size_t length, double checksum)
+{
+	printf(
+		"%-24s %8.3f s %8.1f MB/s checksum %.2f\n",
+		name,
+		elapsed,
+		(double)length * ROUNDS / elapsed / 1e6,
+		checksum
+	);
+}
+
+struct bound_item {
+	struct libadt_const_lptr sku;
+	uint64_t quantity;
+	double price;
+};
+
+struct bound_order {
+	uint64_t id;
+	struct libadt_const_lptr currency;
+	struct bound_item *items;
+	size_t item_count;
+};
+
+static const struct descent_xml_bind_field item_fields[] = {
+	DESCENT_XML_BIND_ATTRIBUTE(struct bound_item, sku, "sku", DESCENT_XML_BIND_STRING, DESCENT_XML_BIND_REQUIRED),
+	DESCENT_XML_BIND_ATTRIBUTE(struct bound_item, quantity, "quantity", DESCENT_XML_BIND_UINT, DESCENT_XML_BIND_REQUIRED),
+	DESCENT_XML_BIND_TEXT(struct bound_item, price, DESCENT_XML_BIND_DOUBLE, 0),
+};
+static const struct descent_xml_bind_record item_record
+	= DESCENT_XML_BIND_RECORD_INIT("item", struct bound_item, item_fields);
+
+static const struct descent_xml_bind_field order_fields[] = {
+	DESCENT_XML_BIND_ATTRIBUTE(struct bound_order, id, "id", DESCENT_XML_BIND_UINT, DESCENT_XML_BIND_REQUIRED),
+	DESCENT_XML_BIND_ATTRIBUTE(struct bound_order, currency, "currency", DESCENT_XML_BIND_STRING, 0),
+	DESCENT_XML_BIND_NESTED_ARRAY(struct bound_order, items, item_count, "item", &item_record),
+};
+static const struct descent_xml_bind_record order_record
+	= DESCENT_XML_BIND_RECORD_INIT("order", struct bound_order, order_fields);
+
+struct generic_item {
+	unsigned long quantity;
+	double price;
+};
+
+struct generic_order {
+	unsigned long id;
+	struct generic_item items[ITEMS];
+	size_t count;
+	bool in_item;
+};
+
+static void generic_text(char *text, bool is_cdata, void *context)
+{
+	(void)is_cdata;
+	struct generic_order *const order = context;
+	if (order->in_item)
+		order->items[order->count - 1].price = strtod(text, NULL);
+}
+
+static struct descent_xml_lex generic_item(
+	struct descent_xml_lex token,
+	char *name,
+	char **attributes,
+	bool empty,
+	void *context
+)
+{
+	struct generic_order *const order = context;
+	if (strcmp(name, "item") != 0 || order->count == ITEMS)
+		return token;
+
+	struct generic_item *const item = &order->items[order->count++];
+	for (; *attributes; attributes += 2) {
+		if (strcmp(attributes[0], "quantity") == 0)
+			item->quantity = strtoul(attributes[1], NULL, 10);
+	}
+	if (empty)
+		return token;
+
+	order->in_item = true;
+	while (token.type != descent_xml_classifier_element_close_name) {
+		if (token.type == descent_xml_classifier_eof)
+			return token;
+		token = descent_xml_parse_cstr(token, NULL, generic_text, context);
+	}
+	order->in_item = false;
+	return descent_xml_parse_cstr(token, NULL, NULL, NULL);
+}
+
+static struct descent_xml_lex generic_order(
+	struct descent_xml_lex token,
+	char *name,
+	char **attributes,
+	bool empty,
+	void *context
+)
+{
+	struct generic_order *const order = context;
+	if (strcmp(name, "order") != 0 || empty)
+		return token;
+	for (; *attributes; attributes += 2) {
+		if (strcmp(attributes[0], "id") == 0)
+			order->id = strtoul(attributes[1], NULL, 10);
+	}
+	while (token.type != descent_xml_classifier_element_close_name) {
+		if (token.type == descent_xml_classifier_eof)
+			return token;
+		token = descent_xml_parse_cstr(token, generic_item, NULL, context);
+	}
+	return descent_xml_parse_cstr(token, NULL, NULL, NULL);
+}
+
+int main()
+{
+	static char document[ITEMS * 80 + 128];
+	size_t length = (size_t)sprintf(document, "<order id=\"42\" currency=\"EUR\">\n");
+	for (int i = 0; i < ITEMS; i++)
+		length += (size_t)sprintf(
+			document + length,
+			"  <item sku=\"sku-%04d\" quantity=\"%d\">%d.%02d</item>\n",
+			i, i % 7 + 1, i, i % 100
+		);
+	length += (size_t)sprintf(document + length, "</order>\n");
+
+	const struct libadt_const_lptr script = {
+		.buffer = document,
+		.size = 1,
+		.length = (ssize_t)length,
+	};
+
+	double checksum = 0;
+	double start = now();
+	for (int round = 0; round < ROUNDS; round++) {
+		struct bound_order order;
+		if (!descent_xml_bind_parse(&order_record, script, &order))
+			return 1;
+		for (size_t i = 0; i < order.item_count; i++)
+			checksum += order.items[i].price * (double)order.items[i].quantity;
+		descent_xml_bind_free(&order_record, &order);
+	}
+	report("descriptor tables", now() - start, length, checksum);
+
+	checksum = 0;
+	start = now();
+	for (int round = 0; round < ROUNDS; round++) {
+		struct generic_order order = { 0 };
+		struct descent_xml_lex token = descent_xml_lex_init(script);
+		while (token.type != descent_xml_classifier_eof) {
+			if (token.type == descent_xml_classifier_unexpected)
+				return 1;
+			token = descent_xml_parse_cstr(token, generic_order, NULL, &order);
+		}
+		for (size_t i = 0; i < order.count; i++)
+			checksum += order.items[i].price * (double)order.items[i].quantity;
+	}
+	report("callbacks and strcmp", now() - start, length, checksum);
+}
@@ -0,0 +1,182 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+// Throughput of the XML Char check on markup-heavy ASCII and on text
+// that's mostly multi-byte, with each SIMD level up to the one in use
+// (so DESCENT_XML_SIMD caps it), next to decoding with mbrtowc() as
+// the lexer does. Short records are also checked one at a time, with
+// and without the padding contract, which lets the SIMD kernels skip
+// the byte-at-a-time tail. Last, runs of indentation are skipped as
+// the lexer does, against decoding them with mbrtowc() and iswspace().
+
+#include <locale.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <wchar.h>
+#include <wctype.h>
+
+#include "descent-xml.h"
+
+#define SIZE (64 * 1024 * 1024)
+#define ROUNDS 8
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static char *fill(const char *piece)
+{
+	char *const buffer = malloc(SIZE + DESCENT_XML_PADDING);
+	if (!buffer)
+		exit(1);
+	const size_t length = strlen(piece);
+	for (size_t i = 0; i + length <= SIZE; i += length)
+		memcpy(buffer + i, piece, length);
+	memset(buffer + SIZE - SIZE % length, ' ', SIZE % length + DESCENT_XML_PADDING);
+	return buffer;
+}
+
+static void bench(const char *name, const char *buffer)
+{
+	const struct libadt_const_lptr script = {
+		.buffer = buffer,
+		.size = 1,
+		.length = SIZE,
+	};
+	size_t checked = 0;
+	const double start = now();
+	for (int round = 0; round < ROUNDS; round++)
+		checked += descent_xml_chars_check(script);
+	const double elapsed = now() - start;
+	printf("%-34s %8.2f GB/s\n", name, (double)checked / elapsed / 1e9);
+}
+
+// checks SIZE bytes as records of record_length bytes
+static void bench_records(
+	const char *name,
+	const char *buffer,
+	size_t record_length,
+	size_t (*check)(struct libadt_const_lptr)
+)
+{
+	size_t checked = 0;
+	const double start = now();
+	for (int round = 0; round < ROUNDS; round++) {
+		for (size_t i = 0; i + record_length <= SIZE; i += record_length) {
+			checked += check((struct libadt_const_lptr) {
+				.buffer = buffer + i,
+				.size = 1,
+				.length = (ssize_t)record_length,
+			});
+		}
+	}
+	const double elapsed = now() - start;
+	printf("%-34s %8.2f GB/s\n", name, (double)checked / elapsed / 1e9);
+}
+
+static void bench_mbrtowc(const char *name, const char *buffer)
+{
+	mbstate_t state = { 0 };
+	size_t decoded = 0;
+	const double start = now();
+	for (size_t i = 0; i < SIZE;) {
+		wchar_t c;
+		const size_t n = mbrtowc(&c, buffer + i, SIZE - i, &state);
+		if (n == 0 || n > SIZE)
+			break;
+		i += n;
+		decoded += n;
+	}
+	const double elapsed = now() - start;
+	printf("%-34s %8.2f GB/s\n", name, (double)decoded / elapsed / 1e9);
+}
+
+// skips the whitespace at the start of each record of record_length
+// bytes, given the rest of the buffer as the lexer would be
+static void bench_spaces(
+	const char *name,
+	const char *buffer,
+	size_t record_length,
+	size_t (*spaces)(struct libadt_const_lptr)
+)
+{
+	size_t skipped = 0;
+	const double start = now();
+	for (int round = 0; round < ROUNDS; round++) {
+		for (size_t i = 0; i + record_length <= SIZE; i += record_length) {
+			skipped += spaces((struct libadt_const_lptr) {
+				.buffer = buffer + i,
+				.size = 1,
+				.length = (ssize_t)(SIZE - i),
+			});
+		}
+	}
+	const double elapsed = now() - start;
+	printf("%-34s %8.2f GB/s\n", name, (double)skipped / elapsed / 1e9);
+}
+
+static size_t spaces_mbrtowc(struct libadt_const_lptr script)
+{
+	mbstate_t state = { 0 };
+	size_t spaces = 0;
+	wchar_t c;
+	while (
+		mbrtowc(&c, (const char *)script.buffer + spaces, (size_t)script.length - spaces, &state) == 1
+		&& iswspace((wint_t)c)
+	)
+		spaces++;
+	return spaces;
+}
+
+int main()
+{
+	if (!setlocale(LC_CTYPE, "C.UTF-8"))
+		fprintf(stderr, "C.UTF-8 locale unavailable, mbrtowc() will stop early\n");
+
+	char *const ascii = fill("<item sku=\"a-1\" quantity=\"3\">\n\t2.50\n</item>\n");
+	// 13 bytes of indentation and a 4-byte tag
+	char *const indented = fill("\n            <x/>");
+	char *const mixed = fill("<p>Gr\xc3\xbc\xc3\x9f""e \xe2\x80\x94 \xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e \xf0\x9f\x98\x80</p>\n");
+
+	const enum descent_xml_simd top = descent_xml_simd_level();
+	for (int level = DESCENT_XML_SIMD_SCALAR; level <= (int)top; level++) {
+		descent_xml_simd_set_level(level);
+		char name[64];
+		snprintf(name, sizeof(name), "ASCII markup, %s", descent_xml_simd_name(level));
+		bench(name, ascii);
+		snprintf(name, sizeof(name), "multi-byte text, %s", descent_xml_simd_name(level));
+		bench(name, mixed);
+		snprintf(name, sizeof(name), "47-byte records, %s", descent_xml_simd_name(level));
+		bench_records(name, ascii, 47, descent_xml_chars_check);
+		snprintf(name, sizeof(name), "47-byte records, %s, padded", descent_xml_simd_name(level));
+		bench_records(name, ascii, 47, descent_xml_chars_check_padded);
+		snprintf(name, sizeof(name), "indentation, %s", descent_xml_simd_name(level));
+		bench_spaces(name, indented, 17, descent_xml_chars_spaces);
+	}
+	bench_mbrtowc("ASCII markup, mbrtowc", ascii);
+	bench_mbrtowc("multi-byte text, mbrtowc", mixed);
+	bench_spaces("indentation, mbrtowc", indented, 17, spaces_mbrtowc);
+
+	free(ascii);
+	free(indented);
+	free(mixed);
+}
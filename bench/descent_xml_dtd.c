@@ -0,0 +1,96 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Validates a stream of small messages against one DTD, comparing a
+// DTD compiled once up front with compiling each message's internal
+// subset, and with plain well-formedness checking.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "descent-xml.h"
+
+#include <libadt/str.h>
+
+#define MESSAGES 100000
+
+typedef struct libadt_const_lptr lptr_t;
+
+#define DECLARATIONS \
+	"<!ELEMENT message (header, item*, trailer?)>" \
+	"<!ELEMENT header EMPTY>" \
+	"<!ATTLIST header seq NMTOKEN #REQUIRED kind (order|cancel) 'order'>" \
+	"<!ELEMENT item (#PCDATA)>" \
+	"<!ATTLIST item sku CDATA #REQUIRED>" \
+	"<!ELEMENT trailer EMPTY>"
+
+static const char message[] =
+	"<!DOCTYPE message [" DECLARATIONS "]>"
+	"<message><header seq='42' kind='order'/>"
+	"<item sku='a-1'>one</item><item sku='b-2'>two</item>"
+	"<item sku='c-3'>three</item><trailer/></message>";
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void report(const char *name, double elapsed, size_t valid)
+{
+	printf(
+		"%-24s %8.3f s %10.0f messages/s %8.1f MB/s %zu valid\n",
+		name,
+		elapsed,
+		MESSAGES / elapsed,
+		(double)(sizeof(message) - 1) * MESSAGES / elapsed / 1e6,
+		valid
+	);
+}
+
+int main()
+{
+	const lptr_t script = libadt_str_literal(message);
+
+	struct descent_xml_dtd *const dtd
+		= descent_xml_dtd_compile(libadt_str_literal(DECLARATIONS));
+	if (!dtd)
+		return 1;
+
+	size_t valid = 0;
+	double start = now();
+	for (int i = 0; i < MESSAGES; i++)
+		valid += descent_xml_dtd_validate_document(dtd, descent_xml_lex_init(script));
+	report("compiled once", now() - start, valid);
+
+	valid = 0;
+	start = now();
+	for (int i = 0; i < MESSAGES; i++)
+		valid += descent_xml_dtd_validate_document(NULL, descent_xml_lex_init(script));
+	report("compiled per message", now() - start, valid);
+
+	valid = 0;
+	start = now();
+	for (int i = 0; i < MESSAGES; i++)
+		valid += descent_xml_validate_document(descent_xml_lex_init(script));
+	report("well-formedness only", now() - start, valid);
+
+	descent_xml_dtd_free(dtd);
+}
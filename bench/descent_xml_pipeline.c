@@ -0,0 +1,157 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Compares a flat descent_xml_parse() loop against the pipeline,
+// with handlers that do a configurable amount of work per event.
+//
+// Usage: bench_descent_xml_pipeline [work-per-event] [handler-threads]
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "descent-xml.h"
+
+#define RECORDS 20000
+
+typedef struct descent_xml_lex lex_t;
+typedef struct libadt_const_lptr lptr_t;
+
+static unsigned work = 2000;
+static atomic_ulong sink;
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// stands in for whatever an application does with an event
+static void busy(lptr_t value)
+{
+	unsigned long hash = 5381;
+	const unsigned char *const bytes = value.buffer;
+	for (unsigned i = 0; i < work; i++)
+		hash = hash * 33 + bytes[i % (unsigned)(value.length ? value.length : 1)];
+	atomic_fetch_add_explicit(&sink, hash, memory_order_relaxed);
+}
+
+static void pipeline_element(lptr_t name, lptr_t attributes, bool empty, void *context)
+{
+	(void)attributes;
+	(void)empty;
+	(void)context;
+	busy(name);
+}
+
+static void pipeline_text(lptr_t text, bool is_cdata, void *context)
+{
+	(void)is_cdata;
+	(void)context;
+	busy(text);
+}
+
+static lex_t flat_element(
+	lex_t token,
+	lptr_t name,
+	lptr_t attributes,
+	bool empty,
+	void *context
+)
+{
+	pipeline_element(name, attributes, empty, context);
+	return token;
+}
+
+static char *make_document(size_t *length)
+{
+	const size_t capacity = (size_t)RECORDS * 128;
+	char *const xml = malloc(capacity);
+	size_t used = (size_t)snprintf(xml, capacity, "<records>");
+	for (int i = 0; i < RECORDS; i++)
+		used += (size_t)snprintf(
+			xml + used,
+			capacity - used,
+			"<record id=\"%d\"><name>Record %d</name></record>",
+			i,
+			i
+		);
+	used += (size_t)snprintf(xml + used, capacity - used, "</records>");
+	*length = used;
+	return xml;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc > 1)
+		work = (unsigned)atoi(argv[1]);
+	const unsigned threads = argc > 2 ? (unsigned)atoi(argv[2]) : 1;
+
+	size_t length = 0;
+	char *const xml = make_document(&length);
+	const lptr_t script = { .buffer = xml, .size = 1, .length = (ssize_t)length };
+
+	double start = now();
+	lex_t token = descent_xml_lex_init(script);
+	while (
+		token.type != descent_xml_classifier_eof
+		&& token.type != descent_xml_classifier_unexpected
+	)
+		token = descent_xml_parse(token, flat_element, pipeline_text, NULL);
+	const double flat = now() - start;
+
+	const struct descent_xml_pipeline_options options = {
+		.handler_threads = threads,
+	};
+	const struct descent_xml_pipeline_handlers handlers = {
+		.element_handler = pipeline_element,
+		.text_handler = pipeline_text,
+	};
+	struct descent_xml_pipeline_stats stats;
+	descent_xml_pipeline_run(
+		descent_xml_lex_init(script),
+		&options,
+		&handlers,
+		NULL,
+		&stats
+	);
+
+	printf("flat parse:     %8.3f ms\n", flat * 1e3);
+	printf("pipeline:       %8.3f ms\n", stats.elapsed_seconds * 1e3);
+	printf(
+		"  lexer:        %8.1f MB/s busy, %zu stalls, %.3f ms waiting\n",
+		(double)stats.lexer.bytes / stats.lexer.busy_seconds / 1e6,
+		stats.lexer.stalls,
+		stats.lexer.wait_seconds * 1e3
+	);
+	printf(
+		"  handlers:     %8.1f MB/s busy, %zu stalls, %.3f ms waiting\n",
+		(double)stats.handlers.bytes / stats.handlers.busy_seconds / 1e6,
+		stats.handlers.stalls,
+		stats.handlers.wait_seconds * 1e3
+	);
+	printf(
+		"  %zu events in %zu batches\n",
+		stats.handlers.events,
+		stats.handlers.batches
+	);
+
+	free(xml);
+}
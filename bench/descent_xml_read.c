@@ -0,0 +1,146 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Compares synchronous pread() input against io_uring input.
+//
+// Usage: bench_descent_xml_read [file]
+//
+// Without a file argument, a synthetic document is written to a
+// temporary file first. Note that, unless the page cache is dropped
+// between runs (echo 3 > /proc/sys/vm/drop_caches), this measures
+// cached reads.
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "descent-xml.h"
+
+#define RUNS 5
+#define RECORDS 400000
+
+typedef struct descent_xml_read_options options_t;
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static int make_document(void)
+{
+	char name[] = "/tmp/descent_xml_benchXXXXXX";
+	const int fd = mkstemp(name);
+	if (fd < 0)
+		return -1;
+	unlink(name);
+
+	FILE *const file = fdopen(dup(fd), "w");
+	fputs("<?xml version=\"1.0\"?>\n<records>\n", file);
+	for (int i = 0; i < RECORDS; i++) {
+		fprintf(
+			file,
+			"\t<record id=\"%d\" kind='sample'>"
+			"<name>Record number %d</name>"
+			"<value>%d.%02d</value></record>\n",
+			i,
+			i,
+			i * 3,
+			i % 100
+		);
+	}
+	fputs("</records>\n", file);
+	fclose(file);
+	return fd;
+}
+
+static size_t count_tokens(struct libadt_lptr document)
+{
+	struct libadt_const_lptr script = {
+		.buffer = document.buffer,
+		.size = 1,
+		.length = document.length,
+	};
+	size_t tokens = 0;
+	struct descent_xml_lex token = descent_xml_lex_init(script);
+	while (
+		token.type != descent_xml_classifier_eof
+		&& token.type != descent_xml_classifier_unexpected
+	) {
+		token = descent_xml_lex_next_raw(token);
+		tokens++;
+	}
+	return tokens;
+}
+
+static void run(const char *name, int fd, int flags, bool lex)
+{
+	const options_t options = { .flags = flags };
+	double best = 0;
+	ssize_t length = 0;
+
+	// lexing dominates by far, so once is enough there
+	const int runs = lex ? 1 : RUNS;
+	for (int i = 0; i < runs; i++) {
+		const double start = now();
+		struct libadt_lptr document = descent_xml_read_fd(fd, &options);
+		if (!document.buffer) {
+			perror(name);
+			exit(1);
+		}
+		if (lex)
+			count_tokens(document);
+		const double elapsed = now() - start;
+		if (!i || elapsed < best)
+			best = elapsed;
+		length = document.length;
+		free(document.buffer);
+	}
+
+	printf(
+		"%-24s %10zd bytes %10.3f ms %10.1f MB/s\n",
+		name,
+		length,
+		best * 1e3,
+		(double)length / best / 1e6
+	);
+}
+
+int main(int argc, char **argv)
+{
+	const int fd = argc > 1 ? open(argv[1], O_RDONLY) : make_document();
+	if (fd < 0) {
+		perror(argc > 1 ? argv[1] : "temporary file");
+		return 1;
+	}
+
+	printf(
+		"io_uring: %s\n",
+		descent_xml_read_io_uring_available() ? "available" : "unavailable"
+	);
+	run("read (pread)", fd, DESCENT_XML_READ_SYNC, false);
+	run("read (io_uring)", fd, 0, false);
+	run("read+lex (pread)", fd, DESCENT_XML_READ_SYNC, true);
+	run("read+lex (io_uring)", fd, 0, true);
+
+	close(fd);
+}
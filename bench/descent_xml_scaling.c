@@ -0,0 +1,132 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+// Times lexing and validating the inputs from tests/pathological.h at
+// doubling sizes, to show how the cost grows. A growth near 1 is
+// linear; anything approaching 2 is a quadratic loop to hunt down.
+//
+// Usage: bench_descent_xml_scaling [--size KB] [--steps N] [--runs N] [--input NAME]...
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pathological.h"
+
+#define MAX_SELECTED 32
+
+static bool selected(const char *const *names, size_t count, const char *name)
+{
+	if (!count)
+		return true;
+	for (size_t i = 0; i < count; i++)
+		if (strcmp(names[i], name) == 0)
+			return true;
+	return false;
+}
+
+static int usage(const char *program)
+{
+	fprintf(stderr,
+		"usage: %s [--size KB] [--steps N] [--runs N] [--input NAME]...\n"
+		"inputs:",
+		program
+	);
+	for (size_t i = 0; i < pathological_input_count; i++)
+		fprintf(stderr, " %s", pathological_inputs[i].name);
+	fprintf(stderr, "\n");
+	return 2;
+}
+
+static bool run(const struct pathological_input *input, size_t size, int steps, int runs)
+{
+	const size_t unit = strlen(input->repeat)
+		+ (input->repeat_after ? strlen(input->repeat_after) : 0);
+	const size_t count = size / unit + 1;
+
+	printf("%s\n", input->name);
+	double first_time = 0, previous_time = 0;
+	size_t first_length = 0, previous_length = 0;
+	for (int step = 0; step <= steps; step++) {
+		size_t length;
+		char *const document = pathological_generate(
+			input,
+			count << step,
+			&length
+		);
+		if (!document)
+			return false;
+
+		const double time = pathological_time(document, length, runs);
+		free(document);
+
+		printf("  %10zu bytes %8.2f ns/byte", length, time / (double)length);
+		if (step > 0)
+			printf("  growth %.2f", log(time / previous_time)
+				/ log((double)length / (double)previous_length));
+		printf("\n");
+
+		if (step == 0) {
+			first_time = time;
+			first_length = length;
+		}
+		previous_time = time;
+		previous_length = length;
+	}
+	if (steps > 0)
+		printf("  overall growth %.2f\n", log(previous_time / first_time)
+			/ log((double)previous_length / (double)first_length));
+	return true;
+}
+
+int main(int argc, char **argv)
+{
+	size_t size = 64 * 1024;
+	int steps = 6;
+	int runs = 3;
+	const char *names[MAX_SELECTED];
+	size_t name_count = 0;
+
+	for (int i = 1; i < argc; i++) {
+		const bool has_value = i + 1 < argc;
+		if (strcmp(argv[i], "--size") == 0 && has_value) {
+			size = strtoul(argv[++i], NULL, 10) * 1024;
+		} else if (strcmp(argv[i], "--steps") == 0 && has_value) {
+			steps = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--runs") == 0 && has_value) {
+			runs = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--input") == 0 && has_value && name_count < MAX_SELECTED) {
+			names[name_count++] = argv[++i];
+		} else {
+			return usage(argv[0]);
+		}
+	}
+	if (!size || steps < 0 || steps > 20 || runs < 1)
+		return usage(argv[0]);
+
+	for (size_t i = 0; i < pathological_input_count; i++) {
+		if (!selected(names, name_count, pathological_inputs[i].name))
+			continue;
+		if (!run(&pathological_inputs[i], size, steps, runs)) {
+			fprintf(stderr, "out of memory\n");
+			return 1;
+		}
+	}
+	return 0;
+}
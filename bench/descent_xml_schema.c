@@ -0,0 +1,104 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Validates a stream of small messages against a compiled schema,
+// compared with plain well-formedness checking.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "descent-xml.h"
+
+#include <libadt/str.h>
+
+#define MESSAGES 100000
+
+typedef struct libadt_const_lptr lptr_t;
+
+static const char xsd[] =
+	"<xs:schema xmlns:xs='http://www.w3.org/2001/XMLSchema'>"
+	"<xs:element name='message'><xs:complexType><xs:sequence>"
+	"<xs:element name='header'><xs:complexType>"
+	"<xs:attribute name='seq' type='xs:positiveInteger' use='required'/>"
+	"<xs:attribute name='kind' type='kind'/>"
+	"</xs:complexType></xs:element>"
+	"<xs:element name='item' type='item' maxOccurs='unbounded'/>"
+	"<xs:element name='trailer' minOccurs='0'><xs:complexType/></xs:element>"
+	"</xs:sequence></xs:complexType></xs:element>"
+	"<xs:simpleType name='kind'><xs:restriction base='xs:token'>"
+	"<xs:enumeration value='order'/><xs:enumeration value='cancel'/>"
+	"</xs:restriction></xs:simpleType>"
+	"<xs:complexType name='item'><xs:simpleContent>"
+	"<xs:extension base='xs:decimal'>"
+	"<xs:attribute name='sku' use='required'><xs:simpleType>"
+	"<xs:restriction base='xs:string'><xs:pattern value='[a-z]-\\d+'/></xs:restriction>"
+	"</xs:simpleType></xs:attribute>"
+	"</xs:extension></xs:simpleContent></xs:complexType>"
+	"</xs:schema>";
+
+static const char message[] =
+	"<message><header seq='42' kind='order'/>"
+	"<item sku='a-1'>1.50</item><item sku='b-2'>20</item>"
+	"<item sku='c-3'>3.25</item><trailer/></message>";
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void report(const char *name, double elapsed, size_t valid)
+{
+	printf(
+		"%-24s %8.3f s %10.0f messages/s %8.1f MB/s %zu valid\n",
+		name,
+		elapsed,
+		MESSAGES / elapsed,
+		(double)(sizeof(message) - 1) * MESSAGES / elapsed / 1e6,
+		valid
+	);
+}
+
+int main()
+{
+	const lptr_t script = libadt_str_literal(message);
+
+	struct descent_xml_schema *const schema
+		= descent_xml_schema_compile(libadt_str_literal(xsd));
+	if (!schema)
+		return 1;
+
+	size_t valid = 0;
+	double start = now();
+	for (int i = 0; i < MESSAGES; i++)
+		valid += descent_xml_schema_validate_document(
+			schema,
+			descent_xml_lex_init(script)
+		);
+	report("schema", now() - start, valid);
+
+	valid = 0;
+	start = now();
+	for (int i = 0; i < MESSAGES; i++)
+		valid += descent_xml_validate_document(descent_xml_lex_init(script));
+	report("well-formedness only", now() - start, valid);
+
+	descent_xml_schema_free(schema);
+}
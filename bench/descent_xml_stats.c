@@ -0,0 +1,184 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Prints the hot-path counters from descent-xml/stats.h for lexing
+// and parsing a document, to show where the work goes.
+//
+// Usage: bench_descent_xml_stats [file]
+//
+// Without a file, the "records" corpus is used. The library has to be
+// built with -DDESCENT_XML_STATS=ON for there to be anything to show.
+
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "descent-xml.h"
+
+#include "corpus.h"
+
+static struct descent_xml_lex ignore_element(
+	struct descent_xml_lex token,
+	struct libadt_const_lptr element_name,
+	struct libadt_const_lptr attributes,
+	bool empty,
+	void *context
+)
+{
+	(void)element_name;
+	(void)attributes;
+	(void)empty;
+	(void)context;
+	return token;
+}
+
+static struct descent_xml_lex ignore_element_cstr(
+	struct descent_xml_lex token,
+	char *element_name,
+	char **attributes,
+	bool empty,
+	void *context
+)
+{
+	(void)element_name;
+	(void)attributes;
+	(void)empty;
+	(void)context;
+	return token;
+}
+
+static void ignore_text(struct libadt_const_lptr text, bool is_cdata, void *context)
+{
+	(void)text;
+	(void)is_cdata;
+	(void)context;
+}
+
+static void ignore_text_cstr(char *text, bool is_cdata, void *context)
+{
+	(void)text;
+	(void)is_cdata;
+	(void)context;
+}
+
+static bool lex(struct libadt_const_lptr script)
+{
+	struct descent_xml_lex token = descent_xml_lex_init(script);
+	while (token.type != descent_xml_classifier_eof) {
+		if (token.type == descent_xml_classifier_unexpected)
+			return false;
+		token = descent_xml_lex_next_raw(token);
+	}
+	return true;
+}
+
+static bool parse(struct libadt_const_lptr script)
+{
+	struct descent_xml_lex token = descent_xml_lex_init(script);
+	while (token.type != descent_xml_classifier_eof) {
+		if (token.type == descent_xml_classifier_unexpected)
+			return false;
+		token = descent_xml_parse(token, ignore_element, ignore_text, NULL);
+	}
+	return true;
+}
+
+static bool parse_cstr(struct libadt_const_lptr script)
+{
+	struct descent_xml_lex token = descent_xml_lex_init(script);
+	while (token.type != descent_xml_classifier_eof) {
+		if (token.type == descent_xml_classifier_unexpected)
+			return false;
+		token = descent_xml_parse_cstr(token, ignore_element_cstr, ignore_text_cstr, NULL);
+	}
+	return true;
+}
+
+static void report(const char *name, bool (*run)(struct libadt_const_lptr), struct libadt_const_lptr script)
+{
+	descent_xml_stats_reset();
+	const bool ok = run(script);
+	const struct descent_xml_stats stats = descent_xml_stats_get();
+
+	printf("%s%s\n", name, ok ? "" : " (failed part way)");
+	printf("  %-64s %12s %14s\n", "token type", "tokens", "bytes");
+	for (size_t slot = 0; slot < DESCENT_XML_STATS_TYPES; slot++) {
+		if (!stats.tokens[slot])
+			continue;
+		printf(
+			"  %-64s %12zu %14zu\n",
+			descent_xml_stats_type_name(slot),
+			stats.tokens[slot],
+			stats.token_bytes[slot]
+		);
+	}
+	printf("  mbrtowc() calls        %14zu (%zu bytes)\n", stats.mbrtowc_calls, stats.decoded_bytes);
+	printf("  bytes compared         %14zu\n", stats.compared_bytes);
+	printf("  lex_or backtracks      %14zu (%zu bytes wasted)\n", stats.or_backtracks, stats.or_wasted_bytes);
+	printf("  lex_optional misses    %14zu (%zu bytes wasted)\n", stats.optional_backtracks, stats.optional_wasted_bytes);
+	printf("  attribute vector grows %14zu\n", stats.vector_allocations);
+	printf("  strndup() calls        %14zu\n\n", stats.strndup_calls);
+}
+
+int main(int argc, char **argv)
+{
+	if (!descent_xml_stats_enabled()) {
+		fprintf(stderr, "descent-xml was built without -DDESCENT_XML_STATS=ON\n");
+		return 1;
+	}
+
+	struct libadt_const_lptr script;
+	char *buffer;
+	if (argc > 1) {
+		const int fd = open(argv[1], O_RDONLY);
+		if (fd < 0) {
+			perror(argv[1]);
+			return 1;
+		}
+		const struct libadt_lptr contents = descent_xml_read_fd(fd, NULL);
+		close(fd);
+		if (!contents.buffer) {
+			perror(argv[1]);
+			return 1;
+		}
+		buffer = contents.buffer;
+		script = (struct libadt_const_lptr) {
+			.buffer = buffer,
+			.size = 1,
+			.length = contents.length,
+		};
+	} else {
+		size_t length;
+		buffer = bench_corpus_find("records")->generate(1024 * 1024, &length);
+		if (!buffer)
+			return 1;
+		script = (struct libadt_const_lptr) {
+			.buffer = buffer,
+			.size = 1,
+			.length = (ssize_t)length,
+		};
+	}
+
+	report("descent_xml_lex_next_raw()", lex, script);
+	report("descent_xml_parse()", parse, script);
+	report("descent_xml_parse_cstr()", parse_cstr, script);
+
+	free(buffer);
+}
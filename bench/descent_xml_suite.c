@@ -0,0 +1,573 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Times each layer of the library over a set of synthetic corpora.
+//
+// Usage: bench_descent_xml_suite [--size MB] [--runs N] [--no-counters]
+// 	[--corpus NAME]... [--layer NAME]... [--json FILE]
+//
+// Layers, from the bottom up:
+//
+// - classifier: the classifier state machine, fed characters that
+//   were decoded beforehand;
+// - lex: descent_xml_lex_next_raw() over the whole document;
+// - lex_generic: the same, with the generic lexer engine, which calls
+//   the classifier state function for each character;
+// - parse: descent_xml_parse() with handlers that do nothing;
+// - parse_coalesced: descent_xml_parse_coalesced(), decoding
+//   references and skipping whitespace-only text, with handlers that
+//   do nothing;
+// - parse_chunked: descent_xml_parse_chunked(), in 64 KiB chunks,
+//   with handlers that do nothing;
+// - parse_cstr: descent_xml_parse_cstr() with handlers that do
+//   nothing;
+// - parse_cstr_parser: the same, allocating from a descent_xml_parser
+//   kept warm between runs;
+// - validate: descent_xml_validate_document_depth().
+//
+// Token rates count the tokens the lexer produces for a corpus, so
+// they're comparable between layers. Each layer is run --runs times
+// and the fastest run reported; allocations are counted for one run.
+// Where perf_event_open() is permitted, hardware counters
+// (instructions, cycles, branch misses, L1d and LLC read misses) are
+// read around each run and reported per byte and per token for the
+// fastest one. Instruction counts barely move between runs, so they
+// show regressions that timing noise would hide.
+// With --json, results are also written to FILE ("-" for standard
+// output) as JSON.
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <wchar.h>
+
+#include "descent-xml.h"
+
+#include "alloc_count.h"
+#include "corpus.h"
+#include "perf_counters.h"
+
+#define MAX_SELECTED 16
+
+struct input {
+	struct libadt_const_lptr script;
+	wchar_t *chars;
+	size_t char_count;
+	size_t tokens;
+};
+
+struct result {
+	const char *corpus;
+	const char *layer;
+	size_t bytes;
+	size_t tokens;
+	double seconds;
+	struct bench_alloc_stats allocations;
+	struct bench_counter_values counters;
+	bool ok;
+};
+
+struct layer {
+	const char *name;
+	bool (*run)(const struct input *input);
+};
+
+// keeps the compiler from throwing away work whose result is unused
+static volatile size_t sink;
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static bool run_classifier(const struct input *input)
+{
+	descent_xml_classifier_fn *state = descent_xml_classifier_start;
+	size_t changes = 0;
+	for (size_t i = 0; i < input->char_count; i++) {
+		descent_xml_classifier_fn *const next
+			= (descent_xml_classifier_fn *)state(input->chars[i]);
+		// comments, CDATA and the prolog are picked out by the
+		// lexer rather than the classifier, so carry on as text
+		if (next == descent_xml_classifier_unexpected
+			|| next == descent_xml_classifier_eof)
+			state = descent_xml_classifier_text;
+		else
+			state = next;
+		changes += next != state;
+	}
+	sink = changes;
+	return true;
+}
+
+static bool run_lex(const struct input *input)
+{
+	struct descent_xml_lex token = descent_xml_lex_init(input->script);
+	size_t tokens = 0;
+	while (token.type != descent_xml_classifier_eof) {
+		if (token.type == descent_xml_classifier_unexpected)
+			return false;
+		token = descent_xml_lex_next_raw(token);
+		tokens++;
+	}
+	sink = tokens;
+	return true;
+}
+
+// descent_xml_lex_next_raw(), with _descent_xml_lex_run_generic() in
+// place of the engine in src/engine.c
+static struct descent_xml_lex next_raw_generic(struct descent_xml_lex token)
+{
+	if (token.type == descent_xml_classifier_element) {
+		const struct descent_xml_lex test = descent_xml_lex_or(
+			token,
+			_descent_xml_lex_handle_prolog,
+			_descent_xml_lex_handle_unmarkdown
+		);
+		if (test.type != descent_xml_classifier_unexpected)
+			return test;
+	}
+
+	const struct libadt_const_lptr next = _descent_xml_lex_remainder(token);
+	const _descent_xml_lex_read_t run
+		= _descent_xml_lex_run_generic(next, token.type);
+	return (struct descent_xml_lex) {
+		.script = token.script,
+		.type = run.type,
+		.value = libadt_const_lptr_truncate(next, (size_t)run.amount),
+	};
+}
+
+static bool run_lex_generic(const struct input *input)
+{
+	struct descent_xml_lex token = descent_xml_lex_init(input->script);
+	size_t tokens = 0;
+	while (token.type != descent_xml_classifier_eof) {
+		if (token.type == descent_xml_classifier_unexpected)
+			return false;
+		token = next_raw_generic(token);
+		tokens++;
+	}
+	sink = tokens;
+	return true;
+}
+
+static struct descent_xml_lex count_element(
+	struct descent_xml_lex token,
+	struct libadt_const_lptr element_name,
+	struct libadt_const_lptr attributes,
+	bool empty,
+	void *context
+)
+{
+	(void)empty;
+	*(size_t *)context += (size_t)element_name.length + (size_t)attributes.length;
+	return token;
+}
+
+static void count_text(struct libadt_const_lptr text, bool is_cdata, void *context)
+{
+	(void)is_cdata;
+	*(size_t *)context += (size_t)text.length;
+}
+
+static bool run_parse(const struct input *input)
+{
+	struct descent_xml_lex token = descent_xml_lex_init(input->script);
+	size_t count = 0;
+	while (token.type != descent_xml_classifier_eof) {
+		if (token.type == descent_xml_classifier_unexpected)
+			return false;
+		token = descent_xml_parse(token, count_element, count_text, &count);
+	}
+	sink = count;
+	return true;
+}
+
+static struct descent_xml_text coalesce;
+
+static bool run_parse_coalesced(const struct input *input)
+{
+	struct descent_xml_lex token = descent_xml_lex_init(input->script);
+	size_t count = 0;
+	while (token.type != descent_xml_classifier_eof) {
+		if (
+			token.type == descent_xml_classifier_unexpected
+			|| token.type == descent_xml_parse_error
+		)
+			return false;
+		token = descent_xml_parse_coalesced(token, &coalesce, count_element, count_text, &count);
+	}
+	sink = count;
+	return true;
+}
+
+static struct descent_xml_text chunks;
+
+static void count_chunk(
+	struct libadt_const_lptr chunk,
+	unsigned position,
+	bool is_cdata,
+	void *context
+)
+{
+	(void)position;
+	(void)is_cdata;
+	*(size_t *)context += (size_t)chunk.length;
+}
+
+static bool run_parse_chunked(const struct input *input)
+{
+	struct descent_xml_lex token = descent_xml_lex_init(input->script);
+	size_t count = 0;
+	while (token.type != descent_xml_classifier_eof) {
+		if (
+			token.type == descent_xml_classifier_unexpected
+			|| token.type == descent_xml_parse_error
+		)
+			return false;
+		token = descent_xml_parse_chunked(token, &chunks, count_element, count_chunk, &count);
+	}
+	sink = count;
+	return true;
+}
+
+static struct descent_xml_lex count_element_cstr(
+	struct descent_xml_lex token,
+	char *element_name,
+	char **attributes,
+	bool empty,
+	void *context
+)
+{
+	(void)empty;
+	*(size_t *)context += (size_t)element_name[0] + (attributes[0] != NULL);
+	return token;
+}
+
+static void count_text_cstr(char *text, bool is_cdata, void *context)
+{
+	(void)is_cdata;
+	*(size_t *)context += (size_t)text[0];
+}
+
+static bool run_parse_cstr(const struct input *input)
+{
+	struct descent_xml_lex token = descent_xml_lex_init(input->script);
+	size_t count = 0;
+	while (token.type != descent_xml_classifier_eof) {
+		if (token.type == descent_xml_classifier_unexpected)
+			return false;
+		token = descent_xml_parse_cstr(token, count_element_cstr, count_text_cstr, &count);
+	}
+	sink = count;
+	return true;
+}
+
+static struct descent_xml_parser parser;
+
+static bool run_parse_cstr_parser(const struct input *input)
+{
+	struct descent_xml_lex token = descent_xml_parser_start(&parser, input->script);
+	size_t count = 0;
+	while (token.type != descent_xml_classifier_eof) {
+		if (token.type == descent_xml_classifier_unexpected)
+			return false;
+		token = descent_xml_parser_parse_cstr(&parser, token, count_element_cstr, count_text_cstr, &count);
+	}
+	sink = count;
+	return true;
+}
+
+static bool run_validate(const struct input *input)
+{
+	return descent_xml_validate_document_depth(
+		descent_xml_lex_init(input->script),
+		-1
+	);
+}
+
+static const struct layer layers[] = {
+	{ "classifier", run_classifier },
+	{ "lex", run_lex },
+	{ "lex_generic", run_lex_generic },
+	{ "parse", run_parse },
+	{ "parse_coalesced", run_parse_coalesced },
+	{ "parse_chunked", run_parse_chunked },
+	{ "parse_cstr", run_parse_cstr },
+	{ "parse_cstr_parser", run_parse_cstr_parser },
+	{ "validate", run_validate },
+};
+
+#define LAYER_COUNT (sizeof(layers) / sizeof(layers[0]))
+
+static bool prepare(struct input *input, char *document, size_t length)
+{
+	input->script = (struct libadt_const_lptr) {
+		.buffer = document,
+		.size = 1,
+		.length = (ssize_t)length,
+	};
+
+	// the corpora are ASCII, so decoding is a widening copy
+	input->chars = malloc(length * sizeof(wchar_t));
+	if (!input->chars)
+		return false;
+	for (size_t i = 0; i < length; i++)
+		input->chars[i] = (wchar_t)(unsigned char)document[i];
+	input->char_count = length;
+
+	if (!run_lex(input))
+		return false;
+	input->tokens = sink;
+	return true;
+}
+
+static struct result measure(
+	const struct bench_corpus *corpus,
+	const struct layer *layer,
+	const struct input *input,
+	int runs,
+	struct bench_counters *counters
+)
+{
+	struct result result = {
+		.corpus = corpus->name,
+		.layer = layer->name,
+		.bytes = input->char_count,
+		.tokens = input->tokens,
+		.ok = true,
+	};
+
+	for (int run = 0; run < runs; run++) {
+		bench_alloc_reset();
+		bench_counters_start(counters);
+		const double start = now();
+		result.ok &= layer->run(input);
+		const double elapsed = now() - start;
+		const struct bench_counter_values values = bench_counters_stop(counters);
+		if (run == 0 || elapsed < result.seconds) {
+			result.seconds = elapsed;
+			result.counters = values;
+		}
+		if (run == 0)
+			result.allocations = bench_alloc_stats();
+	}
+	return result;
+}
+
+static void print_result(const struct result *result)
+{
+	printf(
+		"%-10s %-11s %9.1f MB/s %12.0f tokens/s",
+		result->corpus,
+		result->layer,
+		(double)result->bytes / result->seconds / 1e6,
+		(double)result->tokens / result->seconds
+	);
+	if (bench_alloc_counting())
+		printf(" %10zu allocations %12zu bytes", result->allocations.calls, result->allocations.bytes);
+
+	const struct bench_counter_values *const counters = &result->counters;
+	if (counters->valid[BENCH_COUNTER_INSTRUCTIONS])
+		printf(
+			" %7.2f ins/B %8.1f ins/token",
+			(double)counters->values[BENCH_COUNTER_INSTRUCTIONS] / (double)result->bytes,
+			(double)counters->values[BENCH_COUNTER_INSTRUCTIONS] / (double)result->tokens
+		);
+	if (counters->valid[BENCH_COUNTER_CYCLES])
+		printf(
+			" %6.2f cycles/B",
+			(double)counters->values[BENCH_COUNTER_CYCLES] / (double)result->bytes
+		);
+	printf("%s\n", result->ok ? "" : "  FAILED");
+}
+
+static void write_json(FILE *out, const struct result *results, size_t count, size_t size)
+{
+	fprintf(out, "{\n\t\"size\": %zu,\n\t\"allocations_counted\": %s,\n\t\"results\": [\n",
+		size,
+		bench_alloc_counting() ? "true" : "false"
+	);
+	for (size_t i = 0; i < count; i++) {
+		const struct result *const r = &results[i];
+		fprintf(out,
+			"\t\t{\"corpus\": \"%s\", \"layer\": \"%s\", \"ok\": %s, "
+			"\"bytes\": %zu, \"tokens\": %zu, \"seconds\": %.9f, "
+			"\"mb_per_s\": %.3f, \"tokens_per_s\": %.1f, "
+			"\"allocations\": %zu, \"allocated_bytes\": %zu, \"counters\": {",
+			r->corpus,
+			r->layer,
+			r->ok ? "true" : "false",
+			r->bytes,
+			r->tokens,
+			r->seconds,
+			(double)r->bytes / r->seconds / 1e6,
+			(double)r->tokens / r->seconds,
+			r->allocations.calls,
+			r->allocations.bytes
+		);
+		bool first = true;
+		for (int c = 0; c < BENCH_COUNTER_COUNT; c++) {
+			if (!r->counters.valid[c])
+				continue;
+			const double value = (double)r->counters.values[c];
+			fprintf(out,
+				"%s\"%s\": {\"total\": %.0f, \"per_byte\": %.6f, \"per_token\": %.6f}",
+				first ? "" : ", ",
+				bench_counter_names[c],
+				value,
+				value / (double)r->bytes,
+				value / (double)r->tokens
+			);
+			first = false;
+		}
+		fprintf(out, "}}%s\n", i + 1 < count ? "," : "");
+	}
+	fprintf(out, "\t]\n}\n");
+}
+
+static bool selected(const char *name, const char *const *names, size_t count)
+{
+	if (!count)
+		return true;
+	for (size_t i = 0; i < count; i++)
+		if (strcmp(names[i], name) == 0)
+			return true;
+	return false;
+}
+
+static int usage(const char *program)
+{
+	fprintf(stderr,
+		"usage: %s [--size MB] [--runs N] [--no-counters] [--corpus NAME]... [--layer NAME]... [--json FILE]\n"
+		"corpora:",
+		program
+	);
+	for (size_t i = 0; i < bench_corpus_count; i++)
+		fprintf(stderr, " %s", bench_corpora[i].name);
+	fprintf(stderr, "\nlayers:");
+	for (size_t i = 0; i < LAYER_COUNT; i++)
+		fprintf(stderr, " %s", layers[i].name);
+	fprintf(stderr, "\n");
+	return 2;
+}
+
+int main(int argc, char **argv)
+{
+	size_t size = 4 * 1024 * 1024;
+	int runs = 3;
+	const char *json = NULL;
+	bool use_counters = true;
+	const char *corpus_names[MAX_SELECTED];
+	size_t corpus_name_count = 0;
+	const char *layer_names[MAX_SELECTED];
+	size_t layer_name_count = 0;
+
+	for (int i = 1; i < argc; i++) {
+		const bool has_value = i + 1 < argc;
+		if (strcmp(argv[i], "--size") == 0 && has_value) {
+			size = strtoul(argv[++i], NULL, 10) * 1024 * 1024;
+		} else if (strcmp(argv[i], "--runs") == 0 && has_value) {
+			runs = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--no-counters") == 0) {
+			use_counters = false;
+		} else if (strcmp(argv[i], "--json") == 0 && has_value) {
+			json = argv[++i];
+		} else if (strcmp(argv[i], "--corpus") == 0 && has_value && corpus_name_count < MAX_SELECTED) {
+			corpus_names[corpus_name_count++] = argv[++i];
+			if (!bench_corpus_find(corpus_names[corpus_name_count - 1]))
+				return usage(argv[0]);
+		} else if (strcmp(argv[i], "--layer") == 0 && has_value && layer_name_count < MAX_SELECTED) {
+			layer_names[layer_name_count++] = argv[++i];
+		} else {
+			return usage(argv[0]);
+		}
+	}
+	if (!size || runs < 1)
+		return usage(argv[0]);
+
+	struct bench_counters counters;
+	if (!use_counters || !bench_counters_open(&counters)) {
+		if (use_counters)
+			fprintf(stderr, "hardware counters unavailable, reporting times only\n");
+		for (int i = 0; i < BENCH_COUNTER_COUNT; i++)
+			counters.fds[i] = -1;
+	}
+
+	struct result *const results = calloc(bench_corpus_count * LAYER_COUNT, sizeof(*results));
+	if (!results)
+		return 1;
+	size_t result_count = 0;
+	bool ok = true;
+	descent_xml_parser_init(&parser, 64 * 1024);
+	descent_xml_text_init(
+		&coalesce,
+		DESCENT_XML_TEXT_DECODE | DESCENT_XML_TEXT_SKIP_SPACE,
+		NULL
+	);
+	descent_xml_text_init(&chunks, 0, NULL);
+
+	for (size_t c = 0; c < bench_corpus_count; c++) {
+		const struct bench_corpus *const corpus = &bench_corpora[c];
+		if (!selected(corpus->name, corpus_names, corpus_name_count))
+			continue;
+
+		size_t length;
+		char *const document = corpus->generate(size, &length);
+		struct input input = { 0 };
+		if (!document || !prepare(&input, document, length)) {
+			fprintf(stderr, "%s: couldn't generate a well-formed corpus\n", corpus->name);
+			return 1;
+		}
+
+		for (size_t l = 0; l < LAYER_COUNT; l++) {
+			if (!selected(layers[l].name, layer_names, layer_name_count))
+				continue;
+			results[result_count] = measure(corpus, &layers[l], &input, runs, &counters);
+			print_result(&results[result_count]);
+			ok &= results[result_count].ok;
+			result_count++;
+		}
+
+		free(input.chars);
+		free(document);
+	}
+
+	if (json) {
+		FILE *const out = strcmp(json, "-") == 0 ? stdout : fopen(json, "w");
+		if (!out) {
+			perror(json);
+			return 1;
+		}
+		write_json(out, results, result_count, size);
+		if (out != stdout)
+			fclose(out);
+	}
+
+	bench_counters_close(&counters);
+	descent_xml_parser_free(&parser);
+	descent_xml_text_free(&coalesce);
+	descent_xml_text_free(&chunks);
+	free(results);
+	return ok ? 0 : 1;
+}
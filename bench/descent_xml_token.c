@@ -0,0 +1,144 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+// Cost of testing a token's category, over the tokens of each corpus:
+// the pointer comparisons the parser and validator use, against
+// descent_xml_token_is(), which looks the id up in the hash table
+// first. The token types are lexed once beforehand, so only the test
+// is timed.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "descent-xml.h"
+
+#include "corpus.h"
+
+#define SIZE (4 * 1024 * 1024)
+#define ROUNDS 16
+#define RUNS 5
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// Defines a function timing test over every token, giving the best
+// average of RUNS runs in nanoseconds per token. The test is written into the loop rather
+// than called through a pointer, so only the test itself is measured.
+#define BENCH(name, test) \
+	static double name( \
+		descent_xml_classifier_fn *const *types, \
+		size_t count, \
+		size_t *matched \
+	) \
+	{ \
+		double best = 0; \
+		for (int run = 0; run < RUNS; run++) { \
+			size_t found = 0; \
+			const double start = now(); \
+			for (int round = 0; round < ROUNDS; round++) { \
+				for (size_t i = 0; i < count; i++) \
+					found += test; \
+			} \
+			const double elapsed = now() - start; \
+			*matched = found; \
+			if (run == 0 || elapsed < best) \
+				best = elapsed; \
+		} \
+		return best / ((double)count * ROUNDS) * 1e9; \
+	}
+
+#define TOKEN(i) ((struct descent_xml_lex) { .type = types[i] })
+
+BENCH(text_compared, _descent_xml_is_text_type(TOKEN(i)))
+BENCH(text_looked_up, descent_xml_token_is(TOKEN(i), DESCENT_XML_TOKEN_CATEGORY_TEXT))
+BENCH(data_compared, _descent_xml_non_space_text(TOKEN(i)))
+BENCH(data_looked_up, descent_xml_token_is(TOKEN(i), DESCENT_XML_TOKEN_CATEGORY_DATA))
+
+static descent_xml_classifier_fn **lex_all(struct libadt_const_lptr script, size_t *count)
+{
+	size_t capacity = 1024;
+	descent_xml_classifier_fn **types = malloc(capacity * sizeof(*types));
+	if (!types)
+		return NULL;
+
+	*count = 0;
+	struct descent_xml_lex token = descent_xml_lex_init(script);
+	while (!_descent_xml_end_token(token)) {
+		token = descent_xml_lex_next_raw(token);
+		if (*count == capacity) {
+			capacity *= 2;
+			descent_xml_classifier_fn **const grown = realloc(types, capacity * sizeof(*types));
+			if (!grown) {
+				free(types);
+				return NULL;
+			}
+			types = grown;
+		}
+		types[(*count)++] = token.type;
+	}
+	return types;
+}
+
+int main(void)
+{
+	printf("%-12s %10s %12s %12s %12s %12s\n", "corpus", "tokens",
+		"text ==", "text lookup", "data ==", "data lookup");
+
+	for (size_t c = 0; c < bench_corpus_count; c++) {
+		const struct bench_corpus *const corpus = &bench_corpora[c];
+		size_t length;
+		char *const document = corpus->generate(SIZE, &length);
+		if (!document)
+			return 1;
+		const struct libadt_const_lptr script = {
+			.buffer = document,
+			.size = 1,
+			.length = (ssize_t)length,
+		};
+
+		size_t count;
+		descent_xml_classifier_fn **const types = lex_all(script, &count);
+		if (!types)
+			return 1;
+
+		size_t compared, looked_up;
+		const double text_ns = text_compared(types, count, &compared);
+		const double text_lookup_ns = text_looked_up(types, count, &looked_up);
+		if (compared != looked_up) {
+			fprintf(stderr, "%s: text tests disagree\n", corpus->name);
+			return 1;
+		}
+		const double data_ns = data_compared(types, count, &compared);
+		const double data_lookup_ns = data_looked_up(types, count, &looked_up);
+		if (compared != looked_up) {
+			fprintf(stderr, "%s: data tests disagree\n", corpus->name);
+			return 1;
+		}
+
+		printf("%-12s %10zu %9.2f ns %9.2f ns %9.2f ns %9.2f ns\n",
+			corpus->name, count,
+			text_ns, text_lookup_ns, data_ns, data_lookup_ns);
+
+		free(types);
+		free(document);
+	}
+}
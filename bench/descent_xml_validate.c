@@ -0,0 +1,105 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Times descent_xml_validate_document_depth() over deep and flat
+// documents.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "descent-xml.h"
+
+#define RUNS 5
+
+typedef struct libadt_const_lptr lptr_t;
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static lptr_t deep(int levels)
+{
+	const size_t capacity = (size_t)levels * 32 + 64;
+	char *const xml = malloc(capacity);
+	size_t length = 0;
+	for (int i = 0; i < levels; i++)
+		length += (size_t)snprintf(xml + length, capacity - length, "<level%d>", i % 100);
+	for (int i = levels - 1; i >= 0; i--)
+		length += (size_t)snprintf(xml + length, capacity - length, "</level%d>", i % 100);
+	return (lptr_t) { .buffer = xml, .size = 1, .length = (ssize_t)length };
+}
+
+static lptr_t flat(int records)
+{
+	const size_t capacity = (size_t)records * 64 + 64;
+	char *const xml = malloc(capacity);
+	size_t length = (size_t)snprintf(xml, capacity, "<records>");
+	for (int i = 0; i < records; i++)
+		length += (size_t)snprintf(
+			xml + length,
+			capacity - length,
+			"<record id=\"%d\"><v>%d</v></record>",
+			i,
+			i
+		);
+	length += (size_t)snprintf(xml + length, capacity - length, "</records>");
+	return (lptr_t) { .buffer = xml, .size = 1, .length = (ssize_t)length };
+}
+
+static void run(const char *name, lptr_t script, int depth)
+{
+	double best = 0;
+	bool valid = false;
+	for (int i = 0; i < RUNS; i++) {
+		const double start = now();
+		valid = descent_xml_validate_document_depth(
+			descent_xml_lex_init(script),
+			depth
+		);
+		const double elapsed = now() - start;
+		if (!i || elapsed < best)
+			best = elapsed;
+	}
+	printf(
+		"%-16s %10zd bytes %10.3f ms %8.1f MB/s %s\n",
+		name,
+		script.length,
+		best * 1e3,
+		(double)script.length / best / 1e6,
+		valid ? "valid" : "INVALID"
+	);
+}
+
+int main()
+{
+	const lptr_t shallow = deep(900);
+	const lptr_t deeper = deep(100000);
+	const lptr_t wide = flat(20000);
+
+	run("deep (900)", shallow, 1000);
+	run("deep (100000)", deeper, -1);
+	run("flat (20000)", wide, 1000);
+
+	free((void *)shallow.buffer);
+	free((void *)deeper.buffer);
+	free((void *)wide.buffer);
+}
@@ -0,0 +1,145 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "perf_counters.h"
+
+#include <string.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+const char *const bench_counter_names[BENCH_COUNTER_COUNT] = {
+	[BENCH_COUNTER_INSTRUCTIONS] = "instructions",
+	[BENCH_COUNTER_CYCLES] = "cycles",
+	[BENCH_COUNTER_BRANCH_MISSES] = "branch_misses",
+	[BENCH_COUNTER_L1D_MISSES] = "l1d_misses",
+	[BENCH_COUNTER_LLC_MISSES] = "llc_misses",
+};
+
+#ifdef __linux__
+
+#define CACHE_READ_MISS(cache) \
+	((cache) | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+
+static const struct {
+	uint32_t type;
+	uint64_t config;
+} events[BENCH_COUNTER_COUNT] = {
+	[BENCH_COUNTER_INSTRUCTIONS] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+	[BENCH_COUNTER_CYCLES] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+	[BENCH_COUNTER_BRANCH_MISSES] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+	[BENCH_COUNTER_L1D_MISSES] = { PERF_TYPE_HW_CACHE, CACHE_READ_MISS(PERF_COUNT_HW_CACHE_L1D) },
+	[BENCH_COUNTER_LLC_MISSES] = { PERF_TYPE_HW_CACHE, CACHE_READ_MISS(PERF_COUNT_HW_CACHE_LL) },
+};
+
+static int open_event(enum bench_counter counter)
+{
+	struct perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = events[counter].type;
+	attr.config = events[counter].config;
+	attr.disabled = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+	return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+bool bench_counters_open(struct bench_counters *counters)
+{
+	bool any = false;
+	for (int i = 0; i < BENCH_COUNTER_COUNT; i++) {
+		counters->fds[i] = open_event((enum bench_counter)i);
+		any |= counters->fds[i] >= 0;
+	}
+	return any;
+}
+
+void bench_counters_start(struct bench_counters *counters)
+{
+	for (int i = 0; i < BENCH_COUNTER_COUNT; i++) {
+		if (counters->fds[i] < 0)
+			continue;
+		ioctl(counters->fds[i], PERF_EVENT_IOC_RESET, 0);
+		ioctl(counters->fds[i], PERF_EVENT_IOC_ENABLE, 0);
+	}
+}
+
+struct bench_counter_values bench_counters_stop(struct bench_counters *counters)
+{
+	struct bench_counter_values result = { 0 };
+	for (int i = 0; i < BENCH_COUNTER_COUNT; i++) {
+		if (counters->fds[i] >= 0)
+			ioctl(counters->fds[i], PERF_EVENT_IOC_DISABLE, 0);
+	}
+	for (int i = 0; i < BENCH_COUNTER_COUNT; i++) {
+		// value, time enabled, time running
+		uint64_t read_values[3];
+		if (counters->fds[i] < 0
+			|| read(counters->fds[i], read_values, sizeof(read_values)) != sizeof(read_values)
+			|| read_values[2] == 0)
+			continue;
+
+		double value = (double)read_values[0];
+		if (read_values[2] < read_values[1])
+			value *= (double)read_values[1] / (double)read_values[2];
+		result.values[i] = (uint64_t)value;
+		result.valid[i] = true;
+	}
+	return result;
+}
+
+void bench_counters_close(struct bench_counters *counters)
+{
+	for (int i = 0; i < BENCH_COUNTER_COUNT; i++) {
+		if (counters->fds[i] >= 0)
+			close(counters->fds[i]);
+		counters->fds[i] = -1;
+	}
+}
+
+#else
+
+bool bench_counters_open(struct bench_counters *counters)
+{
+	for (int i = 0; i < BENCH_COUNTER_COUNT; i++)
+		counters->fds[i] = -1;
+	return false;
+}
+
+void bench_counters_start(struct bench_counters *counters)
+{
+	(void)counters;
+}
+
+struct bench_counter_values bench_counters_stop(struct bench_counters *counters)
+{
+	(void)counters;
+	return (struct bench_counter_values) { 0 };
+}
+
+void bench_counters_close(struct bench_counters *counters)
+{
+	(void)counters;
+}
+
+#endif
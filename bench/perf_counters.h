@@ -0,0 +1,79 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef DESCENT_XML_BENCH_PERF_COUNTERS
+#define DESCENT_XML_BENCH_PERF_COUNTERS
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * \file
+ *
+ * Hardware performance counters for the benchmarks, read through
+ * perf_event_open() on Linux. Each counter is opened on its own, so
+ * one the CPU or hypervisor doesn't provide doesn't take the others
+ * down with it, and counts are scaled up if the kernel had to
+ * multiplex them. Without Linux, or when perf_event_paranoid or a
+ * seccomp policy forbids it, no counters open and every value is
+ * reported as unavailable.
+ */
+
+enum bench_counter {
+	BENCH_COUNTER_INSTRUCTIONS,
+	BENCH_COUNTER_CYCLES,
+	BENCH_COUNTER_BRANCH_MISSES,
+	BENCH_COUNTER_L1D_MISSES,
+	BENCH_COUNTER_LLC_MISSES,
+	BENCH_COUNTER_COUNT,
+};
+
+/**
+ * \brief Short names for the counters, suitable as JSON keys.
+ */
+extern const char *const bench_counter_names[BENCH_COUNTER_COUNT];
+
+struct bench_counters {
+	int fds[BENCH_COUNTER_COUNT];
+};
+
+struct bench_counter_values {
+	uint64_t values[BENCH_COUNTER_COUNT];
+	bool valid[BENCH_COUNTER_COUNT];
+};
+
+/**
+ * \brief Opens whichever counters are available, for the calling
+ * 	thread in user space.
+ *
+ * \returns True if at least one counter opened.
+ */
+bool bench_counters_open(struct bench_counters *counters);
+
+/**
+ * \brief Resets the open counters and starts them.
+ */
+void bench_counters_start(struct bench_counters *counters);
+
+/**
+ * \brief Stops the open counters and reads them.
+ */
+struct bench_counter_values bench_counters_stop(struct bench_counters *counters);
+
+void bench_counters_close(struct bench_counters *counters);
+
+#endif // DESCENT_XML_BENCH_PERF_COUNTERS
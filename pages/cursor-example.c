@@ -0,0 +1,86 @@
+#include <libadt/str.h>
+#include <descent-xml.h>
+
+#include <stdio.h>
+#include <string.h>
+
+typedef struct descent_xml_cursor cursor_t;
+typedef struct libadt_const_lptr lptr_t;
+
+#define str libadt_str_literal
+
+#define init descent_xml_cursor_init
+#define child descent_xml_cursor_first_child
+#define sibling descent_xml_cursor_next_sibling
+#define text descent_xml_cursor_text
+#define failed descent_xml_cursor_failed
+
+#define XML \
+"<?xml version=\"1.0\" ?>\n" \
+"<library>\n" \
+"	<book type=\"non-fiction\">\n" \
+"		<title>The Pragmatic Programmer</title>\n" \
+"		<author>David Thomas</author>\n" \
+"		<author>Andrew Hunt</author>\n" \
+"	</book>\n" \
+"	<book type=\"fiction\">\n" \
+"		<title>Magician</title>\n" \
+"		<author>Raymond E. Feist</author>\n" \
+"	</book>\n" \
+"	<book type=\"non-fiction\">\n" \
+"		<title>Operating Systems Principles &amp; Practice Second Edition</title>\n" \
+"		<author>Thomas Anderson</author>\n" \
+"		<author>Michael Dahlin</author>\n" \
+"	</book>\n" \
+"	<book type=\"fiction\">\n" \
+"		<title>Stormbreaker</title>\n" \
+"		<author>Anthony Horowitz</author>\n" \
+"	</book>\n" \
+"</library>"
+
+static int equal(lptr_t a, const char *b)
+{
+	return a.length == (ssize_t)strlen(b)
+		&& memcmp(a.buffer, b, (size_t)a.length) == 0;
+}
+
+static int is_fiction(const cursor_t *cursor)
+{
+	const lptr_t *attributes = cursor->attributes.buffer;
+	for (ssize_t i = 0; i + 1 < cursor->attributes.length; i += 2) {
+		if (
+			equal(attributes[i], "type")
+			&& equal(attributes[i + 1], "fiction")
+		)
+			return 1;
+	}
+	return 0;
+}
+
+int main()
+{
+	cursor_t cursor;
+	init(&cursor, str(XML), NULL);
+
+	// Move down to <library>, then to its first <book>.
+	if (child(&cursor) && child(&cursor)) {
+		do {
+			// Books we don't want are skipped by moving on
+			// to the next one.
+			if (!is_fiction(&cursor) || !child(&cursor))
+				continue;
+
+			do {
+				lptr_t author;
+				if (equal(cursor.name, "author") && text(&cursor, &author))
+					printf("Author: %.*s\n", (int)author.length, (const char *)author.buffer);
+			} while (sibling(&cursor));
+			// When the book's children run out, the cursor is
+			// back on the book, past </book>.
+		} while (sibling(&cursor));
+	}
+
+	const int result = failed(&cursor);
+	descent_xml_cursor_free(&cursor);
+	return result;
+}
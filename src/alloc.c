@@ -0,0 +1,32 @@
+#include "descent-xml/alloc.h"
+
+void *descent_xml_allocate(
+	const struct descent_xml_allocator *allocator,
+	size_t size
+);
+void *descent_xml_allocate_zeroed(
+	const struct descent_xml_allocator *allocator,
+	size_t count,
+	size_t size
+);
+void *descent_xml_reallocate(
+	const struct descent_xml_allocator *allocator,
+	void *pointer,
+	size_t old_size,
+	size_t size
+);
+void descent_xml_release(
+	const struct descent_xml_allocator *allocator,
+	void *pointer,
+	size_t size
+);
+char *descent_xml_strndup(
+	const struct descent_xml_allocator *allocator,
+	const char *string,
+	size_t length
+);
+bool _descent_xml_vector_append(
+	const struct descent_xml_allocator *allocator,
+	struct libadt_vector *vector,
+	const void *value
+);
@@ -0,0 +1,457 @@
+#include "automaton.h"
+#include "descent-xml/validate.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// content models whose automaton would need more states than this are
+// rejected; deterministic models, which XML requires, need at most one
+// per name in the model plus one
+#define MAX_STATES 4096
+
+void _descent_xml_symbols_free(struct _descent_xml_symbols *symbols)
+{
+	free(symbols->names);
+	free(symbols->slots);
+}
+
+int64_t _descent_xml_symbols_find(
+	const struct _descent_xml_symbols *symbols,
+	struct libadt_const_lptr name
+)
+{
+	if (!symbols->slot_count)
+		return -1;
+
+	const size_t mask = symbols->slot_count - 1;
+	for (
+		size_t slot = _descent_xml_name_hash(name) & mask;
+		symbols->slots[slot];
+		slot = (slot + 1) & mask
+	) {
+		const uint32_t index = symbols->slots[slot] - 1;
+		if (libadt_const_lptr_equal(symbols->names[index], name))
+			return index;
+	}
+	return -1;
+}
+
+static bool symbols_rehash(struct _descent_xml_symbols *symbols, size_t slot_count)
+{
+	uint32_t *const slots = calloc(slot_count, sizeof(*slots));
+	if (!slots)
+		return false;
+
+	for (size_t i = 0; i < symbols->length; i++) {
+		size_t slot = _descent_xml_name_hash(symbols->names[i]) & (slot_count - 1);
+		while (slots[slot])
+			slot = (slot + 1) & (slot_count - 1);
+		slots[slot] = (uint32_t)(i + 1);
+	}
+
+	free(symbols->slots);
+	symbols->slots = slots;
+	symbols->slot_count = slot_count;
+	return true;
+}
+
+int64_t _descent_xml_symbols_intern(
+	struct _descent_xml_symbols *symbols,
+	struct libadt_const_lptr name
+)
+{
+	const int64_t found = _descent_xml_symbols_find(symbols, name);
+	if (found >= 0)
+		return found;
+
+	if (symbols->length == symbols->capacity) {
+		const size_t capacity = symbols->capacity
+			? symbols->capacity * 2
+			: 32;
+		struct libadt_const_lptr *const names = realloc(
+			symbols->names,
+			capacity * sizeof(*names)
+		);
+		if (!names)
+			return -1;
+		symbols->names = names;
+		symbols->capacity = capacity;
+	}
+
+	// keep the table at most half full
+	if ((symbols->length + 1) * 2 > symbols->slot_count) {
+		const size_t slot_count = symbols->slot_count
+			? symbols->slot_count * 2
+			: 64;
+		if (!symbols_rehash(symbols, slot_count))
+			return -1;
+	}
+
+	const size_t index = symbols->length++;
+	symbols->names[index] = name;
+	size_t slot = _descent_xml_name_hash(name) & (symbols->slot_count - 1);
+	while (symbols->slots[slot])
+		slot = (slot + 1) & (symbols->slot_count - 1);
+	symbols->slots[slot] = (uint32_t)(index + 1);
+	return (int64_t)index;
+}
+
+static int compare_symbols(const void *left_p, const void *right_p)
+{
+	const uint32_t left = *(const uint32_t *)left_p;
+	const uint32_t right = *(const uint32_t *)right_p;
+	return (left > right) - (left < right);
+}
+
+size_t _descent_xml_automaton_add(
+	struct _descent_xml_automaton_tree *tree,
+	enum _descent_xml_automaton_node_kind kind,
+	uint32_t symbol,
+	uint32_t tag
+)
+{
+	if (tree->length == tree->capacity) {
+		const size_t capacity = tree->capacity ? tree->capacity * 2 : 16;
+		struct _descent_xml_automaton_node *const nodes = realloc(
+			tree->nodes,
+			capacity * sizeof(*nodes)
+		);
+		if (!nodes)
+			return _DESCENT_XML_AUTOMATON_NONE;
+		tree->nodes = nodes;
+		tree->capacity = capacity;
+	}
+
+	tree->nodes[tree->length] = (struct _descent_xml_automaton_node) {
+		.kind = kind,
+		.symbol = symbol,
+		.tag = tag,
+		.position = kind == _DESCENT_XML_AUTOMATON_NAME
+			? tree->positions++
+			: _DESCENT_XML_AUTOMATON_NONE,
+		.child = _DESCENT_XML_AUTOMATON_NONE,
+		.sibling = _DESCENT_XML_AUTOMATON_NONE,
+	};
+	return tree->length++;
+}
+
+void _descent_xml_automaton_append(
+	struct _descent_xml_automaton_tree *tree,
+	size_t parent,
+	size_t child
+)
+{
+	size_t *link = &tree->nodes[parent].child;
+	while (*link != _DESCENT_XML_AUTOMATON_NONE)
+		link = &tree->nodes[*link].sibling;
+	*link = child;
+}
+
+ssize_t _descent_xml_automaton_find_symbol(
+	const struct _descent_xml_automaton *automaton,
+	uint32_t symbol
+)
+{
+	size_t low = 0, high = automaton->symbol_count;
+	while (low < high) {
+		const size_t middle = low + (high - low) / 2;
+		if (automaton->symbols[middle] < symbol)
+			low = middle + 1;
+		else if (automaton->symbols[middle] > symbol)
+			high = middle;
+		else
+			return (ssize_t)middle;
+	}
+	return -1;
+}
+
+int32_t _descent_xml_automaton_step(
+	const struct _descent_xml_automaton *automaton,
+	int32_t state,
+	uint32_t symbol
+)
+{
+	const ssize_t column = _descent_xml_automaton_find_symbol(automaton, symbol);
+	if (column < 0)
+		return -1;
+	return automaton->next[(size_t)state * automaton->symbol_count + (size_t)column];
+}
+
+void _descent_xml_automaton_free(struct _descent_xml_automaton *automaton)
+{
+	free(automaton->symbols);
+	free(automaton->next);
+	free(automaton->accept);
+	free(automaton->tags);
+}
+
+// Glushkov's construction: for every node, the positions (element
+// names in the model) that can start and end it, and for every
+// position, the ones that can follow it
+struct glushkov {
+	size_t words;
+	uint64_t *first;
+	uint64_t *last;
+	bool *nullable;
+	uint64_t *follow;
+};
+
+static uint64_t *bits(uint64_t *sets, size_t words, size_t index)
+{
+	return &sets[index * words];
+}
+
+static void set_union(uint64_t *into, const uint64_t *from, size_t words)
+{
+	for (size_t i = 0; i < words; i++)
+		into[i] |= from[i];
+}
+
+static bool has(const uint64_t *set, size_t bit)
+{
+	return set[bit / 64] >> (bit % 64) & 1;
+}
+
+static void follow_with(
+	struct glushkov *g,
+	const uint64_t *from,
+	const uint64_t *to,
+	size_t positions
+)
+{
+	for (size_t p = 0; p < positions; p++)
+		if (has(from, p))
+			set_union(bits(g->follow, g->words, p), to, g->words);
+}
+
+static void glushkov_node(
+	struct glushkov *g,
+	const struct _descent_xml_automaton_tree *tree,
+	size_t index
+)
+{
+	const struct _descent_xml_automaton_node *const node = &tree->nodes[index];
+	uint64_t *const first = bits(g->first, g->words, index);
+	uint64_t *const last = bits(g->last, g->words, index);
+
+	switch (node->kind) {
+		case _DESCENT_XML_AUTOMATON_NAME:
+			first[node->position / 64] |= 1ull << (node->position % 64);
+			last[node->position / 64] |= 1ull << (node->position % 64);
+			g->nullable[index] = false;
+			break;
+
+		case _DESCENT_XML_AUTOMATON_CHOICE:
+			g->nullable[index] = false;
+			for (size_t c = node->child; c != _DESCENT_XML_AUTOMATON_NONE; c = tree->nodes[c].sibling) {
+				glushkov_node(g, tree, c);
+				set_union(first, bits(g->first, g->words, c), g->words);
+				set_union(last, bits(g->last, g->words, c), g->words);
+				g->nullable[index] |= g->nullable[c];
+			}
+			break;
+
+		case _DESCENT_XML_AUTOMATON_SEQUENCE: {
+			// last holds the positions that can end the
+			// children seen so far
+			bool prefix_nullable = true;
+			for (size_t c = node->child; c != _DESCENT_XML_AUTOMATON_NONE; c = tree->nodes[c].sibling) {
+				glushkov_node(g, tree, c);
+				const uint64_t *const child_first
+					= bits(g->first, g->words, c);
+				const uint64_t *const child_last
+					= bits(g->last, g->words, c);
+
+				follow_with(g, last, child_first, tree->positions);
+				if (prefix_nullable)
+					set_union(first, child_first, g->words);
+				if (!g->nullable[c])
+					memset(last, 0, g->words * sizeof(*last));
+				set_union(last, child_last, g->words);
+				prefix_nullable &= g->nullable[c];
+			}
+			g->nullable[index] = prefix_nullable;
+			break;
+		}
+	}
+
+	if (node->repeat == '*' || node->repeat == '+')
+		follow_with(g, last, first, tree->positions);
+	if (node->repeat == '*' || node->repeat == '?')
+		g->nullable[index] = true;
+}
+
+static ssize_t find_state(
+	const uint64_t *states,
+	size_t state_count,
+	const uint64_t *set,
+	size_t words
+)
+{
+	for (size_t i = 0; i < state_count; i++)
+		if (memcmp(&states[i * words], set, words * sizeof(*set)) == 0)
+			return (ssize_t)i;
+	return -1;
+}
+
+// Subset construction over the Glushkov automaton. For the
+// deterministic models XML requires, every state is a single
+// position, so this is linear in the size of the model.
+bool _descent_xml_automaton_compile(
+	struct _descent_xml_automaton *model,
+	const struct _descent_xml_automaton_tree *tree,
+	size_t root
+)
+{
+	const size_t positions = tree->positions;
+	const size_t nodes = tree->length;
+	// one extra bit marks the initial state
+	const size_t words = (positions + 1 + 63) / 64;
+	const size_t initial = positions;
+
+	struct glushkov g = {
+		.words = words,
+		.first = calloc(nodes * words, sizeof(uint64_t)),
+		.last = calloc(nodes * words, sizeof(uint64_t)),
+		.nullable = calloc(nodes, sizeof(bool)),
+		.follow = calloc(positions * words + 1, sizeof(uint64_t)),
+	};
+	size_t *const position_symbol = malloc((positions + 1) * sizeof(size_t));
+	uint32_t *const position_tag = malloc((positions + 1) * sizeof(uint32_t));
+	uint64_t *const next = malloc(2 * words * sizeof(uint64_t));
+	uint64_t *states = NULL;
+	bool result = false;
+
+	if (!g.first || !g.last || !g.nullable || !g.follow || !position_symbol || !position_tag || !next)
+		goto done;
+
+	glushkov_node(&g, tree, root);
+
+	// the alphabet is the distinct names in the model
+	model->symbols = malloc((positions + 1) * sizeof(uint32_t));
+	if (!model->symbols)
+		goto done;
+	for (size_t i = 0; i < nodes; i++)
+		if (tree->nodes[i].kind == _DESCENT_XML_AUTOMATON_NAME)
+			model->symbols[tree->nodes[i].position] = tree->nodes[i].symbol;
+	qsort(model->symbols, positions, sizeof(uint32_t), compare_symbols);
+	model->symbol_count = 0;
+	for (size_t i = 0; i < positions; i++)
+		if (!model->symbol_count || model->symbols[model->symbol_count - 1] != model->symbols[i])
+			model->symbols[model->symbol_count++] = model->symbols[i];
+	for (size_t i = 0; i < nodes; i++) {
+		const struct _descent_xml_automaton_node *const node = &tree->nodes[i];
+		if (node->kind != _DESCENT_XML_AUTOMATON_NAME)
+			continue;
+		position_symbol[node->position]
+			= (size_t)_descent_xml_automaton_find_symbol(model, node->symbol);
+		position_tag[node->position] = node->tag;
+	}
+
+	size_t state_capacity = 16;
+	states = calloc(state_capacity * words, sizeof(uint64_t));
+	model->next = malloc(state_capacity * (model->symbol_count + 1) * sizeof(int32_t));
+	model->accept = malloc(state_capacity * sizeof(bool));
+	model->tags = malloc(state_capacity * sizeof(uint32_t));
+	if (!states || !model->next || !model->accept || !model->tags)
+		goto done;
+
+	states[initial / 64] |= 1ull << (initial % 64);
+	model->tags[0] = 0;
+	model->state_count = 1;
+
+	const uint64_t *const root_first = bits(g.first, words, root);
+	const uint64_t *const root_last = bits(g.last, words, root);
+	uint64_t *const target = next + words;
+
+	for (size_t state = 0; state < model->state_count; state++) {
+		const uint64_t *set = &states[state * words];
+
+		// everything that can come after this state
+		memset(next, 0, words * sizeof(*next));
+		if (has(set, initial))
+			set_union(next, root_first, words);
+		for (size_t p = 0; p < positions; p++)
+			if (has(set, p))
+				set_union(next, bits(g.follow, words, p), words);
+
+		bool accepting = has(set, initial) && g.nullable[root];
+		for (size_t w = 0; w < words; w++)
+			accepting |= (set[w] & root_last[w]) != 0;
+		model->accept[state] = accepting;
+
+		for (size_t symbol = 0; symbol < model->symbol_count; symbol++) {
+			memset(target, 0, words * sizeof(*target));
+			bool any = false;
+			uint32_t tag = 0;
+			for (size_t p = 0; p < positions; p++) {
+				if (!has(next, p) || position_symbol[p] != symbol)
+					continue;
+				// one symbol can't lead to two different particles
+				if (any && position_tag[p] != tag)
+					goto done;
+				target[p / 64] |= 1ull << (p % 64);
+				tag = position_tag[p];
+				any = true;
+			}
+
+			int32_t to = -1;
+			if (any) {
+				ssize_t found = find_state(states, model->state_count, target, words);
+				if (found < 0) {
+					if (model->state_count == MAX_STATES)
+						goto done;
+					if (model->state_count == state_capacity) {
+						state_capacity *= 2;
+						uint64_t *const grown_states = realloc(
+							states,
+							state_capacity * words * sizeof(uint64_t)
+						);
+						if (!grown_states)
+							goto done;
+						states = grown_states;
+						int32_t *const grown_next = realloc(
+							model->next,
+							state_capacity * (model->symbol_count + 1) * sizeof(int32_t)
+						);
+						if (!grown_next)
+							goto done;
+						model->next = grown_next;
+						bool *const grown_accept = realloc(
+							model->accept,
+							state_capacity * sizeof(bool)
+						);
+						if (!grown_accept)
+							goto done;
+						model->accept = grown_accept;
+						uint32_t *const grown_tags = realloc(
+							model->tags,
+							state_capacity * sizeof(uint32_t)
+						);
+						if (!grown_tags)
+							goto done;
+						model->tags = grown_tags;
+						set = &states[state * words];
+					}
+					found = (ssize_t)model->state_count++;
+					model->tags[found] = tag;
+					memcpy(&states[(size_t)found * words], target, words * sizeof(*target));
+				}
+				to = (int32_t)found;
+			}
+			model->next[state * model->symbol_count + symbol] = to;
+		}
+	}
+	result = true;
+
+done:
+	free(g.first);
+	free(g.last);
+	free(g.nullable);
+	free(g.follow);
+	free(position_symbol);
+	free(position_tag);
+	free(next);
+	free(states);
+	return result;
+}
@@ -0,0 +1,178 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef DESCENT_XML_AUTOMATON
+#define DESCENT_XML_AUTOMATON
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <libadt/lptr.h>
+
+/**
+ * \file
+ *
+ * Internal helpers shared by the DTD and schema validators: a name
+ * table, and content models compiled to deterministic automata. Not
+ * installed.
+ */
+
+#define _DESCENT_XML_AUTOMATON_NONE SIZE_MAX
+
+/**
+ * \brief Interns names, handing out dense ids in order of first
+ * 	appearance.
+ */
+struct _descent_xml_symbols {
+	struct libadt_const_lptr *names;
+	size_t length;
+	size_t capacity;
+
+	// open addressing, holding index + 1 of the name so zero is empty
+	uint32_t *slots;
+	size_t slot_count;
+};
+
+/**
+ * \returns The id of name, or -1 if it hasn't been interned.
+ */
+int64_t _descent_xml_symbols_find(
+	const struct _descent_xml_symbols *symbols,
+	struct libadt_const_lptr name
+);
+
+/**
+ * \returns The id of name, interning it if necessary, or -1 if memory
+ * 	couldn't be allocated. The name isn't copied.
+ */
+int64_t _descent_xml_symbols_intern(
+	struct _descent_xml_symbols *symbols,
+	struct libadt_const_lptr name
+);
+
+void _descent_xml_symbols_free(struct _descent_xml_symbols *symbols);
+
+enum _descent_xml_automaton_node_kind {
+	_DESCENT_XML_AUTOMATON_NAME,
+	_DESCENT_XML_AUTOMATON_SEQUENCE,
+	_DESCENT_XML_AUTOMATON_CHOICE,
+};
+
+/**
+ * \brief A node of a content model expression.
+ *
+ * Names are leaves; sequences and choices list their children
+ * through child and sibling. repeat is one of '\0', '?', '*' or '+'.
+ * tag is carried through to the states a name leads to, so callers
+ * can tell which particle matched.
+ */
+struct _descent_xml_automaton_node {
+	enum _descent_xml_automaton_node_kind kind;
+	char repeat;
+	uint32_t symbol;
+	uint32_t tag;
+	size_t position;
+	size_t child;
+	size_t sibling;
+};
+
+struct _descent_xml_automaton_tree {
+	struct _descent_xml_automaton_node *nodes;
+	size_t length;
+	size_t capacity;
+	size_t positions;
+};
+
+/**
+ * \brief Adds a node to a tree. Name nodes are given the next
+ * 	position, and child and sibling start out empty.
+ *
+ * \returns The new node's index, or _DESCENT_XML_AUTOMATON_NONE if
+ * 	memory couldn't be allocated.
+ */
+size_t _descent_xml_automaton_add(
+	struct _descent_xml_automaton_tree *tree,
+	enum _descent_xml_automaton_node_kind kind,
+	uint32_t symbol,
+	uint32_t tag
+);
+
+/**
+ * \brief Appends child to parent's list of children.
+ */
+void _descent_xml_automaton_append(
+	struct _descent_xml_automaton_tree *tree,
+	size_t parent,
+	size_t child
+);
+
+/**
+ * \brief A deterministic automaton over the symbols a content model
+ * 	mentions.
+ *
+ * symbols is sorted, so the column for a symbol is found with a
+ * binary search, and next has a row of symbol_count transitions per
+ * state, with -1 for no transition. State zero is the start state,
+ * and tags holds the tag of the name each state was entered on.
+ */
+struct _descent_xml_automaton {
+	uint32_t *symbols;
+	size_t symbol_count;
+	int32_t *next;
+	bool *accept;
+	uint32_t *tags;
+	size_t state_count;
+};
+
+/**
+ * \brief Compiles the expression rooted at root.
+ *
+ * \returns False if memory couldn't be allocated, if the automaton
+ * 	would be too large, or if the same symbol could lead to names
+ * 	with different tags from the same state.
+ */
+bool _descent_xml_automaton_compile(
+	struct _descent_xml_automaton *automaton,
+	const struct _descent_xml_automaton_tree *tree,
+	size_t root
+);
+
+/**
+ * \returns The column of symbol in the automaton, or -1 if the
+ * 	model doesn't mention it.
+ */
+ssize_t _descent_xml_automaton_find_symbol(
+	const struct _descent_xml_automaton *automaton,
+	uint32_t symbol
+);
+
+/**
+ * \returns The state reached from state on symbol, or -1 if there is
+ * 	no such transition.
+ */
+int32_t _descent_xml_automaton_step(
+	const struct _descent_xml_automaton *automaton,
+	int32_t state,
+	uint32_t symbol
+);
+
+void _descent_xml_automaton_free(struct _descent_xml_automaton *automaton);
+
+#endif // DESCENT_XML_AUTOMATON
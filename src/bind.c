@@ -0,0 +1,616 @@
+#include "descent-xml/bind.h"
+
+#include "descent-xml/classifier.h"
+#include "descent-xml/parse.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_FIELDS 64
+
+// the largest power of ten a double holds exactly
+#define MAX_EXACT_POWER 22
+
+struct frame {
+	const struct descent_xml_bind_record *record;
+	char *value;
+	uint64_t seen;
+	struct libadt_const_lptr text;
+	bool has_text;
+	bool error;
+	const struct descent_xml_allocator *allocator;
+};
+
+static bool end_token(struct descent_xml_lex token)
+{
+	return token.type == descent_xml_classifier_eof
+		|| token.type == descent_xml_classifier_unexpected
+		|| token.type == descent_xml_parse_error;
+}
+
+static bool is_space(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static bool is_blank(struct libadt_const_lptr text)
+{
+	const char *const s = text.buffer;
+	for (ssize_t i = 0; i < text.length; i++)
+		if (!is_space(s[i]))
+			return false;
+	return true;
+}
+
+static struct libadt_const_lptr trim(struct libadt_const_lptr text)
+{
+	const char *s = text.buffer;
+	while (text.length > 0 && is_space(*s)) {
+		s++;
+		text.length--;
+	}
+	while (text.length > 0 && is_space(s[text.length - 1]))
+		text.length--;
+	text.buffer = s;
+	return text;
+}
+
+static bool to_uint(struct libadt_const_lptr text, uint64_t *out)
+{
+	text = trim(text);
+	const char *const s = text.buffer;
+	ssize_t i = text.length > 0 && s[0] == '+';
+	if (i == text.length)
+		return false;
+	uint64_t value = 0;
+	for (; i < text.length; i++) {
+		const unsigned digit = (unsigned)(s[i] - '0');
+		if (digit > 9 || value > (UINT64_MAX - digit) / 10)
+			return false;
+		value = value * 10 + digit;
+	}
+	*out = value;
+	return true;
+}
+
+static bool to_int(struct libadt_const_lptr text, int64_t *out)
+{
+	text = trim(text);
+	const bool negative = text.length > 0 && *(const char *)text.buffer == '-';
+	if (negative) {
+		text = libadt_const_lptr_index(text, 1);
+		if (text.length > 0 && *(const char *)text.buffer == '+')
+			return false;
+	}
+	uint64_t magnitude;
+	if (!to_uint(text, &magnitude))
+		return false;
+	if (magnitude > (uint64_t)INT64_MAX + negative)
+		return false;
+	*out = negative ? (int64_t)(0 - magnitude) : (int64_t)magnitude;
+	return true;
+}
+
+static const double powers_of_ten[MAX_EXACT_POWER + 1] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+// Plain decimals whose digits fit in a double's mantissa, scaled by a
+// power of ten it holds exactly, convert with a single rounding, so
+// the result is the same as strtod()'s. Everything else, including
+// INF and NaN, is copied out and handed to strtod().
+static bool to_double(struct libadt_const_lptr text, double *out)
+{
+	text = trim(text);
+	const char *const s = text.buffer;
+	const ssize_t length = text.length;
+	if (length <= 0)
+		return false;
+
+	ssize_t i = 0;
+	const bool negative = s[0] == '-';
+	if (s[0] == '-' || s[0] == '+')
+		i++;
+
+	uint64_t mantissa = 0;
+	int digits = 0;
+	int exponent = 0;
+	bool any = false;
+	for (; i < length && (unsigned)(s[i] - '0') <= 9; i++, any = true) {
+		if (mantissa || s[i] != '0')
+			digits++;
+		mantissa = mantissa * 10 + (uint64_t)(s[i] - '0');
+	}
+	if (i < length && s[i] == '.') {
+		for (i++; i < length && (unsigned)(s[i] - '0') <= 9; i++, any = true) {
+			if (mantissa || s[i] != '0')
+				digits++;
+			mantissa = mantissa * 10 + (uint64_t)(s[i] - '0');
+			exponent--;
+		}
+	}
+	if (any && i < length && (s[i] == 'e' || s[i] == 'E')) {
+		ssize_t j = i + 1;
+		const bool negative_exponent = j < length && s[j] == '-';
+		if (j < length && (s[j] == '-' || s[j] == '+'))
+			j++;
+		int value = 0;
+		const ssize_t start = j;
+		for (; j < length && (unsigned)(s[j] - '0') <= 9 && value < 10000; j++)
+			value = value * 10 + (s[j] - '0');
+		if (j > start) {
+			exponent += negative_exponent ? -value : value;
+			i = j;
+		}
+	}
+
+	if (any && i == length && digits <= 19 && mantissa <= (UINT64_C(1) << 53)
+		&& exponent >= -MAX_EXACT_POWER && exponent <= MAX_EXACT_POWER) {
+		double value = (double)mantissa;
+		if (exponent < 0)
+			value /= powers_of_ten[-exponent];
+		else
+			value *= powers_of_ten[exponent];
+		*out = negative ? -value : value;
+		return true;
+	}
+
+	char buffer[128];
+	if ((size_t)length >= sizeof(buffer))
+		return false;
+	memcpy(buffer, s, (size_t)length);
+	buffer[length] = '\0';
+	char *end;
+	*out = strtod(buffer, &end);
+	return end == buffer + length;
+}
+
+static bool to_bool(struct libadt_const_lptr text, bool *out)
+{
+	text = trim(text);
+	const char *const s = text.buffer;
+	if ((text.length == 4 && memcmp(s, "true", 4) == 0) || (text.length == 1 && s[0] == '1'))
+		*out = true;
+	else if ((text.length == 5 && memcmp(s, "false", 5) == 0) || (text.length == 1 && s[0] == '0'))
+		*out = false;
+	else
+		return false;
+	return true;
+}
+
+static size_t type_size(const struct descent_xml_bind_field *field)
+{
+	switch (field->type) {
+	case DESCENT_XML_BIND_STRING:
+		return sizeof(struct libadt_const_lptr);
+	case DESCENT_XML_BIND_INT:
+		return sizeof(int64_t);
+	case DESCENT_XML_BIND_UINT:
+		return sizeof(uint64_t);
+	case DESCENT_XML_BIND_DOUBLE:
+		return sizeof(double);
+	case DESCENT_XML_BIND_BOOL:
+		return sizeof(bool);
+	case DESCENT_XML_BIND_RECORD:
+		return field->record->size;
+	}
+	return 0;
+}
+
+static bool convert(
+	const struct descent_xml_bind_field *field,
+	struct libadt_const_lptr text,
+	void *out
+)
+{
+	switch (field->type) {
+	case DESCENT_XML_BIND_STRING:
+		*(struct libadt_const_lptr *)out = text;
+		return true;
+	case DESCENT_XML_BIND_INT:
+		return to_int(text, out);
+	case DESCENT_XML_BIND_UINT:
+		return to_uint(text, out);
+	case DESCENT_XML_BIND_DOUBLE:
+		return to_double(text, out);
+	case DESCENT_XML_BIND_BOOL:
+		return to_bool(text, out);
+	case DESCENT_XML_BIND_RECORD:
+		break;
+	}
+	return false;
+}
+
+// Adds a zeroed entry to a repeated field. Arrays grow at powers of
+// two, so the count is all that needs keeping.
+static void *append(
+	char *value,
+	const struct descent_xml_bind_field *field,
+	const struct descent_xml_allocator *allocator
+)
+{
+	void **const array = (void **)(value + field->offset);
+	size_t *const count = (size_t *)(value + field->count_offset);
+	const size_t size = type_size(field);
+
+	if (!*count || (*count & (*count - 1)) == 0) {
+		void *const grown = descent_xml_reallocate(
+			allocator,
+			*array,
+			*count * size,
+			(*count ? *count * 2 : 1) * size
+		);
+		if (!grown)
+			return NULL;
+		*array = grown;
+	}
+	char *const entry = (char *)*array + *count * size;
+	memset(entry, 0, size);
+	++*count;
+	return entry;
+}
+
+static int find_field(
+	const struct descent_xml_bind_record *record,
+	enum descent_xml_bind_source source,
+	struct libadt_const_lptr name
+)
+{
+	for (size_t i = 0; i < record->field_count; i++) {
+		const struct descent_xml_bind_field *const field = &record->fields[i];
+		if (field->source == source
+			&& (ssize_t)field->name_length == name.length
+			&& memcmp(field->name, name.buffer, field->name_length) == 0)
+			return (int)i;
+	}
+	return -1;
+}
+
+static int find_text_field(const struct descent_xml_bind_record *record)
+{
+	for (size_t i = 0; i < record->field_count; i++)
+		if (record->fields[i].source == DESCENT_XML_BIND_FROM_TEXT)
+			return (int)i;
+	return -1;
+}
+
+// Text split up by comments or CDATA sections can't be pointed at as
+// one string, so only whitespace may surround the piece that's kept.
+static void collect_text(struct libadt_const_lptr text, bool is_cdata, void *context)
+{
+	struct frame *const frame = context;
+	if (!frame->has_text || (!is_cdata && is_blank(frame->text))) {
+		frame->text = text;
+		frame->has_text = true;
+	} else if (is_cdata || !is_blank(text)) {
+		frame->error = true;
+	}
+}
+
+// Parses the content of an element until its closing tag, and past
+// it.
+static struct descent_xml_lex content(
+	struct descent_xml_lex token,
+	struct libadt_const_lptr name,
+	descent_xml_parse_element_fn *element_handler,
+	descent_xml_parse_text_fn *text_handler,
+	struct frame *frame
+)
+{
+	while (token.type != descent_xml_classifier_element_close_name) {
+		if (frame->error || end_token(token)) {
+			frame->error = true;
+			return token;
+		}
+		token = descent_xml_parse_alloc(
+			token,
+			frame->allocator,
+			element_handler,
+			text_handler,
+			frame
+		);
+	}
+	if (!libadt_const_lptr_equal(token.value, name))
+		frame->error = true;
+	return descent_xml_parse(token, NULL, NULL, NULL);
+}
+
+static struct descent_xml_lex skip(
+	struct descent_xml_lex token,
+	struct libadt_const_lptr name,
+	struct libadt_const_lptr attributes,
+	bool empty,
+	void *context
+)
+{
+	(void)attributes;
+	struct frame *const parent = context;
+	if (empty)
+		return token;
+	struct frame frame = { .allocator = parent->allocator };
+	token = content(token, name, skip, NULL, &frame);
+	parent->error |= frame.error;
+	return token;
+}
+
+static descent_xml_parse_element_fn bind_child;
+
+// Fills in value from an element's attributes and content, leaving
+// the token past its closing tag.
+static struct descent_xml_lex bind_record(
+	struct descent_xml_lex token,
+	const struct descent_xml_bind_record *record,
+	struct libadt_const_lptr name,
+	struct libadt_const_lptr attributes,
+	bool empty,
+	void *value,
+	const struct descent_xml_allocator *allocator,
+	bool *error
+)
+{
+	struct frame frame = {
+		.record = record,
+		.value = value,
+		.allocator = allocator,
+	};
+	if (record->field_count > MAX_FIELDS) {
+		*error = true;
+		return token;
+	}
+
+	const struct libadt_const_lptr *const pairs = attributes.buffer;
+	for (ssize_t i = 0; i + 1 < attributes.length; i += 2) {
+		const int index = find_field(record, DESCENT_XML_BIND_FROM_ATTRIBUTE, pairs[i]);
+		if (index < 0)
+			continue;
+		const struct descent_xml_bind_field *const field = &record->fields[index];
+		if (!convert(field, pairs[i + 1], frame.value + field->offset)) {
+			*error = true;
+			return token;
+		}
+		frame.seen |= UINT64_C(1) << index;
+	}
+
+	const int text_index = find_text_field(record);
+	if (!empty)
+		token = content(
+			token,
+			name,
+			bind_child,
+			text_index < 0 ? NULL : collect_text,
+			&frame
+		);
+	if (frame.error) {
+		*error = true;
+		return token;
+	}
+
+	if (text_index >= 0 && frame.has_text) {
+		const struct descent_xml_bind_field *const field = &record->fields[text_index];
+		if (!convert(field, frame.text, frame.value + field->offset)) {
+			*error = true;
+			return token;
+		}
+		frame.seen |= UINT64_C(1) << text_index;
+	}
+
+	for (size_t i = 0; i < record->field_count; i++) {
+		if ((record->fields[i].flags & DESCENT_XML_BIND_REQUIRED)
+			&& !(frame.seen & (UINT64_C(1) << i))) {
+			*error = true;
+			break;
+		}
+	}
+	return token;
+}
+
+static struct descent_xml_lex bind_child(
+	struct descent_xml_lex token,
+	struct libadt_const_lptr name,
+	struct libadt_const_lptr attributes,
+	bool empty,
+	void *context
+)
+{
+	struct frame *const parent = context;
+	const int index = find_field(parent->record, DESCENT_XML_BIND_FROM_CHILD, name);
+	if (index < 0)
+		return skip(token, name, attributes, empty, parent);
+
+	const struct descent_xml_bind_field *const field = &parent->record->fields[index];
+	const uint64_t bit = UINT64_C(1) << index;
+	const bool repeated = field->flags & DESCENT_XML_BIND_REPEATED;
+	if (!repeated && (parent->seen & bit)) {
+		parent->error = true;
+		return token;
+	}
+	parent->seen |= bit;
+
+	void *target;
+	if (repeated) {
+		target = append(parent->value, field, parent->allocator);
+	} else if (field->type == DESCENT_XML_BIND_RECORD) {
+		target = descent_xml_allocate_zeroed(
+			parent->allocator,
+			1,
+			field->record->size
+		);
+		if (target)
+			*(void **)(parent->value + field->offset) = target;
+	} else {
+		target = parent->value + field->offset;
+	}
+	if (!target) {
+		parent->error = true;
+		return token;
+	}
+
+	if (field->type == DESCENT_XML_BIND_RECORD)
+		return bind_record(
+			token,
+			field->record,
+			name,
+			attributes,
+			empty,
+			target,
+			parent->allocator,
+			&parent->error
+		);
+
+	struct frame frame = { .allocator = parent->allocator };
+	if (!empty)
+		token = content(token, name, skip, collect_text, &frame);
+	const struct libadt_const_lptr text = frame.has_text
+		? frame.text
+		: (struct libadt_const_lptr) { .buffer = "", .size = 1, .length = 0 };
+	if (frame.error || !convert(field, text, target))
+		parent->error = true;
+	return token;
+}
+
+struct descent_xml_lex descent_xml_bind_element(
+	struct descent_xml_lex token,
+	struct libadt_const_lptr element_name,
+	struct libadt_const_lptr attributes,
+	bool empty,
+	void *context
+)
+{
+	struct descent_xml_bind_target *const target = context;
+	const struct descent_xml_bind_record *const record = target->record;
+	const bool matches = !target->bound
+		&& (ssize_t)record->name_length == element_name.length
+		&& memcmp(record->name, element_name.buffer, record->name_length) == 0;
+
+	if (!matches) {
+		struct frame frame = { .allocator = target->allocator };
+		token = skip(token, element_name, attributes, empty, &frame);
+		target->error |= frame.error;
+		return token;
+	}
+
+	target->bound = true;
+	return bind_record(
+		token,
+		record,
+		element_name,
+		attributes,
+		empty,
+		target->value,
+		target->allocator,
+		&target->error
+	);
+}
+
+// Binds the root element, which must be the record's element and
+// the only one.
+static struct descent_xml_lex bind_root(
+	struct descent_xml_lex token,
+	struct libadt_const_lptr element_name,
+	struct libadt_const_lptr attributes,
+	bool empty,
+	void *context
+)
+{
+	struct descent_xml_bind_target *const target = context;
+	const struct descent_xml_bind_record *const record = target->record;
+	if (target->bound
+		|| (ssize_t)record->name_length != element_name.length
+		|| memcmp(record->name, element_name.buffer, record->name_length) != 0) {
+		target->error = true;
+		return token;
+	}
+	return descent_xml_bind_element(token, element_name, attributes, empty, context);
+}
+
+bool descent_xml_bind_parse_alloc(
+	const struct descent_xml_bind_record *record,
+	struct libadt_const_lptr document,
+	void *value,
+	const struct descent_xml_allocator *allocator
+)
+{
+	memset(value, 0, record->size);
+	struct descent_xml_bind_target target = {
+		.record = record,
+		.value = value,
+		.allocator = allocator,
+	};
+
+	struct descent_xml_lex token = descent_xml_lex_init(document);
+	while (token.type != descent_xml_classifier_eof) {
+		if (target.error || end_token(token)) {
+			descent_xml_bind_free_alloc(record, value, allocator);
+			return false;
+		}
+		token = descent_xml_parse_alloc(token, allocator, bind_root, NULL, &target);
+	}
+	if (!target.bound || target.error) {
+		descent_xml_bind_free_alloc(record, value, allocator);
+		return false;
+	}
+	return true;
+}
+
+bool descent_xml_bind_parse(
+	const struct descent_xml_bind_record *record,
+	struct libadt_const_lptr document,
+	void *value
+)
+{
+	return descent_xml_bind_parse_alloc(record, document, value, NULL);
+}
+
+// Repeated fields grow at powers of two.
+static size_t capacity_of(size_t count)
+{
+	size_t capacity = 1;
+	while (capacity < count)
+		capacity *= 2;
+	return count ? capacity : 0;
+}
+
+void descent_xml_bind_free_alloc(
+	const struct descent_xml_bind_record *record,
+	void *value,
+	const struct descent_xml_allocator *allocator
+)
+{
+	if (!value)
+		return;
+	char *const base = value;
+	for (size_t i = 0; i < record->field_count; i++) {
+		const struct descent_xml_bind_field *const field = &record->fields[i];
+		if (field->flags & DESCENT_XML_BIND_REPEATED) {
+			char *const array = *(char **)(base + field->offset);
+			const size_t count = *(size_t *)(base + field->count_offset);
+			if (field->type == DESCENT_XML_BIND_RECORD)
+				for (size_t j = 0; j < count; j++)
+					descent_xml_bind_free_alloc(
+						field->record,
+						array + j * field->record->size,
+						allocator
+					);
+			descent_xml_release(
+				allocator,
+				array,
+				capacity_of(count) * type_size(field)
+			);
+		} else if (field->type == DESCENT_XML_BIND_RECORD) {
+			void *const child = *(void **)(base + field->offset);
+			descent_xml_bind_free_alloc(field->record, child, allocator);
+			descent_xml_release(allocator, child, field->record->size);
+		}
+	}
+	memset(value, 0, record->size);
+}
+
+void descent_xml_bind_free(
+	const struct descent_xml_bind_record *record,
+	void *value
+)
+{
+	descent_xml_bind_free_alloc(record, value, NULL);
+}
@@ -0,0 +1,170 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef DESCENT_XML_CCLASS
+#define DESCENT_XML_CCLASS
+
+#include <stdbool.h>
+#include <wchar.h>
+#include <wctype.h>
+
+/**
+ * \file
+ *
+ * Internal character classes, shared by the classifier states and the
+ * lexer engine. Not installed.
+ */
+
+// https://www.w3.org/TR/REC-xml/#sec-documents
+
+// character classes
+typedef enum {
+	CCLASS_UNKNOWN = -1,
+	// zero so that unlisted entries of ascii_cclass are text
+	CCLASS_TEXT = 0,
+	CCLASS_EOF,
+	CCLASS_NAME_START,
+	CCLASS_NAME,
+	CCLASS_SPACE,
+	CCLASS_EQUALS = '=',
+	CCLASS_HASH = '#',
+	CCLASS_OBRACKET = '<',
+	CCLASS_CBRACKET = '>',
+	CCLASS_DQUOTE = '"',
+	CCLASS_SQUOTE = '\'',
+	CCLASS_REF_START = '%',
+	CCLASS_ENTITY_START = '&',
+	CCLASS_ENTITY_END = ';',
+	CCLASS_EMARK = '!',
+	CCLASS_DASH = '-',
+	CCLASS_QMARK = '?',
+	CCLASS_SLASH = '/',
+} CHARACTER_CLASS;
+
+// The classes of the ASCII characters, as the slow path below would
+// work them out.
+static const signed char ascii_cclass[128] = {
+	[0] = CCLASS_EOF,
+	['\t'] = CCLASS_SPACE, ['\n'] = CCLASS_SPACE,
+	['\r'] = CCLASS_SPACE, [' '] = CCLASS_SPACE,
+	['!'] = CCLASS_EMARK, ['"'] = CCLASS_DQUOTE, ['#'] = CCLASS_HASH,
+	['%'] = CCLASS_REF_START, ['&'] = CCLASS_ENTITY_START,
+	['\''] = CCLASS_SQUOTE, ['-'] = CCLASS_DASH, ['.'] = CCLASS_NAME,
+	['/'] = CCLASS_SLASH,
+	['0'] = CCLASS_NAME, ['1'] = CCLASS_NAME, ['2'] = CCLASS_NAME,
+	['3'] = CCLASS_NAME, ['4'] = CCLASS_NAME, ['5'] = CCLASS_NAME,
+	['6'] = CCLASS_NAME, ['7'] = CCLASS_NAME, ['8'] = CCLASS_NAME,
+	['9'] = CCLASS_NAME,
+	[':'] = CCLASS_NAME_START, [';'] = CCLASS_ENTITY_END,
+	['<'] = CCLASS_OBRACKET, ['='] = CCLASS_EQUALS,
+	['>'] = CCLASS_CBRACKET, ['?'] = CCLASS_QMARK,
+	['A'] = CCLASS_NAME_START, ['B'] = CCLASS_NAME_START,
+	['C'] = CCLASS_NAME_START, ['D'] = CCLASS_NAME_START,
+	['E'] = CCLASS_NAME_START, ['F'] = CCLASS_NAME_START,
+	['G'] = CCLASS_NAME_START, ['H'] = CCLASS_NAME_START,
+	['I'] = CCLASS_NAME_START, ['J'] = CCLASS_NAME_START,
+	['K'] = CCLASS_NAME_START, ['L'] = CCLASS_NAME_START,
+	['M'] = CCLASS_NAME_START, ['N'] = CCLASS_NAME_START,
+	['O'] = CCLASS_NAME_START, ['P'] = CCLASS_NAME_START,
+	['Q'] = CCLASS_NAME_START, ['R'] = CCLASS_NAME_START,
+	['S'] = CCLASS_NAME_START, ['T'] = CCLASS_NAME_START,
+	['U'] = CCLASS_NAME_START, ['V'] = CCLASS_NAME_START,
+	['W'] = CCLASS_NAME_START, ['X'] = CCLASS_NAME_START,
+	['Y'] = CCLASS_NAME_START, ['Z'] = CCLASS_NAME_START,
+	['_'] = CCLASS_NAME_START,
+	['a'] = CCLASS_NAME_START, ['b'] = CCLASS_NAME_START,
+	['c'] = CCLASS_NAME_START, ['d'] = CCLASS_NAME_START,
+	['e'] = CCLASS_NAME_START, ['f'] = CCLASS_NAME_START,
+	['g'] = CCLASS_NAME_START, ['h'] = CCLASS_NAME_START,
+	['i'] = CCLASS_NAME_START, ['j'] = CCLASS_NAME_START,
+	['k'] = CCLASS_NAME_START, ['l'] = CCLASS_NAME_START,
+	['m'] = CCLASS_NAME_START, ['n'] = CCLASS_NAME_START,
+	['o'] = CCLASS_NAME_START, ['p'] = CCLASS_NAME_START,
+	['q'] = CCLASS_NAME_START, ['r'] = CCLASS_NAME_START,
+	['s'] = CCLASS_NAME_START, ['t'] = CCLASS_NAME_START,
+	['u'] = CCLASS_NAME_START, ['v'] = CCLASS_NAME_START,
+	['w'] = CCLASS_NAME_START, ['x'] = CCLASS_NAME_START,
+	['y'] = CCLASS_NAME_START, ['z'] = CCLASS_NAME_START,
+};
+
+static inline bool in(const wchar_t c, const wchar_t *set)
+{
+	for (; *set; set++)
+		if (c == *set)
+			return true;
+	return false;
+}
+
+static inline bool between(const wchar_t start, const wchar_t c, const wchar_t end)
+{
+	return start <= c
+		&& c <= end;
+}
+
+static inline CHARACTER_CLASS get_cclass(wchar_t c)
+{
+	if (c >= 0 && c < 128)
+		return ascii_cclass[c];
+
+	if (in(c, L"<>'\"&#=;!-%/?"))
+		return c;
+
+	const bool is_name_start
+		= in(c, L":_")
+		|| iswalpha((wint_t)c)
+		// I don't know what these numbers mean,
+		// but they're in the spec
+		// [#xC0-#xD6] | [#xD8-#xF6] | [#xF8-#x2FF] | [#x370-#x37D] | [#x37F-#x1FFF] | [#x200C-#x200D] | [#x2070-#x218F] | [#x2C00-#x2FEF] | [#x3001-#xD7FF] | [#xF900-#xFDCF] | [#xFDF0-#xFFFD] | [#x10000-#xEFFFF]
+		|| between(0xC0, c, 0xD6)
+		|| between(0xD8, c, 0xF6)
+		|| between(0xF8, c, 0x2FF)
+		|| between(0x370, c, 0x37D)
+		|| between(0x37F, c, 0x1FFF)
+		|| between(0x200C, c, 0x200D)
+		|| between(0x2070, c, 0x218F)
+		|| between(0x2C00, c, 0x2FEF)
+		|| between(0x3001, c, 0xD7FF)
+		|| between(0xF900, c, 0xFDCF)
+		|| between(0xFDF0, c, 0xFFFD)
+		|| between(0x10000, c, 0xEFFFF);
+
+	if (is_name_start)
+		return CCLASS_NAME_START;
+
+	const bool is_name
+		= c == '.'
+		|| iswdigit((wint_t)c)
+		// more magic numbers
+		// #xB7 | [#x0300-#x036F] | [#x203F-#x2040]
+		|| c == 0xB7
+		|| between(0x300, c, 0x36F)
+		|| between(0x203F, c, 0x2040);
+
+	if (is_name)
+		return CCLASS_NAME;
+
+	if (in(c, L" \t\r\n"))
+		return CCLASS_SPACE;
+
+	if (c == (wchar_t)WEOF || c == 0)
+		return CCLASS_EOF;
+
+	return CCLASS_TEXT;
+}
+
+#endif // DESCENT_XML_CCLASS
@@ -0,0 +1,578 @@
+#include "descent-xml/chars.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "descent-xml/cpu.h"
+
+bool descent_xml_chars_valid(struct libadt_const_lptr script);
+
+// Returns the length of the character at s if it's a well-formed
+// UTF-8 sequence for an XML Char, or zero otherwise.
+static size_t char_length(const unsigned char *s, size_t available)
+{
+	const unsigned c = s[0];
+	if (c < 0x80)
+		return c >= 0x20 || c == '\t' || c == '\n' || c == '\r';
+	if (c < 0xc2)
+		return 0;
+	if (c < 0xe0)
+		return available >= 2 && (s[1] & 0xc0) == 0x80 ? 2 : 0;
+	if (c < 0xf0) {
+		if (available < 3 || (s[1] & 0xc0) != 0x80 || (s[2] & 0xc0) != 0x80)
+			return 0;
+		// overlong forms, surrogates, and U+FFFE and U+FFFF
+		if ((c == 0xe0 && s[1] < 0xa0)
+			|| (c == 0xed && s[1] >= 0xa0)
+			|| (c == 0xef && s[1] == 0xbf && s[2] >= 0xbe))
+			return 0;
+		return 3;
+	}
+	if (c < 0xf5) {
+		if (available < 4
+			|| (s[1] & 0xc0) != 0x80
+			|| (s[2] & 0xc0) != 0x80
+			|| (s[3] & 0xc0) != 0x80)
+			return 0;
+		// overlong forms, and code points past U+10FFFF
+		if ((c == 0xf0 && s[1] < 0x90) || (c == 0xf4 && s[1] >= 0x90))
+			return 0;
+		return 4;
+	}
+	return 0;
+}
+
+// Checks characters one at a time from i until at least end, which
+// may finish a few bytes past it if a sequence straddles it. Returns
+// the offset reached, or the offset of a bad character negated and
+// less one.
+static ptrdiff_t check_scalar(
+	const unsigned char *s,
+	size_t i,
+	size_t end,
+	size_t length
+)
+{
+	while (i < end) {
+		const size_t n = char_length(s + i, length - i);
+		if (!n)
+			return -(ptrdiff_t)i - 1;
+		i += n;
+	}
+	return (ptrdiff_t)i;
+}
+
+// The block kernels. Each returns a mask of the non-ASCII bytes in a
+// block, and sets bad to a mask of the ASCII control characters other
+// than tab, line feed and carriage return; only whether the masks are
+// zero matters.
+
+#define ONES (UINT64_MAX / 255)
+
+static uint64_t check_block_word(const unsigned char *s, uint64_t *bad)
+{
+	uint64_t word;
+	memcpy(&word, s, sizeof(word));
+	const uint64_t high = word & (ONES * 0x80);
+
+	// flags bytes below 0x20 in an all-ASCII word, with no false
+	// negatives; which bytes are set is left to the scalar path
+	*bad = (word - ONES * 0x20) & ~word & (ONES * 0x80);
+	return high;
+}
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define X86_KERNELS
+
+#include <immintrin.h>
+
+__attribute__((target("sse2")))
+static uint64_t check_block_sse2(const unsigned char *s, uint64_t *bad)
+{
+	const __m128i bytes = _mm_loadu_si128((const __m128i *)s);
+	const unsigned high = (unsigned)_mm_movemask_epi8(bytes);
+
+	// signed, so non-ASCII bytes count as below 0x20 too, and are
+	// masked off with high
+	const __m128i below = _mm_cmplt_epi8(bytes, _mm_set1_epi8(0x20));
+	const __m128i allowed = _mm_or_si128(
+		_mm_or_si128(
+			_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\t')),
+			_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n'))
+		),
+		_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\r'))
+	);
+	*bad = (unsigned)_mm_movemask_epi8(_mm_andnot_si128(allowed, below)) & ~high;
+	return high;
+}
+
+__attribute__((target("avx2")))
+static uint64_t check_block_avx2(const unsigned char *s, uint64_t *bad)
+{
+	const __m256i bytes = _mm256_loadu_si256((const __m256i *)s);
+	const uint32_t high = (uint32_t)_mm256_movemask_epi8(bytes);
+
+	// AVX2 only compares for greater than; signed again
+	const __m256i below = _mm256_cmpgt_epi8(_mm256_set1_epi8(0x20), bytes);
+	const __m256i allowed = _mm256_or_si256(
+		_mm256_or_si256(
+			_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\t')),
+			_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\n'))
+		),
+		_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\r'))
+	);
+	*bad = (uint32_t)_mm256_movemask_epi8(_mm256_andnot_si256(allowed, below)) & ~high;
+	return high;
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static uint64_t check_block_avx512(const unsigned char *s, uint64_t *bad)
+{
+	const __m512i bytes = _mm512_loadu_si512((const void *)s);
+	const __mmask64 high = _mm512_movepi8_mask(bytes);
+
+	const __mmask64 below = _mm512_cmplt_epi8_mask(bytes, _mm512_set1_epi8(0x20));
+	const __mmask64 allowed
+		= _mm512_cmpeq_epi8_mask(bytes, _mm512_set1_epi8('\t'))
+		| _mm512_cmpeq_epi8_mask(bytes, _mm512_set1_epi8('\n'))
+		| _mm512_cmpeq_epi8_mask(bytes, _mm512_set1_epi8('\r'));
+	*bad = below & ~allowed & ~high;
+	return high;
+}
+
+// The UTF-8 kernels, for blocks with non-ASCII bytes in them, follow
+// the lookup method of simdutf (Keiser and Lemire, "Validating UTF-8
+// In Less Than One Instruction Per Byte"). Each byte is looked at
+// with the one before it: the high and low nibbles of the first and
+// the high nibble of the second index three 16-entry tables of error
+// classes, and a class set in all three is an error. The byte shuffles
+// this needs come with SSSE3, so the SSE2 and word kernels still
+// decode multi-byte sequences one at a time.
+
+#define TOO_SHORT (1 << 0) // a lead byte, then ASCII or another lead
+#define TOO_LONG (1 << 1) // ASCII, then a continuation byte
+#define OVERLONG_3 (1 << 2) // E0, then 80 to 9F
+#define TOO_LARGE (1 << 3) // F4, then 90 to BF, or F5 and up
+#define SURROGATE (1 << 4) // ED, then A0 to BF
+#define OVERLONG_2 (1 << 5) // C0 or C1
+#define TOO_LARGE_1000 (1 << 6) // F5 and up, then 80 to 8F
+#define OVERLONG_4 (1 << 6) // F0, then 80 to 8F
+// two continuation bytes, an error unless they're the third or fourth
+// byte of a sequence
+#define TWO_CONTS (1 << 7)
+#define CARRY (TOO_SHORT | TOO_LONG | TWO_CONTS)
+
+static const unsigned char first_high[16] = {
+	TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+	TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+	TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+	TOO_SHORT | OVERLONG_2,
+	TOO_SHORT,
+	TOO_SHORT | OVERLONG_3 | SURROGATE,
+	TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4,
+};
+
+static const unsigned char first_low[16] = {
+	CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4,
+	CARRY | OVERLONG_2,
+	CARRY,
+	CARRY,
+	CARRY | TOO_LARGE,
+	CARRY | TOO_LARGE | TOO_LARGE_1000,
+	CARRY | TOO_LARGE | TOO_LARGE_1000,
+	CARRY | TOO_LARGE | TOO_LARGE_1000,
+	CARRY | TOO_LARGE | TOO_LARGE_1000,
+	CARRY | TOO_LARGE | TOO_LARGE_1000,
+	CARRY | TOO_LARGE | TOO_LARGE_1000,
+	CARRY | TOO_LARGE | TOO_LARGE_1000,
+	CARRY | TOO_LARGE | TOO_LARGE_1000,
+	CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,
+	CARRY | TOO_LARGE | TOO_LARGE_1000,
+	CARRY | TOO_LARGE | TOO_LARGE_1000,
+};
+
+static const unsigned char second_high[16] = {
+	TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+	TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+	TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4,
+	TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+	TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+	TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+	TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+};
+
+// Each returns a mask of the bytes in a block at which a bad character
+// is found, which may have started up to three bytes earlier, in the
+// block *prev holds. Then it sets *prev to this block. Besides
+// malformed UTF-8, this finds U+FFFE and U+FFFF, EF BF BE and EF BF
+// BF; the controls are left to check_block_*().
+
+__attribute__((target("avx2")))
+static __m256i lookup_avx2(const unsigned char table[16], __m256i nibbles)
+{
+	const __m128i entries = _mm_loadu_si128((const __m128i *)table);
+	return _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(entries), nibbles);
+}
+
+__attribute__((target("avx2")))
+static uint64_t utf8_block_avx2(const unsigned char *s, __m256i *prev)
+{
+	const __m256i input = _mm256_loadu_si256((const __m256i *)s);
+	// the last 16 bytes of the block before, then the first 16 of
+	// this one, for the shifts across the middle of the block
+	const __m256i straddle = _mm256_permute2x128_si256(*prev, input, 0x21);
+	const __m256i prev1 = _mm256_alignr_epi8(input, straddle, 15);
+	const __m256i prev2 = _mm256_alignr_epi8(input, straddle, 14);
+	const __m256i prev3 = _mm256_alignr_epi8(input, straddle, 13);
+	*prev = input;
+
+	const __m256i nibble = _mm256_set1_epi8(0x0f);
+	const __m256i special = _mm256_and_si256(
+		_mm256_and_si256(
+			lookup_avx2(first_high, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble)),
+			lookup_avx2(first_low, _mm256_and_si256(prev1, nibble))
+		),
+		lookup_avx2(second_high, _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble))
+	);
+	// only bytes two after E0 and up, or three after F0 and up, come
+	// out with the high bit set
+	const __m256i continuation = _mm256_or_si256(
+		_mm256_subs_epu8(prev2, _mm256_set1_epi8((char)(0xe0 - 0x80))),
+		_mm256_subs_epu8(prev3, _mm256_set1_epi8((char)(0xf0 - 0x80)))
+	);
+	const __m256i utf8 = _mm256_xor_si256(
+		_mm256_and_si256(continuation, _mm256_set1_epi8((char)0x80)),
+		special
+	);
+	const __m256i nonchar = _mm256_and_si256(
+		_mm256_and_si256(
+			_mm256_cmpeq_epi8(prev2, _mm256_set1_epi8((char)0xef)),
+			_mm256_cmpeq_epi8(prev1, _mm256_set1_epi8((char)0xbf))
+		),
+		_mm256_cmpeq_epi8(_mm256_max_epu8(input, _mm256_set1_epi8((char)0xbe)), input)
+	);
+
+	const uint32_t good = (uint32_t)_mm256_movemask_epi8(
+		_mm256_cmpeq_epi8(utf8, _mm256_setzero_si256())
+	);
+	return (uint32_t)~good | (uint32_t)_mm256_movemask_epi8(nonchar);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static __m512i lookup_avx512(const unsigned char table[16], __m512i nibbles)
+{
+	const __m128i entries = _mm_loadu_si128((const __m128i *)table);
+	return _mm512_shuffle_epi8(_mm512_broadcast_i32x4(entries), nibbles);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static uint64_t utf8_block_avx512(const unsigned char *s, __m512i *prev)
+{
+	const __m512i input = _mm512_loadu_si512((const void *)s);
+	// each 16-byte lane of this block moved up by one, with the last
+	// lane of the block before first
+	const __m512i straddle = _mm512_permutex2var_epi64(
+		*prev,
+		_mm512_setr_epi64(6, 7, 8, 9, 10, 11, 12, 13),
+		input
+	);
+	const __m512i prev1 = _mm512_alignr_epi8(input, straddle, 15);
+	const __m512i prev2 = _mm512_alignr_epi8(input, straddle, 14);
+	const __m512i prev3 = _mm512_alignr_epi8(input, straddle, 13);
+	*prev = input;
+
+	const __m512i nibble = _mm512_set1_epi8(0x0f);
+	const __m512i special = _mm512_and_si512(
+		_mm512_and_si512(
+			lookup_avx512(first_high, _mm512_and_si512(_mm512_srli_epi16(prev1, 4), nibble)),
+			lookup_avx512(first_low, _mm512_and_si512(prev1, nibble))
+		),
+		lookup_avx512(second_high, _mm512_and_si512(_mm512_srli_epi16(input, 4), nibble))
+	);
+	const __m512i continuation = _mm512_or_si512(
+		_mm512_subs_epu8(prev2, _mm512_set1_epi8((char)(0xe0 - 0x80))),
+		_mm512_subs_epu8(prev3, _mm512_set1_epi8((char)(0xf0 - 0x80)))
+	);
+	const __m512i utf8 = _mm512_xor_si512(
+		_mm512_and_si512(continuation, _mm512_set1_epi8((char)0x80)),
+		special
+	);
+	const __mmask64 nonchar
+		= _mm512_cmpeq_epi8_mask(prev2, _mm512_set1_epi8((char)0xef))
+		& _mm512_cmpeq_epi8_mask(prev1, _mm512_set1_epi8((char)0xbf))
+		& _mm512_cmpge_epu8_mask(input, _mm512_set1_epi8((char)0xbe));
+
+	return _mm512_test_epi8_mask(utf8, utf8) | nonchar;
+}
+
+#endif
+
+// The offset of the first byte of the character that runs across end,
+// or end if none does, given that everything before end is well-formed
+// so far.
+static size_t sequence_start(const unsigned char *s, size_t end)
+{
+	if (end >= 1 && s[end - 1] >= 0xc0)
+		return end - 1;
+	if (end >= 2 && s[end - 2] >= 0xe0)
+		return end - 2;
+	if (end >= 3 && s[end - 3] >= 0xf0)
+		return end - 3;
+	return end;
+}
+
+// Defines a whole-script check from a block kernel, compiled with the
+// kernel's target so it can be inlined. If the script is padded and
+// the kernel's masks have a bit per byte, the tail is checked with
+// one more block, ignoring the bytes past the end.
+#define CHECK(name, block, check_block, bit_per_byte, ...) \
+	__VA_ARGS__ \
+	static size_t name(const unsigned char *s, size_t length, bool padded) \
+	{ \
+		size_t i = 0; \
+		while (length - i >= (block)) { \
+			uint64_t bad; \
+			const uint64_t high = check_block(s + i, &bad); \
+			if (!high && !bad) { \
+				i += (block); \
+				continue; \
+			} \
+			/* the scalar path finds exactly which byte is bad, */ \
+			/* and decodes any multi-byte sequences */ \
+			const ptrdiff_t reached \
+				= check_scalar(s, i, i + (block), length); \
+			if (reached < 0) \
+				return (size_t)(-reached - 1); \
+			i = (size_t)reached; \
+		} \
+		if ((bit_per_byte) && padded && i < length) { \
+			uint64_t bad; \
+			const uint64_t high = check_block(s + i, &bad); \
+			const uint64_t tail = (UINT64_C(1) << (length - i)) - 1; \
+			if (!((high | bad) & tail)) \
+				return length; \
+		} \
+		const ptrdiff_t reached = check_scalar(s, i, length, length); \
+		if (reached < 0) \
+			return (size_t)(-reached - 1); \
+		return length; \
+	}
+
+// Defines a whole-script check from a block kernel and a UTF-8 kernel
+// of the same width, as CHECK() does. ASCII blocks only go through the
+// block kernel; the others go through the UTF-8 kernel, with the block
+// before kept for the sequences running across the two. The scalar
+// path only runs to find which byte of a bad block is at fault, and
+// for the tail of an unpadded script.
+#define CHECK_UTF8(name, block, vector, zero, check_block, utf8_block, ...) \
+	__VA_ARGS__ \
+	static size_t name(const unsigned char *s, size_t length, bool padded) \
+	{ \
+		size_t i = 0; \
+		vector prev = zero(); \
+		bool straddles = false; \
+		while (length - i >= (block)) { \
+			uint64_t bad; \
+			if (!check_block(s + i, &bad) && !bad && !straddles) { \
+				prev = zero(); \
+				i += (block); \
+				continue; \
+			} \
+			if (!(utf8_block(s + i, &prev) | bad)) { \
+				i += (block); \
+				straddles = sequence_start(s, i) != i; \
+				continue; \
+			} \
+			const ptrdiff_t reached = check_scalar( \
+				s, \
+				sequence_start(s, i), \
+				i + (block), \
+				length \
+			); \
+			if (reached < 0) \
+				return (size_t)(-reached - 1); \
+			/* it stopped between characters, so nothing runs on */ \
+			i = (size_t)reached; \
+			prev = zero(); \
+			straddles = false; \
+		} \
+		if (padded && i < length) { \
+			uint64_t bad; \
+			check_block(s + i, &bad); \
+			const uint64_t tail = (UINT64_C(1) << (length - i)) - 1; \
+			if ( \
+				!((utf8_block(s + i, &prev) | bad) & tail) \
+				&& sequence_start(s, length) == length \
+			) \
+				return length; \
+		} \
+		const ptrdiff_t reached \
+			= check_scalar(s, sequence_start(s, i), length, length); \
+		if (reached < 0) \
+			return (size_t)(-reached - 1); \
+		return length; \
+	}
+
+// the word kernel's tail is under 8 bytes, and its masks have a bit
+// per byte only on little-endian machines, so it never over-reads
+CHECK(check_word, 8, check_block_word, false)
+#ifdef X86_KERNELS
+CHECK(check_sse2, 16, check_block_sse2, true, __attribute__((target("sse2"))))
+CHECK_UTF8(check_avx2, 32, __m256i, _mm256_setzero_si256, check_block_avx2, utf8_block_avx2, __attribute__((target("avx2"))))
+CHECK_UTF8(check_avx512, 64, __m512i, _mm512_setzero_si512, check_block_avx512, utf8_block_avx512, __attribute__((target("avx512f,avx512bw"))))
+#endif
+
+static size_t (*const checks[DESCENT_XML_SIMD_COUNT])(const unsigned char *, size_t, bool) = {
+	[DESCENT_XML_SIMD_SCALAR] = check_word,
+#ifdef X86_KERNELS
+	[DESCENT_XML_SIMD_SSE2] = check_sse2,
+	[DESCENT_XML_SIMD_AVX2] = check_avx2,
+	[DESCENT_XML_SIMD_AVX512] = check_avx512,
+#endif
+};
+
+size_t descent_xml_chars_check(struct libadt_const_lptr script)
+{
+	const size_t length = script.length > 0 ? (size_t)script.length : 0;
+	return checks[_descent_xml_simd_current()](script.buffer, length, false);
+}
+
+size_t descent_xml_chars_check_padded(struct libadt_const_lptr script)
+{
+	const size_t length = script.length > 0 ? (size_t)script.length : 0;
+	return checks[_descent_xml_simd_current()](script.buffer, length, true);
+}
+
+// The space kernels. Each returns a mask of the bytes in a block that
+// aren't XML whitespace, with the bits in the order of the bytes.
+
+static bool is_space(unsigned char c)
+{
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+// sets the high bit of each byte of word equal to c, and only those
+static uint64_t equal_bytes(uint64_t word, unsigned char c)
+{
+	const uint64_t x = word ^ (ONES * c);
+	return ~(((x & ONES * 0x7f) + ONES * 0x7f) | x) & (ONES * 0x80);
+}
+
+static uint64_t space_block_word(const unsigned char *s)
+{
+	uint64_t word;
+	memcpy(&word, s, sizeof(word));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	word = __builtin_bswap64(word);
+#endif
+	const uint64_t space = equal_bytes(word, ' ')
+		| equal_bytes(word, '\t')
+		| equal_bytes(word, '\n')
+		| equal_bytes(word, '\r');
+	return ~space & (ONES * 0x80);
+}
+
+#ifdef X86_KERNELS
+
+__attribute__((target("sse2")))
+static uint64_t space_block_sse2(const unsigned char *s)
+{
+	const __m128i bytes = _mm_loadu_si128((const __m128i *)s);
+	const __m128i space = _mm_or_si128(
+		_mm_or_si128(
+			_mm_cmpeq_epi8(bytes, _mm_set1_epi8(' ')),
+			_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\t'))
+		),
+		_mm_or_si128(
+			_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n')),
+			_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\r'))
+		)
+	);
+	return ~(unsigned)_mm_movemask_epi8(space) & 0xffff;
+}
+
+__attribute__((target("avx2")))
+static uint64_t space_block_avx2(const unsigned char *s)
+{
+	const __m256i bytes = _mm256_loadu_si256((const __m256i *)s);
+	const __m256i space = _mm256_or_si256(
+		_mm256_or_si256(
+			_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(' ')),
+			_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\t'))
+		),
+		_mm256_or_si256(
+			_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\n')),
+			_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\r'))
+		)
+	);
+	return (uint32_t)~_mm256_movemask_epi8(space);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static uint64_t space_block_avx512(const unsigned char *s)
+{
+	const __m512i bytes = _mm512_loadu_si512((const void *)s);
+	return ~(
+		_mm512_cmpeq_epi8_mask(bytes, _mm512_set1_epi8(' '))
+		| _mm512_cmpeq_epi8_mask(bytes, _mm512_set1_epi8('\t'))
+		| _mm512_cmpeq_epi8_mask(bytes, _mm512_set1_epi8('\n'))
+		| _mm512_cmpeq_epi8_mask(bytes, _mm512_set1_epi8('\r'))
+	);
+}
+
+#endif
+
+// the index of the lowest set bit of a non-zero mask
+static unsigned lowest_bit(uint64_t mask)
+{
+#ifdef __GNUC__
+	return (unsigned)__builtin_ctzll(mask);
+#else
+	unsigned bit = 0;
+	while (!(mask & 1)) {
+		mask >>= 1;
+		bit++;
+	}
+	return bit;
+#endif
+}
+
+// Defines a whitespace count from a space kernel, as CHECK() does.
+// The word kernel marks the high bit of each byte, so bits_per_byte
+// is 8 for it and 1 for the others.
+#define SPACES(name, block, space_block, bits_per_byte, ...) \
+	__VA_ARGS__ \
+	static size_t name(const unsigned char *s, size_t length) \
+	{ \
+		size_t i = 0; \
+		for (; length - i >= (block); i += (block)) { \
+			const uint64_t other = space_block(s + i); \
+			if (other) \
+				return i + lowest_bit(other) / (bits_per_byte); \
+		} \
+		while (i < length && is_space(s[i])) \
+			i++; \
+		return i; \
+	}
+
+SPACES(spaces_word, 8, space_block_word, 8)
+#ifdef X86_KERNELS
+SPACES(spaces_sse2, 16, space_block_sse2, 1, __attribute__((target("sse2"))))
+SPACES(spaces_avx2, 32, space_block_avx2, 1, __attribute__((target("avx2"))))
+SPACES(spaces_avx512, 64, space_block_avx512, 1, __attribute__((target("avx512f,avx512bw"))))
+#endif
+
+static size_t (*const spaces[DESCENT_XML_SIMD_COUNT])(const unsigned char *, size_t) = {
+	[DESCENT_XML_SIMD_SCALAR] = spaces_word,
+#ifdef X86_KERNELS
+	[DESCENT_XML_SIMD_SSE2] = spaces_sse2,
+	[DESCENT_XML_SIMD_AVX2] = spaces_avx2,
+	[DESCENT_XML_SIMD_AVX512] = spaces_avx512,
+#endif
+};
+
+size_t descent_xml_chars_spaces(struct libadt_const_lptr script)
+{
+	const size_t length = script.length > 0 ? (size_t)script.length : 0;
+	return spaces[_descent_xml_simd_current()](script.buffer, length);
+}
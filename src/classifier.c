@@ -1,9 +1,10 @@
 #include "descent-xml/classifier.h"
 
-#include <wctype.h>
 #include <stdbool.h>
 #include <stdlib.h>
 
+#include "cclass.h"
+
 // https://www.w3.org/TR/REC-xml/#sec-documents
 
 typedef descent_xml_classifier_fn cfn;
@@ -39,91 +40,6 @@ static vfn *eof_impl(wchar_t c)
 cfn *const descent_xml_classifier_unexpected = unexpected_impl;
 cfn *const descent_xml_classifier_eof = eof_impl;
 
-// character classes
-typedef enum {
-	CCLASS_UNKNOWN = -1,
-	CCLASS_EOF = 0,
-	CCLASS_NAME_START,
-	CCLASS_NAME,
-	CCLASS_SPACE,
-	CCLASS_TEXT,
-	CCLASS_EQUALS = '=',
-	CCLASS_HASH = '#',
-	CCLASS_OBRACKET = '<',
-	CCLASS_CBRACKET = '>',
-	CCLASS_DQUOTE = '"',
-	CCLASS_SQUOTE = '\'',
-	CCLASS_REF_START = '%',
-	CCLASS_ENTITY_START = '&',
-	CCLASS_ENTITY_END = ';',
-	CCLASS_EMARK = '!',
-	CCLASS_DASH = '-',
-	CCLASS_QMARK = '?',
-	CCLASS_SLASH = '/',
-} CHARACTER_CLASS;
-
-static bool in(const wchar_t c, const wchar_t *set)
-{
-	for (; *set; set++)
-		if (c == *set)
-			return true;
-	return false;
-}
-
-static bool between(const wchar_t start, const wchar_t c, const wchar_t end)
-{
-	return start <= c
-		&& c <= end;
-}
-
-static CHARACTER_CLASS get_cclass(wchar_t c)
-{
-	if (in(c, L"<>'\"&#=;!-%/?"))
-		return c;
-
-	const bool is_name_start
-		= in(c, L":_")
-		|| iswalpha((wint_t)c)
-		// I don't know what these numbers mean,
-		// but they're in the spec
-		// [#xC0-#xD6] | [#xD8-#xF6] | [#xF8-#x2FF] | [#x370-#x37D] | [#x37F-#x1FFF] | [#x200C-#x200D] | [#x2070-#x218F] | [#x2C00-#x2FEF] | [#x3001-#xD7FF] | [#xF900-#xFDCF] | [#xFDF0-#xFFFD] | [#x10000-#xEFFFF]
-		|| between(0xC0, c, 0xD6)
-		|| between(0xD8, c, 0xF6)
-		|| between(0xF8, c, 0x2FF)
-		|| between(0x370, c, 0x37D)
-		|| between(0x37F, c, 0x1FFF)
-		|| between(0x200C, c, 0x200D)
-		|| between(0x2070, c, 0x218F)
-		|| between(0x2C00, c, 0x2FEF)
-		|| between(0x3001, c, 0xD7FF)
-		|| between(0xF900, c, 0xFDCF)
-		|| between(0xFDF0, c, 0xFFFD)
-		|| between(0x10000, c, 0xEFFFF);
-
-	if (is_name_start)
-		return CCLASS_NAME_START;
-
-	const bool is_name
-		= c == '.'
-		|| iswdigit((wint_t)c)
-		// more magic numbers
-		// #xB7 | [#x0300-#x036F] | [#x203F-#x2040]
-		|| c == 0xB7
-		|| between(0x300, c, 0x36F)
-		|| between(0x203F, c, 0x2040);
-
-	if (is_name)
-		return CCLASS_NAME;
-
-	if (in(c, L" \t\r\n"))
-		return CCLASS_SPACE;
-
-	if (c == (wchar_t)WEOF || c == 0)
-		return CCLASS_EOF;
-
-	return CCLASS_TEXT;
-}
-
 static cfn *entity_start(wchar_t input, cfn *cont)
 {
 	switch (get_cclass(input)) {
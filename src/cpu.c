@@ -0,0 +1,78 @@
+#include "descent-xml/cpu.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum descent_xml_simd _descent_xml_simd_current(void);
+enum descent_xml_simd descent_xml_simd_level(void);
+
+// the level in use, or -1 until it's been picked
+int _descent_xml_simd = -1;
+
+static enum descent_xml_simd supported;
+
+static const char *const names[DESCENT_XML_SIMD_COUNT] = {
+	[DESCENT_XML_SIMD_SCALAR] = "scalar",
+	[DESCENT_XML_SIMD_SSE2] = "sse2",
+	[DESCENT_XML_SIMD_AVX2] = "avx2",
+	[DESCENT_XML_SIMD_AVX512] = "avx512",
+};
+
+static enum descent_xml_simd detect(void)
+{
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+	// these check that the OS saves the wider registers too
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512bw"))
+		return DESCENT_XML_SIMD_AVX512;
+	if (__builtin_cpu_supports("avx2"))
+		return DESCENT_XML_SIMD_AVX2;
+	if (__builtin_cpu_supports("sse2"))
+		return DESCENT_XML_SIMD_SSE2;
+#endif
+	return DESCENT_XML_SIMD_SCALAR;
+}
+
+static void pick(void)
+{
+	supported = detect();
+	enum descent_xml_simd level = supported;
+
+	const char *const wanted = getenv("DESCENT_XML_SIMD");
+	for (int i = 0; wanted && i < DESCENT_XML_SIMD_COUNT; i++)
+		if (strcmp(wanted, names[i]) == 0 && (enum descent_xml_simd)i < level)
+			level = (enum descent_xml_simd)i;
+
+	__atomic_store_n(&_descent_xml_simd, (int)level, __ATOMIC_RELAXED);
+}
+
+static pthread_once_t once = PTHREAD_ONCE_INIT;
+
+int _descent_xml_simd_init(void)
+{
+	pthread_once(&once, pick);
+	return __atomic_load_n(&_descent_xml_simd, __ATOMIC_RELAXED);
+}
+
+enum descent_xml_simd descent_xml_simd_supported(void)
+{
+	pthread_once(&once, pick);
+	return supported;
+}
+
+enum descent_xml_simd descent_xml_simd_set_level(enum descent_xml_simd level)
+{
+	pthread_once(&once, pick);
+	if (level > supported)
+		level = supported;
+	__atomic_store_n(&_descent_xml_simd, (int)level, __ATOMIC_RELAXED);
+	return level;
+}
+
+const char *descent_xml_simd_name(enum descent_xml_simd level)
+{
+	if ((unsigned)level >= DESCENT_XML_SIMD_COUNT)
+		return NULL;
+	return names[level];
+}
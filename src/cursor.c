@@ -0,0 +1,308 @@
+#include "descent-xml/cursor.h"
+
+#include <stdbool.h>
+
+bool descent_xml_cursor_failed(const struct descent_xml_cursor *cursor);
+
+enum event {
+	EVENT_ELEMENT,
+	EVENT_CLOSE,
+	EVENT_TEXT,
+	EVENT_END,
+	EVENT_FAILED,
+};
+
+static struct libadt_const_lptr no_attributes(const struct descent_xml_cursor *cursor)
+{
+	return (struct libadt_const_lptr) {
+		.buffer = cursor->attribute_buffer.buffer,
+		.size = sizeof(struct libadt_const_lptr),
+		.length = 0,
+	};
+}
+
+static struct descent_xml_lex fail(struct descent_xml_lex token)
+{
+	if (token.type != descent_xml_parse_error)
+		token.type = descent_xml_classifier_unexpected;
+	return token;
+}
+
+// Reads on to the next start tag, closing tag, text or the end of the
+// document, keeping the stack of open elements up to date. The
+// attributes of start tags are only stored if collect is set; the
+// cursor's name and empty members are set either way.
+static enum event next(
+	struct descent_xml_cursor *cursor,
+	bool collect,
+	struct libadt_const_lptr *text
+)
+{
+	struct descent_xml_lex token = cursor->token;
+	for (;;) {
+		token = descent_xml_lex_next_raw(token);
+
+		if (token.type == descent_xml_classifier_element_name) {
+			const struct libadt_const_lptr name = token.value;
+			if (collect)
+				cursor->attribute_buffer.length = 0;
+			token = _descent_xml_read_attributes(
+				descent_xml_lex_next_raw(token),
+				cursor->allocator,
+				collect ? &cursor->attribute_buffer : NULL
+			);
+
+			const bool empty
+				= token.type == descent_xml_classifier_element_empty;
+			if (!empty && token.type != descent_xml_classifier_element_end) {
+				token = fail(token);
+				break;
+			}
+			if (!empty && !_descent_xml_vector_append(
+				cursor->allocator,
+				&cursor->open,
+				&name
+			)) {
+				token.type = descent_xml_parse_error;
+				break;
+			}
+
+			cursor->token = token;
+			cursor->name = name;
+			cursor->empty = empty;
+			if (collect) {
+				cursor->attributes = no_attributes(cursor);
+				cursor->attributes.length
+					= (ssize_t)cursor->attribute_buffer.length;
+			}
+			return EVENT_ELEMENT;
+		}
+
+		if (token.type == descent_xml_classifier_element_close_name) {
+			struct libadt_vector *const open = &cursor->open;
+			const struct libadt_const_lptr *const names = open->buffer;
+			if (
+				open->length == 0
+				|| !libadt_const_lptr_equal(token.value, names[open->length - 1])
+			) {
+				token.type = descent_xml_validate_error;
+				break;
+			}
+			open->length--;
+
+			cursor->token = token;
+			cursor->name = token.value;
+			cursor->empty = false;
+			return EVENT_CLOSE;
+		}
+
+		if (_descent_xml_is_text_type(token)) {
+			const _descent_xml_value_t value = _descent_xml_text_value(token);
+			cursor->token = value.token;
+			*text = value.value;
+			return EVENT_TEXT;
+		}
+
+		if (token.type == descent_xml_lex_cdata) {
+			*text = _descent_xml_cdata_value(token);
+			cursor->token = token;
+			return EVENT_TEXT;
+		}
+
+		if (token.type == descent_xml_classifier_eof) {
+			// an element was left open
+			if (cursor->open.length) {
+				token.type = descent_xml_validate_error;
+				break;
+			}
+			cursor->token = token;
+			return EVENT_END;
+		}
+
+		if (
+			token.type == descent_xml_classifier_unexpected
+			|| token.type == descent_xml_parse_error
+		)
+			break;
+	}
+
+	cursor->token = token;
+	return EVENT_FAILED;
+}
+
+// Moves past the rest of the current element's content, to just after
+// its closing tag, or to the end of the document at depth 0. If text
+// isn't a NULL pointer, it's set to the first text directly inside.
+static bool read_content(
+	struct descent_xml_cursor *cursor,
+	struct libadt_const_lptr *text
+)
+{
+	const size_t inside = cursor->open.length;
+	bool found = false;
+	cursor->has_content = false;
+
+	for (;;) {
+		struct libadt_const_lptr value;
+		switch (next(cursor, false, &value)) {
+			case EVENT_ELEMENT:
+				continue;
+			case EVENT_TEXT:
+				if (text && !found && cursor->open.length == inside) {
+					*text = value;
+					found = true;
+				}
+				continue;
+			case EVENT_CLOSE:
+				if (cursor->depth && cursor->open.length < inside)
+					return true;
+				continue;
+			case EVENT_END:
+				cursor->name = libadt_const_lptr_truncate(cursor->name, 0);
+				return true;
+			case EVENT_FAILED:
+				return false;
+		}
+	}
+}
+
+// Called once the parent's closing tag has been read, or the end of
+// the document.
+static void move_up(struct descent_xml_cursor *cursor)
+{
+	cursor->depth--;
+	cursor->has_content = false;
+	cursor->empty = false;
+	cursor->attributes = no_attributes(cursor);
+	if (cursor->depth == 0)
+		cursor->name = libadt_const_lptr_truncate(cursor->name, 0);
+}
+
+static bool next_sibling(struct descent_xml_cursor *cursor, bool collect)
+{
+	if (descent_xml_cursor_failed(cursor) || cursor->depth == 0)
+		return false;
+	if (cursor->has_content && !read_content(cursor, NULL))
+		return false;
+
+	for (;;) {
+		struct libadt_const_lptr text;
+		switch (next(cursor, collect, &text)) {
+			case EVENT_ELEMENT:
+				cursor->has_content = !cursor->empty;
+				return true;
+			case EVENT_TEXT:
+				continue;
+			case EVENT_CLOSE:
+			case EVENT_END:
+				move_up(cursor);
+				return false;
+			case EVENT_FAILED:
+				return false;
+		}
+	}
+}
+
+void descent_xml_cursor_init(
+	struct descent_xml_cursor *cursor,
+	struct libadt_const_lptr script,
+	const struct descent_xml_allocator *allocator
+)
+{
+	*cursor = (struct descent_xml_cursor) {
+		.token = descent_xml_lex_init(script),
+		.name = libadt_const_lptr_truncate(script, 0),
+		.attributes = {
+			.size = sizeof(struct libadt_const_lptr),
+		},
+		.has_content = true,
+		.open = {
+			.element_size = sizeof(struct libadt_const_lptr),
+		},
+		.attribute_buffer = {
+			.element_size = sizeof(struct libadt_const_lptr),
+		},
+		.allocator = allocator,
+	};
+}
+
+void descent_xml_cursor_free(struct descent_xml_cursor *cursor)
+{
+	struct libadt_vector *const vectors[] = {
+		&cursor->open,
+		&cursor->attribute_buffer,
+	};
+	for (size_t i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++) {
+		descent_xml_release(
+			cursor->allocator,
+			vectors[i]->buffer,
+			vectors[i]->capacity * vectors[i]->element_size
+		);
+		vectors[i]->buffer = NULL;
+		vectors[i]->length = vectors[i]->capacity = 0;
+	}
+	cursor->attributes = no_attributes(cursor);
+}
+
+bool descent_xml_cursor_first_child(struct descent_xml_cursor *cursor)
+{
+	if (descent_xml_cursor_failed(cursor) || !cursor->has_content)
+		return false;
+
+	for (;;) {
+		struct libadt_const_lptr text;
+		switch (next(cursor, true, &text)) {
+			case EVENT_ELEMENT:
+				cursor->depth++;
+				cursor->has_content = !cursor->empty;
+				return true;
+			case EVENT_TEXT:
+				continue;
+			case EVENT_CLOSE:
+			case EVENT_END:
+				// no child elements; still on the same element
+				cursor->has_content = false;
+				return false;
+			case EVENT_FAILED:
+				return false;
+		}
+	}
+}
+
+bool descent_xml_cursor_next_sibling(struct descent_xml_cursor *cursor)
+{
+	return next_sibling(cursor, true);
+}
+
+bool descent_xml_cursor_parent_end(struct descent_xml_cursor *cursor)
+{
+	if (descent_xml_cursor_failed(cursor) || cursor->depth == 0)
+		return false;
+	while (next_sibling(cursor, false))
+		;
+	return !descent_xml_cursor_failed(cursor);
+}
+
+bool descent_xml_cursor_skip(struct descent_xml_cursor *cursor)
+{
+	if (descent_xml_cursor_failed(cursor))
+		return false;
+	if (!cursor->has_content)
+		return true;
+	return read_content(cursor, NULL);
+}
+
+bool descent_xml_cursor_text(
+	struct descent_xml_cursor *cursor,
+	struct libadt_const_lptr *text
+)
+{
+	*text = libadt_const_lptr_truncate(cursor->name, 0);
+	if (descent_xml_cursor_failed(cursor))
+		return false;
+	if (cursor->empty)
+		return true;
+	if (!cursor->has_content)
+		return false;
+	return read_content(cursor, text);
+}
@@ -23,9 +23,23 @@
 extern "C" {
 #endif
 
+#include "descent-xml/alloc.h"
+#include "descent-xml/bind.h"
+#include "descent-xml/chars.h"
 #include "descent-xml/classifier.h"
+#include "descent-xml/cpu.h"
+#include "descent-xml/cursor.h"
+#include "descent-xml/dtd.h"
 #include "descent-xml/lex.h"
 #include "descent-xml/parse.h"
+#include "descent-xml/parser.h"
+#include "descent-xml/pipeline.h"
+#include "descent-xml/read.h"
+#include "descent-xml/schema.h"
+#include "descent-xml/stats.h"
+#include "descent-xml/text.h"
+#include "descent-xml/token.h"
+#include "descent-xml/trace.h"
 #include "descent-xml/validate.h"
 
 #ifdef __cplusplus
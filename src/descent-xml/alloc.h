@@ -0,0 +1,242 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef DESCENT_XML_ALLOC
+#define DESCENT_XML_ALLOC
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <libadt/vector.h>
+
+/**
+ * \file
+ *
+ * Routing the memory the parser allocates to an allocator of the
+ * application's choosing, such as an arena reset after each message.
+ *
+ * Everything that allocates while a document is being read takes an
+ * allocator: descent_xml_parse_alloc(), descent_xml_parse_cstr_alloc(),
+ * descent_xml_validate_document_alloc(), descent_xml_bind_parse_alloc(),
+ * and the `allocator` member of the validators. A NULL pointer means
+ * malloc(), realloc() and free(), and is what the functions without an
+ * allocator pass.
+ *
+ * Compiling a DTD or schema, reading files, the pipeline and parsers
+ * generated by descent-xml-gen still use malloc(), as they aren't done
+ * per document or have their own ways of reusing memory.
+ *
+ * The sizes of blocks are passed back when they're resized or released,
+ * so an arena doesn't have to record them. Every block is released
+ * before the call that allocated it returns, apart from the bound
+ * structs from descent_xml_bind_parse_alloc() and a validator's stack;
+ * an arena can also just be reset once they're no longer needed.
+ */
+
+/**
+ * \brief A set of allocation functions, and a pointer passed to them.
+ */
+struct descent_xml_allocator {
+	/**
+	 * \brief Allocates size bytes, suitably aligned for any type.
+	 *
+	 * \returns The block, or a NULL pointer on failure.
+	 */
+	void *(*allocate)(void *context, size_t size);
+
+	/**
+	 * \brief Resizes a block from allocate(), keeping its contents
+	 * 	up to the smaller of the two sizes.
+	 *
+	 * \param pointer The block, or a NULL pointer to allocate a new
+	 * 	one, in which case old_size is zero.
+	 *
+	 * \returns The resized block, or a NULL pointer on failure, in
+	 * 	which case the old block is left alone.
+	 */
+	void *(*reallocate)(
+		void *context,
+		void *pointer,
+		size_t old_size,
+		size_t size
+	);
+
+	/**
+	 * \brief Releases a block from allocate() or reallocate().
+	 * 	Can be a NULL pointer if blocks are never released one
+	 * 	at a time.
+	 *
+	 * \param pointer The block, or a NULL pointer, which should be
+	 * 	ignored.
+	 */
+	void (*release)(void *context, void *pointer, size_t size);
+
+	/**
+	 * \brief Passed to each of the functions.
+	 */
+	void *context;
+};
+
+/**
+ * \brief Allocates size bytes.
+ *
+ * \param allocator The allocator, or a NULL pointer for malloc().
+ */
+inline void *descent_xml_allocate(
+	const struct descent_xml_allocator *allocator,
+	size_t size
+)
+{
+	if (!allocator)
+		return malloc(size);
+	return allocator->allocate(allocator->context, size);
+}
+
+/**
+ * \brief Allocates zeroed space for count objects of size bytes.
+ *
+ * \param allocator The allocator, or a NULL pointer for calloc().
+ */
+inline void *descent_xml_allocate_zeroed(
+	const struct descent_xml_allocator *allocator,
+	size_t count,
+	size_t size
+)
+{
+	if (!allocator)
+		return calloc(count, size);
+	if (size && count > SIZE_MAX / size)
+		return NULL;
+	void *const result = allocator->allocate(allocator->context, count * size);
+	if (result)
+		memset(result, 0, count * size);
+	return result;
+}
+
+/**
+ * \brief Resizes a block from old_size to size bytes.
+ *
+ * \param allocator The allocator, or a NULL pointer for realloc().
+ */
+inline void *descent_xml_reallocate(
+	const struct descent_xml_allocator *allocator,
+	void *pointer,
+	size_t old_size,
+	size_t size
+)
+{
+	if (!allocator)
+		return realloc(pointer, size);
+	return allocator->reallocate(allocator->context, pointer, old_size, size);
+}
+
+/**
+ * \brief Releases a block of size bytes.
+ *
+ * \param allocator The allocator, or a NULL pointer for free().
+ */
+inline void descent_xml_release(
+	const struct descent_xml_allocator *allocator,
+	void *pointer,
+	size_t size
+)
+{
+	if (!allocator)
+		free(pointer);
+	else if (allocator->release)
+		allocator->release(allocator->context, pointer, size);
+}
+
+/**
+ * \brief Copies at most length bytes of a string into a new,
+ * 	null-terminated block, like strndup().
+ *
+ * Release the copy with descent_xml_release(), passing the string's
+ * length plus one.
+ *
+ * \param allocator The allocator, or a NULL pointer for strndup().
+ */
+inline char *descent_xml_strndup(
+	const struct descent_xml_allocator *allocator,
+	const char *string,
+	size_t length
+)
+{
+	if (!allocator)
+		return strndup(string, length);
+
+	const char *const end = memchr(string, '\0', length);
+	if (end)
+		length = (size_t)(end - string);
+	char *const result = allocator->allocate(allocator->context, length + 1);
+	if (!result)
+		return NULL;
+	memcpy(result, string, length);
+	result[length] = '\0';
+	return result;
+}
+
+/**
+ * \brief Appends an element to a vector, growing it with an allocator.
+ *
+ * This is libadt_vector_append() for vectors whose buffer came from
+ * allocator; release the buffer with descent_xml_release(), passing
+ * capacity * element_size.
+ *
+ * \returns True on success, false if the vector couldn't grow, in
+ * 	which case it's left alone.
+ */
+inline bool _descent_xml_vector_append(
+	const struct descent_xml_allocator *allocator,
+	struct libadt_vector *vector,
+	const void *value
+)
+{
+	if (vector->length == vector->capacity) {
+		const size_t capacity = vector->capacity ? vector->capacity * 2 : 8;
+		void *const buffer = descent_xml_reallocate(
+			allocator,
+			vector->buffer,
+			vector->capacity * vector->element_size,
+			capacity * vector->element_size
+		);
+		if (!buffer)
+			return false;
+		vector->buffer = buffer;
+		vector->capacity = capacity;
+	}
+	memcpy(
+		(char *)vector->buffer + vector->length * vector->element_size,
+		value,
+		vector->element_size
+	);
+	vector->length++;
+	return true;
+}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // DESCENT_XML_ALLOC
@@ -0,0 +1,409 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef DESCENT_XML_BIND
+#define DESCENT_XML_BIND
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <libadt/lptr.h>
+
+#include "alloc.h"
+#include "lex.h"
+
+/**
+ * \file
+ *
+ * Filling in C structs from a document, driven by tables describing
+ * where each attribute and child element goes.
+ *
+ * Each kind of element is described by a descent_xml_bind_record,
+ * listing its fields: which attribute, child element or text the
+ * field is read from, what type it is, and its offset in the struct.
+ * The tables are plain constant data, so they can be static and
+ * shared between threads:
+ *
+ * ```c
+ * struct item {
+ * 	struct libadt_const_lptr sku;
+ * 	uint64_t quantity;
+ * 	double price;
+ * };
+ *
+ * static const struct descent_xml_bind_field item_fields[] = {
+ * 	DESCENT_XML_BIND_ATTRIBUTE(struct item, sku, "sku", DESCENT_XML_BIND_STRING, DESCENT_XML_BIND_REQUIRED),
+ * 	DESCENT_XML_BIND_ATTRIBUTE(struct item, quantity, "quantity", DESCENT_XML_BIND_UINT, 0),
+ * 	DESCENT_XML_BIND_TEXT(struct item, price, DESCENT_XML_BIND_DOUBLE, 0),
+ * };
+ * static const struct descent_xml_bind_record item_record
+ * 	= DESCENT_XML_BIND_RECORD_INIT("item", struct item, item_fields);
+ * ```
+ *
+ * Numbers are converted straight from the document, without copying
+ * them into null-terminated strings first. Strings point into the
+ * document, so it has to outlive the result, and entities in them
+ * aren't replaced. Attributes and child elements that no field
+ * mentions are skipped.
+ *
+ * For parsers compiled from a description ahead of time, see the
+ * descent-xml-gen tool.
+ */
+
+/**
+ * \brief The type of a field, and so of the struct member it's
+ * 	stored in.
+ */
+enum descent_xml_bind_type {
+	/**
+	 * \brief A `struct libadt_const_lptr` pointing into the document.
+	 */
+	DESCENT_XML_BIND_STRING,
+	/**
+	 * \brief An `int64_t`.
+	 */
+	DESCENT_XML_BIND_INT,
+	/**
+	 * \brief A `uint64_t`.
+	 */
+	DESCENT_XML_BIND_UINT,
+	/**
+	 * \brief A `double`.
+	 */
+	DESCENT_XML_BIND_DOUBLE,
+	/**
+	 * \brief A `bool`, written as `true`, `false`, `1` or `0`.
+	 */
+	DESCENT_XML_BIND_BOOL,
+	/**
+	 * \brief A pointer to a struct described by the field's record,
+	 * 	allocated while parsing. Only for child elements.
+	 */
+	DESCENT_XML_BIND_RECORD,
+};
+
+/**
+ * \brief Where a field is read from.
+ */
+enum descent_xml_bind_source {
+	/**
+	 * \brief An attribute of the element.
+	 */
+	DESCENT_XML_BIND_FROM_ATTRIBUTE,
+	/**
+	 * \brief A child element: its text for simple types, or its
+	 * 	attributes and content for records.
+	 */
+	DESCENT_XML_BIND_FROM_CHILD,
+	/**
+	 * \brief The text content of the element itself.
+	 */
+	DESCENT_XML_BIND_FROM_TEXT,
+};
+
+/**
+ * \brief The field must be present for the element to be valid.
+ */
+#define DESCENT_XML_BIND_REQUIRED 0x1
+
+/**
+ * \brief The field is a child element that can appear any number of
+ * 	times. The struct member is a pointer to an array of the field's
+ * 	type, allocated while parsing, and count_offset locates a
+ * 	`size_t` holding its length.
+ */
+#define DESCENT_XML_BIND_REPEATED 0x2
+
+/**
+ * \brief Describes one field of a record.
+ */
+struct descent_xml_bind_field {
+	/**
+	 * \brief The attribute or child element name. Unused for text.
+	 */
+	const char *name;
+
+	/**
+	 * \brief The length of name, so it isn't measured while parsing.
+	 */
+	size_t name_length;
+
+	enum descent_xml_bind_source source;
+	enum descent_xml_bind_type type;
+
+	/**
+	 * \brief DESCENT_XML_BIND_REQUIRED and DESCENT_XML_BIND_REPEATED,
+	 * 	or zero.
+	 */
+	unsigned flags;
+
+	/**
+	 * \brief The offset of the member in the record's struct.
+	 */
+	size_t offset;
+
+	/**
+	 * \brief The offset of the `size_t` count of a repeated field.
+	 */
+	size_t count_offset;
+
+	/**
+	 * \brief The record describing a DESCENT_XML_BIND_RECORD field.
+	 */
+	const struct descent_xml_bind_record *record;
+};
+
+/**
+ * \brief Describes an element, and the struct it's stored in.
+ *
+ * A record has at most 64 fields.
+ */
+struct descent_xml_bind_record {
+	/**
+	 * \brief The element name. Only checked for the root element;
+	 * 	child elements are matched by their field's name.
+	 */
+	const char *name;
+	size_t name_length;
+
+	/**
+	 * \brief The size of the struct.
+	 */
+	size_t size;
+
+	const struct descent_xml_bind_field *fields;
+	size_t field_count;
+};
+
+/**
+ * \brief Initialises a field read from an attribute.
+ */
+#define DESCENT_XML_BIND_ATTRIBUTE(struct_type, member, attribute_name, bind_type, bind_flags) \
+	{ \
+		.name = (attribute_name), \
+		.name_length = sizeof(attribute_name) - 1, \
+		.source = DESCENT_XML_BIND_FROM_ATTRIBUTE, \
+		.type = (bind_type), \
+		.flags = (bind_flags), \
+		.offset = offsetof(struct_type, member), \
+	}
+
+/**
+ * \brief Initialises a field read from a child element's text.
+ */
+#define DESCENT_XML_BIND_CHILD(struct_type, member, element_name, bind_type, bind_flags) \
+	{ \
+		.name = (element_name), \
+		.name_length = sizeof(element_name) - 1, \
+		.source = DESCENT_XML_BIND_FROM_CHILD, \
+		.type = (bind_type), \
+		.flags = (bind_flags), \
+		.offset = offsetof(struct_type, member), \
+	}
+
+/**
+ * \brief Initialises a field read from a child element's text, that
+ * 	can appear any number of times.
+ */
+#define DESCENT_XML_BIND_CHILDREN(struct_type, member, count_member, element_name, bind_type) \
+	{ \
+		.name = (element_name), \
+		.name_length = sizeof(element_name) - 1, \
+		.source = DESCENT_XML_BIND_FROM_CHILD, \
+		.type = (bind_type), \
+		.flags = DESCENT_XML_BIND_REPEATED, \
+		.offset = offsetof(struct_type, member), \
+		.count_offset = offsetof(struct_type, count_member), \
+	}
+
+/**
+ * \brief Initialises a field holding a child element described by
+ * 	another record.
+ */
+#define DESCENT_XML_BIND_NESTED(struct_type, member, element_name, child_record, bind_flags) \
+	{ \
+		.name = (element_name), \
+		.name_length = sizeof(element_name) - 1, \
+		.source = DESCENT_XML_BIND_FROM_CHILD, \
+		.type = DESCENT_XML_BIND_RECORD, \
+		.flags = (bind_flags), \
+		.offset = offsetof(struct_type, member), \
+		.record = (child_record), \
+	}
+
+/**
+ * \brief Initialises a field holding child elements described by
+ * 	another record, that can appear any number of times.
+ */
+#define DESCENT_XML_BIND_NESTED_ARRAY(struct_type, member, count_member, element_name, child_record) \
+	{ \
+		.name = (element_name), \
+		.name_length = sizeof(element_name) - 1, \
+		.source = DESCENT_XML_BIND_FROM_CHILD, \
+		.type = DESCENT_XML_BIND_RECORD, \
+		.flags = DESCENT_XML_BIND_REPEATED, \
+		.offset = offsetof(struct_type, member), \
+		.count_offset = offsetof(struct_type, count_member), \
+		.record = (child_record), \
+	}
+
+/**
+ * \brief Initialises a field read from the element's own text.
+ */
+#define DESCENT_XML_BIND_TEXT(struct_type, member, bind_type, bind_flags) \
+	{ \
+		.source = DESCENT_XML_BIND_FROM_TEXT, \
+		.type = (bind_type), \
+		.flags = (bind_flags), \
+		.offset = offsetof(struct_type, member), \
+	}
+
+/**
+ * \brief Initialises a record from an element name, a struct type and
+ * 	an array of fields.
+ */
+#define DESCENT_XML_BIND_RECORD_INIT(element_name, struct_type, field_array) \
+	{ \
+		.name = (element_name), \
+		.name_length = sizeof(element_name) - 1, \
+		.size = sizeof(struct_type), \
+		.fields = (field_array), \
+		.field_count = sizeof(field_array) / sizeof((field_array)[0]), \
+	}
+
+/**
+ * \brief The context for descent_xml_bind_element().
+ */
+struct descent_xml_bind_target {
+	/**
+	 * \brief The record describing the element to bind.
+	 */
+	const struct descent_xml_bind_record *record;
+
+	/**
+	 * \brief The struct to fill in. It should be zeroed beforehand,
+	 * 	as absent optional fields are left alone.
+	 */
+	void *value;
+
+	/**
+	 * \brief Set once an element has been bound. Later elements are
+	 * 	skipped.
+	 */
+	bool bound;
+
+	/**
+	 * \brief Set if the element didn't match the record, or memory
+	 * 	couldn't be allocated.
+	 */
+	bool error;
+
+	/**
+	 * \brief The allocator for nested structs, arrays and parsing,
+	 * 	or a NULL pointer for malloc(). Release the result with
+	 * 	descent_xml_bind_free_alloc() and the same allocator.
+	 */
+	const struct descent_xml_allocator *allocator;
+};
+
+/**
+ * \brief An element handler, to be passed to descent_xml_parse(),
+ * 	that binds the first element with the record's name.
+ *
+ * context must point to a struct descent_xml_bind_target. Elements
+ * with other names are skipped, along with their content, so this can
+ * be used to pull one record out of a larger document.
+ *
+ * \returns The last token processed.
+ */
+struct descent_xml_lex descent_xml_bind_element(
+	struct descent_xml_lex token,
+	struct libadt_const_lptr element_name,
+	struct libadt_const_lptr attributes,
+	bool empty,
+	void *context
+);
+
+/**
+ * \brief Parses a document whose root element is described by a
+ * 	record.
+ *
+ * \param record The record describing the root element.
+ * \param document The document. Strings in the result point into it.
+ * \param value The struct to fill in. It's zeroed first.
+ *
+ * \returns True on success. On failure, anything allocated is
+ * 	released and value is left zeroed.
+ */
+bool descent_xml_bind_parse(
+	const struct descent_xml_bind_record *record,
+	struct libadt_const_lptr document,
+	void *value
+);
+
+/**
+ * \brief descent_xml_bind_parse(), allocating with the given
+ * 	allocator.
+ *
+ * \param allocator The allocator, or a NULL pointer for malloc().
+ * 	Release the result with descent_xml_bind_free_alloc() and the
+ * 	same allocator, or reset the allocator.
+ *
+ * \sa descent-xml/alloc.h
+ */
+bool descent_xml_bind_parse_alloc(
+	const struct descent_xml_bind_record *record,
+	struct libadt_const_lptr document,
+	void *value,
+	const struct descent_xml_allocator *allocator
+);
+
+/**
+ * \brief Releases the arrays and nested structs allocated while
+ * 	binding, and zeroes the struct.
+ *
+ * \param record The record describing value.
+ * \param value The struct to release. Can be a NULL pointer.
+ */
+void descent_xml_bind_free(
+	const struct descent_xml_bind_record *record,
+	void *value
+);
+
+/**
+ * \brief descent_xml_bind_free() for a struct bound with an
+ * 	allocator.
+ *
+ * \param allocator The allocator passed when binding.
+ */
+void descent_xml_bind_free_alloc(
+	const struct descent_xml_bind_record *record,
+	void *value,
+	const struct descent_xml_allocator *allocator
+);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // DESCENT_XML_BIND
@@ -0,0 +1,108 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef DESCENT_XML_CHARS
+#define DESCENT_XML_CHARS
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <libadt/lptr.h>
+
+#include "cpu.h"
+
+/**
+ * \file
+ *
+ * Checks that a UTF-8 document only holds characters allowed by the
+ * XML `Char` production: tab, line feed, carriage return, and
+ * everything from U+0020 up except surrogates, U+FFFE and U+FFFF.
+ *
+ * The lexer and validator work a character at a time and don't look
+ * for these, so this is a separate pass over the bytes, run before
+ * parsing. Runs of ASCII are checked 64, 32 or 16 bytes at a time
+ * with AVX-512, AVX2 or SSE2, as picked at run time by
+ * descent-xml/cpu.h, or 8 bytes at a time in a machine word
+ * otherwise. Multi-byte sequences must be well-formed UTF-8, with no
+ * overlong forms, surrogates or code points past U+10FFFF. The
+ * AVX-512 and AVX2 kernels check them a block at a time too, with
+ * byte-shuffle table lookups; the SSE2 and word kernels decode them
+ * one at a time.
+ *
+ * descent_xml_chars_spaces() scans runs of whitespace the same way,
+ * which is how the lexer skips indentation.
+ */
+
+/**
+ * \brief Finds the first byte that isn't part of a well-formed UTF-8
+ * 	sequence encoding an XML `Char`.
+ *
+ * \param script The bytes to check.
+ *
+ * \returns The offset of the first bad byte, or script.length if the
+ * 	whole script is valid. A sequence cut off by the end of the
+ * 	script is reported at its first byte.
+ */
+size_t descent_xml_chars_check(struct libadt_const_lptr script);
+
+/**
+ * \brief descent_xml_chars_check() for a padded script, which the
+ * 	SIMD kernels check to the end with full-width loads.
+ *
+ * \param script The bytes to check, followed by DESCENT_XML_PADDING
+ * 	readable bytes, whatever they hold.
+ *
+ * \sa DESCENT_XML_PADDING
+ */
+size_t descent_xml_chars_check_padded(struct libadt_const_lptr script);
+
+/**
+ * \brief Counts the XML whitespace at the start of a script: spaces,
+ * 	tabs, line feeds and carriage returns, as in the `S` production.
+ *
+ * The kernel is picked as for descent_xml_chars_check(). These bytes
+ * never appear inside a multi-byte character in any encoding the C
+ * library supports, so this works on any locale's encoding, not only
+ * UTF-8.
+ *
+ * \param script The bytes to look at.
+ *
+ * \returns The number of whitespace bytes before the first other
+ * 	byte, or script.length if they're all whitespace.
+ */
+size_t descent_xml_chars_spaces(struct libadt_const_lptr script);
+
+/**
+ * \brief Checks that a script is well-formed UTF-8 holding only XML
+ * 	`Char`s.
+ *
+ * \sa descent_xml_chars_check()
+ */
+inline bool descent_xml_chars_valid(struct libadt_const_lptr script)
+{
+	return descent_xml_chars_check(script) == (size_t)script.length;
+}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // DESCENT_XML_CHARS
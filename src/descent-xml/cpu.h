@@ -0,0 +1,133 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef DESCENT_XML_CPU
+#define DESCENT_XML_CPU
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \file
+ *
+ * Chooses which SIMD instructions the scanning kernels, such as
+ * descent_xml_chars_check(), run with.
+ *
+ * The level is picked once, the first time a kernel runs, as the
+ * highest one the CPU supports, so one build runs well on older and
+ * newer machines alike. Setting the `DESCENT_XML_SIMD` environment
+ * variable to `scalar`, `sse2`, `avx2` or `avx512` caps it, for
+ * comparing kernels in benchmarks or reproducing a result from
+ * another machine. A level the CPU doesn't support is never used: a
+ * cap above it has no effect.
+ *
+ * Only x86 builds with GCC or Clang have SIMD kernels; elsewhere, the
+ * level is always DESCENT_XML_SIMD_SCALAR.
+ */
+
+/**
+ * \brief A set of instructions for the scanning kernels, from the
+ * 	least capable up.
+ */
+enum descent_xml_simd {
+	/**
+	 * \brief Eight bytes at a time in a machine word.
+	 */
+	DESCENT_XML_SIMD_SCALAR,
+	/**
+	 * \brief 16 bytes at a time with SSE2.
+	 */
+	DESCENT_XML_SIMD_SSE2,
+	/**
+	 * \brief 32 bytes at a time with AVX2.
+	 */
+	DESCENT_XML_SIMD_AVX2,
+	/**
+	 * \brief 64 bytes at a time with AVX-512BW, which AVX10 includes.
+	 */
+	DESCENT_XML_SIMD_AVX512,
+	DESCENT_XML_SIMD_COUNT
+};
+
+/**
+ * \brief The padding a padded script has after its end: the widest
+ * 	load any kernel makes.
+ *
+ * A script is padded if the DESCENT_XML_PADDING bytes after its last
+ * one can be read, whatever they hold. Kernels given a padded script,
+ * such as descent_xml_chars_check_padded(), can finish with one
+ * full-width load instead of a byte-at-a-time loop over the tail.
+ * Pass DESCENT_XML_READ_PADDED to descent_xml_read_fd(), or map a
+ * file with descent_xml_read_map(), to get one.
+ */
+#define DESCENT_XML_PADDING 64
+
+extern int _descent_xml_simd;
+
+int _descent_xml_simd_init(void);
+
+inline enum descent_xml_simd _descent_xml_simd_current(void)
+{
+	int level = __atomic_load_n(&_descent_xml_simd, __ATOMIC_RELAXED);
+	if (level < 0)
+		level = _descent_xml_simd_init();
+	return (enum descent_xml_simd)level;
+}
+
+/**
+ * \brief Gets the highest level that the CPU, and this build of the
+ * 	library, support.
+ */
+enum descent_xml_simd descent_xml_simd_supported(void);
+
+/**
+ * \brief Gets the level the kernels run with.
+ */
+inline enum descent_xml_simd descent_xml_simd_level(void)
+{
+	return _descent_xml_simd_current();
+}
+
+/**
+ * \brief Sets the level the kernels run with, overriding the
+ * 	environment.
+ *
+ * Meant for tests and benchmarks; the change is seen by every thread,
+ * but kernels already running finish with the level they started with.
+ *
+ * \param level The level wanted. Levels above
+ * 	descent_xml_simd_supported() are lowered to it.
+ *
+ * \returns The level now in use.
+ */
+enum descent_xml_simd descent_xml_simd_set_level(enum descent_xml_simd level);
+
+/**
+ * \brief Gets the name of a level, as accepted by the
+ * 	`DESCENT_XML_SIMD` environment variable.
+ *
+ * \returns The name, or a NULL pointer for levels out of range.
+ */
+const char *descent_xml_simd_name(enum descent_xml_simd level);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // DESCENT_XML_CPU
@@ -0,0 +1,240 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef DESCENT_XML_CURSOR
+#define DESCENT_XML_CURSOR
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <libadt/lptr.h>
+#include <libadt/vector.h>
+
+#include "alloc.h"
+#include "lex.h"
+#include "parse.h"
+#include "validate.h"
+
+/**
+ * \file
+ *
+ * Walking a document's elements without callbacks or recursion.
+ *
+ * A cursor sits on one element at a time. descent_xml_cursor_first_child()
+ * moves down into it, descent_xml_cursor_next_sibling() moves across,
+ * and when there's nothing left at that level the cursor moves back up
+ * to the parent, past its closing tag, ready for the parent's next
+ * sibling. The cursor keeps the names of the open elements on a stack
+ * of its own and checks each closing tag against it, so callers never
+ * see closing tags at all:
+ *
+ * ```c
+ * struct descent_xml_cursor cursor;
+ * descent_xml_cursor_init(&cursor, document, NULL);
+ * if (descent_xml_cursor_first_child(&cursor)) {                // <library>
+ * 	if (descent_xml_cursor_first_child(&cursor)) {        // the first <book>
+ * 		do {
+ * 			if (descent_xml_cursor_first_child(&cursor)) {  // <title>
+ * 				struct libadt_const_lptr title;
+ * 				if (descent_xml_cursor_text(&cursor, &title))
+ * 					use(title);
+ * 				descent_xml_cursor_parent_end(&cursor);  // back on <book>
+ * 			}
+ * 		} while (descent_xml_cursor_next_sibling(&cursor));
+ * 	}
+ * }
+ * bool ok = !descent_xml_cursor_failed(&cursor);
+ * descent_xml_cursor_free(&cursor);
+ * ```
+ *
+ * Elements the caller isn't interested in are skipped by moving past
+ * them, which only lexes their content: nothing is allocated for their
+ * attributes. Text, comments and CDATA sections between elements are
+ * passed over; descent_xml_cursor_text() reads an element's text.
+ *
+ * Only the nesting of elements is checked. For the rest of
+ * well-formedness, validate the document first.
+ */
+
+/**
+ * \brief State for walking a document.
+ *
+ * Create one with descent_xml_cursor_init() and release it with
+ * descent_xml_cursor_free().
+ */
+struct descent_xml_cursor {
+	/**
+	 * \brief The last token read. Its type is
+	 * 	descent_xml_classifier_unexpected if the document couldn't
+	 * 	be lexed, descent_xml_validate_error if a closing tag didn't
+	 * 	match, or descent_xml_parse_error if memory couldn't be
+	 * 	allocated.
+	 */
+	struct descent_xml_lex token;
+
+	/**
+	 * \brief The name of the current element. Empty at the document
+	 * 	level.
+	 */
+	struct libadt_const_lptr name;
+
+	/**
+	 * \brief The attributes of the current element, as names and
+	 * 	values in turn, like those passed to a
+	 * 	descent_xml_parse_element_fn. They're empty once the cursor
+	 * 	has moved back up to an element, and are only valid until
+	 * 	the cursor next moves to another element.
+	 */
+	struct libadt_const_lptr attributes;
+
+	/**
+	 * \brief True if the current element was written as an empty
+	 * 	element, `<name/>`.
+	 */
+	bool empty;
+
+	/**
+	 * \brief The depth of the current element: 1 for the root, and
+	 * 	0 before the root element and after it's finished.
+	 */
+	size_t depth;
+
+	/**
+	 * \brief True while the content of the current element is still
+	 * 	ahead of the cursor.
+	 */
+	bool has_content;
+
+	/**
+	 * \brief The names of the elements whose content the cursor is
+	 * 	in, outermost first.
+	 */
+	struct libadt_vector open;
+
+	/**
+	 * \brief Storage for attributes, reused from element to element.
+	 */
+	struct libadt_vector attribute_buffer;
+
+	/**
+	 * \brief The allocator for the two vectors, or a NULL pointer for
+	 * 	malloc().
+	 */
+	const struct descent_xml_allocator *allocator;
+};
+
+/**
+ * \brief Creates a cursor at the start of a document, at depth 0.
+ * 	Call descent_xml_cursor_first_child() to move to the root
+ * 	element.
+ *
+ * \param cursor The cursor to initialise.
+ * \param script The document.
+ * \param allocator The allocator for the cursor's stacks, or a NULL
+ * 	pointer for malloc(). Nothing is allocated until the root
+ * 	element is reached.
+ */
+void descent_xml_cursor_init(
+	struct descent_xml_cursor *cursor,
+	struct libadt_const_lptr script,
+	const struct descent_xml_allocator *allocator
+);
+
+/**
+ * \brief Releases the memory held by a cursor.
+ */
+void descent_xml_cursor_free(struct descent_xml_cursor *cursor);
+
+/**
+ * \brief Moves to the first child element of the current element.
+ *
+ * \returns True if the cursor moved. False if the element has no
+ * 	child elements, in which case its content has been read and the
+ * 	cursor stays where it is, or if the element's content was
+ * 	already passed, or on failure.
+ */
+bool descent_xml_cursor_first_child(struct descent_xml_cursor *cursor);
+
+/**
+ * \brief Moves to the next sibling of the current element, skipping
+ * 	any content of the current element that hasn't been read.
+ *
+ * \returns True if the cursor moved to a sibling. False if there are
+ * 	no more siblings, in which case the cursor has moved up to the
+ * 	parent, past its closing tag, or on failure.
+ */
+bool descent_xml_cursor_next_sibling(struct descent_xml_cursor *cursor);
+
+/**
+ * \brief Skips the rest of the parent element's content, and moves up
+ * 	to the parent, past its closing tag.
+ *
+ * \returns True on success, false at the document level or on
+ * 	failure.
+ */
+bool descent_xml_cursor_parent_end(struct descent_xml_cursor *cursor);
+
+/**
+ * \brief Skips the current element's content, leaving the cursor on
+ * 	the element, past its closing tag. Nothing is allocated for the
+ * 	attributes of the elements skipped.
+ *
+ * \returns True on success, or if the content was already passed,
+ * 	false on failure.
+ */
+bool descent_xml_cursor_skip(struct descent_xml_cursor *cursor);
+
+/**
+ * \brief Reads the current element's text, and skips the rest of its
+ * 	content.
+ *
+ * \param text Set to the first text node or CDATA section directly
+ * 	inside the element, pointing into the document, or to an empty
+ * 	pointer if it has none. Entities aren't replaced.
+ *
+ * \returns True on success, false if the element's content was
+ * 	already passed, or on failure. An empty element has empty text.
+ */
+bool descent_xml_cursor_text(
+	struct descent_xml_cursor *cursor,
+	struct libadt_const_lptr *text
+);
+
+/**
+ * \brief Whether the cursor has stopped on an error.
+ *
+ * \returns True if the document couldn't be lexed, a closing tag
+ * 	didn't match its opening tag, or memory couldn't be allocated.
+ * 	cursor->token says which.
+ */
+inline bool descent_xml_cursor_failed(const struct descent_xml_cursor *cursor)
+{
+	return cursor->token.type == descent_xml_classifier_unexpected
+		|| cursor->token.type == descent_xml_parse_error
+		|| cursor->token.type == descent_xml_validate_error;
+}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // DESCENT_XML_CURSOR
@@ -0,0 +1,251 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef DESCENT_XML_DTD
+#define DESCENT_XML_DTD
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <libadt/lptr.h>
+
+#include "alloc.h"
+#include "lex.h"
+
+/**
+ * \file
+ *
+ * Validation against a document type definition.
+ *
+ * A DTD is compiled once with descent_xml_dtd_compile(). Each
+ * element's content model becomes a deterministic automaton over the
+ * names of its children, and each attribute list a table sorted for
+ * lookup. The compiled DTD is never modified afterwards, so it can be
+ * kept around and shared, including between threads, to validate any
+ * number of documents without paying for the compile again.
+ *
+ * Validating a document needs a struct descent_xml_dtd_validator,
+ * which keeps the automaton state of each open element. Elements,
+ * text and closing tags are fed to it as they're parsed, in a single
+ * pass. The easiest way to do that is to point a struct
+ * descent_xml_validator at it and parse with
+ * descent_xml_parse_validated(), or to call
+ * descent_xml_dtd_validate_document().
+ *
+ * Supported declarations are ELEMENT, ATTLIST, ENTITY and NOTATION.
+ * Parameter entity references between declarations are not expanded
+ * and fail the compile. ID, IDREF and ENTITY attribute values are
+ * not cross-referenced.
+ */
+
+/**
+ * \brief A compiled DTD. Opaque; created by descent_xml_dtd_compile().
+ */
+struct descent_xml_dtd;
+
+struct _descent_xml_dtd_frame {
+	uint32_t element;
+	int32_t state;
+};
+
+/**
+ * \brief Holds the state for validating one document against a
+ * 	compiled DTD.
+ *
+ * Create one with descent_xml_dtd_validator_init() and release it
+ * with descent_xml_dtd_validator_free().
+ */
+struct descent_xml_dtd_validator {
+	/**
+	 * \brief The DTD being validated against.
+	 */
+	const struct descent_xml_dtd *dtd;
+
+	/**
+	 * \brief The name the root element must have, from the
+	 * 	document's DOCTYPE. An empty length-pointer accepts any
+	 * 	root element.
+	 */
+	struct libadt_const_lptr root;
+
+	struct _descent_xml_dtd_frame *frames;
+	size_t depth;
+	size_t capacity;
+
+	/**
+	 * \brief The allocator for the validator's stack, or a NULL
+	 * 	pointer for malloc(). The init function sets this to NULL;
+	 * 	change it before the first element.
+	 */
+	const struct descent_xml_allocator *allocator;
+};
+
+/**
+ * \brief Compiles a set of markup declarations.
+ *
+ * \param declarations The declarations to compile: the internal
+ * 	subset of a DOCTYPE, as returned by descent_xml_doctype_subset(),
+ * 	or the contents of an external DTD file. The text is copied, so
+ * 	it doesn't have to outlive the result.
+ *
+ * \returns The compiled DTD, to be released with descent_xml_dtd_free(),
+ * 	or a NULL pointer if the declarations are malformed, use
+ * 	something unsupported, or memory couldn't be allocated.
+ */
+struct descent_xml_dtd *descent_xml_dtd_compile(
+	struct libadt_const_lptr declarations
+);
+
+/**
+ * \brief Releases a compiled DTD.
+ *
+ * \param dtd The DTD to release. Can be a NULL pointer.
+ */
+void descent_xml_dtd_free(struct descent_xml_dtd *dtd);
+
+/**
+ * \brief Returns the root element name from a DOCTYPE token.
+ *
+ * \param doctype A token of type descent_xml_lex_doctype.
+ *
+ * \returns A length-pointer to the name, or an empty length-pointer
+ * 	if the token isn't a DOCTYPE.
+ */
+struct libadt_const_lptr descent_xml_doctype_name(struct descent_xml_lex doctype);
+
+/**
+ * \brief Returns the internal subset from a DOCTYPE token.
+ *
+ * \param doctype A token of type descent_xml_lex_doctype.
+ *
+ * \returns A length-pointer to the declarations between the square
+ * 	brackets, or an empty length-pointer if there is no internal
+ * 	subset.
+ */
+struct libadt_const_lptr descent_xml_doctype_subset(struct descent_xml_lex doctype);
+
+/**
+ * \brief Creates a validator for one document.
+ *
+ * \param dtd The compiled DTD to validate against. It must outlive
+ * 	the validator.
+ *
+ * \returns A validator at the start of a document. No memory is
+ * 	allocated until the first element is opened.
+ */
+inline struct descent_xml_dtd_validator descent_xml_dtd_validator_init(
+	const struct descent_xml_dtd *dtd
+)
+{
+	return (struct descent_xml_dtd_validator) { .dtd = dtd };
+}
+
+/**
+ * \brief Releases the memory held by a validator.
+ *
+ * \param validator The validator to release. The compiled DTD is
+ * 	not released.
+ */
+inline void descent_xml_dtd_validator_free(
+	struct descent_xml_dtd_validator *validator
+)
+{
+	descent_xml_release(
+		validator->allocator,
+		validator->frames,
+		validator->capacity * sizeof(*validator->frames)
+	);
+	validator->frames = NULL;
+	validator->depth = validator->capacity = 0;
+}
+
+/**
+ * \brief Checks an opening tag against the DTD and advances the
+ * 	parent element's content model.
+ *
+ * The arguments are the ones passed to a descent_xml_parse_element_fn.
+ *
+ * \returns True if the element is allowed here and its attributes
+ * 	are valid, false otherwise. Memory allocation failures also
+ * 	return false.
+ */
+bool descent_xml_dtd_element(
+	struct descent_xml_dtd_validator *validator,
+	struct libadt_const_lptr element_name,
+	struct libadt_const_lptr attributes,
+	bool empty
+);
+
+/**
+ * \brief Checks a text node against the content model of the open
+ * 	element.
+ *
+ * The arguments are the ones passed to a descent_xml_parse_text_fn.
+ * Whitespace is allowed between children in element content; any
+ * other text needs mixed or ANY content.
+ *
+ * \returns True if the text is allowed here, false otherwise.
+ */
+bool descent_xml_dtd_text(
+	struct descent_xml_dtd_validator *validator,
+	struct libadt_const_lptr text,
+	bool is_cdata
+);
+
+/**
+ * \brief Checks that the open element's content is complete, and
+ * 	closes it.
+ *
+ * Matching the closing tag's name to the open element is left to
+ * the well-formedness checks.
+ *
+ * \returns True if the content model accepts the children seen,
+ * 	false otherwise.
+ */
+bool descent_xml_dtd_close(struct descent_xml_dtd_validator *validator);
+
+/**
+ * \brief Checks that a document is well-formed and valid, in a single
+ * 	pass.
+ *
+ * The root element must match the name in the document's DOCTYPE,
+ * if it has one.
+ *
+ * \param dtd The DTD to validate against. Pass a NULL pointer to
+ * 	compile the document's own internal subset for this one call.
+ * \param token A token at the start of the document, as created by
+ * 	descent_xml_lex_init().
+ *
+ * \returns True if the document is valid, false otherwise.
+ */
+bool descent_xml_dtd_validate_document(
+	const struct descent_xml_dtd *dtd,
+	struct descent_xml_lex token
+);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // DESCENT_XML_DTD
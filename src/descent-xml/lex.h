@@ -30,7 +30,9 @@ extern "C" {
 
 #include <libadt.h>
 
+#include "chars.h"
 #include "classifier.h"
+#include "stats.h"
 
 /**
  * \file
@@ -68,12 +70,15 @@ inline ssize_t _descent_xml_lex_mbrtowc(
 		*result = L'\0';
 		return 0;
 	}
-	return (ssize_t)mbrtowc(
+	const ssize_t amount = (ssize_t)mbrtowc(
 		result,
 		string.buffer,
 		(size_t)string.length,
 		_mbstate
 	);
+	_DESCENT_XML_STATS_ADD(mbrtowc_calls, 1);
+	_DESCENT_XML_STATS_ADD(decoded_bytes, amount > 0 ? amount : 0);
+	return amount;
 }
 
 typedef struct {
@@ -106,6 +111,65 @@ inline _descent_xml_lex_read_t _descent_xml_lex_read(
 	return result;
 }
 
+/*
+ * Reads one token's worth of script, starting in the previous token's
+ * state: each character is decoded and fed to the current state's
+ * function until the state changes. The result's amount is the
+ * token's length, and it's 0 for unexpected tokens.
+ *
+ * This is the generic engine, which works with any state function.
+ * _descent_xml_lex_run() is equivalent, but runs the library's own
+ * states without an indirect call per character.
+ */
+inline _descent_xml_lex_read_t _descent_xml_lex_run_generic(
+	struct libadt_const_lptr next,
+	descent_xml_classifier_fn *previous
+)
+{
+	_descent_xml_lex_read_t
+		read = _descent_xml_lex_read(next, previous),
+		previous_read = read;
+
+	if (_descent_xml_lex_read_error(read))
+		return (_descent_xml_lex_read_t) {
+			.amount = 0,
+			.type = descent_xml_classifier_unexpected,
+			.script = next,
+		};
+
+	if (read.type == descent_xml_classifier_eof)
+		return read;
+
+	ssize_t value_length = read.amount;
+	for (
+		read = _descent_xml_lex_read(read.script, read.type);
+		!_descent_xml_lex_read_error(read);
+		read = _descent_xml_lex_read(read.script, read.type)
+	) {
+		if (read.type != previous_read.type)
+			break;
+
+		previous_read = read;
+		value_length += read.amount;
+	}
+
+	return (_descent_xml_lex_read_t) {
+		.amount = value_length,
+		.type = previous_read.type,
+		.script = libadt_const_lptr_index(next, value_length),
+	};
+}
+
+/*
+ * _descent_xml_lex_run_generic(), with the library's states compiled
+ * into one function, see src/engine.c. Other states are handed to
+ * _descent_xml_lex_run_generic().
+ */
+_descent_xml_lex_read_t _descent_xml_lex_run(
+	struct libadt_const_lptr next,
+	descent_xml_classifier_fn *previous
+);
+
 descent_xml_classifier_void_fn *descent_xml_lex_doctype(wchar_t input);
 descent_xml_classifier_void_fn *descent_xml_lex_xmldecl(wchar_t input);
 descent_xml_classifier_void_fn *descent_xml_lex_cdata(wchar_t input);
@@ -139,34 +203,20 @@ inline bool _descent_xml_lex_startswith(
 	if (string.length < start.length)
 		return false;
 
+	_DESCENT_XML_STATS_ADD(compared_bytes, start.length);
 	return libadt_const_lptr_equal(
 		libadt_const_lptr_truncate(string, (size_t)start.length),
 		start
 	);
 }
 
+// Counts the whitespace bytes, as in the `S` production, at the start
+// of next, a block at a time rather than decoding each character.
 inline ssize_t _descent_xml_lex_count_spaces(
 	struct libadt_const_lptr next
 )
 {
-	ssize_t spaces = 0;
-	wchar_t c = 0;
-	mbstate_t mbstate = { 0 };
-	for (
-		ssize_t current = _descent_xml_lex_mbrtowc(&c, next, &mbstate);
-		iswspace((wint_t)c);
-		next = libadt_const_lptr_index(next, current),
-		current = _descent_xml_lex_mbrtowc(&c, next, &mbstate)
-	) {
-		const bool unexpected = c == L'\0'
-			|| current < 0;
-		if (unexpected)
-			return -1;
-
-		spaces += current;
-	}
-
-	return spaces;
+	return (ssize_t)descent_xml_chars_spaces(next);
 }
 
 inline struct libadt_const_lptr _descent_xml_lex_remainder(
@@ -204,9 +254,12 @@ inline struct descent_xml_lex descent_xml_lex_or(
 	_descent_xml_lex_section *right
 )
 {
+	_DESCENT_XML_STATS_MARK(decoded);
 	struct descent_xml_lex result = descent_xml_lex_then(token, left);
-	if (result.type == descent_xml_classifier_unexpected)
+	if (result.type == descent_xml_classifier_unexpected) {
+		_DESCENT_XML_STATS_BACKTRACK(or, decoded);
 		result = descent_xml_lex_then(token, right);
+	}
 	return result;
 }
 
@@ -215,10 +268,13 @@ inline struct descent_xml_lex descent_xml_lex_optional(
 	_descent_xml_lex_section *section
 )
 {
+	_DESCENT_XML_STATS_MARK(decoded);
 	struct descent_xml_lex result
 		= descent_xml_lex_then(token, section);
-	if (result.type == descent_xml_classifier_unexpected)
+	if (result.type == descent_xml_classifier_unexpected) {
+		_DESCENT_XML_STATS_BACKTRACK(optional, decoded);
 		return token;
+	}
 	return result;
 }
 
@@ -431,6 +487,60 @@ inline struct descent_xml_lex _descent_xml_lex_doctype_extrawurst(
 	return token;
 }
 
+inline struct descent_xml_lex _descent_xml_lex_doctype_subset(
+	struct descent_xml_lex token
+)
+{
+	struct libadt_const_lptr remainder
+		= _descent_xml_lex_remainder(token);
+	const char *const bytes = remainder.buffer;
+	if (remainder.length <= 0 || bytes[0] != '[') {
+		token.type = descent_xml_classifier_unexpected;
+		return token;
+	}
+
+	// the declarations themselves are compiled by descent_xml_dtd_compile(),
+	// here we only need to find the closing bracket, which can't be
+	// hiding in a literal or a comment
+	const struct libadt_const_lptr
+		comment = libadt_str_literal("<!--"),
+		comment_end = libadt_str_literal("-->");
+	char quote = '\0';
+	for (ssize_t i = 1; i < remainder.length; i++) {
+		if (quote) {
+			if (bytes[i] == quote)
+				quote = '\0';
+			continue;
+		}
+
+		const struct libadt_const_lptr rest
+			= libadt_const_lptr_index(remainder, i);
+		if (_descent_xml_lex_startswith(rest, comment)) {
+			for (i += comment.length; i < remainder.length; i++)
+				if (_descent_xml_lex_startswith(
+					libadt_const_lptr_index(remainder, i),
+					comment_end
+				))
+					break;
+			i += comment_end.length - 1;
+			continue;
+		}
+
+		switch (bytes[i]) {
+			case '"':
+			case '\'':
+				quote = bytes[i];
+				break;
+			case ']':
+				token.value.length += i + 1;
+				return token;
+		}
+	}
+
+	token.type = descent_xml_classifier_unexpected;
+	return token;
+}
+
 inline struct descent_xml_lex descent_xml_lex_handle_doctype(
 	struct descent_xml_lex token
 )
@@ -446,6 +556,14 @@ inline struct descent_xml_lex descent_xml_lex_handle_doctype(
 		token,
 		_descent_xml_lex_space
 	);
+	token = descent_xml_lex_optional(
+		token,
+		_descent_xml_lex_doctype_subset
+	);
+	token = descent_xml_lex_optional(
+		token,
+		_descent_xml_lex_space
+	);
 
 	if (token.type == descent_xml_classifier_unexpected)
 		return token;
@@ -597,15 +715,7 @@ inline struct descent_xml_lex _descent_xml_lex_handle_unmarkdown(
 	);
 }
 
-/**
- * \brief Returns the next, raw token in the script referred to by
- * 	previous.
- *
- * \param previous The previous token from the script.
- *
- * \returns The next token.
- */
-inline struct descent_xml_lex descent_xml_lex_next_raw(
+inline struct descent_xml_lex _descent_xml_lex_next_raw(
 	struct descent_xml_lex token
 )
 {
@@ -623,45 +733,31 @@ inline struct descent_xml_lex descent_xml_lex_next_raw(
 			return test;
 	}
 
-	_descent_xml_lex_read_t
-		read = _descent_xml_lex_read(next, token.type),
-		previous_read = read;
-
-	if (_descent_xml_lex_read_error(read))
-		return (struct descent_xml_lex) {
-			.script = token.script,
-			.type = descent_xml_classifier_unexpected,
-			.value = libadt_const_lptr_truncate(next, 0),
-		};
-
-	if (read.type == descent_xml_classifier_eof) {
-		return (struct descent_xml_lex) {
-			.script = token.script,
-			.type = read.type,
-			.value = libadt_const_lptr_truncate(next, (size_t)read.amount)
-		};
-	}
-
-	ssize_t value_length = read.amount;
-	for (
-		read = _descent_xml_lex_read(read.script, read.type);
-		!_descent_xml_lex_read_error(read);
-		read = _descent_xml_lex_read(read.script, read.type)
-	) {
-		if (read.type != previous_read.type)
-			break;
-
-		previous_read = read;
-		value_length += read.amount;
-	}
-
+	const _descent_xml_lex_read_t run = _descent_xml_lex_run(next, token.type);
 	return (struct descent_xml_lex) {
 		.script = token.script,
-		.type = previous_read.type,
-		.value = libadt_const_lptr_truncate(next, (size_t)value_length),
+		.type = run.type,
+		.value = libadt_const_lptr_truncate(next, (size_t)run.amount),
 	};
 }
 
+/**
+ * \brief Returns the next, raw token in the script referred to by
+ * 	previous.
+ *
+ * \param previous The previous token from the script.
+ *
+ * \returns The next token.
+ */
+inline struct descent_xml_lex descent_xml_lex_next_raw(
+	struct descent_xml_lex previous
+)
+{
+	const struct descent_xml_lex token = _descent_xml_lex_next_raw(previous);
+	_DESCENT_XML_STATS_TOKEN(token);
+	return token;
+}
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -28,7 +28,10 @@ extern "C" {
 #include <stdbool.h>
 
 
+#include "alloc.h"
 #include "lex.h"
+#include "token.h"
+#include "trace.h"
 
 #include <libadt/lptr.h>
 #include <libadt/vector.h>
@@ -135,12 +138,25 @@ typedef void descent_xml_parse_text_cstr_fn(
 	void *context
 );
 
+/**
+ * \brief Token type returned by the parser when memory couldn't be
+ * 	allocated.
+ *
+ * This is only a marker: calling it, or lexing on from a token of
+ * this type, will call abort().
+ */
+extern descent_xml_classifier_void_fn *descent_xml_parse_error(wchar_t);
+
+// True for eof and errors, which can't be lexed on from.
 inline bool _descent_xml_end_token(struct descent_xml_lex token)
 {
-	return token.type == descent_xml_classifier_eof
-		|| token.type == descent_xml_classifier_unexpected;
+	return descent_xml_token_is(token, DESCENT_XML_TOKEN_CATEGORY_END);
 }
 
+// The same as the DESCENT_XML_TOKEN_CATEGORY_ATTRIBUTE_VALUE and
+// DESCENT_XML_TOKEN_CATEGORY_TEXT categories, but compared directly:
+// these run on every token of a value, where the id lookup costs more
+// than the comparisons (see bench_descent_xml_token).
 inline bool _descent_xml_is_attribute_value_type(struct descent_xml_lex token)
 {
 	return token.type == descent_xml_classifier_attribute_value_single_quote
@@ -149,7 +165,6 @@ inline bool _descent_xml_is_attribute_value_type(struct descent_xml_lex token)
 		|| token.type == descent_xml_classifier_attribute_value_double_quote
 		|| token.type == descent_xml_classifier_attribute_value_double_quote_entity_start
 		|| token.type == descent_xml_classifier_attribute_value_double_quote_entity;
-
 }
 
 typedef struct {
@@ -176,8 +191,75 @@ inline _descent_xml_value_t _descent_xml_attribute_value(
 	return (_descent_xml_value_t) { result, next };
 }
 
+inline bool _descent_xml_append_attribute(
+	const struct descent_xml_allocator *allocator,
+	struct libadt_vector *attributes,
+	const struct libadt_const_lptr *value
+)
+{
+	const size_t capacity = attributes->capacity;
+	if (!_descent_xml_vector_append(allocator, attributes, value))
+		return false;
+	_DESCENT_XML_STATS_ADD(vector_allocations, attributes->capacity != capacity);
+	if (attributes->capacity != capacity)
+		_DESCENT_XML_TRACE1(attributes__grow, attributes->capacity);
+	return true;
+}
+
+// Reads the attributes of a start tag, from the token after its name
+// up to the '>' or '/>'. Names and values are appended to attributes
+// in turn, or skipped if it's a NULL pointer.
+inline struct descent_xml_lex _descent_xml_read_attributes(
+	struct descent_xml_lex token,
+	const struct descent_xml_allocator *allocator,
+	struct libadt_vector *attributes
+)
+{
+	while (token.type == descent_xml_classifier_element_space) {
+		token = descent_xml_lex_next_raw(token);
+
+		if (token.type == descent_xml_classifier_attribute_name) {
+			if (attributes && !_descent_xml_append_attribute(
+				allocator,
+				attributes,
+				&token.value
+			)) {
+				token.type = descent_xml_parse_error;
+				break;
+			}
+			token = descent_xml_lex_next_raw(token);
+			if (token.type == descent_xml_classifier_attribute_expect_assign)
+				token = descent_xml_lex_next_raw(token);
+			if (token.type == descent_xml_classifier_attribute_assign)
+				token = descent_xml_lex_next_raw(token);
+			const bool quote =
+				token.type == descent_xml_classifier_attribute_value_single_quote_start
+				|| token.type == descent_xml_classifier_attribute_value_double_quote_start;
+			if (quote)
+				token = descent_xml_lex_next_raw(token);
+
+			_descent_xml_value_t attr
+				= _descent_xml_attribute_value(token);
+			if (attributes && !_descent_xml_append_attribute(
+				allocator,
+				attributes,
+				&attr.value
+			)) {
+				token.type = descent_xml_parse_error;
+				break;
+			}
+			token = attr.token;
+			if (token.type == descent_xml_classifier_unexpected)
+				break;
+			token = descent_xml_lex_next_raw(token);
+		}
+	}
+	return token;
+}
+
 inline struct descent_xml_lex _descent_xml_handle_element(
 	struct descent_xml_lex token,
+	const struct descent_xml_allocator *allocator,
 	descent_xml_parse_element_fn *element_handler,
 	void *context
 )
@@ -188,59 +270,43 @@ inline struct descent_xml_lex _descent_xml_handle_element(
 	if (token.type == descent_xml_classifier_unexpected)
 		return token;
 
-	LIBADT_VECTOR_WITH(attributes, sizeof(struct libadt_const_lptr), 0) {
-		while (token.type == descent_xml_classifier_element_space) {
-			token = descent_xml_lex_next_raw(token);
+	struct libadt_vector attributes = {
+		.element_size = sizeof(struct libadt_const_lptr),
+	};
+	token = _descent_xml_read_attributes(token, allocator, &attributes);
 
-			if (token.type == descent_xml_classifier_attribute_name) {
-				attributes = libadt_vector_append(
-					attributes,
-					&token.value
-				);
-				token = descent_xml_lex_next_raw(token);
-				if (token.type == descent_xml_classifier_attribute_expect_assign)
-					token = descent_xml_lex_next_raw(token);
-				if (token.type == descent_xml_classifier_attribute_assign)
-					token = descent_xml_lex_next_raw(token);
-				const bool quote =
-					token.type == descent_xml_classifier_attribute_value_single_quote_start
-					|| token.type == descent_xml_classifier_attribute_value_double_quote_start;
-				if (quote)
-					token = descent_xml_lex_next_raw(token);
-
-				_descent_xml_value_t attr
-					= _descent_xml_attribute_value(token);
-				attributes = libadt_vector_append(
-					attributes,
-					&attr.value
-				);
-				token = attr.token;
-				token = descent_xml_lex_next_raw(token);
-			}
-		}
+	const bool is_empty
+		= token.type == descent_xml_classifier_element_empty;
 
-		if (token.type == descent_xml_classifier_unexpected)
-			continue;
-
-		const bool is_empty
-			= token.type == descent_xml_classifier_element_empty;
-
-		if (is_empty || token.type == descent_xml_classifier_element_end) {
-			struct libadt_const_lptr attribsptr = {
-				.buffer = attributes.buffer,
-				.size = sizeof(struct libadt_const_lptr),
-				.length = (ssize_t)attributes.length,
-			};
-
-			token = element_handler(
-				token,
-				name,
-				attribsptr,
-				is_empty,
-				context
-			);
-		}
+	if (is_empty || token.type == descent_xml_classifier_element_end) {
+		struct libadt_const_lptr attribsptr = {
+			.buffer = attributes.buffer,
+			.size = sizeof(struct libadt_const_lptr),
+			.length = (ssize_t)attributes.length,
+		};
+
+		_DESCENT_XML_TRACE3(
+			element__start,
+			name.buffer,
+			name.length,
+			attributes.length / 2
+		);
+		token = element_handler(
+			token,
+			name,
+			attribsptr,
+			is_empty,
+			context
+		);
+		if (is_empty)
+			_DESCENT_XML_TRACE2(element__end, name.buffer, name.length);
 	}
+
+	descent_xml_release(
+		allocator,
+		attributes.buffer,
+		attributes.capacity * attributes.element_size
+	);
 	return token;
 }
 
@@ -277,6 +343,87 @@ inline struct descent_xml_lex _descent_xml_handle_text(
 	return result.token;
 }
 
+// The text of a CDATA section, without the `![CDATA[` and `]]`.
+inline struct libadt_const_lptr _descent_xml_cdata_value(
+	struct descent_xml_lex token
+)
+{
+	const struct libadt_const_lptr value = libadt_const_lptr_index(
+		token.value,
+		sizeof("![CDATA[") - 1
+	);
+	return libadt_const_lptr_truncate(
+		value,
+		(size_t)value.length - 2 /* ]] */
+	);
+}
+
+// Tracing shared by the descent_xml_parse*() functions, for the token
+// they were passed and the one they return.
+inline void _descent_xml_parse_begin(struct descent_xml_lex xml)
+{
+	if (xml.type == descent_xml_classifier_start)
+		_DESCENT_XML_TRACE2(document__start, xml.script.buffer, xml.script.length);
+}
+
+inline struct descent_xml_lex _descent_xml_parse_end(struct descent_xml_lex xml)
+{
+	if (xml.type == descent_xml_classifier_element_close_name)
+		_DESCENT_XML_TRACE2(element__end, xml.value.buffer, xml.value.length);
+	else if (xml.type == descent_xml_classifier_eof)
+		_DESCENT_XML_TRACE2(document__end, xml.script.buffer, xml.script.length);
+	else if (xml.type == descent_xml_classifier_unexpected)
+		_DESCENT_XML_TRACE2(
+			parse__error,
+			xml.script.buffer,
+			_DESCENT_XML_TRACE_OFFSET(xml)
+		);
+	return xml;
+}
+
+/**
+ * \brief descent_xml_parse(), allocating with the given allocator.
+ *
+ * The attribute list passed to element handlers is allocated with
+ * allocator, and released when the handler returns. Handlers parsing
+ * further content should call this again with the same allocator.
+ *
+ * \param allocator The allocator, or a NULL pointer for malloc().
+ *
+ * \sa descent_xml_parse()
+ * \sa descent-xml/alloc.h
+ */
+inline struct descent_xml_lex descent_xml_parse_alloc(
+	struct descent_xml_lex xml,
+	const struct descent_xml_allocator *allocator,
+	descent_xml_parse_element_fn *element_handler,
+	descent_xml_parse_text_fn *text_handler,
+	void *context
+)
+{
+	_descent_xml_parse_begin(xml);
+	xml = descent_xml_lex_next_raw(xml);
+
+	if (xml.type == descent_xml_classifier_element_name && element_handler) {
+		xml = _descent_xml_handle_element(
+			xml,
+			allocator,
+			element_handler,
+			context
+		);
+	} else if (_descent_xml_is_text_type(xml) && text_handler) {
+		xml = _descent_xml_handle_text(
+			xml,
+			text_handler,
+			context
+		);
+	} else if (xml.type == descent_xml_lex_cdata && text_handler) {
+		text_handler(_descent_xml_cdata_value(xml), true, context);
+	}
+
+	return _descent_xml_parse_end(xml);
+}
+
 /**
  * \brief Function for parsing an XML document.
  *
@@ -306,10 +453,14 @@ inline struct descent_xml_lex _descent_xml_handle_text(
  * \returns The last token encountered while parsing. If the
  * 	return value's `type` property is `descent_xml_classifier_unexpected`,
  * 	an error was encountered. If the `type` property is
+ * 	`descent_xml_parse_error`, the attribute list couldn't be
+ * 	allocated. If the `type` property is
  * 	`descent_xml_classifier_eof`, then the end of the XML was encountered
  * 	in an expected way.
  *
  * \sa descent_xml_parse_cstr() An interface for C-style strings.
+ * \sa descent_xml_parse_alloc() To allocate with something other than
+ * 	malloc().
  */
 inline struct descent_xml_lex descent_xml_parse(
 	struct descent_xml_lex xml,
@@ -318,45 +469,46 @@ inline struct descent_xml_lex descent_xml_parse(
 	void *context
 )
 {
-	xml = descent_xml_lex_next_raw(xml);
-
-	if (xml.type == descent_xml_classifier_element_name && element_handler) {
-		xml = _descent_xml_handle_element(
-			xml,
-			element_handler,
-			context
-		);
-	} else if (_descent_xml_is_text_type(xml) && text_handler) {
-		xml = _descent_xml_handle_text(
-			xml,
-			text_handler,
-			context
-		);
-	} else if (xml.type == descent_xml_lex_cdata && text_handler) {
-		// TODO: clean this up
-		struct libadt_const_lptr arg
-			= libadt_const_lptr_index(
-				xml.value,
-				sizeof("![CDATA[") - 1
-			);
-		arg = libadt_const_lptr_truncate(
-			arg,
-			arg.length - 2 /* ]] */
-		);
-		text_handler(arg, true, context);
-	}
-
-	return xml;
+	return descent_xml_parse_alloc(
+		xml,
+		NULL,
+		element_handler,
+		text_handler,
+		context
+	);
 }
 
 typedef struct {
 	descent_xml_parse_element_cstr_fn *const element_handler;
 	descent_xml_parse_text_cstr_fn *const text_handler;
 	void *const context;
+	const struct descent_xml_allocator *const allocator;
 	int error;
 } _descent_xml_parse_cstr_context;
 
-extern descent_xml_classifier_void_fn *descent_xml_parse_error(wchar_t);
+inline void _descent_xml_release_cstr(
+	const struct descent_xml_allocator *allocator,
+	char *string
+)
+{
+	if (string)
+		descent_xml_release(allocator, string, strlen(string) + 1);
+}
+
+inline void _descent_xml_release_cstrs(
+	const struct descent_xml_allocator *allocator,
+	char **strings,
+	size_t count
+)
+{
+	// newest first, so a stack-like allocator gets them all back
+	char **end = strings;
+	while (*end)
+		end++;
+	while (end > strings)
+		_descent_xml_release_cstr(allocator, *--end);
+	descent_xml_release(allocator, strings, (count + 1) * sizeof(char*));
+}
 
 inline struct descent_xml_lex _cstr_element_handler(
 	struct descent_xml_lex xml,
@@ -370,22 +522,41 @@ inline struct descent_xml_lex _cstr_element_handler(
 	const _descent_xml_parse_cstr_context *const cstr_context = context;
 	if (!cstr_context->element_handler)
 		return xml;
+	const struct descent_xml_allocator *const allocator
+		= cstr_context->allocator;
 
-	char *const cname = strndup(element_name.buffer, (size_t)element_name.length);
+	char *const cname = descent_xml_strndup(
+		allocator,
+		element_name.buffer,
+		(size_t)element_name.length
+	);
+	_DESCENT_XML_STATS_ADD(strndup_calls, 1);
 	if (!cname)
 		goto error_return_xml;
 
-	char * *const cattr = calloc((size_t)(attributes.length + 1), sizeof(char*));
+	char * *const cattr = descent_xml_allocate_zeroed(
+		allocator,
+		(size_t)(attributes.length + 1),
+		sizeof(char*)
+	);
 	if (!cattr)
 		goto error_free_cname;
 
+	ssize_t copied = element_name.length;
 	for (ssize_t i = 0; i < attributes.length; ++i) {
 		const struct libadt_const_lptr *const attarr = attributes.buffer;
 		const struct libadt_const_lptr *const attribute = &attarr[i];
-		cattr[i] = strndup(attribute->buffer, (size_t)attribute->length);
+		cattr[i] = descent_xml_strndup(
+			allocator,
+			attribute->buffer,
+			(size_t)attribute->length
+		);
+		_DESCENT_XML_STATS_ADD(strndup_calls, 1);
 		if (!cattr[i])
 			goto error_free_cattr;
+		copied += attribute->length;
 	}
+	_DESCENT_XML_TRACE2(cstr__copy, attributes.length + 1, copied);
 
 	xml = cstr_context->element_handler(
 		xml,
@@ -395,21 +566,15 @@ inline struct descent_xml_lex _cstr_element_handler(
 		cstr_context->context
 	);
 
-	for (char **attr = cattr; *attr; attr++) {
-		free(*attr);
-	}
-	free(cattr);
-	free(cname);
+	_descent_xml_release_cstrs(allocator, cattr, (size_t)attributes.length);
+	_descent_xml_release_cstr(allocator, cname);
 
 	return xml;
 
 error_free_cattr:
-	for (char **attr = cattr; *attr; attr++) {
-		free(*attr);
-	}
-	free(cattr);
+	_descent_xml_release_cstrs(allocator, cattr, (size_t)attributes.length);
 error_free_cname:
-	free(cname);
+	_descent_xml_release_cstr(allocator, cname);
 error_return_xml:
 	xml.type = descent_xml_parse_error;
 	return xml;
@@ -425,7 +590,13 @@ inline void _cstr_text_handler(
 	if (!cstr_context->text_handler)
 		return;
 
-	char *const ctext = strndup(text.buffer, (size_t)text.length);
+	char *const ctext = descent_xml_strndup(
+		cstr_context->allocator,
+		text.buffer,
+		(size_t)text.length
+	);
+	_DESCENT_XML_STATS_ADD(strndup_calls, 1);
+	_DESCENT_XML_TRACE2(cstr__copy, 1, text.length);
 	if (!ctext) {
 		cstr_context->error = 1;
 		return;
@@ -437,7 +608,42 @@ inline void _cstr_text_handler(
 		cstr_context->context
 	);
 
-	free(ctext);
+	_descent_xml_release_cstr(cstr_context->allocator, ctext);
+}
+
+/**
+ * \brief descent_xml_parse_cstr(), allocating the strings with the
+ * 	given allocator.
+ *
+ * Handlers parsing further content should call this again with the
+ * same allocator.
+ *
+ * \param allocator The allocator, or a NULL pointer for malloc().
+ *
+ * \sa descent_xml_parse_cstr()
+ * \sa descent-xml/alloc.h
+ */
+inline struct descent_xml_lex descent_xml_parse_cstr_alloc(
+	struct descent_xml_lex xml,
+	const struct descent_xml_allocator *allocator,
+	descent_xml_parse_element_cstr_fn *element_handler,
+	descent_xml_parse_text_cstr_fn *text_handler,
+	void *context
+)
+{
+	_descent_xml_parse_cstr_context cstr_context = {
+		.element_handler = element_handler,
+		.text_handler = text_handler,
+		.context = context,
+		.allocator = allocator,
+	};
+	return descent_xml_parse_alloc(
+		xml,
+		allocator,
+		_cstr_element_handler,
+		_cstr_text_handler,
+		&cstr_context
+	);
 }
 
 /**
@@ -475,6 +681,8 @@ inline void _cstr_text_handler(
  *
  * \sa descent_xml_parse() An interface using pointer-length structs,
  * 	using no allocation or copying logic.
+ * \sa descent_xml_parse_cstr_alloc() To allocate with something other
+ * 	than malloc().
  */
 inline struct descent_xml_lex descent_xml_parse_cstr(
 	struct descent_xml_lex xml,
@@ -483,16 +691,12 @@ inline struct descent_xml_lex descent_xml_parse_cstr(
 	void *context
 )
 {
-	_descent_xml_parse_cstr_context cstr_context = {
-		.element_handler = element_handler,
-		.text_handler = text_handler,
-		.context = context,
-	};
-	return descent_xml_parse(
+	return descent_xml_parse_cstr_alloc(
 		xml,
-		_cstr_element_handler,
-		_cstr_text_handler,
-		&cstr_context
+		NULL,
+		element_handler,
+		text_handler,
+		context
 	);
 }
 
@@ -0,0 +1,250 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef DESCENT_XML_PARSER
+#define DESCENT_XML_PARSER
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <libadt/lptr.h>
+
+#include "alloc.h"
+#include "lex.h"
+#include "parse.h"
+#include "validate.h"
+
+/**
+ * \file
+ *
+ * A context for parsing one document after another, keeping its
+ * memory warm between them.
+ *
+ * A parser owns an arena that everything allocated while reading a
+ * document comes from: attribute lists, C-string copies, the stack of
+ * open elements and the tables for checking attribute names. Blocks
+ * are released in the reverse order they're allocated, so the arena
+ * is mostly reused as parsing goes, and only grows with the nesting
+ * depth and the largest element. Resetting the parser between
+ * documents rewinds the arena without freeing it, so after the first
+ * few documents nothing is allocated from the system at all.
+ *
+ * ```c
+ * struct descent_xml_parser parser;
+ * descent_xml_parser_init(&parser, 64 * 1024);
+ * for (each message) {
+ * 	struct descent_xml_lex token = descent_xml_parser_start(&parser, message);
+ * 	while (!done(token))
+ * 		token = descent_xml_parser_parse_cstr(&parser, token, on_element, on_text, context);
+ * }
+ * descent_xml_parser_free(&parser);
+ * ```
+ *
+ * A parser holds the state for one document at a time, so it
+ * shouldn't be shared between threads; give each worker its own.
+ */
+
+struct _descent_xml_arena_chunk;
+
+/**
+ * \brief Reusable state for parsing documents.
+ *
+ * Create one with descent_xml_parser_init() and release it with
+ * descent_xml_parser_free(). The allocator points back at the
+ * parser, so it mustn't be moved or copied once initialised.
+ */
+struct descent_xml_parser {
+	/**
+	 * \brief Allocates from the parser's arena. Pass it to any of
+	 * 	the `_alloc` functions; blocks from it are only valid until
+	 * 	the next reset.
+	 */
+	struct descent_xml_allocator allocator;
+
+	/**
+	 * \brief The validator used by descent_xml_parser_parse_validated().
+	 * 	Its max_depth, dtd and schema members can be set after each
+	 * 	reset; they're kept across resets, but the DTD and schema
+	 * 	validators' own state isn't touched.
+	 */
+	struct descent_xml_validator validator;
+
+	struct _descent_xml_arena_chunk *chunks;
+	struct _descent_xml_arena_chunk *current;
+
+	/**
+	 * \brief Bytes used in the current chunk.
+	 */
+	size_t used;
+
+	/**
+	 * \brief Bytes used in the chunks before the current one.
+	 */
+	size_t used_before;
+
+	/**
+	 * \brief The total size of the arena's chunks.
+	 */
+	size_t capacity;
+
+	/**
+	 * \brief The most bytes in use at once since the parser was
+	 * 	initialised.
+	 */
+	size_t peak;
+};
+
+/**
+ * \brief Initialises a parser.
+ *
+ * \param parser The parser to initialise.
+ * \param capacity The size to give the arena up front, or zero to
+ * 	allocate it when it's first needed.
+ *
+ * \returns True on success, false if the arena couldn't be allocated.
+ * 	The parser can be used either way.
+ */
+bool descent_xml_parser_init(struct descent_xml_parser *parser, size_t capacity);
+
+/**
+ * \brief Releases the memory held by a parser.
+ */
+void descent_xml_parser_free(struct descent_xml_parser *parser);
+
+/**
+ * \brief Gets a parser ready for another document.
+ *
+ * Everything allocated from the parser is released at once, without
+ * giving the memory back to the system. If the last document needed
+ * more than one chunk of arena, they're merged into one big enough for
+ * it.
+ */
+void descent_xml_parser_reset(struct descent_xml_parser *parser);
+
+/**
+ * \brief Resets a parser and starts on a document.
+ *
+ * \returns A token at the start of the document, as from
+ * 	descent_xml_lex_init().
+ */
+inline struct descent_xml_lex descent_xml_parser_start(
+	struct descent_xml_parser *parser,
+	struct libadt_const_lptr script
+)
+{
+	descent_xml_parser_reset(parser);
+	return descent_xml_lex_init(script);
+}
+
+/**
+ * \brief descent_xml_parse(), allocating from the parser.
+ *
+ * \sa descent_xml_parse_alloc()
+ */
+inline struct descent_xml_lex descent_xml_parser_parse(
+	struct descent_xml_parser *parser,
+	struct descent_xml_lex xml,
+	descent_xml_parse_element_fn *element_handler,
+	descent_xml_parse_text_fn *text_handler,
+	void *context
+)
+{
+	return descent_xml_parse_alloc(
+		xml,
+		&parser->allocator,
+		element_handler,
+		text_handler,
+		context
+	);
+}
+
+/**
+ * \brief descent_xml_parse_cstr(), allocating the strings from the
+ * 	parser.
+ *
+ * \sa descent_xml_parse_cstr_alloc()
+ */
+inline struct descent_xml_lex descent_xml_parser_parse_cstr(
+	struct descent_xml_parser *parser,
+	struct descent_xml_lex xml,
+	descent_xml_parse_element_cstr_fn *element_handler,
+	descent_xml_parse_text_cstr_fn *text_handler,
+	void *context
+)
+{
+	return descent_xml_parse_cstr_alloc(
+		xml,
+		&parser->allocator,
+		element_handler,
+		text_handler,
+		context
+	);
+}
+
+/**
+ * \brief descent_xml_parse_validated(), with the parser's validator.
+ *
+ * \sa descent_xml_parse_validated()
+ */
+inline struct descent_xml_lex descent_xml_parser_parse_validated(
+	struct descent_xml_parser *parser,
+	struct descent_xml_lex xml,
+	descent_xml_parse_element_fn *element_handler,
+	descent_xml_parse_text_fn *text_handler,
+	void *context
+)
+{
+	return descent_xml_parse_validated(
+		xml,
+		&parser->validator,
+		element_handler,
+		text_handler,
+		context
+	);
+}
+
+/**
+ * \brief Resets a parser and checks that a script is a well-formed
+ * 	document, nesting no deeper than the validator's max_depth.
+ *
+ * \param flags DESCENT_XML_VALIDATE_* flags, or zero.
+ *
+ * \sa descent_xml_validate_document_flags()
+ */
+inline bool descent_xml_parser_validate(
+	struct descent_xml_parser *parser,
+	struct libadt_const_lptr script,
+	unsigned flags
+)
+{
+	return descent_xml_validate_document_alloc(
+		descent_xml_parser_start(parser, script),
+		parser->validator.max_depth,
+		flags,
+		&parser->allocator
+	);
+}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // DESCENT_XML_PARSER
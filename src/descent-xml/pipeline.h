@@ -0,0 +1,211 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef DESCENT_XML_PIPELINE
+#define DESCENT_XML_PIPELINE
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "lex.h"
+#include "parse.h"
+
+/**
+ * \file
+ *
+ * A pipelined alternative to calling descent_xml_parse() in a loop,
+ * for when the handlers cost as much as the parsing does.
+ *
+ * The calling thread lexes the document and packs the elements,
+ * closing tags and text nodes it finds into batches. Each batch is
+ * pushed onto a lock-free single-producer/single-consumer ring owned
+ * by a handler thread, which runs the user's callbacks over it while
+ * the calling thread carries on lexing. When a ring is full, the
+ * lexer waits for its handler thread to catch up.
+ *
+ * With a single handler thread, the callbacks see the document in
+ * order, exactly as a flat descent_xml_parse() loop would. With more
+ * than one, batches are dealt out to the handler threads in turn:
+ * the events inside a batch stay in order, but batches are handled
+ * concurrently, so the callbacks must be thread-safe and must not
+ * rely on seeing an element's content in the same call sequence as
+ * its opening tag.
+ *
+ * All the values passed to the callbacks point into the original
+ * script, which must outlive descent_xml_pipeline_run().
+ */
+
+/**
+ * \brief Type signature for a pipeline opening-tag callback.
+ *
+ * \param element_name A length-pointer to the element name.
+ * \param attributes A length-pointer of length-pointers, laid out
+ * 	the same way as for descent_xml_parse_element_fn.
+ * \param empty True if the element is an empty element, of the format
+ * 	`<element-name />`. No close callback follows an empty element.
+ * \param context The pointer provided to descent_xml_pipeline_run().
+ */
+typedef void descent_xml_pipeline_element_fn(
+	struct libadt_const_lptr element_name,
+	struct libadt_const_lptr attributes,
+	bool empty,
+	void *context
+);
+
+/**
+ * \brief Type signature for a pipeline closing-tag callback.
+ *
+ * \param element_name A length-pointer to the closing tag's name.
+ * \param context The pointer provided to descent_xml_pipeline_run().
+ */
+typedef void descent_xml_pipeline_close_fn(
+	struct libadt_const_lptr element_name,
+	void *context
+);
+
+/**
+ * \brief The callbacks run by the handler threads. Any of them can
+ * 	be a NULL pointer to disable it.
+ */
+struct descent_xml_pipeline_handlers {
+	descent_xml_pipeline_element_fn *element_handler;
+	descent_xml_pipeline_close_fn *close_handler;
+	descent_xml_parse_text_fn *text_handler;
+};
+
+/**
+ * \brief Options for descent_xml_pipeline_run().
+ *
+ * A zero-initialized struct is valid and selects the defaults.
+ */
+struct descent_xml_pipeline_options {
+	/**
+	 * \brief Number of handler threads. Zero selects one.
+	 */
+	unsigned handler_threads;
+
+	/**
+	 * \brief Number of batches each handler thread's ring can
+	 * 	hold before the lexer has to wait. Zero selects 16.
+	 */
+	unsigned queue_batches;
+
+	/**
+	 * \brief Maximum number of events in a batch. Zero selects 256.
+	 */
+	unsigned batch_events;
+};
+
+/**
+ * \brief Counters for one stage of the pipeline.
+ */
+struct descent_xml_pipeline_stage_stats {
+	/**
+	 * \brief Script bytes consumed by the stage.
+	 */
+	size_t bytes;
+
+	/**
+	 * \brief Elements, closing tags and text nodes passed through
+	 * 	the stage.
+	 */
+	size_t events;
+
+	/**
+	 * \brief Batches passed through the stage.
+	 */
+	size_t batches;
+
+	/**
+	 * \brief Number of times the stage had to wait on its ring:
+	 * 	for the lexer, because a ring was full; for the handlers,
+	 * 	because their ring was empty.
+	 */
+	size_t stalls;
+
+	/**
+	 * \brief Seconds the stage spent working, summed over threads.
+	 */
+	double busy_seconds;
+
+	/**
+	 * \brief Seconds the stage spent waiting on its rings, summed
+	 * 	over threads.
+	 */
+	double wait_seconds;
+};
+
+/**
+ * \brief Throughput statistics filled in by descent_xml_pipeline_run().
+ */
+struct descent_xml_pipeline_stats {
+	/**
+	 * \brief The lexing stage, run on the calling thread.
+	 */
+	struct descent_xml_pipeline_stage_stats lexer;
+
+	/**
+	 * \brief The handler stage, summed over all handler threads.
+	 */
+	struct descent_xml_pipeline_stage_stats handlers;
+
+	/**
+	 * \brief Wall-clock seconds for the whole run.
+	 */
+	double elapsed_seconds;
+};
+
+/**
+ * \brief Parses a document, running the handlers on separate threads
+ * 	from the lexer.
+ *
+ * \param xml A token into an XML document. Can be created on a full
+ * 	XML document using descent_xml_lex_init().
+ * \param options Pipeline options. Pass a NULL pointer for the
+ * 	defaults.
+ * \param handlers The callbacks to run on the handler threads.
+ * \param context A user-provided pointer that will be passed to
+ * 	the callbacks.
+ * \param stats A struct to receive throughput statistics. Pass a NULL
+ * 	pointer to disable.
+ *
+ * \returns The last token encountered by the lexer. If the `type`
+ * 	property is `descent_xml_classifier_unexpected`, a lex error
+ * 	occurred; events up to the error have still been handled. If
+ * 	the `type` property is `descent_xml_parse_error`, the pipeline
+ * 	couldn't allocate its queues or start its threads. If the `type`
+ * 	property is `descent_xml_classifier_eof`, the whole document was
+ * 	handled.
+ */
+struct descent_xml_lex descent_xml_pipeline_run(
+	struct descent_xml_lex xml,
+	const struct descent_xml_pipeline_options *options,
+	const struct descent_xml_pipeline_handlers *handlers,
+	void *context,
+	struct descent_xml_pipeline_stats *stats
+);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // DESCENT_XML_PIPELINE
@@ -0,0 +1,195 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef DESCENT_XML_READ
+#define DESCENT_XML_READ
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <libadt/lptr.h>
+
+#include "cpu.h"
+
+/**
+ * \file
+ *
+ * Helpers for getting a document off a file descriptor and into
+ * memory, ready for descent_xml_lex_init().
+ *
+ * On Linux, when the library is built with io_uring support, reads
+ * are issued through an io_uring with several requests kept in
+ * flight at once, each into its own buffer from a small pool. Chunks
+ * are handed back in file order as they complete, so the caller can
+ * work on one chunk while the kernel is still filling the next.
+ *
+ * If io_uring isn't compiled in, isn't permitted (e.g. by a seccomp
+ * policy) or the descriptor isn't a regular file, the reader falls
+ * back to plain pread()/read() calls with the same interface.
+ */
+
+/**
+ * \brief Forces the synchronous pread() path, even if io_uring is
+ * 	available. Mostly useful for benchmarking and testing.
+ */
+#define DESCENT_XML_READ_SYNC 1
+
+/**
+ * \brief Makes descent_xml_read_fd() pad the result with
+ * 	DESCENT_XML_PADDING zero bytes after the end, not counted in its
+ * 	length.
+ */
+#define DESCENT_XML_READ_PADDED 2
+
+/**
+ * \brief Options controlling how a descriptor is read.
+ *
+ * A zero-initialized struct is valid and selects the defaults.
+ */
+struct descent_xml_read_options {
+	/**
+	 * \brief Size of each buffer in the pool, in bytes. Zero
+	 * 	selects a 64 KiB default.
+	 */
+	size_t chunk_size;
+
+	/**
+	 * \brief Number of reads to keep in flight, which is also the
+	 * 	number of buffers in the pool. Zero selects a default of 8.
+	 */
+	unsigned queue_depth;
+
+	/**
+	 * \brief Bitwise OR of DESCENT_XML_READ_* flags.
+	 */
+	int flags;
+};
+
+/**
+ * \brief Type signature for a user-passed chunk callback. Used by
+ * 	descent_xml_read_chunks().
+ *
+ * \param chunk The bytes read. The buffer belongs to the reader and
+ * 	is reused for a later read once the callback returns, so
+ * 	anything that needs to outlive the call must be copied.
+ * \param context The pointer provided to descent_xml_read_chunks().
+ *
+ * \returns Zero to keep reading, non-zero to stop early.
+ */
+typedef int descent_xml_read_chunk_fn(
+	struct libadt_const_lptr chunk,
+	void *context
+);
+
+/**
+ * \brief Reports whether io_uring reads can be used in this process.
+ *
+ * \returns True if the library was built with io_uring support and
+ * 	the kernel accepted a ring setup, false otherwise.
+ */
+bool descent_xml_read_io_uring_available(void);
+
+/**
+ * \brief Reads fd from the beginning to the end of the file, passing
+ * 	each chunk, in order, to chunk_handler.
+ *
+ * \param fd The file descriptor to read. Regular files are read with
+ * 	absolute offsets and the file position is not changed. Other
+ * 	descriptors, such as pipes, are read from their current position.
+ * \param options Read options. Pass a NULL pointer for the defaults.
+ * \param chunk_handler The callback receiving each chunk.
+ * \param context A user-provided pointer that will be passed to
+ * 	chunk_handler.
+ *
+ * \returns Zero when the end of the file was reached or the callback
+ * 	asked to stop, -1 on a read or allocation error with errno set.
+ */
+int descent_xml_read_chunks(
+	int fd,
+	const struct descent_xml_read_options *options,
+	descent_xml_read_chunk_fn *chunk_handler,
+	void *context
+);
+
+/**
+ * \brief Reads the whole of fd into a newly-allocated buffer.
+ *
+ * For regular files, the reads are issued directly into the result
+ * buffer, without copying through the chunk pool.
+ *
+ * \param fd The file descriptor to read.
+ * \param options Read options. Pass a NULL pointer for the defaults.
+ *
+ * \returns A length-pointer to the file's contents, which can be
+ * 	passed to descent_xml_lex_init(). The buffer must be released
+ * 	with free(). On error, the buffer is a NULL pointer and errno
+ * 	is set.
+ */
+struct libadt_lptr descent_xml_read_fd(
+	int fd,
+	const struct descent_xml_read_options *options
+);
+
+/**
+ * \brief A file mapped into memory by descent_xml_read_map().
+ */
+struct descent_xml_read_mapping {
+	/**
+	 * \brief The file's contents, which can be passed to
+	 * 	descent_xml_lex_init(). Padded with DESCENT_XML_PADDING or
+	 * 	more zero bytes, followed by an unreadable guard page.
+	 */
+	struct libadt_const_lptr script;
+
+	/**
+	 * \brief The whole mapping, guard page included.
+	 */
+	void *base;
+	size_t size;
+};
+
+/**
+ * \brief Maps a regular file into memory, read-only and padded.
+ *
+ * The padding is followed by a page that can't be accessed, so a
+ * kernel that reads past its padding faults straight away rather
+ * than reading whatever comes next. The file mustn't be truncated
+ * while it's mapped.
+ *
+ * \param fd The file descriptor, which can be closed afterwards.
+ * \param mapping Set to the mapping.
+ *
+ * \returns Zero on success, -1 with errno set on failure, including
+ * 	EINVAL if fd isn't a regular file.
+ */
+int descent_xml_read_map(int fd, struct descent_xml_read_mapping *mapping);
+
+/**
+ * \brief Releases a mapping made by descent_xml_read_map().
+ */
+void descent_xml_read_unmap(struct descent_xml_read_mapping *mapping);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // DESCENT_XML_READ
@@ -0,0 +1,250 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef DESCENT_XML_SCHEMA
+#define DESCENT_XML_SCHEMA
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <libadt/lptr.h>
+
+#include "alloc.h"
+#include "lex.h"
+
+/**
+ * \file
+ *
+ * Validation against a subset of W3C XML Schema.
+ *
+ * A schema is compiled once, with descent_xml_schema_compile() or
+ * descent_xml_schema_load(). Complex types become deterministic
+ * automata over the names of their child elements, in the same way
+ * as DTD content models, and simple types become chains of facet
+ * checks. As with DTDs, the compiled schema is never modified, so it
+ * can be shared between threads and reused for any number of
+ * documents.
+ *
+ * The supported subset is:
+ *
+ * - global and local `element`s, with `ref`, `type` or an anonymous
+ *   type, `minOccurs` and `maxOccurs`;
+ * - named and anonymous `complexType`s, with `sequence`, `choice` and
+ *   `all` content (`all` holding at most 64 elements), `mixed`,
+ *   `attribute`s, `anyAttribute`, and `simpleContent` extending or
+ *   restricting a simple type;
+ * - named and anonymous `simpleType`s, restricting a built-in or
+ *   another simple type with `enumeration`, `pattern`, `minInclusive`,
+ *   `maxInclusive`, `minExclusive`, `maxExclusive`, `length`,
+ *   `minLength`, `maxLength` and `whiteSpace`, or a `list` of one;
+ * - the string, name, boolean, decimal, integer, float and date/time
+ *   built-in types.
+ *
+ * Namespaces aren't resolved: element, attribute and type names are
+ * matched on their local part, and `xmlns`, `xml:` and `xsi:`
+ * attributes in documents are ignored. Patterns are translated to
+ * POSIX extended regular expressions, which covers the usual
+ * character class escapes but not Unicode categories. Anything
+ * outside the subset makes the compile fail, rather than being
+ * silently ignored.
+ */
+
+/**
+ * \brief A compiled schema. Opaque; created by
+ * 	descent_xml_schema_compile() or descent_xml_schema_load().
+ */
+struct descent_xml_schema;
+
+struct _descent_xml_schema_frame {
+	size_t type;
+	int32_t state;
+	uint64_t seen;
+	size_t text;
+};
+
+/**
+ * \brief Holds the state for validating one document against a
+ * 	compiled schema.
+ *
+ * Create one with descent_xml_schema_validator_init() and release it
+ * with descent_xml_schema_validator_free().
+ */
+struct descent_xml_schema_validator {
+	/**
+	 * \brief The schema being validated against.
+	 */
+	const struct descent_xml_schema *schema;
+
+	struct _descent_xml_schema_frame *frames;
+	size_t depth;
+	size_t capacity;
+
+	// text content of simple-typed elements, with entities
+	// replaced, collected until the element closes
+	char *text;
+	size_t text_length;
+	size_t text_capacity;
+
+	/**
+	 * \brief The allocator for the validator's stack and text, or a NULL
+	 * 	pointer for malloc(). The init function sets this to NULL;
+	 * 	change it before the first element.
+	 */
+	const struct descent_xml_allocator *allocator;
+};
+
+/**
+ * \brief Compiles a schema document.
+ *
+ * \param xsd The text of the schema. It's copied, so it doesn't have
+ * 	to outlive the result.
+ *
+ * \returns The compiled schema, to be released with
+ * 	descent_xml_schema_free(), or a NULL pointer if the schema is
+ * 	malformed, uses something outside the supported subset, or
+ * 	memory couldn't be allocated.
+ */
+struct descent_xml_schema *descent_xml_schema_compile(struct libadt_const_lptr xsd);
+
+/**
+ * \brief Reads and compiles a schema file.
+ *
+ * \param path The path of the schema file.
+ *
+ * \returns The compiled schema, or a NULL pointer if the file
+ * 	couldn't be read, with errno set, or couldn't be compiled.
+ *
+ * \sa descent_xml_schema_compile()
+ */
+struct descent_xml_schema *descent_xml_schema_load(const char *path);
+
+/**
+ * \brief Releases a compiled schema.
+ *
+ * \param schema The schema to release. Can be a NULL pointer.
+ */
+void descent_xml_schema_free(struct descent_xml_schema *schema);
+
+/**
+ * \brief Creates a validator for one document.
+ *
+ * \param schema The compiled schema to validate against. It must
+ * 	outlive the validator.
+ *
+ * \returns A validator at the start of a document. No memory is
+ * 	allocated until the first element is opened.
+ */
+inline struct descent_xml_schema_validator descent_xml_schema_validator_init(
+	const struct descent_xml_schema *schema
+)
+{
+	return (struct descent_xml_schema_validator) { .schema = schema };
+}
+
+/**
+ * \brief Releases the memory held by a validator.
+ *
+ * \param validator The validator to release. The compiled schema is
+ * 	not released.
+ */
+inline void descent_xml_schema_validator_free(
+	struct descent_xml_schema_validator *validator
+)
+{
+	descent_xml_release(
+		validator->allocator,
+		validator->frames,
+		validator->capacity * sizeof(*validator->frames)
+	);
+	descent_xml_release(
+		validator->allocator,
+		validator->text,
+		validator->text_capacity
+	);
+	validator->frames = NULL;
+	validator->text = NULL;
+	validator->depth = validator->capacity = 0;
+	validator->text_length = validator->text_capacity = 0;
+}
+
+/**
+ * \brief Checks an opening tag against the schema and advances the
+ * 	parent element's content model.
+ *
+ * The arguments are the ones passed to a descent_xml_parse_element_fn.
+ *
+ * \returns True if the element is allowed here and its attributes
+ * 	are valid, false otherwise. Memory allocation failures also
+ * 	return false.
+ */
+bool descent_xml_schema_element(
+	struct descent_xml_schema_validator *validator,
+	struct libadt_const_lptr element_name,
+	struct libadt_const_lptr attributes,
+	bool empty
+);
+
+/**
+ * \brief Checks a text node against the type of the open element.
+ *
+ * The arguments are the ones passed to a descent_xml_parse_text_fn.
+ * The text of simple-typed elements is collected, and checked when
+ * the element closes.
+ *
+ * \returns True if the text is allowed here, false otherwise.
+ */
+bool descent_xml_schema_text(
+	struct descent_xml_schema_validator *validator,
+	struct libadt_const_lptr text,
+	bool is_cdata
+);
+
+/**
+ * \brief Checks that the open element's content is complete and
+ * 	valid, and closes it.
+ *
+ * \returns True if the content is valid, false otherwise.
+ */
+bool descent_xml_schema_close(struct descent_xml_schema_validator *validator);
+
+/**
+ * \brief Checks that a document is well-formed and valid against a
+ * 	schema, in a single pass.
+ *
+ * \param schema The compiled schema.
+ * \param token A token at the start of the document, as created by
+ * 	descent_xml_lex_init().
+ *
+ * \returns True if the document is valid, false otherwise.
+ */
+bool descent_xml_schema_validate_document(
+	const struct descent_xml_schema *schema,
+	struct descent_xml_lex token
+);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // DESCENT_XML_SCHEMA
@@ -0,0 +1,185 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef DESCENT_XML_STATS_H
+#define DESCENT_XML_STATS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "classifier.h"
+
+/**
+ * \file
+ *
+ * Counters for the lexer and parser hot paths, for finding out where
+ * time goes on real documents.
+ *
+ * Counting is compiled in only when `DESCENT_XML_STATS` is defined,
+ * which the CMake option of the same name does for the library and
+ * everything linking it. Without it the counting macros expand to
+ * nothing, and the functions below report zeros, so code calling
+ * them builds either way.
+ *
+ * Counters are thread-local: each thread sees, and resets, only the
+ * work it did itself. Most of the library is inline functions
+ * compiled into the caller, so define `DESCENT_XML_STATS` for the
+ * whole program rather than for single files.
+ */
+
+/**
+ * \brief The number of token type slots in struct descent_xml_stats.
+ *
+ * Slot zero counts token types the library doesn't know about, such
+ * as ones from a user-defined classifier.
+ */
+#define DESCENT_XML_STATS_TYPES 48
+
+/**
+ * \brief A snapshot of the counters.
+ */
+struct descent_xml_stats {
+	/**
+	 * \brief Tokens produced by descent_xml_lex_next_raw(), by
+	 * 	type; see descent_xml_stats_type_name().
+	 */
+	size_t tokens[DESCENT_XML_STATS_TYPES];
+
+	/**
+	 * \brief Bytes covered by those tokens, by type.
+	 */
+	size_t token_bytes[DESCENT_XML_STATS_TYPES];
+
+	/**
+	 * \brief Times the first alternative of descent_xml_lex_or()
+	 * 	failed and the second was tried from the same point.
+	 */
+	size_t or_backtracks;
+
+	/**
+	 * \brief Bytes decoded by the failed first alternatives.
+	 */
+	size_t or_wasted_bytes;
+
+	/**
+	 * \brief Times the section passed to descent_xml_lex_optional()
+	 * 	failed.
+	 */
+	size_t optional_backtracks;
+
+	/**
+	 * \brief Bytes decoded by the failed optional sections.
+	 */
+	size_t optional_wasted_bytes;
+
+	/**
+	 * \brief Calls to mbrtowc(), and the bytes they decoded.
+	 */
+	size_t mbrtowc_calls;
+	size_t decoded_bytes;
+
+	/**
+	 * \brief Bytes compared by the byte-at-a-time scans for fixed
+	 * 	strings, such as the ends of comments and CDATA sections.
+	 */
+	size_t compared_bytes;
+
+	/**
+	 * \brief Times the attribute vector built for each element
+	 * 	by descent_xml_parse() had to grow.
+	 */
+	size_t vector_allocations;
+
+	/**
+	 * \brief Strings copied by descent_xml_parse_cstr().
+	 */
+	size_t strndup_calls;
+};
+
+/**
+ * \returns True if the library was built with counting enabled.
+ */
+bool descent_xml_stats_enabled(void);
+
+/**
+ * \returns The calling thread's counters.
+ */
+struct descent_xml_stats descent_xml_stats_get(void);
+
+/**
+ * \brief Zeroes the calling thread's counters.
+ */
+void descent_xml_stats_reset(void);
+
+/**
+ * \returns The name of the token type counted in a slot of
+ * 	descent_xml_stats.tokens, or a NULL pointer for unused slots.
+ */
+const char *descent_xml_stats_type_name(size_t slot);
+
+/**
+ * \returns The slot that tokens of a type are counted in.
+ */
+size_t descent_xml_stats_type_slot(descent_xml_classifier_fn *type);
+
+#ifdef DESCENT_XML_STATS
+
+#ifdef __cplusplus
+extern thread_local struct descent_xml_stats _descent_xml_stats;
+#else
+extern _Thread_local struct descent_xml_stats _descent_xml_stats;
+#endif
+
+#define _DESCENT_XML_STATS_ADD(field, amount) \
+	((void)(_descent_xml_stats.field += (size_t)(amount)))
+
+#define _DESCENT_XML_STATS_TOKEN(token) \
+	do { \
+		const size_t _slot = descent_xml_stats_type_slot((token).type); \
+		_descent_xml_stats.tokens[_slot]++; \
+		_descent_xml_stats.token_bytes[_slot] += (size_t)(token).value.length; \
+	} while (0)
+
+// Marks the decoding position before trying a section that might
+// fail, so the bytes it wasted can be counted.
+#define _DESCENT_XML_STATS_MARK(mark) \
+	const size_t mark = _descent_xml_stats.decoded_bytes
+
+#define _DESCENT_XML_STATS_BACKTRACK(kind, mark) \
+	do { \
+		_descent_xml_stats.kind##_backtracks++; \
+		_descent_xml_stats.kind##_wasted_bytes += _descent_xml_stats.decoded_bytes - (mark); \
+	} while (0)
+
+#else
+
+#define _DESCENT_XML_STATS_ADD(field, amount) ((void)0)
+#define _DESCENT_XML_STATS_TOKEN(token) ((void)0)
+#define _DESCENT_XML_STATS_MARK(mark)
+#define _DESCENT_XML_STATS_BACKTRACK(kind, mark) ((void)0)
+
+#endif
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // DESCENT_XML_STATS_H
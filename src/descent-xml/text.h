@@ -0,0 +1,335 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef DESCENT_XML_TEXT
+#define DESCENT_XML_TEXT
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <libadt/lptr.h>
+#include <libadt/vector.h>
+
+#include "alloc.h"
+#include "lex.h"
+#include "parse.h"
+
+/**
+ * \file
+ *
+ * Delivering each text node as one value.
+ *
+ * descent_xml_parse() passes a text node to the text handler in
+ * pieces: once for the text around each CDATA section and once for
+ * each section. descent_xml_parse_coalesced() calls it once for the
+ * whole node instead, so `a<![CDATA[<b>]]>c` arrives as `a<b>c`.
+ * Comments inside the node are left out.
+ *
+ * The value still points into the document when it can: a node that
+ * is one run of text, or one CDATA section, is passed as it is. Only
+ * a node made of several pieces is copied, into a buffer kept in a
+ * struct descent_xml_text and reused from node to node, so it's only
+ * valid until the next node is read:
+ *
+ * ```c
+ * struct descent_xml_text text;
+ * descent_xml_text_init(&text, DESCENT_XML_TEXT_DECODE, NULL);
+ * struct descent_xml_lex token = descent_xml_lex_init(document);
+ * do {
+ * 	token = descent_xml_parse_coalesced(token, &text, on_element, on_text, context);
+ * } while (!_descent_xml_end_token(token));
+ * descent_xml_text_free(&text);
+ * ```
+ *
+ * With DESCENT_XML_TEXT_DECODE, the predefined entities and character
+ * references in text are replaced too. Text with references in it is
+ * then always copied; CDATA sections are never decoded.
+ *
+ * With DESCENT_XML_TEXT_SKIP_SPACE, nodes holding only whitespace,
+ * such as the indentation between the elements of a pretty-printed
+ * document, aren't passed to the text handler at all.
+ *
+ * For nodes too large to want in one piece, such as embedded base64
+ * payloads, descent_xml_parse_chunked() passes each node on in chunks
+ * of at most chunk_size bytes instead, marked as the beginning and end
+ * of the node, so they can be fed straight to a decoder or a file.
+ * Nothing is copied but decoded chunks, so the memory used stays
+ * within two chunks however large the node is.
+ */
+
+/**
+ * \brief Replace the predefined entities (`&lt;`, `&gt;`, `&amp;`,
+ * 	`&apos;` and `&quot;`) and character references in text.
+ * 	Other entities, malformed references, and references over 16
+ * 	bytes long, are left as they are.
+ */
+#define DESCENT_XML_TEXT_DECODE 0x1
+
+/**
+ * \brief Don't call the text handler for nodes that hold only
+ * 	whitespace outside CDATA sections.
+ */
+#define DESCENT_XML_TEXT_SKIP_SPACE 0x2
+
+/**
+ * \brief The default largest chunk for descent_xml_parse_chunked():
+ * 	64 KiB.
+ */
+#define DESCENT_XML_TEXT_CHUNK_SIZE (64 * 1024)
+
+/**
+ * \brief Marks the first chunk of a node.
+ */
+#define DESCENT_XML_TEXT_CHUNK_BEGIN 0x1
+
+/**
+ * \brief Marks the last chunk of a node.
+ */
+#define DESCENT_XML_TEXT_CHUNK_END 0x2
+
+/**
+ * \brief Type signature for a user-passed text chunk function. Used
+ * 	by descent_xml_parse_chunked().
+ *
+ * \param chunk Part of a text node, pointing into the document or, if
+ * 	decoded, into a buffer that's only valid until the next call.
+ * 	Chunks are at most chunk_size bytes, and in UTF-8 never split
+ * 	a character.
+ * \param position DESCENT_XML_TEXT_CHUNK_BEGIN on the first chunk of
+ * 	a node and DESCENT_XML_TEXT_CHUNK_END on the last, so both on
+ * 	a node in one chunk, and neither on the chunks between.
+ * \param is_cdata True if the chunk came from a CDATA section.
+ * \param context The pointer provided to descent_xml_parse_chunked()
+ * 	by the user.
+ */
+typedef void descent_xml_text_chunk_fn(
+	struct libadt_const_lptr chunk,
+	unsigned position,
+	bool is_cdata,
+	void *context
+);
+
+/**
+ * \brief State for coalescing text nodes.
+ *
+ * Create one with descent_xml_text_init() and release it with
+ * descent_xml_text_free().
+ */
+struct descent_xml_text {
+	/**
+	 * \brief Storage for values made of several pieces, or
+	 * 	decoded. A vector of chars, reused from node to node.
+	 */
+	struct libadt_vector buffer;
+
+	/**
+	 * \brief DESCENT_XML_TEXT_DECODE and
+	 * 	DESCENT_XML_TEXT_SKIP_SPACE, or zero.
+	 */
+	unsigned flags;
+
+	/**
+	 * \brief The largest chunk passed to a
+	 * 	descent_xml_text_chunk_fn. DESCENT_XML_TEXT_CHUNK_SIZE
+	 * 	unless set after descent_xml_text_init(); anything under 16
+	 * 	counts as 16.
+	 */
+	size_t chunk_size;
+
+	/**
+	 * \brief Set by descent_xml_text_read() if the node held only
+	 * 	whitespace, outside CDATA sections, and by
+	 * 	descent_xml_text_read_chunks() given
+	 * 	DESCENT_XML_TEXT_SKIP_SPACE.
+	 */
+	bool blank;
+
+	/**
+	 * \brief The allocator for the buffer and for parsing, or a NULL
+	 * 	pointer for malloc().
+	 */
+	const struct descent_xml_allocator *allocator;
+};
+
+/**
+ * \brief Initialises the state for coalescing text nodes.
+ *
+ * Nothing is allocated until a node needs copying.
+ *
+ * \param text The state to initialise.
+ * \param flags DESCENT_XML_TEXT_DECODE and
+ * 	DESCENT_XML_TEXT_SKIP_SPACE, or zero.
+ * \param allocator The allocator, or a NULL pointer for malloc().
+ */
+void descent_xml_text_init(
+	struct descent_xml_text *text,
+	unsigned flags,
+	const struct descent_xml_allocator *allocator
+);
+
+/**
+ * \brief Releases the buffer. The state can be initialised again.
+ */
+void descent_xml_text_free(struct descent_xml_text *text);
+
+/**
+ * \brief Reads a whole text node.
+ *
+ * \param token The first token of the node: a text token, or a CDATA
+ * 	section.
+ * \param text The coalescing state.
+ * \param value Set to the text of the node, pointing into the
+ * 	document or into text's buffer.
+ * \param is_cdata Set to true if the node was made only of CDATA
+ * 	sections, and comments.
+ *
+ * \returns The last token of the node, to lex on from. Its type is
+ * 	descent_xml_parse_error if memory couldn't be allocated, in
+ * 	which case value is left alone.
+ */
+struct descent_xml_lex descent_xml_text_read(
+	struct descent_xml_lex token,
+	struct descent_xml_text *text,
+	struct libadt_const_lptr *value,
+	bool *is_cdata
+);
+
+/**
+ * \brief descent_xml_parse(), calling the text handler once per text
+ * 	node.
+ *
+ * Attribute lists are allocated with text's allocator. Element
+ * handlers parsing further content should call this again with the
+ * same state.
+ *
+ * \param text The coalescing state.
+ *
+ * \sa descent_xml_parse()
+ */
+inline struct descent_xml_lex descent_xml_parse_coalesced(
+	struct descent_xml_lex xml,
+	struct descent_xml_text *text,
+	descent_xml_parse_element_fn *element_handler,
+	descent_xml_parse_text_fn *text_handler,
+	void *context
+)
+{
+	_descent_xml_parse_begin(xml);
+	xml = descent_xml_lex_next_raw(xml);
+
+	if (xml.type == descent_xml_classifier_element_name && element_handler) {
+		xml = _descent_xml_handle_element(
+			xml,
+			text->allocator,
+			element_handler,
+			context
+		);
+	} else if (
+		text_handler
+		&& (_descent_xml_is_text_type(xml) || xml.type == descent_xml_lex_cdata)
+	) {
+		struct libadt_const_lptr value;
+		bool is_cdata;
+		xml = descent_xml_text_read(xml, text, &value, &is_cdata);
+		const bool skip = text->blank
+			&& (text->flags & DESCENT_XML_TEXT_SKIP_SPACE);
+		if (xml.type != descent_xml_parse_error && !skip)
+			text_handler(value, is_cdata, context);
+	}
+
+	return _descent_xml_parse_end(xml);
+}
+
+/**
+ * \brief Reads a whole text node, passing it on in chunks.
+ *
+ * The handler is called once or more, as the node is read: with
+ * DESCENT_XML_TEXT_CHUNK_BEGIN first and DESCENT_XML_TEXT_CHUNK_END
+ * last. A node that's empty, or all empty CDATA sections, is passed
+ * on as one empty chunk. Given DESCENT_XML_TEXT_SKIP_SPACE, a node of
+ * only whitespace isn't passed on at all.
+ *
+ * \param token The first token of the node: a text token, or a CDATA
+ * 	section.
+ * \param text The state, holding the chunk size and the buffer for
+ * 	decoded chunks.
+ * \param chunk_handler The function to pass the chunks to.
+ * \param context The pointer to pass to chunk_handler.
+ *
+ * \returns The last token of the node, to lex on from. Its type is
+ * 	descent_xml_parse_error if memory for decoding couldn't be
+ * 	allocated, in which case the handler isn't called.
+ */
+struct descent_xml_lex descent_xml_text_read_chunks(
+	struct descent_xml_lex token,
+	struct descent_xml_text *text,
+	descent_xml_text_chunk_fn *chunk_handler,
+	void *context
+);
+
+/**
+ * \brief descent_xml_parse(), passing text nodes to a chunk handler.
+ *
+ * Attribute lists are allocated with text's allocator. Element
+ * handlers parsing further content should call this again with the
+ * same state.
+ *
+ * \param text The state for reading text nodes.
+ * \param chunk_handler A callback to pass text nodes to in chunks.
+ * 	Pass a NULL pointer to disable.
+ *
+ * \sa descent_xml_parse()
+ * \sa descent_xml_text_read_chunks()
+ */
+inline struct descent_xml_lex descent_xml_parse_chunked(
+	struct descent_xml_lex xml,
+	struct descent_xml_text *text,
+	descent_xml_parse_element_fn *element_handler,
+	descent_xml_text_chunk_fn *chunk_handler,
+	void *context
+)
+{
+	_descent_xml_parse_begin(xml);
+	xml = descent_xml_lex_next_raw(xml);
+
+	if (xml.type == descent_xml_classifier_element_name && element_handler) {
+		xml = _descent_xml_handle_element(
+			xml,
+			text->allocator,
+			element_handler,
+			context
+		);
+	} else if (
+		chunk_handler
+		&& (_descent_xml_is_text_type(xml) || xml.type == descent_xml_lex_cdata)
+	) {
+		xml = descent_xml_text_read_chunks(xml, text, chunk_handler, context);
+	}
+
+	return _descent_xml_parse_end(xml);
+}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // DESCENT_XML_TEXT
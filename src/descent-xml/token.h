@@ -0,0 +1,252 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef DESCENT_XML_TOKEN
+#define DESCENT_XML_TOKEN
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "classifier.h"
+#include "lex.h"
+
+/**
+ * \file
+ *
+ * Small integer ids for token types, and the categories they belong
+ * to.
+ *
+ * Token types are classifier functions, which are good for lexing but
+ * awkward to switch on. descent_xml_token_id() maps a type to a dense
+ * id, usable as an index into tables of your own, and
+ * descent_xml_token_categories says which categories each id belongs
+ * to, so testing a token against a group of types is one lookup and
+ * one AND:
+ *
+ * ```c
+ * if (descent_xml_token_is(token, DESCENT_XML_TOKEN_CATEGORY_TEXT))
+ * 	...
+ *
+ * static void (*const dispatch[DESCENT_XML_TOKEN_COUNT])(struct descent_xml_lex) = {
+ * 	[DESCENT_XML_TOKEN_ELEMENT_NAME] = on_element,
+ * 	[DESCENT_XML_TOKEN_TEXT] = on_text,
+ * };
+ * ```
+ *
+ * The mapping is a hash table keyed on the function pointer, built the
+ * first time it's needed. A lookup is an atomic load, a hash and a
+ * probe, so on a hot path, comparing the type against the few
+ * pointers in a category directly is cheaper; the library's own
+ * parsing loops do that.
+ */
+
+/**
+ * \brief The id of each token type the library produces.
+ *
+ * Ids are in the range [0, DESCENT_XML_TOKEN_COUNT), and may be
+ * renumbered between versions; use the names.
+ */
+enum descent_xml_token_id {
+	/**
+	 * \brief A type the library doesn't know, such as one from a
+	 * 	classifier of your own.
+	 */
+	DESCENT_XML_TOKEN_UNKNOWN,
+	DESCENT_XML_TOKEN_START,
+	DESCENT_XML_TOKEN_TEXT,
+	DESCENT_XML_TOKEN_TEXT_SPACE,
+	DESCENT_XML_TOKEN_TEXT_ENTITY_START,
+	DESCENT_XML_TOKEN_TEXT_ENTITY,
+	DESCENT_XML_TOKEN_ELEMENT,
+	DESCENT_XML_TOKEN_ELEMENT_NAME,
+	DESCENT_XML_TOKEN_ELEMENT_SPACE,
+	DESCENT_XML_TOKEN_ELEMENT_EMPTY,
+	DESCENT_XML_TOKEN_ELEMENT_END,
+	DESCENT_XML_TOKEN_ELEMENT_CLOSE,
+	DESCENT_XML_TOKEN_ELEMENT_CLOSE_NAME,
+	DESCENT_XML_TOKEN_ELEMENT_CLOSE_SPACE,
+	DESCENT_XML_TOKEN_ATTRIBUTE_NAME,
+	DESCENT_XML_TOKEN_ATTRIBUTE_EXPECT_ASSIGN,
+	DESCENT_XML_TOKEN_ATTRIBUTE_ASSIGN,
+	DESCENT_XML_TOKEN_ATTRIBUTE_VALUE_SINGLE_QUOTE_START,
+	DESCENT_XML_TOKEN_ATTRIBUTE_VALUE_SINGLE_QUOTE,
+	DESCENT_XML_TOKEN_ATTRIBUTE_VALUE_SINGLE_QUOTE_ENTITY_START,
+	DESCENT_XML_TOKEN_ATTRIBUTE_VALUE_SINGLE_QUOTE_ENTITY,
+	DESCENT_XML_TOKEN_ATTRIBUTE_VALUE_SINGLE_QUOTE_END,
+	DESCENT_XML_TOKEN_ATTRIBUTE_VALUE_DOUBLE_QUOTE_START,
+	DESCENT_XML_TOKEN_ATTRIBUTE_VALUE_DOUBLE_QUOTE,
+	DESCENT_XML_TOKEN_ATTRIBUTE_VALUE_DOUBLE_QUOTE_ENTITY_START,
+	DESCENT_XML_TOKEN_ATTRIBUTE_VALUE_DOUBLE_QUOTE_ENTITY,
+	DESCENT_XML_TOKEN_ATTRIBUTE_VALUE_DOUBLE_QUOTE_END,
+	DESCENT_XML_TOKEN_DOCTYPE,
+	DESCENT_XML_TOKEN_XMLDECL,
+	DESCENT_XML_TOKEN_CDATA,
+	DESCENT_XML_TOKEN_COMMENT,
+	DESCENT_XML_TOKEN_EOF,
+	DESCENT_XML_TOKEN_UNEXPECTED,
+	DESCENT_XML_TOKEN_PARSE_ERROR,
+	DESCENT_XML_TOKEN_VALIDATE_ERROR,
+
+	/**
+	 * \brief The number of ids.
+	 */
+	DESCENT_XML_TOKEN_COUNT
+};
+
+/**
+ * \brief Text content, including whitespace and entity references.
+ */
+#define DESCENT_XML_TOKEN_CATEGORY_TEXT 0x1
+
+/**
+ * \brief Content that isn't only whitespace: text, entity references
+ * 	in text, and CDATA sections.
+ */
+#define DESCENT_XML_TOKEN_CATEGORY_DATA 0x2
+
+/**
+ * \brief Whitespace, in text or inside tags.
+ */
+#define DESCENT_XML_TOKEN_CATEGORY_SPACE 0x4
+
+/**
+ * \brief The contents of an attribute value, between the quotes.
+ */
+#define DESCENT_XML_TOKEN_CATEGORY_ATTRIBUTE_VALUE 0x8
+
+/**
+ * \brief Entity references, in text or attribute values.
+ */
+#define DESCENT_XML_TOKEN_CATEGORY_ENTITY 0x10
+
+/**
+ * \brief Part of an opening, closing or empty element tag, attributes
+ * 	included. The `<` and `>` around markup sections count too.
+ */
+#define DESCENT_XML_TOKEN_CATEGORY_TAG 0x20
+
+/**
+ * \brief Part of a closing tag.
+ */
+#define DESCENT_XML_TOKEN_CATEGORY_CLOSE 0x40
+
+/**
+ * \brief A whole section lexed at once: the XML declaration, doctype,
+ * 	comments and CDATA sections.
+ */
+#define DESCENT_XML_TOKEN_CATEGORY_MARKUP 0x80
+
+/**
+ * \brief Nothing can be lexed on from the token: the end of the
+ * 	document, or an error.
+ */
+#define DESCENT_XML_TOKEN_CATEGORY_END 0x100
+
+/**
+ * \brief An error from the lexer, parser or validator.
+ */
+#define DESCENT_XML_TOKEN_CATEGORY_ERROR 0x200
+
+/**
+ * \brief The categories of each token id, indexed by id.
+ */
+extern const uint16_t descent_xml_token_categories[DESCENT_XML_TOKEN_COUNT];
+
+#define _DESCENT_XML_TOKEN_SLOTS 128
+
+struct _descent_xml_token_slot {
+	descent_xml_classifier_fn *type;
+	enum descent_xml_token_id id;
+};
+
+extern const struct _descent_xml_token_slot *_descent_xml_token_table;
+
+const struct _descent_xml_token_slot *_descent_xml_token_table_init(void);
+
+inline size_t _descent_xml_token_hash(descent_xml_classifier_fn *type)
+{
+	// the top bits of the product depend on every bit of the pointer
+	const uint64_t product = (uint64_t)(uintptr_t)type
+		* UINT64_C(0x9e3779b97f4a7c15);
+	return (size_t)(product >> 57);
+}
+
+/**
+ * \brief Gets the id of a token type.
+ *
+ * \returns The id, or DESCENT_XML_TOKEN_UNKNOWN for types the library
+ * 	doesn't produce.
+ */
+inline enum descent_xml_token_id descent_xml_token_id(
+	descent_xml_classifier_fn *type
+)
+{
+	const struct _descent_xml_token_slot *table
+		= __atomic_load_n(&_descent_xml_token_table, __ATOMIC_ACQUIRE);
+	if (!table)
+		table = _descent_xml_token_table_init();
+
+	for (size_t slot = _descent_xml_token_hash(type);; slot = (slot + 1) % _DESCENT_XML_TOKEN_SLOTS) {
+		if (table[slot].type == type)
+			return table[slot].id;
+		if (!table[slot].type)
+			return DESCENT_XML_TOKEN_UNKNOWN;
+	}
+}
+
+/**
+ * \brief Checks whether a token belongs to any of the given
+ * 	categories.
+ *
+ * \param categories DESCENT_XML_TOKEN_CATEGORY_* flags, ORed together.
+ */
+inline bool descent_xml_token_is(
+	struct descent_xml_lex token,
+	unsigned categories
+)
+{
+	return (descent_xml_token_categories[descent_xml_token_id(token.type)] & categories) != 0;
+}
+
+/**
+ * \brief Gets the token type with an id.
+ *
+ * \returns The type, or a NULL pointer for DESCENT_XML_TOKEN_UNKNOWN
+ * 	and ids out of range.
+ */
+descent_xml_classifier_fn *descent_xml_token_type(enum descent_xml_token_id id);
+
+/**
+ * \brief Gets the name of the token type with an id: the name of its
+ * 	classifier function, such as `descent_xml_classifier_text`.
+ *
+ * \returns The name, or a NULL pointer for DESCENT_XML_TOKEN_UNKNOWN
+ * 	and ids out of range.
+ */
+const char *descent_xml_token_name(enum descent_xml_token_id id);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // DESCENT_XML_TOKEN
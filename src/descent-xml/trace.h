@@ -0,0 +1,93 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef DESCENT_XML_TRACE
+#define DESCENT_XML_TRACE
+
+/**
+ * \file
+ *
+ * Static tracepoints (USDT probes) for tracing a running program with
+ * bpftrace, perf or SystemTap, without rebuilding it.
+ *
+ * The probes are compiled in when `DESCENT_XML_USDT` is defined, which
+ * the CMake option of the same name does, for the library and
+ * everything linking it, when `<sys/sdt.h>` is available. A probe is a
+ * single no-op instruction until a tracer attaches to it; without the
+ * option they aren't compiled at all.
+ *
+ * Every probe is in the `descent_xml` provider. Pointers are into the
+ * document, and lengths and offsets are in bytes:
+ *
+ * - `document__start(script, length)`: descent_xml_parse() was given
+ *   a token fresh from descent_xml_lex_init().
+ * - `document__end(script, length)`: descent_xml_parse() reached the
+ *   end of the document.
+ * - `element__start(name, name_length, attribute_count)`: an opening
+ *   tag was read, just before the element handler is called.
+ * - `element__end(name, name_length)`: a closing tag was read, or an
+ *   empty element's handler returned.
+ * - `parse__error(script, offset)`: the lexer found something it
+ *   couldn't tokenise.
+ * - `validate__failure(script, offset)`: a document failed
+ *   descent_xml_validate_document() or descent_xml_parse_validated();
+ *   the offset is the token being looked at when it failed.
+ * - `attributes__grow(capacity)`: the attribute vector built for an
+ *   element had to be reallocated.
+ * - `cstr__copy(strings, bytes)`: descent_xml_parse_cstr() copied an
+ *   element's name and attributes into C strings.
+ *
+ * For example, a histogram of the time taken per document:
+ *
+ * ```
+ * bpftrace -e '
+ * 	usdt:./program:descent_xml:document__start { @start[tid] = nsecs; }
+ * 	usdt:./program:descent_xml:document__end /@start[tid]/ {
+ * 		@ns = hist(nsecs - @start[tid]); delete(@start[tid]);
+ * 	}'
+ * ```
+ *
+ * As most of the library is inline functions, the probes are in the
+ * program calling them rather than in the shared library.
+ */
+
+#ifdef DESCENT_XML_USDT
+
+#include <sys/sdt.h>
+
+#define _DESCENT_XML_TRACE1(name, a) \
+	DTRACE_PROBE1(descent_xml, name, a)
+#define _DESCENT_XML_TRACE2(name, a, b) \
+	DTRACE_PROBE2(descent_xml, name, a, b)
+#define _DESCENT_XML_TRACE3(name, a, b, c) \
+	DTRACE_PROBE3(descent_xml, name, a, b, c)
+
+#else
+
+#define _DESCENT_XML_TRACE1(name, a) do { } while (0)
+#define _DESCENT_XML_TRACE2(name, a, b) do { } while (0)
+#define _DESCENT_XML_TRACE3(name, a, b, c) do { } while (0)
+
+#endif
+
+/**
+ * \brief The offset of a token's value from the start of its script.
+ */
+#define _DESCENT_XML_TRACE_OFFSET(token) \
+	((ssize_t)((const char *)(token).value.buffer - (const char *)(token).script.buffer))
+
+#endif // DESCENT_XML_TRACE
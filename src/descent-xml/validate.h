@@ -24,16 +24,122 @@ extern "C" {
 #endif
 
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include <libadt/lptr.h>
 #include <libadt/str.h>
+#include <libadt/vector.h>
 
+#include "alloc.h"
+#include "chars.h"
+#include "dtd.h"
+#include "schema.h"
 #include "parse.h"
+#include "trace.h"
 
 /**
  * \file
  */
 
+typedef struct {
+	bool opened;
+	bool empty;
+	bool duplicate;
+	struct libadt_const_lptr name;
+	const struct descent_xml_allocator *allocator;
+} _descent_xml_validate_context;
+
+inline bool _descent_xml_attribute_names_scan(
+	const struct libadt_const_lptr *attributes,
+	size_t count
+)
+{
+	for (size_t i = 2; i < count * 2; i += 2)
+		for (size_t j = 0; j < i; j += 2)
+			if (libadt_const_lptr_equal(attributes[i], attributes[j]))
+				return true;
+	return false;
+}
+
+// FNV-1a, for the duplicate-attribute check here and the DTD and
+// schema name tables
+inline uint32_t _descent_xml_name_hash(struct libadt_const_lptr name)
+{
+	const unsigned char *const bytes = name.buffer;
+	uint32_t hash = 2166136261u;
+	for (ssize_t i = 0; i < name.length; i++)
+		hash = (hash ^ bytes[i]) * 16777619u;
+	return hash;
+}
+
+/**
+ * \brief Checks an attribute list for a repeated attribute name.
+ *
+ * Small lists are compared pairwise. Past that, the names are put
+ * into an open-addressing hash table, so elements with hundreds of
+ * attributes are still checked in linear time.
+ *
+ * \param attributes A length-pointer of length-pointers, alternating
+ * 	name and value, as passed to descent_xml_parse_element_fn.
+ * \param allocator The allocator for large tables, or a NULL pointer
+ * 	for malloc().
+ *
+ * \returns True if any attribute name appears more than once.
+ */
+inline bool _descent_xml_has_duplicate_attribute(
+	struct libadt_const_lptr attributes,
+	const struct descent_xml_allocator *allocator
+)
+{
+	const struct libadt_const_lptr *const attrs = attributes.buffer;
+	const size_t count = (size_t)attributes.length / 2;
+	if (count <= 8)
+		return _descent_xml_attribute_names_scan(attrs, count);
+
+	// a power of two at least twice the count keeps the probes short
+	size_t slots = 32;
+	while (slots < count * 2)
+		slots *= 2;
+
+	// slots hold index + 1 of the name, so zero is empty; only the
+	// slots in use are cleared
+	uint32_t local[512];
+	uint32_t *table = local;
+	if (slots > sizeof(local) / sizeof(local[0])) {
+		table = descent_xml_allocate_zeroed(allocator, slots, sizeof(*table));
+		if (!table)
+			return _descent_xml_attribute_names_scan(attrs, count);
+	} else {
+		memset(local, 0, slots * sizeof(*table));
+	}
+
+	bool duplicate = false;
+	for (size_t i = 0; i < count && !duplicate; i++) {
+		const struct libadt_const_lptr name = attrs[i * 2];
+		size_t slot = _descent_xml_name_hash(name) & (slots - 1);
+		for (; table[slot]; slot = (slot + 1) & (slots - 1)) {
+			const struct libadt_const_lptr other
+				= attrs[(table[slot] - 1) * 2];
+			if (libadt_const_lptr_equal(name, other)) {
+				duplicate = true;
+				break;
+			}
+		}
+		table[slot] = (uint32_t)(i + 1);
+	}
+
+	if (table != local)
+		descent_xml_release(allocator, table, slots * sizeof(*table));
+	return duplicate;
+}
+
+typedef struct {
+	bool valid;
+	struct descent_xml_lex token;
+} _descent_xml_validate_t;
+
 inline struct descent_xml_lex _descent_xml_validate_element_handler(
 	struct descent_xml_lex token,
 	struct libadt_const_lptr element_name,
@@ -42,64 +148,127 @@ inline struct descent_xml_lex _descent_xml_validate_element_handler(
 	void *context_p
 )
 {
-	(void)attributes;
-	struct {
-		bool valid;
-		int depth;
-	} *context = context_p;
-	if (context->depth == 0) {
-		context->valid = false;
-		return token;
-	}
-	context->depth--;
+	_descent_xml_validate_context *const context = context_p;
+	context->opened = true;
+	context->empty = empty;
+	context->duplicate = _descent_xml_has_duplicate_attribute(
+		attributes,
+		context->allocator
+	);
+	context->name = element_name;
+	return token;
+}
 
+inline _descent_xml_validate_t _descent_xml_validate_element_iterative(
+	struct descent_xml_lex token,
+	int depth,
+	const struct descent_xml_allocator *allocator
+)
+{
+	// Rather than recursing once per nesting level, the handler
+	// just reports the element it was given and we keep the names
+	// of the open elements on a stack of our own.
 	const struct libadt_const_lptr xmldecl = libadt_str_literal("?xml");
+	_descent_xml_validate_context context = { .allocator = allocator };
+	bool valid = false;
 
-	if (libadt_const_lptr_equal(element_name, xmldecl)) {
-		context->valid = false;
-		return token;
-	}
-
-	if (empty)
-		return token;
+	struct libadt_vector open = {
+		.element_size = sizeof(struct libadt_const_lptr),
+	};
 
-	while (token.type != descent_xml_classifier_element_close_name) {
-		token = descent_xml_parse(
+	for (;;) {
+		context.opened = false;
+		token = descent_xml_parse_alloc(
 			token,
+			allocator,
 			_descent_xml_validate_element_handler,
 			NULL,
-			context
+			&context
 		);
+
+		if (context.opened) {
+			const bool too_deep = depth >= 0
+				&& open.length >= (size_t)depth;
+			if (
+				too_deep
+				|| context.duplicate
+				|| libadt_const_lptr_equal(context.name, xmldecl)
+			)
+				break;
+
+			if (context.empty) {
+				if (open.length == 0) {
+					valid = true;
+					break;
+				}
+				continue;
+			}
+
+			if (!_descent_xml_vector_append(allocator, &open, &context.name))
+				break;
+			continue;
+		}
+
+		// the first thing we see has to be an element
+		if (open.length == 0)
+			break;
+
+		if (token.type == descent_xml_classifier_element_close_name) {
+			const struct libadt_const_lptr *const names = open.buffer;
+			if (!libadt_const_lptr_equal(token.value, names[open.length - 1]))
+				break;
+			open.length--;
+
+			// iterate past the closing '>'
+			token = descent_xml_parse(token, NULL, NULL, NULL);
+			if (token.type == descent_xml_classifier_unexpected)
+				break;
+
+			if (open.length == 0) {
+				valid = true;
+				break;
+			}
+			continue;
+		}
+
 		if (
 			token.type == descent_xml_classifier_unexpected
+			|| token.type == descent_xml_parse_error
 			|| token.type == descent_xml_classifier_eof
 			|| token.type == descent_xml_lex_xmldecl
 			|| token.type == descent_xml_lex_doctype
-			|| !context->valid
-		) {
-			context->valid = false;
-			return token;
-		}
+		)
+			break;
 	}
 
-	context->valid = libadt_const_lptr_equal(
-		token.value,
-		element_name
+	descent_xml_release(
+		allocator,
+		open.buffer,
+		open.capacity * open.element_size
 	);
-	context->depth++;
-	token = descent_xml_parse(token, NULL, NULL, NULL);
-	return token;
+	return (_descent_xml_validate_t) { valid, token };
 }
 
+/**
+ * \brief Checks that the next element in the script is well-formed,
+ * 	with matching opening and closing tags and no repeated
+ * 	attribute names all the way down.
+ *
+ * The check doesn't recurse, so deep documents cost a little heap
+ * memory per level rather than a stack frame.
+ *
+ * \param token A token into an XML document, before the element to
+ * 	check.
+ * \param depth The maximum number of nested elements to accept.
+ * 	Pass a negative number to accept any depth.
+ *
+ * \returns True if the element is well-formed, false otherwise.
+ */
 inline bool descent_xml_validate_element_depth(
 	struct descent_xml_lex token,
 	int depth
 )
 {
-	struct {
-		bool valid;
-		int depth;
-	} context = { true, depth };
 	while (token.type != descent_xml_classifier_element) {
 		if (
 			token.type == descent_xml_classifier_unexpected
@@ -108,26 +277,29 @@ inline bool descent_xml_validate_element_depth(
 			return false;
 		token = descent_xml_lex_next_raw(token);
 	}
-	token = descent_xml_parse(
-		token,
-		_descent_xml_validate_element_handler,
-		NULL,
-		&context
-	);
 
-	// We have to check for unexpected/eof here in case the
-	// element handler never runs
+	_descent_xml_validate_t result
+		= _descent_xml_validate_element_iterative(token, depth, NULL);
+
 	return
-		context.valid
-		&& token.type != descent_xml_classifier_unexpected
-		&& token.type != descent_xml_classifier_eof;
+		result.valid
+		&& result.token.type != descent_xml_classifier_unexpected
+		&& result.token.type != descent_xml_classifier_eof;
 }
 
+/**
+ * \brief Checks that the next element in the script is well-formed,
+ * 	accepting up to 10000 nested elements.
+ *
+ * \sa descent_xml_validate_element_depth()
+ */
 inline bool descent_xml_validate_element(struct descent_xml_lex token)
 {
 	return descent_xml_validate_element_depth(token, 10000);
 }
 
+// DESCENT_XML_TOKEN_CATEGORY_DATA, compared directly as in
+// _descent_xml_is_text_type()
 inline bool _descent_xml_non_space_text(struct descent_xml_lex token)
 {
 	return token.type == descent_xml_classifier_text
@@ -234,47 +406,81 @@ inline struct descent_xml_lex _descent_xml_validate_parse_prolog(
 	return token;
 }
 
-inline bool descent_xml_validate_document_depth(
+inline bool _descent_xml_validate_failure(struct descent_xml_lex token)
+{
+	(void)token;
+	_DESCENT_XML_TRACE2(
+		validate__failure,
+		token.script.buffer,
+		_DESCENT_XML_TRACE_OFFSET(token)
+	);
+	return false;
+}
+
+inline bool _descent_xml_validate_document(
 	struct descent_xml_lex token,
-	int depth
+	int depth,
+	const struct descent_xml_allocator *allocator
 )
 {
-	struct {
-		bool valid;
-		int depth;
-	} context = {true, depth};
-
 	token = _descent_xml_validate_parse_prolog(token);
 	if (
 		token.type == descent_xml_classifier_unexpected
 		|| token.type == descent_xml_classifier_eof
 	)
-		return false;
+		return _descent_xml_validate_failure(token);
 
-	token = descent_xml_parse(
-		token,
-		_descent_xml_validate_element_handler,
-		NULL,
-		&context
-	);
+	_descent_xml_validate_t result
+		= _descent_xml_validate_element_iterative(token, depth, allocator);
 
-	if (!context.valid)
-		return false;
+	if (!result.valid)
+		return _descent_xml_validate_failure(result.token);
+	token = result.token;
 
-	// check that there's only one element node in the root
-	while (token.type != descent_xml_classifier_element) {
+	// check that there's only one element node in the root, and
+	// nothing after it but whitespace and comments
+	for (;;) {
 		if (token.type == descent_xml_classifier_eof)
 			return true;
 		if (token.type == descent_xml_classifier_unexpected)
-			return false;
+			return _descent_xml_validate_failure(token);
 		if (token.type == descent_xml_classifier_text)
-			return false;
+			return _descent_xml_validate_failure(token);
+		if (token.type == descent_xml_classifier_element) {
+			token = descent_xml_lex_next_raw(token);
+			if (token.type != descent_xml_lex_comment)
+				return _descent_xml_validate_failure(token);
+		}
 		token = descent_xml_lex_next_raw(token);
 	}
+}
 
-	return false;
+/**
+ * \brief Checks that a script is a well-formed document: an optional
+ * 	prolog, then exactly one well-formed root element, followed by
+ * 	nothing but whitespace and comments.
+ *
+ * \param token A token at the start of the document, as created by
+ * 	descent_xml_lex_init().
+ * \param depth The maximum number of nested elements to accept.
+ * 	Pass a negative number to accept any depth.
+ *
+ * \returns True if the document is well-formed, false otherwise.
+ */
+inline bool descent_xml_validate_document_depth(
+	struct descent_xml_lex token,
+	int depth
+)
+{
+	return _descent_xml_validate_document(token, depth, NULL);
 }
 
+/**
+ * \brief Checks that a script is a well-formed document, accepting
+ * 	up to 1000 nested elements.
+ *
+ * \sa descent_xml_validate_document_depth()
+ */
 inline bool descent_xml_validate_document(
 	struct descent_xml_lex token
 )
@@ -282,6 +488,493 @@ inline bool descent_xml_validate_document(
 	return descent_xml_validate_document_depth(token, 1000);
 }
 
+/**
+ * \brief Also checks that the document is well-formed UTF-8 holding
+ * 	only characters allowed by the XML `Char` production.
+ *
+ * \sa descent_xml_chars_check()
+ */
+#define DESCENT_XML_VALIDATE_CHARS 1
+
+/**
+ * \brief The script is padded, so DESCENT_XML_VALIDATE_CHARS can
+ * 	check it with descent_xml_chars_check_padded().
+ *
+ * \sa DESCENT_XML_PADDING
+ */
+#define DESCENT_XML_VALIDATE_PADDED 2
+
+/**
+ * \brief descent_xml_validate_document_flags(), allocating with the
+ * 	given allocator.
+ *
+ * \param allocator The allocator for the stack of open elements and
+ * 	the tables for checking attribute names, or a NULL pointer for
+ * 	malloc().
+ *
+ * \sa descent_xml_validate_document_flags()
+ * \sa descent-xml/alloc.h
+ */
+inline bool descent_xml_validate_document_alloc(
+	struct descent_xml_lex token,
+	int depth,
+	unsigned flags,
+	const struct descent_xml_allocator *allocator
+)
+{
+	if (flags & DESCENT_XML_VALIDATE_CHARS) {
+		const size_t bad = flags & DESCENT_XML_VALIDATE_PADDED
+			? descent_xml_chars_check_padded(token.script)
+			: descent_xml_chars_check(token.script);
+		if (bad != (size_t)token.script.length) {
+			token.value = libadt_const_lptr_index(token.script, (ssize_t)bad);
+			return _descent_xml_validate_failure(token);
+		}
+	}
+	return _descent_xml_validate_document(token, depth, allocator);
+}
+
+/**
+ * \brief Checks that a script is a well-formed document, with extra
+ * 	checks selected by flags.
+ *
+ * \param token A token at the start of the document, as created by
+ * 	descent_xml_lex_init().
+ * \param depth The maximum number of nested elements to accept.
+ * 	Pass a negative number to accept any depth.
+ * \param flags DESCENT_XML_VALIDATE_* flags, or zero.
+ *
+ * \returns True if the document is well-formed and passes the extra
+ * 	checks, false otherwise.
+ *
+ * \sa descent_xml_validate_document_depth()
+ */
+inline bool descent_xml_validate_document_flags(
+	struct descent_xml_lex token,
+	int depth,
+	unsigned flags
+)
+{
+	return descent_xml_validate_document_alloc(token, depth, flags, NULL);
+}
+
+/**
+ * \brief Holds the state for validating a document while parsing it
+ * 	with descent_xml_parse_validated().
+ *
+ * Create one with descent_xml_validator_init() and release it with
+ * descent_xml_validator_free().
+ */
+struct descent_xml_validator {
+	/**
+	 * \brief The names of the currently-open elements, outermost
+	 * 	first.
+	 */
+	struct libadt_const_lptr *open;
+
+	/**
+	 * \brief The number of currently-open elements.
+	 */
+	size_t depth;
+
+	/**
+	 * \brief The number of names open has room for.
+	 */
+	size_t capacity;
+
+	/**
+	 * \brief The maximum nesting depth to accept, or a negative
+	 * 	number for no limit.
+	 */
+	int max_depth;
+
+	/**
+	 * \brief Whether a comment, XML declaration or DOCTYPE has been
+	 * 	seen yet. An XML declaration after any of these is rejected.
+	 */
+	bool seen_prolog;
+
+	/**
+	 * \brief Whether the DOCTYPE declaration has been seen yet.
+	 */
+	bool seen_doctype;
+
+	/**
+	 * \brief Whether the root element has been opened yet.
+	 */
+	bool seen_root;
+
+	/**
+	 * \brief A DTD validator to check the document against as
+	 * 	well, or a NULL pointer to only check well-formedness.
+	 * 	descent_xml_validator_init() sets this to NULL.
+	 */
+	struct descent_xml_dtd_validator *dtd;
+
+	/**
+	 * \brief A schema validator to check the document against as
+	 * 	well, or a NULL pointer. descent_xml_validator_init() sets
+	 * 	this to NULL.
+	 */
+	struct descent_xml_schema_validator *schema;
+
+	/**
+	 * \brief The allocator for the stack of open elements, and
+	 * 	everything descent_xml_parse_validated() allocates, or a NULL
+	 * 	pointer for malloc(). descent_xml_validator_init() sets this
+	 * 	to NULL. The DTD and schema validators have their own.
+	 */
+	const struct descent_xml_allocator *allocator;
+};
+
+/**
+ * \brief Token type returned by descent_xml_parse_validated() when
+ * 	the document is not well-formed.
+ *
+ * Like descent_xml_parse_error, this is only a marker: calling it,
+ * or lexing on from a token of this type, will call abort().
+ */
+extern descent_xml_classifier_void_fn *descent_xml_validate_error(wchar_t);
+
+/**
+ * \brief Creates a validator for descent_xml_parse_validated().
+ *
+ * \param depth The maximum number of nested elements to accept.
+ * 	Pass a negative number to accept any depth.
+ *
+ * \returns A validator at the start of a document. No memory is
+ * 	allocated until the first element is opened.
+ */
+inline struct descent_xml_validator descent_xml_validator_init(int depth)
+{
+	return (struct descent_xml_validator) { .max_depth = depth };
+}
+
+/**
+ * \brief Releases the memory held by a validator.
+ *
+ * \param validator The validator to release. It can be reused after
+ * 	another call to descent_xml_validator_init().
+ */
+inline void descent_xml_validator_free(struct descent_xml_validator *validator)
+{
+	descent_xml_release(
+		validator->allocator,
+		validator->open,
+		validator->capacity * sizeof(struct libadt_const_lptr)
+	);
+	validator->open = NULL;
+	validator->depth = validator->capacity = 0;
+}
+
+inline bool _descent_xml_validator_push(
+	struct descent_xml_validator *validator,
+	struct libadt_const_lptr name
+)
+{
+	if (validator->depth == validator->capacity) {
+		const size_t capacity = validator->capacity
+			? validator->capacity * 2
+			: 16;
+		struct libadt_const_lptr *const open = descent_xml_reallocate(
+			validator->allocator,
+			validator->open,
+			validator->capacity * sizeof(struct libadt_const_lptr),
+			capacity * sizeof(struct libadt_const_lptr)
+		);
+		if (!open)
+			return false;
+		validator->open = open;
+		validator->capacity = capacity;
+	}
+	validator->open[validator->depth++] = name;
+	return true;
+}
+
+inline bool _descent_xml_is_xml_space(struct libadt_const_lptr text)
+{
+	const char *const bytes = text.buffer;
+	for (ssize_t i = 0; i < text.length; i++) {
+		switch (bytes[i]) {
+			case ' ':
+			case '\t':
+			case '\r':
+			case '\n':
+				continue;
+			default:
+				return false;
+		}
+	}
+	return true;
+}
+
+typedef struct {
+	descent_xml_parse_element_fn *const element_handler;
+	descent_xml_parse_text_fn *const text_handler;
+	void *const context;
+	struct descent_xml_validator *const validator;
+	descent_xml_classifier_fn *error;
+} _descent_xml_parse_validated_context;
+
+inline struct descent_xml_lex _descent_xml_validated_element_handler(
+	struct descent_xml_lex token,
+	struct libadt_const_lptr element_name,
+	struct libadt_const_lptr attributes,
+	bool empty,
+	void *context_p
+)
+{
+	_descent_xml_parse_validated_context *const context = context_p;
+	struct descent_xml_validator *const validator = context->validator;
+
+	const bool second_root = validator->depth == 0 && validator->seen_root;
+	const bool too_deep = validator->max_depth >= 0
+		&& validator->depth >= (size_t)validator->max_depth;
+	if (
+		second_root
+		|| too_deep
+		|| _descent_xml_has_duplicate_attribute(
+			attributes,
+			validator->allocator
+		)
+	) {
+		context->error = descent_xml_validate_error;
+		return token;
+	}
+
+	if (
+		validator->dtd
+		&& !descent_xml_dtd_element(validator->dtd, element_name, attributes, empty)
+	) {
+		context->error = descent_xml_validate_error;
+		return token;
+	}
+
+	if (
+		validator->schema
+		&& !descent_xml_schema_element(validator->schema, element_name, attributes, empty)
+	) {
+		context->error = descent_xml_validate_error;
+		return token;
+	}
+
+	validator->seen_root = true;
+	if (!empty && !_descent_xml_validator_push(validator, element_name)) {
+		context->error = descent_xml_parse_error;
+		return token;
+	}
+
+	if (!context->element_handler)
+		return token;
+
+	return context->element_handler(
+		token,
+		element_name,
+		attributes,
+		empty,
+		context->context
+	);
+}
+
+inline void _descent_xml_validated_text_handler(
+	struct libadt_const_lptr text,
+	bool is_cdata,
+	void *context_p
+)
+{
+	_descent_xml_parse_validated_context *const context = context_p;
+
+	// the lexer already rejects text before the root element,
+	// so outside of an element means after it
+	const bool outside = context->validator->depth == 0;
+	if (outside && (is_cdata || !_descent_xml_is_xml_space(text))) {
+		context->error = descent_xml_validate_error;
+		return;
+	}
+
+	if (
+		context->validator->dtd
+		&& !descent_xml_dtd_text(context->validator->dtd, text, is_cdata)
+	) {
+		context->error = descent_xml_validate_error;
+		return;
+	}
+
+	if (
+		context->validator->schema
+		&& !descent_xml_schema_text(context->validator->schema, text, is_cdata)
+	) {
+		context->error = descent_xml_validate_error;
+		return;
+	}
+
+	if (context->text_handler)
+		context->text_handler(text, is_cdata, context->context);
+}
+
+/**
+ * \brief Parses the next entity in a document, checking that the
+ * 	document is well-formed as it goes.
+ *
+ * descent_xml_parse_validated() behaves like descent_xml_parse(), but
+ * replaces the separate descent_xml_validate_document() pass, so each
+ * byte of the document is only lexed once. It checks that:
+ *
+ * - closing tags match the open element,
+ * - no element repeats an attribute name,
+ * - the XML declaration and DOCTYPE each appear at most once, in
+ * 	that order, before the root element,
+ * - there is exactly one root element,
+ * - only whitespace and comments follow the root element, and
+ * - the document doesn't end with elements still open.
+ *
+ * If the validator's `dtd` or `schema` member is set, each element,
+ * text node and closing tag is also checked against the DTD or schema
+ * as it's parsed.
+ *
+ * Every call for the same document, including the calls made from
+ * inside the handlers, must pass the same validator; skipping content
+ * with a plain descent_xml_parse() call will make the validator lose
+ * track of the open elements. Unlike descent_xml_parse(), the opening
+ * tag is always read in full, even if element_handler is a NULL
+ * pointer.
+ *
+ * Because the document is checked as it's parsed, the handlers will
+ * already have been called for everything before the point where the
+ * document turns out to be malformed.
+ *
+ * \param xml A token into an XML document. Can be created on a
+ * 	full XML document using descent_xml_lex_init().
+ * \param validator The validator tracking this document.
+ * \param element_handler A callback to call when encountering an
+ * 	opening element tag. Pass a NULL pointer to disable.
+ * \param text_handler A callback to call when encountering a
+ * 	text node. Pass a NULL pointer to disable.
+ * \param context A user-provided pointer that will be passed
+ * 	to the callbacks.
+ *
+ * \returns The last token encountered while parsing. In addition to
+ * 	the types returned by descent_xml_parse(), the `type` property
+ * 	is `descent_xml_validate_error` if the document is not
+ * 	well-formed, and `descent_xml_parse_error` if the validator
+ * 	couldn't allocate memory.
+ */
+inline struct descent_xml_lex descent_xml_parse_validated(
+	struct descent_xml_lex xml,
+	struct descent_xml_validator *validator,
+	descent_xml_parse_element_fn *element_handler,
+	descent_xml_parse_text_fn *text_handler,
+	void *context
+)
+{
+	if (
+		xml.type == descent_xml_validate_error
+		|| xml.type == descent_xml_parse_error
+	)
+		return xml;
+
+	_descent_xml_parse_validated_context validated_context = {
+		.element_handler = element_handler,
+		.text_handler = text_handler,
+		.context = context,
+		.validator = validator,
+	};
+	xml = descent_xml_parse_alloc(
+		xml,
+		validator->allocator,
+		_descent_xml_validated_element_handler,
+		_descent_xml_validated_text_handler,
+		&validated_context
+	);
+
+	if (validated_context.error) {
+		if (validated_context.error == descent_xml_validate_error)
+			_descent_xml_validate_failure(xml);
+		xml.type = validated_context.error;
+		return xml;
+	}
+
+	if (xml.type == descent_xml_classifier_element_close_name) {
+		const bool matches = validator->depth > 0
+			&& libadt_const_lptr_equal(
+				xml.value,
+				validator->open[validator->depth - 1]
+			);
+		if (!matches)
+			xml.type = descent_xml_validate_error;
+		else
+			validator->depth--;
+		if (matches && validator->dtd && !descent_xml_dtd_close(validator->dtd))
+			xml.type = descent_xml_validate_error;
+		if (
+			matches
+			&& validator->schema
+			&& !descent_xml_schema_close(validator->schema)
+		)
+			xml.type = descent_xml_validate_error;
+	} else if (xml.type == descent_xml_lex_xmldecl) {
+		// only whitespace can come before the XML declaration
+		if (validator->seen_prolog || validator->seen_root)
+			xml.type = descent_xml_validate_error;
+		validator->seen_prolog = true;
+	} else if (xml.type == descent_xml_lex_doctype) {
+		if (validator->seen_doctype || validator->seen_root)
+			xml.type = descent_xml_validate_error;
+		else if (validator->dtd)
+			validator->dtd->root = descent_xml_doctype_name(xml);
+		validator->seen_prolog = validator->seen_doctype = true;
+	} else if (xml.type == descent_xml_lex_comment) {
+		validator->seen_prolog = true;
+	} else if (xml.type == descent_xml_classifier_eof) {
+		if (validator->depth > 0 || !validator->seen_root)
+			xml.type = descent_xml_validate_error;
+	}
+
+	if (xml.type == descent_xml_validate_error)
+		_descent_xml_validate_failure(xml);
+
+	return xml;
+}
+
+typedef struct {
+	struct descent_xml_validator *const validator;
+	descent_xml_parse_element_cstr_fn *const element_handler;
+	descent_xml_parse_text_cstr_fn *const text_handler;
+	void *const context;
+} _descent_xml_parse_cstr_validated_context;
+
+/**
+ * \brief The C-string counterpart to descent_xml_parse_validated().
+ *
+ * The same rules apply: every call for a document, including those
+ * from inside the handlers, must pass the same validator.
+ *
+ * \sa descent_xml_parse_validated()
+ * \sa descent_xml_parse_cstr()
+ */
+inline struct descent_xml_lex descent_xml_parse_cstr_validated(
+	struct descent_xml_lex xml,
+	struct descent_xml_validator *validator,
+	descent_xml_parse_element_cstr_fn *element_handler,
+	descent_xml_parse_text_cstr_fn *text_handler,
+	void *context
+)
+{
+	_descent_xml_parse_cstr_context cstr_context = {
+		.element_handler = element_handler,
+		.text_handler = text_handler,
+		.context = context,
+		.allocator = validator->allocator,
+	};
+	return descent_xml_parse_validated(
+		xml,
+		validator,
+		_cstr_element_handler,
+		_cstr_text_handler,
+		&cstr_context
+	);
+}
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -0,0 +1,1100 @@
+#include "descent-xml/dtd.h"
+
+#include "automaton.h"
+#include "descent-xml/validate.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// how deep parentheses can nest in a content model
+#define MAX_GROUP_DEPTH 64
+
+#define NONE _DESCENT_XML_AUTOMATON_NONE
+
+struct descent_xml_dtd_validator descent_xml_dtd_validator_init(
+	const struct descent_xml_dtd *dtd
+);
+void descent_xml_dtd_validator_free(struct descent_xml_dtd_validator *validator);
+
+enum content {
+	CONTENT_UNDECLARED,
+	CONTENT_EMPTY,
+	CONTENT_ANY,
+	CONTENT_MIXED,
+	CONTENT_CHILDREN,
+};
+
+enum attribute_type {
+	ATTRIBUTE_CDATA,
+	ATTRIBUTE_ID,
+	ATTRIBUTE_IDREF,
+	ATTRIBUTE_IDREFS,
+	ATTRIBUTE_ENTITY,
+	ATTRIBUTE_ENTITIES,
+	ATTRIBUTE_NMTOKEN,
+	ATTRIBUTE_NMTOKENS,
+	ATTRIBUTE_ENUMERATION,
+};
+
+enum attribute_default {
+	DEFAULT_IMPLIED,
+	DEFAULT_REQUIRED,
+	DEFAULT_FIXED,
+	DEFAULT_VALUE,
+};
+
+struct attribute {
+	uint32_t name;
+	enum attribute_type type;
+	enum attribute_default default_type;
+	struct libadt_const_lptr value;
+	struct libadt_const_lptr *values;
+	size_t value_count;
+};
+
+// children content uses the whole automaton; mixed content only
+// uses its symbols, the names allowed alongside the text
+struct element {
+	enum content content;
+	struct _descent_xml_automaton model;
+
+	// sorted by name once the whole DTD has been read
+	struct attribute *attributes;
+	size_t attribute_count;
+	size_t attribute_capacity;
+	size_t required;
+};
+
+struct descent_xml_dtd {
+	// our own copy of the declarations; every name and value
+	// below points into it
+	char *text;
+
+	// element and attribute names share one table, and elements
+	// is indexed by it
+	struct _descent_xml_symbols names;
+	struct element *elements;
+	size_t element_count;
+
+	struct _descent_xml_symbols entities;
+	struct _descent_xml_symbols unparsed;
+};
+
+struct cursor {
+	const char *at;
+	const char *end;
+};
+
+static struct libadt_const_lptr span(const char *start, const char *end)
+{
+	return (struct libadt_const_lptr) {
+		.buffer = start,
+		.size = 1,
+		.length = end - start,
+	};
+}
+
+static bool is_space(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static bool is_name_start(char c)
+{
+	return (c >= 'a' && c <= 'z')
+		|| (c >= 'A' && c <= 'Z')
+		|| c == '_'
+		|| c == ':'
+		|| (unsigned char)c >= 0x80;
+}
+
+static bool is_name_char(char c)
+{
+	return is_name_start(c)
+		|| (c >= '0' && c <= '9')
+		|| c == '-'
+		|| c == '.';
+}
+
+static bool cursor_done(const struct cursor *cursor)
+{
+	return cursor->at >= cursor->end;
+}
+
+static bool skip_space(struct cursor *cursor)
+{
+	const char *const start = cursor->at;
+	while (!cursor_done(cursor) && is_space(*cursor->at))
+		cursor->at++;
+	return cursor->at != start;
+}
+
+static bool starts(const struct cursor *cursor, const char *literal)
+{
+	const size_t length = strlen(literal);
+	return (size_t)(cursor->end - cursor->at) >= length
+		&& memcmp(cursor->at, literal, length) == 0;
+}
+
+static bool accept_literal(struct cursor *cursor, const char *literal)
+{
+	if (!starts(cursor, literal))
+		return false;
+	cursor->at += strlen(literal);
+	return true;
+}
+
+// a keyword has to end where a name would
+static bool accept_keyword(struct cursor *cursor, const char *keyword)
+{
+	const size_t length = strlen(keyword);
+	if (!starts(cursor, keyword))
+		return false;
+	if (cursor->at + length < cursor->end && is_name_char(cursor->at[length]))
+		return false;
+	cursor->at += length;
+	return true;
+}
+
+static bool skip_past(struct cursor *cursor, const char *terminator)
+{
+	while (!cursor_done(cursor)) {
+		if (accept_literal(cursor, terminator))
+			return true;
+		cursor->at++;
+	}
+	return false;
+}
+
+static bool read_name(struct cursor *cursor, struct libadt_const_lptr *name)
+{
+	const char *const start = cursor->at;
+	if (cursor_done(cursor) || !is_name_start(*cursor->at))
+		return false;
+	while (!cursor_done(cursor) && is_name_char(*cursor->at))
+		cursor->at++;
+	*name = span(start, cursor->at);
+	return true;
+}
+
+static bool read_nmtoken(struct cursor *cursor, struct libadt_const_lptr *name)
+{
+	const char *const start = cursor->at;
+	while (!cursor_done(cursor) && is_name_char(*cursor->at))
+		cursor->at++;
+	*name = span(start, cursor->at);
+	return cursor->at != start;
+}
+
+static bool read_literal(struct cursor *cursor, struct libadt_const_lptr *value)
+{
+	if (cursor_done(cursor) || (*cursor->at != '"' && *cursor->at != '\''))
+		return false;
+	const char quote = *cursor->at++;
+	const char *const start = cursor->at;
+	const char *const end = memchr(start, quote, (size_t)(cursor->end - start));
+	if (!end)
+		return false;
+	*value = span(start, end);
+	cursor->at = end + 1;
+	return true;
+}
+
+static bool expect(struct cursor *cursor, char c)
+{
+	skip_space(cursor);
+	if (cursor_done(cursor) || *cursor->at != c)
+		return false;
+	cursor->at++;
+	return true;
+}
+
+static bool read_external_id(struct cursor *cursor)
+{
+	struct libadt_const_lptr literal;
+	if (accept_keyword(cursor, "SYSTEM"))
+		return skip_space(cursor) && read_literal(cursor, &literal);
+	if (accept_keyword(cursor, "PUBLIC"))
+		return skip_space(cursor)
+			&& read_literal(cursor, &literal)
+			&& skip_space(cursor)
+			&& read_literal(cursor, &literal);
+	return false;
+}
+
+static struct element *element_for(struct descent_xml_dtd *dtd, int64_t id)
+{
+	if (id < 0)
+		return NULL;
+
+	if ((size_t)id >= dtd->element_count) {
+		const size_t count = dtd->names.capacity;
+		struct element *const elements = realloc(
+			dtd->elements,
+			count * sizeof(*elements)
+		);
+		if (!elements)
+			return NULL;
+		memset(
+			&elements[dtd->element_count],
+			0,
+			(count - dtd->element_count) * sizeof(*elements)
+		);
+		dtd->elements = elements;
+		dtd->element_count = count;
+	}
+	return &dtd->elements[id];
+}
+
+static int compare_symbols(const void *left_p, const void *right_p)
+{
+	const uint32_t left = *(const uint32_t *)left_p;
+	const uint32_t right = *(const uint32_t *)right_p;
+	return (left > right) - (left < right);
+}
+
+static int compare_attributes(const void *left, const void *right)
+{
+	return compare_symbols(
+		&((const struct attribute *)left)->name,
+		&((const struct attribute *)right)->name
+	);
+}
+
+static void read_repeat(struct cursor *cursor, struct _descent_xml_automaton_node *node)
+{
+	if (cursor_done(cursor))
+		return;
+	switch (*cursor->at) {
+		case '?':
+		case '*':
+		case '+':
+			node->repeat = *cursor->at++;
+	}
+}
+
+static size_t read_particle(
+	struct descent_xml_dtd *dtd,
+	struct cursor *cursor,
+	struct _descent_xml_automaton_tree *tree,
+	int depth
+)
+{
+	skip_space(cursor);
+
+	if (!accept_literal(cursor, "(")) {
+		struct libadt_const_lptr name;
+		if (!read_name(cursor, &name))
+			return NONE;
+		const int64_t symbol = _descent_xml_symbols_intern(&dtd->names, name);
+		if (symbol < 0 || !element_for(dtd, symbol))
+			return NONE;
+		const size_t index = _descent_xml_automaton_add(
+			tree,
+			_DESCENT_XML_AUTOMATON_NAME,
+			(uint32_t)symbol,
+			(uint32_t)symbol
+		);
+		if (index != NONE)
+			read_repeat(cursor, &tree->nodes[index]);
+		return index;
+	}
+
+	if (depth >= MAX_GROUP_DEPTH)
+		return NONE;
+
+	const size_t group = _descent_xml_automaton_add(
+		tree,
+		_DESCENT_XML_AUTOMATON_SEQUENCE,
+		0,
+		0
+	);
+	if (group == NONE)
+		return NONE;
+
+	char separator = '\0';
+	for (;;) {
+		const size_t child = read_particle(dtd, cursor, tree, depth + 1);
+		if (child == NONE)
+			return NONE;
+		_descent_xml_automaton_append(tree, group, child);
+
+		skip_space(cursor);
+		if (accept_literal(cursor, ")"))
+			break;
+		if (cursor_done(cursor))
+			return NONE;
+
+		const char next = *cursor->at++;
+		if (next != ',' && next != '|')
+			return NONE;
+		if (separator && next != separator)
+			return NONE;
+		separator = next;
+	}
+
+	if (separator == '|')
+		tree->nodes[group].kind = _DESCENT_XML_AUTOMATON_CHOICE;
+	read_repeat(cursor, &tree->nodes[group]);
+	return group;
+}
+
+static bool read_element_declaration(
+	struct descent_xml_dtd *dtd,
+	struct cursor *cursor
+)
+{
+	struct libadt_const_lptr name;
+	if (!skip_space(cursor) || !read_name(cursor, &name) || !skip_space(cursor))
+		return false;
+
+	// interning the names in the content model can move the element,
+	// so it's looked up again by id after each of them
+	const int64_t id = _descent_xml_symbols_intern(&dtd->names, name);
+	struct element *element = element_for(dtd, id);
+	// each element can only be declared once
+	if (!element || element->content != CONTENT_UNDECLARED)
+		return false;
+
+	if (accept_keyword(cursor, "EMPTY")) {
+		element->content = CONTENT_EMPTY;
+		return expect(cursor, '>');
+	}
+	if (accept_keyword(cursor, "ANY")) {
+		element->content = CONTENT_ANY;
+		return expect(cursor, '>');
+	}
+
+	const struct cursor group = *cursor;
+	if (!accept_literal(cursor, "("))
+		return false;
+	skip_space(cursor);
+
+	if (accept_literal(cursor, "#PCDATA")) {
+		struct _descent_xml_automaton *model = &element->model;
+		element->content = CONTENT_MIXED;
+		size_t capacity = 0;
+		while (expect(cursor, '|')) {
+			skip_space(cursor);
+			if (!read_name(cursor, &name))
+				return false;
+			const int64_t symbol = _descent_xml_symbols_intern(&dtd->names, name);
+			if (symbol < 0 || !element_for(dtd, symbol))
+				return false;
+			model = &dtd->elements[id].model;
+			if (model->symbol_count == capacity) {
+				capacity = capacity ? capacity * 2 : 8;
+				uint32_t *const symbols = realloc(
+					model->symbols,
+					capacity * sizeof(*symbols)
+				);
+				if (!symbols)
+					return false;
+				model->symbols = symbols;
+			}
+			model->symbols[model->symbol_count++] = (uint32_t)symbol;
+		}
+		if (!expect(cursor, ')'))
+			return false;
+		// only (#PCDATA) can leave off the star
+		if (!accept_literal(cursor, "*") && model->symbol_count)
+			return false;
+		if (model->symbols)
+			qsort(model->symbols, model->symbol_count, sizeof(uint32_t), compare_symbols);
+		return expect(cursor, '>');
+	}
+
+	*cursor = group;
+	struct _descent_xml_automaton_tree tree = { 0 };
+	const size_t root = read_particle(dtd, cursor, &tree, 0);
+	bool result = root != NONE && expect(cursor, '>');
+	if (result) {
+		element = &dtd->elements[id];
+		element->content = CONTENT_CHILDREN;
+		result = _descent_xml_automaton_compile(&element->model, &tree, root);
+	}
+	free(tree.nodes);
+	return result;
+}
+
+static bool read_attribute_type(struct cursor *cursor, struct attribute *attribute)
+{
+	static const struct {
+		const char *keyword;
+		enum attribute_type type;
+	} types[] = {
+		{ "CDATA", ATTRIBUTE_CDATA },
+		{ "ID", ATTRIBUTE_ID },
+		{ "IDREF", ATTRIBUTE_IDREF },
+		{ "IDREFS", ATTRIBUTE_IDREFS },
+		{ "ENTITY", ATTRIBUTE_ENTITY },
+		{ "ENTITIES", ATTRIBUTE_ENTITIES },
+		{ "NMTOKEN", ATTRIBUTE_NMTOKEN },
+		{ "NMTOKENS", ATTRIBUTE_NMTOKENS },
+	};
+	for (size_t i = 0; i < sizeof(types) / sizeof(types[0]); i++) {
+		if (accept_keyword(cursor, types[i].keyword)) {
+			attribute->type = types[i].type;
+			return true;
+		}
+	}
+
+	// NOTATION (a|b) checks the value the same way as (a|b)
+	if (accept_keyword(cursor, "NOTATION") && !skip_space(cursor))
+		return false;
+	if (!accept_literal(cursor, "("))
+		return false;
+
+	attribute->type = ATTRIBUTE_ENUMERATION;
+	size_t capacity = 0;
+	do {
+		skip_space(cursor);
+		struct libadt_const_lptr value;
+		if (!read_nmtoken(cursor, &value))
+			return false;
+		if (attribute->value_count == capacity) {
+			capacity = capacity ? capacity * 2 : 8;
+			struct libadt_const_lptr *const values = realloc(
+				attribute->values,
+				capacity * sizeof(*values)
+			);
+			if (!values)
+				return false;
+			attribute->values = values;
+		}
+		attribute->values[attribute->value_count++] = value;
+	} while (expect(cursor, '|'));
+	return expect(cursor, ')');
+}
+
+static bool read_attribute_default(struct cursor *cursor, struct attribute *attribute)
+{
+	if (accept_keyword(cursor, "#REQUIRED")) {
+		attribute->default_type = DEFAULT_REQUIRED;
+		return true;
+	}
+	if (accept_keyword(cursor, "#IMPLIED")) {
+		attribute->default_type = DEFAULT_IMPLIED;
+		return true;
+	}
+
+	attribute->default_type = DEFAULT_VALUE;
+	if (accept_keyword(cursor, "#FIXED")) {
+		attribute->default_type = DEFAULT_FIXED;
+		if (!skip_space(cursor))
+			return false;
+	}
+	return read_literal(cursor, &attribute->value);
+}
+
+static bool add_attribute(struct element *element, struct attribute attribute)
+{
+	// the first declaration of an attribute is the one that counts
+	for (size_t i = 0; i < element->attribute_count; i++) {
+		if (element->attributes[i].name == attribute.name) {
+			free(attribute.values);
+			return true;
+		}
+	}
+
+	if (element->attribute_count == element->attribute_capacity) {
+		const size_t capacity = element->attribute_capacity
+			? element->attribute_capacity * 2
+			: 8;
+		struct attribute *const attributes = realloc(
+			element->attributes,
+			capacity * sizeof(*attributes)
+		);
+		if (!attributes) {
+			free(attribute.values);
+			return false;
+		}
+		element->attributes = attributes;
+		element->attribute_capacity = capacity;
+	}
+
+	element->attributes[element->attribute_count++] = attribute;
+	if (attribute.default_type == DEFAULT_REQUIRED)
+		element->required++;
+	return true;
+}
+
+static bool read_attlist_declaration(
+	struct descent_xml_dtd *dtd,
+	struct cursor *cursor
+)
+{
+	struct libadt_const_lptr name;
+	if (!skip_space(cursor) || !read_name(cursor, &name))
+		return false;
+
+	// attributes can be declared before their element is
+	const int64_t element_id = _descent_xml_symbols_intern(&dtd->names, name);
+	if (!element_for(dtd, element_id))
+		return false;
+
+	for (;;) {
+		const bool space = skip_space(cursor);
+		if (accept_literal(cursor, ">"))
+			return true;
+		if (!space || !read_name(cursor, &name))
+			return false;
+
+		const int64_t attribute_id = _descent_xml_symbols_intern(&dtd->names, name);
+		if (attribute_id < 0 || !element_for(dtd, attribute_id))
+			return false;
+
+		struct attribute attribute = { .name = (uint32_t)attribute_id };
+		const bool valid = skip_space(cursor)
+			&& read_attribute_type(cursor, &attribute)
+			&& skip_space(cursor)
+			&& read_attribute_default(cursor, &attribute);
+		if (!valid) {
+			free(attribute.values);
+			return false;
+		}
+
+		if (!add_attribute(&dtd->elements[element_id], attribute))
+			return false;
+	}
+}
+
+static bool read_entity_declaration(
+	struct descent_xml_dtd *dtd,
+	struct cursor *cursor
+)
+{
+	if (!skip_space(cursor))
+		return false;
+	const bool parameter = accept_literal(cursor, "%");
+	if (parameter && !skip_space(cursor))
+		return false;
+
+	struct libadt_const_lptr name, value;
+	if (!read_name(cursor, &name) || !skip_space(cursor))
+		return false;
+
+	bool unparsed = false;
+	if (!read_literal(cursor, &value)) {
+		if (!read_external_id(cursor))
+			return false;
+		const struct cursor before = *cursor;
+		if (skip_space(cursor) && accept_keyword(cursor, "NDATA")) {
+			if (parameter || !skip_space(cursor) || !read_name(cursor, &value))
+				return false;
+			unparsed = true;
+		} else {
+			*cursor = before;
+		}
+	}
+
+	if (!expect(cursor, '>'))
+		return false;
+
+	// parameter entities are only used inside the DTD, and we
+	// don't expand them
+	if (parameter)
+		return true;
+
+	// the first declaration of an entity is the one that counts
+	if (_descent_xml_symbols_find(&dtd->entities, name) >= 0)
+		return true;
+	if (_descent_xml_symbols_intern(&dtd->entities, name) < 0)
+		return false;
+	return !unparsed || _descent_xml_symbols_intern(&dtd->unparsed, name) >= 0;
+}
+
+static bool skip_declaration(struct cursor *cursor)
+{
+	while (!cursor_done(cursor)) {
+		struct libadt_const_lptr literal;
+		if (*cursor->at == '"' || *cursor->at == '\'') {
+			if (!read_literal(cursor, &literal))
+				return false;
+			continue;
+		}
+		if (*cursor->at++ == '>')
+			return true;
+	}
+	return false;
+}
+
+static bool read_declarations(struct descent_xml_dtd *dtd, struct cursor *cursor)
+{
+	for (;;) {
+		skip_space(cursor);
+		if (cursor_done(cursor))
+			return true;
+
+		bool valid;
+		if (accept_literal(cursor, "<!--"))
+			valid = skip_past(cursor, "-->");
+		else if (accept_literal(cursor, "<?"))
+			valid = skip_past(cursor, "?>");
+		else if (accept_keyword(cursor, "<!ELEMENT"))
+			valid = read_element_declaration(dtd, cursor);
+		else if (accept_keyword(cursor, "<!ATTLIST"))
+			valid = read_attlist_declaration(dtd, cursor);
+		else if (accept_keyword(cursor, "<!ENTITY"))
+			valid = read_entity_declaration(dtd, cursor);
+		else if (accept_keyword(cursor, "<!NOTATION"))
+			valid = skip_declaration(cursor);
+		else
+			valid = false;
+
+		if (!valid)
+			return false;
+	}
+}
+
+struct descent_xml_dtd *descent_xml_dtd_compile(
+	struct libadt_const_lptr declarations
+)
+{
+	struct descent_xml_dtd *const dtd = calloc(1, sizeof(*dtd));
+	if (!dtd)
+		return NULL;
+
+	const size_t length = declarations.length > 0
+		? (size_t)declarations.length
+		: 0;
+	dtd->text = malloc(length + 1);
+	if (!dtd->text)
+		goto error;
+	if (length)
+		memcpy(dtd->text, declarations.buffer, length);
+
+	struct cursor cursor = { dtd->text, dtd->text + length };
+	if (!read_declarations(dtd, &cursor))
+		goto error;
+
+	for (size_t i = 0; i < dtd->element_count; i++) {
+		struct element *const element = &dtd->elements[i];
+		if (element->attributes)
+			qsort(
+				element->attributes,
+				element->attribute_count,
+				sizeof(*element->attributes),
+				compare_attributes
+			);
+	}
+
+	return dtd;
+
+error:
+	descent_xml_dtd_free(dtd);
+	return NULL;
+}
+
+void descent_xml_dtd_free(struct descent_xml_dtd *dtd)
+{
+	if (!dtd)
+		return;
+
+	for (size_t i = 0; i < dtd->element_count; i++) {
+		struct element *const element = &dtd->elements[i];
+		_descent_xml_automaton_free(&element->model);
+		for (size_t j = 0; j < element->attribute_count; j++)
+			free(element->attributes[j].values);
+		free(element->attributes);
+	}
+	free(dtd->elements);
+	_descent_xml_symbols_free(&dtd->names);
+	_descent_xml_symbols_free(&dtd->entities);
+	_descent_xml_symbols_free(&dtd->unparsed);
+	free(dtd->text);
+	free(dtd);
+}
+
+static struct cursor doctype_after_name(
+	struct descent_xml_lex doctype,
+	struct libadt_const_lptr *name
+)
+{
+	const char *const start = doctype.value.buffer;
+	struct cursor cursor = { start, start + doctype.value.length };
+	*name = span(start, start);
+	if (doctype.type != descent_xml_lex_doctype)
+		return (struct cursor) { start, start };
+
+	accept_literal(&cursor, "!DOCTYPE");
+	skip_space(&cursor);
+	if (!read_name(&cursor, name))
+		return (struct cursor) { start, start };
+	return cursor;
+}
+
+struct libadt_const_lptr descent_xml_doctype_name(struct descent_xml_lex doctype)
+{
+	struct libadt_const_lptr name;
+	doctype_after_name(doctype, &name);
+	return name;
+}
+
+struct libadt_const_lptr descent_xml_doctype_subset(struct descent_xml_lex doctype)
+{
+	struct libadt_const_lptr name;
+	struct cursor cursor = doctype_after_name(doctype, &name);
+
+	skip_space(&cursor);
+	const struct cursor before = cursor;
+	if (!read_external_id(&cursor))
+		cursor = before;
+	skip_space(&cursor);
+
+	if (!accept_literal(&cursor, "["))
+		return span(cursor.at, cursor.at);
+
+	// the lexer made sure the subset ends with the last bracket
+	const char *end = cursor.end;
+	while (end > cursor.at && end[-1] != ']')
+		end--;
+	if (end == cursor.at)
+		return span(cursor.at, cursor.at);
+	return span(cursor.at, end - 1);
+}
+
+static const struct element *lookup_element(
+	const struct descent_xml_dtd *dtd,
+	struct libadt_const_lptr name
+)
+{
+	const int64_t id = _descent_xml_symbols_find(&dtd->names, name);
+	if (id < 0 || (size_t)id >= dtd->element_count)
+		return NULL;
+	const struct element *const element = &dtd->elements[id];
+	if (element->content == CONTENT_UNDECLARED)
+		return NULL;
+	return element;
+}
+
+static const struct attribute *lookup_attribute(
+	const struct descent_xml_dtd *dtd,
+	const struct element *element,
+	struct libadt_const_lptr name
+)
+{
+	const int64_t id = _descent_xml_symbols_find(&dtd->names, name);
+	if (id < 0)
+		return NULL;
+
+	size_t low = 0, high = element->attribute_count;
+	while (low < high) {
+		const size_t middle = low + (high - low) / 2;
+		const uint32_t found = element->attributes[middle].name;
+		if (found < (uint32_t)id)
+			low = middle + 1;
+		else if (found > (uint32_t)id)
+			high = middle;
+		else
+			return &element->attributes[middle];
+	}
+	return NULL;
+}
+
+// every &name; has to be predefined or declared, and not unparsed
+static bool check_references(
+	const struct descent_xml_dtd *dtd,
+	struct libadt_const_lptr text
+)
+{
+	static const char *const predefined[] = { "lt", "gt", "amp", "apos", "quot" };
+	if (text.length <= 0)
+		return true;
+
+	const char *const end = (const char *)text.buffer + text.length;
+	for (
+		const char *at = memchr(text.buffer, '&', (size_t)text.length);
+		at;
+		at = memchr(at, '&', (size_t)(end - at))
+	) {
+		at++;
+		const char *const semicolon = memchr(at, ';', (size_t)(end - at));
+		if (!semicolon)
+			return false;
+		const struct libadt_const_lptr name = span(at, semicolon);
+		at = semicolon + 1;
+
+		if (name.length > 0 && *(const char *)name.buffer == '#')
+			continue;
+
+		bool known = false;
+		for (size_t i = 0; i < sizeof(predefined) / sizeof(predefined[0]); i++)
+			known |= (size_t)name.length == strlen(predefined[i])
+				&& memcmp(name.buffer, predefined[i], (size_t)name.length) == 0;
+		if (known)
+			continue;
+
+		if (
+			_descent_xml_symbols_find(&dtd->entities, name) < 0
+			|| _descent_xml_symbols_find(&dtd->unparsed, name) >= 0
+		)
+			return false;
+	}
+	return true;
+}
+
+static struct libadt_const_lptr trim(struct libadt_const_lptr value)
+{
+	const char *start = value.buffer;
+	const char *end = start + value.length;
+	while (start < end && is_space(*start))
+		start++;
+	while (end > start && is_space(end[-1]))
+		end--;
+	return span(start, end);
+}
+
+static bool check_token(
+	const struct descent_xml_dtd *dtd,
+	enum attribute_type type,
+	struct libadt_const_lptr token
+)
+{
+	struct cursor cursor = { token.buffer, (const char *)token.buffer + token.length };
+	struct libadt_const_lptr name;
+	switch (type) {
+		case ATTRIBUTE_NMTOKEN:
+		case ATTRIBUTE_NMTOKENS:
+			return read_nmtoken(&cursor, &name) && cursor_done(&cursor);
+		case ATTRIBUTE_ENTITY:
+		case ATTRIBUTE_ENTITIES:
+			if (_descent_xml_symbols_find(&dtd->unparsed, token) < 0)
+				return false;
+			return read_name(&cursor, &name) && cursor_done(&cursor);
+		default:
+			return read_name(&cursor, &name) && cursor_done(&cursor);
+	}
+}
+
+static bool check_attribute(
+	const struct descent_xml_dtd *dtd,
+	const struct attribute *attribute,
+	struct libadt_const_lptr value
+)
+{
+	if (!check_references(dtd, value))
+		return false;
+
+	if (attribute->type == ATTRIBUTE_CDATA) {
+		return attribute->default_type != DEFAULT_FIXED
+			|| libadt_const_lptr_equal(value, attribute->value);
+	}
+
+	// everything else is compared after whitespace normalization,
+	// which for single tokens is just a trim
+	value = trim(value);
+	if (
+		attribute->default_type == DEFAULT_FIXED
+		&& !libadt_const_lptr_equal(value, trim(attribute->value))
+	)
+		return false;
+
+	switch (attribute->type) {
+		case ATTRIBUTE_ENUMERATION:
+			for (size_t i = 0; i < attribute->value_count; i++)
+				if (libadt_const_lptr_equal(value, attribute->values[i]))
+					return true;
+			return false;
+
+		case ATTRIBUTE_IDREFS:
+		case ATTRIBUTE_ENTITIES:
+		case ATTRIBUTE_NMTOKENS: {
+			const char *at = value.buffer;
+			const char *const end = at + value.length;
+			if (at == end)
+				return false;
+			while (at < end) {
+				const char *token_end = at;
+				while (token_end < end && !is_space(*token_end))
+					token_end++;
+				if (!check_token(dtd, attribute->type, span(at, token_end)))
+					return false;
+				at = token_end;
+				while (at < end && is_space(*at))
+					at++;
+			}
+			return true;
+		}
+
+		default:
+			return check_token(dtd, attribute->type, value);
+	}
+}
+
+static bool check_attributes(
+	const struct descent_xml_dtd *dtd,
+	const struct element *element,
+	struct libadt_const_lptr attributes
+)
+{
+	const struct libadt_const_lptr *const attrs = attributes.buffer;
+	size_t required = 0;
+	for (ssize_t i = 0; i + 1 < attributes.length; i += 2) {
+		const struct attribute *const attribute
+			= lookup_attribute(dtd, element, attrs[i]);
+		if (!attribute || !check_attribute(dtd, attribute, attrs[i + 1]))
+			return false;
+		if (attribute->default_type == DEFAULT_REQUIRED)
+			required++;
+	}
+	return required == element->required;
+}
+
+static bool advance(const struct element *parent, int32_t *state, uint32_t child)
+{
+	switch (parent->content) {
+		case CONTENT_ANY:
+			return true;
+		case CONTENT_MIXED:
+			return _descent_xml_automaton_find_symbol(&parent->model, child) >= 0;
+		case CONTENT_CHILDREN: {
+			const int32_t next
+				= _descent_xml_automaton_step(&parent->model, *state, child);
+			if (next < 0)
+				return false;
+			*state = next;
+			return true;
+		}
+		default:
+			return false;
+	}
+}
+
+bool descent_xml_dtd_element(
+	struct descent_xml_dtd_validator *validator,
+	struct libadt_const_lptr element_name,
+	struct libadt_const_lptr attributes,
+	bool empty
+)
+{
+	const struct descent_xml_dtd *const dtd = validator->dtd;
+	const struct element *const element = lookup_element(dtd, element_name);
+	if (!element)
+		return false;
+
+	if (validator->depth == 0) {
+		if (
+			validator->root.length > 0
+			&& !libadt_const_lptr_equal(validator->root, element_name)
+		)
+			return false;
+	} else {
+		struct _descent_xml_dtd_frame *const parent
+			= &validator->frames[validator->depth - 1];
+		const uint32_t child = (uint32_t)(element - dtd->elements);
+		if (!advance(&dtd->elements[parent->element], &parent->state, child))
+			return false;
+	}
+
+	if (!check_attributes(dtd, element, attributes))
+		return false;
+
+	if (empty)
+		return element->content != CONTENT_CHILDREN || element->model.accept[0];
+
+	if (validator->depth == validator->capacity) {
+		const size_t capacity = validator->capacity
+			? validator->capacity * 2
+			: 16;
+		struct _descent_xml_dtd_frame *const frames = descent_xml_reallocate(
+			validator->allocator,
+			validator->frames,
+			validator->capacity * sizeof(*frames),
+			capacity * sizeof(*frames)
+		);
+		if (!frames)
+			return false;
+		validator->frames = frames;
+		validator->capacity = capacity;
+	}
+	validator->frames[validator->depth++] = (struct _descent_xml_dtd_frame) {
+		.element = (uint32_t)(element - dtd->elements),
+		.state = 0,
+	};
+	return true;
+}
+
+bool descent_xml_dtd_text(
+	struct descent_xml_dtd_validator *validator,
+	struct libadt_const_lptr text,
+	bool is_cdata
+)
+{
+	// outside the root element is for the well-formedness checks
+	if (validator->depth == 0)
+		return true;
+
+	const struct descent_xml_dtd *const dtd = validator->dtd;
+	const struct element *const element
+		= &dtd->elements[validator->frames[validator->depth - 1].element];
+	switch (element->content) {
+		case CONTENT_EMPTY:
+			return false;
+		case CONTENT_CHILDREN:
+			return !is_cdata && trim(text).length == 0;
+		default:
+			return is_cdata || check_references(dtd, text);
+	}
+}
+
+bool descent_xml_dtd_close(struct descent_xml_dtd_validator *validator)
+{
+	if (validator->depth == 0)
+		return false;
+
+	const struct _descent_xml_dtd_frame frame
+		= validator->frames[--validator->depth];
+	const struct element *const element
+		= &validator->dtd->elements[frame.element];
+	return element->content != CONTENT_CHILDREN
+		|| element->model.accept[frame.state];
+}
+
+bool descent_xml_dtd_validate_document(
+	const struct descent_xml_dtd *dtd,
+	struct descent_xml_lex token
+)
+{
+	struct descent_xml_dtd *compiled = NULL;
+	struct descent_xml_dtd_validator dtd_validator
+		= descent_xml_dtd_validator_init(dtd);
+	struct descent_xml_validator validator = descent_xml_validator_init(1000);
+	if (dtd)
+		validator.dtd = &dtd_validator;
+
+	bool valid = true;
+	while (valid) {
+		token = descent_xml_parse_validated(token, &validator, NULL, NULL, NULL);
+
+		if (token.type == descent_xml_lex_doctype) {
+			dtd_validator.root = descent_xml_doctype_name(token);
+			if (!dtd) {
+				compiled = descent_xml_dtd_compile(
+					descent_xml_doctype_subset(token)
+				);
+				dtd_validator.dtd = compiled;
+				validator.dtd = compiled ? &dtd_validator : NULL;
+			}
+		}
+
+		// without a DTD of our own, one has to come before the root
+		if (!validator.dtd && validator.seen_root)
+			valid = false;
+
+		if (token.type == descent_xml_classifier_eof)
+			break;
+		if (
+			token.type == descent_xml_classifier_unexpected
+			|| token.type == descent_xml_validate_error
+			|| token.type == descent_xml_parse_error
+		)
+			valid = false;
+	}
+
+	descent_xml_validator_free(&validator);
+	descent_xml_dtd_validator_free(&dtd_validator);
+	descent_xml_dtd_free(compiled);
+	return valid;
+}
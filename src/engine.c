@@ -0,0 +1,461 @@
+#include "descent-xml/lex.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "descent-xml/chars.h"
+#include "descent-xml/token.h"
+
+#include "cclass.h"
+
+// The classifier states, run as labels inside one function rather than
+// one function call per character. _descent_xml_lex_run_generic() is
+// the reference: for the states here, the two must produce the same
+// tokens, which tests/descent_xml_engine.c checks.
+
+typedef descent_xml_classifier_fn cfn;
+
+// Computed goto is a GNU extension. Elsewhere, or with
+// DESCENT_XML_COMPUTED_GOTO turned off, states are dispatched with a
+// switch instead.
+#if defined(__GNUC__) && !defined(DESCENT_XML_NO_COMPUTED_GOTO)
+#define COMPUTED_GOTO
+#endif
+
+// The states run here, by token id and type
+#define STATES(X) \
+	X(START, descent_xml_classifier_start) \
+	X(TEXT, descent_xml_classifier_text) \
+	X(TEXT_SPACE, descent_xml_classifier_text_space) \
+	X(TEXT_ENTITY_START, descent_xml_classifier_text_entity_start) \
+	X(TEXT_ENTITY, descent_xml_classifier_text_entity) \
+	X(ELEMENT, descent_xml_classifier_element) \
+	X(ELEMENT_NAME, descent_xml_classifier_element_name) \
+	X(ELEMENT_SPACE, descent_xml_classifier_element_space) \
+	X(ELEMENT_EMPTY, descent_xml_classifier_element_empty) \
+	X(ELEMENT_END, descent_xml_classifier_element_end) \
+	X(ELEMENT_CLOSE, descent_xml_classifier_element_close) \
+	X(ELEMENT_CLOSE_NAME, descent_xml_classifier_element_close_name) \
+	X(ELEMENT_CLOSE_SPACE, descent_xml_classifier_element_close_space) \
+	X(ATTRIBUTE_NAME, descent_xml_classifier_attribute_name) \
+	X(ATTRIBUTE_EXPECT_ASSIGN, descent_xml_classifier_attribute_expect_assign) \
+	X(ATTRIBUTE_ASSIGN, descent_xml_classifier_attribute_assign) \
+	X(ATTRIBUTE_VALUE_SINGLE_QUOTE_START, descent_xml_classifier_attribute_value_single_quote_start) \
+	X(ATTRIBUTE_VALUE_SINGLE_QUOTE, descent_xml_classifier_attribute_value_single_quote) \
+	X(ATTRIBUTE_VALUE_SINGLE_QUOTE_ENTITY_START, descent_xml_classifier_attribute_value_single_quote_entity_start) \
+	X(ATTRIBUTE_VALUE_SINGLE_QUOTE_ENTITY, descent_xml_classifier_attribute_value_single_quote_entity) \
+	X(ATTRIBUTE_VALUE_SINGLE_QUOTE_END, descent_xml_classifier_attribute_value_single_quote_end) \
+	X(ATTRIBUTE_VALUE_DOUBLE_QUOTE_START, descent_xml_classifier_attribute_value_double_quote_start) \
+	X(ATTRIBUTE_VALUE_DOUBLE_QUOTE, descent_xml_classifier_attribute_value_double_quote) \
+	X(ATTRIBUTE_VALUE_DOUBLE_QUOTE_ENTITY_START, descent_xml_classifier_attribute_value_double_quote_entity_start) \
+	X(ATTRIBUTE_VALUE_DOUBLE_QUOTE_ENTITY, descent_xml_classifier_attribute_value_double_quote_entity) \
+	X(ATTRIBUTE_VALUE_DOUBLE_QUOTE_END, descent_xml_classifier_attribute_value_double_quote_end) \
+	X(DOCTYPE, descent_xml_lex_doctype) \
+	X(XMLDECL, descent_xml_lex_xmldecl) \
+	X(CDATA, descent_xml_lex_cdata) \
+	X(COMMENT, descent_xml_lex_comment)
+
+#define TYPE(id, type) [DESCENT_XML_TOKEN_##id] = type,
+static cfn *const types[DESCENT_XML_TOKEN_COUNT] = { STATES(TYPE) };
+#undef TYPE
+
+// Decodes the character at the start of script, as
+// _descent_xml_lex_read() does.
+static inline ssize_t decode(wchar_t *c, struct libadt_const_lptr script)
+{
+	mbstate_t mbs = { 0 };
+	*c = 0;
+	return _descent_xml_lex_mbrtowc(c, script, &mbs);
+}
+
+_descent_xml_lex_read_t _descent_xml_lex_run(
+	struct libadt_const_lptr next,
+	descent_xml_classifier_fn *previous
+)
+{
+	enum descent_xml_token_id state = descent_xml_token_id(previous);
+	if (!types[state])
+		return _descent_xml_lex_run_generic(next, previous);
+
+#ifdef COMPUTED_GOTO
+#define LABEL(id, type) [DESCENT_XML_TOKEN_##id] = &&state_##id,
+	static void *const labels[DESCENT_XML_TOKEN_COUNT] = { STATES(LABEL) };
+#undef LABEL
+#define DISPATCH() goto *labels[state]
+#else
+#define CASE(id, type) case DESCENT_XML_TOKEN_##id: goto state_##id;
+#define DISPATCH() \
+	switch (state) { \
+		STATES(CASE) \
+		default: \
+			abort(); \
+	}
+#endif
+
+	// The first character is fed to the previous token's state, and
+	// picks the new token's type. The token then runs for as long as
+	// its state keeps the characters that follow.
+	bool first = true;
+	// the bytes taken so far, and the rest of the script after them
+	ssize_t length = 0;
+	struct libadt_const_lptr rest = next;
+	// the character at the start of rest
+	wchar_t c;
+	ssize_t amount;
+	CHARACTER_CLASS cclass;
+	// the state the character moves to
+	enum descent_xml_token_id to;
+
+#define READ() \
+	do { \
+		amount = decode(&c, rest); \
+		if (amount < 0) \
+			goto done; \
+		cclass = get_cclass(c); \
+	} while (0)
+
+#define GO(id) \
+	do { \
+		to = DESCENT_XML_TOKEN_##id; \
+		goto transition; \
+	} while (0)
+
+	// Takes the character when it keeps the token's state, and runs
+	// straight on to the next one without dispatching.
+#define STAY(id) \
+	do { \
+		if (first || state != DESCENT_XML_TOKEN_##id) \
+			GO(id); \
+		length += amount; \
+		rest = libadt_const_lptr_index(rest, amount); \
+		READ(); \
+		goto state_##id; \
+	} while (0)
+
+	READ();
+	DISPATCH();
+
+state_START:
+	// skip BOM
+	if (c == 0xFEFF)
+		STAY(START);
+	switch (cclass) {
+		case CCLASS_OBRACKET:
+			GO(ELEMENT);
+		case CCLASS_SPACE:
+			STAY(START);
+		default:
+			GO(UNEXPECTED);
+	}
+
+state_ELEMENT:
+	switch (cclass) {
+		case CCLASS_EMARK:
+		case CCLASS_QMARK:
+		case CCLASS_NAME_START:
+			GO(ELEMENT_NAME);
+		case CCLASS_SLASH:
+			GO(ELEMENT_CLOSE);
+		default:
+			GO(UNEXPECTED);
+	}
+
+state_ELEMENT_EMPTY:
+	if (cclass == CCLASS_CBRACKET)
+		GO(ELEMENT_END);
+	GO(UNEXPECTED);
+
+state_ELEMENT_END:
+	switch (cclass) {
+		case CCLASS_EOF:
+			GO(EOF);
+		case CCLASS_OBRACKET:
+			GO(ELEMENT);
+		case CCLASS_CBRACKET:
+			GO(UNEXPECTED);
+		case CCLASS_REF_START:
+		case CCLASS_ENTITY_START:
+			GO(TEXT_ENTITY_START);
+		case CCLASS_SPACE:
+			GO(TEXT_SPACE);
+		default:
+			GO(TEXT);
+	}
+
+state_ELEMENT_CLOSE:
+	if (cclass == CCLASS_NAME_START)
+		GO(ELEMENT_CLOSE_NAME);
+	GO(UNEXPECTED);
+
+state_ELEMENT_CLOSE_NAME:
+	switch (cclass) {
+		case CCLASS_NAME_START:
+		case CCLASS_NAME:
+			STAY(ELEMENT_CLOSE_NAME);
+		case CCLASS_SPACE:
+			GO(ELEMENT_CLOSE_SPACE);
+		case CCLASS_CBRACKET:
+			GO(ELEMENT_END);
+		default:
+			GO(UNEXPECTED);
+	}
+
+state_ELEMENT_CLOSE_SPACE:
+	switch (cclass) {
+		case CCLASS_SPACE:
+			STAY(ELEMENT_CLOSE_SPACE);
+		case CCLASS_CBRACKET:
+			GO(ELEMENT_END);
+		default:
+			GO(UNEXPECTED);
+	}
+
+state_ELEMENT_NAME:
+	switch (cclass) {
+		case CCLASS_NAME_START:
+		case CCLASS_NAME:
+		case CCLASS_DASH:
+			STAY(ELEMENT_NAME);
+		case CCLASS_SPACE:
+			GO(ELEMENT_SPACE);
+		case CCLASS_CBRACKET:
+			GO(ELEMENT_END);
+		case CCLASS_SLASH:
+		case CCLASS_QMARK:
+			GO(ELEMENT_EMPTY);
+		default:
+			GO(UNEXPECTED);
+	}
+
+state_ELEMENT_SPACE:
+	switch (cclass) {
+		case CCLASS_NAME_START:
+			GO(ATTRIBUTE_NAME);
+		case CCLASS_SPACE:
+			STAY(ELEMENT_SPACE);
+		case CCLASS_CBRACKET:
+			GO(ELEMENT_END);
+		case CCLASS_SLASH:
+		case CCLASS_QMARK:
+			GO(ELEMENT_EMPTY);
+		default:
+			GO(UNEXPECTED);
+	}
+
+state_ATTRIBUTE_NAME:
+	switch (cclass) {
+		case CCLASS_NAME_START:
+		case CCLASS_NAME:
+			STAY(ATTRIBUTE_NAME);
+		case CCLASS_EQUALS:
+			GO(ATTRIBUTE_ASSIGN);
+		case CCLASS_SPACE:
+			GO(ATTRIBUTE_EXPECT_ASSIGN);
+		default:
+			GO(UNEXPECTED);
+	}
+
+state_ATTRIBUTE_EXPECT_ASSIGN:
+	switch (cclass) {
+		case CCLASS_EQUALS:
+			GO(ATTRIBUTE_ASSIGN);
+		case CCLASS_SPACE:
+			STAY(ATTRIBUTE_EXPECT_ASSIGN);
+		default:
+			GO(UNEXPECTED);
+	}
+
+state_ATTRIBUTE_ASSIGN:
+	switch (cclass) {
+		case CCLASS_SPACE:
+			STAY(ATTRIBUTE_ASSIGN);
+		case CCLASS_SQUOTE:
+			GO(ATTRIBUTE_VALUE_SINGLE_QUOTE_START);
+		case CCLASS_DQUOTE:
+			GO(ATTRIBUTE_VALUE_DOUBLE_QUOTE_START);
+		default:
+			GO(UNEXPECTED);
+	}
+
+state_ATTRIBUTE_VALUE_SINGLE_QUOTE_START:
+state_ATTRIBUTE_VALUE_SINGLE_QUOTE:
+	switch (cclass) {
+		case CCLASS_OBRACKET:
+		case CCLASS_EOF:
+			GO(UNEXPECTED);
+		case CCLASS_SQUOTE:
+			GO(ATTRIBUTE_VALUE_SINGLE_QUOTE_END);
+		case CCLASS_ENTITY_START:
+		case CCLASS_REF_START:
+			GO(ATTRIBUTE_VALUE_SINGLE_QUOTE_ENTITY_START);
+		default:
+			STAY(ATTRIBUTE_VALUE_SINGLE_QUOTE);
+	}
+
+state_ATTRIBUTE_VALUE_SINGLE_QUOTE_ENTITY_START:
+	switch (cclass) {
+		case CCLASS_NAME_START:
+		case CCLASS_HASH:
+			GO(ATTRIBUTE_VALUE_SINGLE_QUOTE_ENTITY);
+		default:
+			GO(UNEXPECTED);
+	}
+
+state_ATTRIBUTE_VALUE_SINGLE_QUOTE_ENTITY:
+	switch (cclass) {
+		case CCLASS_NAME_START:
+		case CCLASS_NAME:
+			STAY(ATTRIBUTE_VALUE_SINGLE_QUOTE_ENTITY);
+		case CCLASS_ENTITY_END:
+			GO(ATTRIBUTE_VALUE_SINGLE_QUOTE);
+		default:
+			GO(UNEXPECTED);
+	}
+
+state_ATTRIBUTE_VALUE_SINGLE_QUOTE_END:
+state_ATTRIBUTE_VALUE_DOUBLE_QUOTE_END:
+	switch (cclass) {
+		case CCLASS_CBRACKET:
+			GO(ELEMENT_END);
+		case CCLASS_SPACE:
+			GO(ELEMENT_SPACE);
+		case CCLASS_SLASH:
+		case CCLASS_QMARK:
+			GO(ELEMENT_EMPTY);
+		default:
+			GO(UNEXPECTED);
+	}
+
+state_ATTRIBUTE_VALUE_DOUBLE_QUOTE_START:
+state_ATTRIBUTE_VALUE_DOUBLE_QUOTE:
+	switch (cclass) {
+		case CCLASS_OBRACKET:
+		case CCLASS_EOF:
+			GO(UNEXPECTED);
+		case CCLASS_DQUOTE:
+			GO(ATTRIBUTE_VALUE_DOUBLE_QUOTE_END);
+		case CCLASS_ENTITY_START:
+		case CCLASS_REF_START:
+			GO(ATTRIBUTE_VALUE_DOUBLE_QUOTE_ENTITY_START);
+		default:
+			STAY(ATTRIBUTE_VALUE_DOUBLE_QUOTE);
+	}
+
+state_ATTRIBUTE_VALUE_DOUBLE_QUOTE_ENTITY_START:
+	switch (cclass) {
+		case CCLASS_NAME_START:
+		case CCLASS_HASH:
+			GO(ATTRIBUTE_VALUE_DOUBLE_QUOTE_ENTITY);
+		default:
+			GO(UNEXPECTED);
+	}
+
+state_ATTRIBUTE_VALUE_DOUBLE_QUOTE_ENTITY:
+	switch (cclass) {
+		case CCLASS_NAME_START:
+		case CCLASS_NAME:
+			STAY(ATTRIBUTE_VALUE_DOUBLE_QUOTE_ENTITY);
+		case CCLASS_ENTITY_END:
+			GO(ATTRIBUTE_VALUE_DOUBLE_QUOTE);
+		default:
+			GO(UNEXPECTED);
+	}
+
+state_TEXT_SPACE:
+	if (cclass == CCLASS_SPACE) {
+		if (first || state != DESCENT_XML_TOKEN_TEXT_SPACE)
+			GO(TEXT_SPACE);
+		// indentation: take the whole run at once, rather than
+		// decoding it a character at a time
+		const size_t spaces = descent_xml_chars_spaces(rest);
+		length += (ssize_t)spaces;
+		rest = libadt_const_lptr_index(rest, spaces);
+		READ();
+	}
+	goto text;
+
+state_TEXT:
+text:
+	switch (cclass) {
+		case CCLASS_OBRACKET:
+			GO(ELEMENT);
+		case CCLASS_ENTITY_START:
+		case CCLASS_REF_START:
+			GO(TEXT_ENTITY_START);
+		case CCLASS_EOF:
+			GO(EOF);
+		case CCLASS_CBRACKET:
+			GO(UNEXPECTED);
+		default:
+			STAY(TEXT);
+	}
+
+state_TEXT_ENTITY_START:
+	switch (cclass) {
+		case CCLASS_NAME_START:
+		case CCLASS_HASH:
+			GO(TEXT_ENTITY);
+		default:
+			GO(UNEXPECTED);
+	}
+
+state_TEXT_ENTITY:
+	switch (cclass) {
+		case CCLASS_NAME_START:
+		case CCLASS_NAME:
+			STAY(TEXT_ENTITY);
+		case CCLASS_ENTITY_END:
+			GO(TEXT);
+		default:
+			GO(UNEXPECTED);
+	}
+
+state_DOCTYPE:
+state_XMLDECL:
+state_CDATA:
+state_COMMENT:
+	if (c == L'>')
+		GO(ELEMENT_END);
+	GO(UNEXPECTED);
+
+transition:
+	if (first) {
+		if (to == DESCENT_XML_TOKEN_UNEXPECTED)
+			goto unexpected;
+		if (to == DESCENT_XML_TOKEN_EOF)
+			return (_descent_xml_lex_read_t) {
+				.amount = amount,
+				.type = descent_xml_classifier_eof,
+				.script = libadt_const_lptr_index(rest, amount),
+			};
+		first = false;
+	} else if (to != state) {
+		goto done;
+	}
+	state = to;
+	length += amount;
+	rest = libadt_const_lptr_index(rest, amount);
+	READ();
+	DISPATCH();
+
+done:
+	if (first)
+		goto unexpected;
+	return (_descent_xml_lex_read_t) {
+		.amount = length,
+		.type = types[state],
+		.script = rest,
+	};
+
+unexpected:
+	return (_descent_xml_lex_read_t) {
+		.amount = 0,
+		.type = descent_xml_classifier_unexpected,
+		.script = next,
+	};
+
+#undef STAY
+#undef GO
+#undef READ
+#undef DISPATCH
+}
@@ -17,9 +17,16 @@ _descent_xml_lex_read_t _descent_xml_lex_read(
 	struct libadt_const_lptr script,
 	descent_xml_classifier_fn *const previous
 );
+_descent_xml_lex_read_t _descent_xml_lex_run_generic(
+	struct libadt_const_lptr next,
+	descent_xml_classifier_fn *previous
+);
 struct descent_xml_lex descent_xml_lex_init(
 	struct libadt_const_lptr script
 );
+struct descent_xml_lex _descent_xml_lex_next_raw(
+	struct descent_xml_lex token
+);
 struct descent_xml_lex descent_xml_lex_next_raw(
 	struct descent_xml_lex previous
 );
@@ -69,6 +76,9 @@ struct descent_xml_lex _descent_xml_lex_doctype_public(
 struct descent_xml_lex _descent_xml_lex_doctype_extrawurst(
 	struct descent_xml_lex token
 );
+struct descent_xml_lex _descent_xml_lex_doctype_subset(
+	struct descent_xml_lex token
+);
 struct descent_xml_lex descent_xml_lex_handle_xmldecl(
 	struct descent_xml_lex token
 );
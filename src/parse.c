@@ -10,11 +10,29 @@ descent_xml_classifier_void_fn *descent_xml_parse_error(wchar_t c)
 }
 
 bool _descent_xml_end_token(struct descent_xml_lex token);
+bool _descent_xml_append_attribute(
+	const struct descent_xml_allocator *allocator,
+	struct libadt_vector *attributes,
+	const struct libadt_const_lptr *value
+);
+struct descent_xml_lex _descent_xml_read_attributes(
+	struct descent_xml_lex token,
+	const struct descent_xml_allocator *allocator,
+	struct libadt_vector *attributes
+);
 struct descent_xml_lex _descent_xml_handle_element(
 	struct descent_xml_lex token,
+	const struct descent_xml_allocator *allocator,
 	descent_xml_parse_element_fn *element_handler,
 	void *context
 );
+struct descent_xml_lex descent_xml_parse_alloc(
+	struct descent_xml_lex xml,
+	const struct descent_xml_allocator *allocator,
+	descent_xml_parse_element_fn *element_handler,
+	descent_xml_parse_text_fn *text_handler,
+	void *context
+);
 struct descent_xml_lex descent_xml_parse(
 	struct descent_xml_lex xml,
 	descent_xml_parse_element_fn *element_handler,
@@ -34,6 +52,20 @@ bool _descent_xml_is_attribute_value_type(
 );
 bool _descent_xml_is_text_type(struct descent_xml_lex token);
 _descent_xml_value_t _descent_xml_text_value(struct descent_xml_lex token);
+struct libadt_const_lptr _descent_xml_cdata_value(
+	struct descent_xml_lex token
+);
+void _descent_xml_parse_begin(struct descent_xml_lex xml);
+struct descent_xml_lex _descent_xml_parse_end(struct descent_xml_lex xml);
+void _descent_xml_release_cstr(
+	const struct descent_xml_allocator *allocator,
+	char *string
+);
+void _descent_xml_release_cstrs(
+	const struct descent_xml_allocator *allocator,
+	char **strings,
+	size_t count
+);
 struct descent_xml_lex _cstr_element_handler(
 	struct descent_xml_lex xml,
 	struct libadt_const_lptr element_name,
@@ -52,3 +84,10 @@ struct descent_xml_lex descent_xml_parse_cstr(
 	descent_xml_parse_text_cstr_fn *text_handler,
 	void *context
 );
+struct descent_xml_lex descent_xml_parse_cstr_alloc(
+	struct descent_xml_lex xml,
+	const struct descent_xml_allocator *allocator,
+	descent_xml_parse_element_cstr_fn *element_handler,
+	descent_xml_parse_text_cstr_fn *text_handler,
+	void *context
+);
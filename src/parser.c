@@ -0,0 +1,246 @@
+#include "descent-xml/parser.h"
+
+#include <stdalign.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ALIGNMENT alignof(max_align_t)
+
+// the smallest chunk worth asking the system for
+#define MIN_CHUNK 4096
+
+struct _descent_xml_arena_chunk {
+	struct _descent_xml_arena_chunk *next;
+	size_t size;
+	max_align_t data[];
+};
+
+struct descent_xml_lex descent_xml_parser_start(
+	struct descent_xml_parser *parser,
+	struct libadt_const_lptr script
+);
+struct descent_xml_lex descent_xml_parser_parse(
+	struct descent_xml_parser *parser,
+	struct descent_xml_lex xml,
+	descent_xml_parse_element_fn *element_handler,
+	descent_xml_parse_text_fn *text_handler,
+	void *context
+);
+struct descent_xml_lex descent_xml_parser_parse_cstr(
+	struct descent_xml_parser *parser,
+	struct descent_xml_lex xml,
+	descent_xml_parse_element_cstr_fn *element_handler,
+	descent_xml_parse_text_cstr_fn *text_handler,
+	void *context
+);
+struct descent_xml_lex descent_xml_parser_parse_validated(
+	struct descent_xml_parser *parser,
+	struct descent_xml_lex xml,
+	descent_xml_parse_element_fn *element_handler,
+	descent_xml_parse_text_fn *text_handler,
+	void *context
+);
+bool descent_xml_parser_validate(
+	struct descent_xml_parser *parser,
+	struct libadt_const_lptr script,
+	unsigned flags
+);
+
+// Rounds a size up to keep every block aligned, or returns zero if
+// that would overflow.
+static size_t round_up(size_t size)
+{
+	if (size > SIZE_MAX - ALIGNMENT)
+		return 0;
+	return (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+}
+
+static struct _descent_xml_arena_chunk *new_chunk(size_t size)
+{
+	if (size > SIZE_MAX - sizeof(struct _descent_xml_arena_chunk))
+		return NULL;
+	struct _descent_xml_arena_chunk *const chunk
+		= malloc(sizeof(struct _descent_xml_arena_chunk) + size);
+	if (!chunk)
+		return NULL;
+	chunk->next = NULL;
+	chunk->size = size;
+	return chunk;
+}
+
+static char *top(const struct descent_xml_parser *parser)
+{
+	return (char *)parser->current->data + parser->used;
+}
+
+static void note_peak(struct descent_xml_parser *parser)
+{
+	const size_t in_use = parser->used_before + parser->used;
+	if (in_use > parser->peak)
+		parser->peak = in_use;
+}
+
+// Moves on to a chunk with at least size bytes free: one left over
+// from an earlier document if there is one, or a new one twice the
+// size of the last.
+static bool next_chunk(struct descent_xml_parser *parser, size_t size)
+{
+	struct _descent_xml_arena_chunk *chunk = parser->current
+		? parser->current->next
+		: parser->chunks;
+	while (chunk && chunk->size < size)
+		chunk = chunk->next;
+
+	if (!chunk) {
+		size_t chunk_size = parser->current
+			? parser->current->size * 2
+			: MIN_CHUNK;
+		if (chunk_size < size)
+			chunk_size = size;
+		chunk = new_chunk(chunk_size);
+		if (!chunk)
+			return false;
+		if (parser->current) {
+			chunk->next = parser->current->next;
+			parser->current->next = chunk;
+		} else {
+			chunk->next = parser->chunks;
+			parser->chunks = chunk;
+		}
+		parser->capacity += chunk_size;
+	}
+
+	if (parser->current)
+		parser->used_before += parser->used;
+	parser->current = chunk;
+	parser->used = 0;
+	return true;
+}
+
+static void *arena_allocate(void *context, size_t size)
+{
+	struct descent_xml_parser *const parser = context;
+	const size_t rounded = round_up(size);
+	if (!rounded && size)
+		return NULL;
+
+	if (
+		(!parser->current || parser->current->size - parser->used < rounded)
+		&& !next_chunk(parser, rounded)
+	)
+		return NULL;
+
+	void *const result = top(parser);
+	parser->used += rounded;
+	note_peak(parser);
+	return result;
+}
+
+// Blocks are only given back if they're on top of the current chunk,
+// which they are when released in reverse order. Anything else waits
+// for the next reset.
+static void arena_release(void *context, void *pointer, size_t size)
+{
+	struct descent_xml_parser *const parser = context;
+	if (!pointer || !parser->current)
+		return;
+	if ((char *)pointer + round_up(size) == top(parser))
+		parser->used = (size_t)((char *)pointer - (char *)parser->current->data);
+}
+
+static void *arena_reallocate(
+	void *context,
+	void *pointer,
+	size_t old_size,
+	size_t size
+)
+{
+	struct descent_xml_parser *const parser = context;
+	if (!pointer)
+		return arena_allocate(context, size);
+
+	const size_t rounded = round_up(size);
+	if (!rounded && size)
+		return NULL;
+
+	// the block on top can grow or shrink where it is
+	char *const block = pointer;
+	if (parser->current && block + round_up(old_size) == top(parser)) {
+		const size_t offset = (size_t)(block - (char *)parser->current->data);
+		if (parser->current->size - offset >= rounded) {
+			parser->used = offset + rounded;
+			note_peak(parser);
+			return pointer;
+		}
+	}
+
+	void *const result = arena_allocate(context, size);
+	if (!result)
+		return NULL;
+	memcpy(result, pointer, old_size < size ? old_size : size);
+	return result;
+}
+
+bool descent_xml_parser_init(struct descent_xml_parser *parser, size_t capacity)
+{
+	*parser = (struct descent_xml_parser) {
+		.allocator = {
+			.allocate = arena_allocate,
+			.reallocate = arena_reallocate,
+			.release = arena_release,
+			.context = parser,
+		},
+		.validator = descent_xml_validator_init(1000),
+	};
+	parser->validator.allocator = &parser->allocator;
+
+	if (!capacity)
+		return true;
+	capacity = round_up(capacity);
+	parser->chunks = capacity ? new_chunk(capacity) : NULL;
+	if (!parser->chunks)
+		return false;
+	parser->current = parser->chunks;
+	parser->capacity = capacity;
+	return true;
+}
+
+static void free_chunks(struct _descent_xml_arena_chunk *chunk)
+{
+	while (chunk) {
+		struct _descent_xml_arena_chunk *const next = chunk->next;
+		free(chunk);
+		chunk = next;
+	}
+}
+
+void descent_xml_parser_free(struct descent_xml_parser *parser)
+{
+	free_chunks(parser->chunks);
+	parser->chunks = parser->current = NULL;
+	parser->used = parser->used_before = parser->capacity = 0;
+	parser->validator.open = NULL;
+	parser->validator.depth = parser->validator.capacity = 0;
+}
+
+void descent_xml_parser_reset(struct descent_xml_parser *parser)
+{
+	// one chunk the size of all of them saves moving between them
+	// next time
+	if (parser->chunks && parser->chunks->next) {
+		const size_t capacity = parser->capacity;
+		free_chunks(parser->chunks);
+		parser->chunks = new_chunk(capacity);
+		parser->capacity = parser->chunks ? capacity : 0;
+	}
+	parser->current = parser->chunks;
+	parser->used = parser->used_before = 0;
+
+	struct descent_xml_validator *const validator = &parser->validator;
+	validator->open = NULL;
+	validator->depth = validator->capacity = 0;
+	validator->seen_prolog = validator->seen_doctype = false;
+	validator->seen_root = false;
+	validator->allocator = &parser->allocator;
+}
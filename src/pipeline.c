@@ -0,0 +1,489 @@
+#include "descent-xml/pipeline.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_HANDLER_THREADS 1u
+#define DEFAULT_QUEUE_BATCHES 16u
+#define DEFAULT_BATCH_EVENTS 256u
+
+// number of times to poll a ring before yielding the CPU
+#define SPINS 128
+
+enum event_type {
+	EVENT_ELEMENT,
+	EVENT_EMPTY_ELEMENT,
+	EVENT_CLOSE,
+	EVENT_TEXT,
+	EVENT_CDATA,
+};
+
+// the compact form of an event: attributes are stored once per
+// batch, and the event just records where its own ones start
+struct event {
+	const void *value;
+	size_t length;
+	uint32_t attributes;
+	uint32_t attribute_count;
+	uint8_t type;
+};
+
+struct batch {
+	struct event *events;
+	size_t length;
+	struct libadt_const_lptr *attributes;
+	size_t attributes_length;
+	size_t attributes_capacity;
+	size_t bytes;
+};
+
+struct ring {
+	// head is only written by the handler thread and tail only
+	// by the lexer thread, so they get their own cache lines
+	_Alignas(64) atomic_size_t head;
+	_Alignas(64) atomic_size_t tail;
+	_Alignas(64) atomic_bool done;
+
+	size_t capacity;
+	struct batch *batches;
+
+	pthread_t thread;
+	bool started;
+	const struct descent_xml_pipeline_handlers *handlers;
+	void *context;
+	struct descent_xml_pipeline_stage_stats stats;
+};
+
+struct producer {
+	struct ring *rings;
+	unsigned ring_count;
+	unsigned next_ring;
+	struct batch *batch;
+	size_t batch_events;
+
+	const char *script;
+	size_t offset;
+	size_t published;
+
+	struct descent_xml_pipeline_stage_stats stats;
+	bool error;
+};
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void pause_briefly(unsigned *spins)
+{
+	if (++*spins < SPINS)
+		return;
+	*spins = 0;
+	sched_yield();
+}
+
+static void run_batch(struct ring *ring, const struct batch *batch)
+{
+	const struct descent_xml_pipeline_handlers *const handlers
+		= ring->handlers;
+
+	for (size_t i = 0; i < batch->length; i++) {
+		const struct event *const event = &batch->events[i];
+		const struct libadt_const_lptr value = {
+			.buffer = event->value,
+			.size = 1,
+			.length = (ssize_t)event->length,
+		};
+
+		switch (event->type) {
+			case EVENT_ELEMENT:
+			case EVENT_EMPTY_ELEMENT:
+				if (handlers->element_handler) {
+					const struct libadt_const_lptr attributes = {
+						.buffer = event->attribute_count
+							? &batch->attributes[event->attributes]
+							: NULL,
+						.size = sizeof(struct libadt_const_lptr),
+						.length = (ssize_t)event->attribute_count,
+					};
+					handlers->element_handler(
+						value,
+						attributes,
+						event->type == EVENT_EMPTY_ELEMENT,
+						ring->context
+					);
+				}
+				break;
+			case EVENT_CLOSE:
+				if (handlers->close_handler)
+					handlers->close_handler(value, ring->context);
+				break;
+			case EVENT_TEXT:
+			case EVENT_CDATA:
+				if (handlers->text_handler)
+					handlers->text_handler(
+						value,
+						event->type == EVENT_CDATA,
+						ring->context
+					);
+				break;
+		}
+	}
+}
+
+static void *handler_thread(void *ring_p)
+{
+	struct ring *const ring = ring_p;
+	const double start = now();
+	double waiting = 0;
+
+	for (;;) {
+		const size_t head
+			= atomic_load_explicit(&ring->head, memory_order_relaxed);
+		size_t tail
+			= atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+		if (head == tail) {
+			const double wait_start = now();
+			unsigned spins = 0;
+			bool done = false;
+			ring->stats.stalls++;
+			while (head == tail && !done) {
+				pause_briefly(&spins);
+				// done has to be checked before tail, so we
+				// can't miss a batch published just before it
+				done = atomic_load_explicit(
+					&ring->done,
+					memory_order_acquire
+				);
+				tail = atomic_load_explicit(
+					&ring->tail,
+					memory_order_acquire
+				);
+			}
+			waiting += now() - wait_start;
+			if (head == tail)
+				break;
+		}
+
+		const struct batch *const batch
+			= &ring->batches[head % ring->capacity];
+		run_batch(ring, batch);
+		ring->stats.events += batch->length;
+		ring->stats.bytes += batch->bytes;
+		ring->stats.batches++;
+		atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+	}
+
+	ring->stats.wait_seconds = waiting;
+	ring->stats.busy_seconds = now() - start - waiting;
+	return NULL;
+}
+
+static void publish(struct producer *producer)
+{
+	struct ring *const ring = &producer->rings[producer->next_ring];
+	struct batch *const batch = producer->batch;
+
+	batch->bytes = producer->offset - producer->published;
+	producer->published = producer->offset;
+	producer->stats.events += batch->length;
+	producer->stats.batches++;
+
+	const size_t tail
+		= atomic_load_explicit(&ring->tail, memory_order_relaxed);
+	atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+
+	producer->batch = NULL;
+	producer->next_ring = (producer->next_ring + 1) % producer->ring_count;
+}
+
+static struct batch *acquire(struct producer *producer)
+{
+	if (producer->batch)
+		return producer->batch;
+
+	struct ring *const ring = &producer->rings[producer->next_ring];
+	const size_t tail
+		= atomic_load_explicit(&ring->tail, memory_order_relaxed);
+	size_t head
+		= atomic_load_explicit(&ring->head, memory_order_acquire);
+
+	if (tail - head == ring->capacity) {
+		const double wait_start = now();
+		unsigned spins = 0;
+		producer->stats.stalls++;
+		while (tail - head == ring->capacity) {
+			pause_briefly(&spins);
+			head = atomic_load_explicit(
+				&ring->head,
+				memory_order_acquire
+			);
+		}
+		producer->stats.wait_seconds += now() - wait_start;
+	}
+
+	struct batch *const batch = &ring->batches[tail % ring->capacity];
+	batch->length = 0;
+	batch->attributes_length = 0;
+	producer->batch = batch;
+	return batch;
+}
+
+static struct event *append_event(struct producer *producer)
+{
+	struct batch *batch = acquire(producer);
+	if (batch->length == producer->batch_events) {
+		publish(producer);
+		batch = acquire(producer);
+	}
+	return &batch->events[batch->length++];
+}
+
+static struct descent_xml_lex producer_element(
+	struct descent_xml_lex token,
+	struct libadt_const_lptr element_name,
+	struct libadt_const_lptr attributes,
+	bool empty,
+	void *context
+)
+{
+	struct producer *const producer = context;
+	struct event *const event = append_event(producer);
+	struct batch *const batch = producer->batch;
+
+	const size_t needed
+		= batch->attributes_length + (size_t)attributes.length;
+	if (needed > batch->attributes_capacity) {
+		size_t capacity = batch->attributes_capacity * 2;
+		while (capacity < needed)
+			capacity *= 2;
+		struct libadt_const_lptr *const grown = needed <= UINT32_MAX
+			? realloc(batch->attributes, capacity * sizeof(*grown))
+			: NULL;
+		if (!grown) {
+			batch->length--;
+			producer->error = true;
+			return token;
+		}
+		batch->attributes = grown;
+		batch->attributes_capacity = capacity;
+	}
+
+	if (attributes.length)
+		memcpy(
+			&batch->attributes[batch->attributes_length],
+			attributes.buffer,
+			(size_t)attributes.length * sizeof(struct libadt_const_lptr)
+		);
+
+	*event = (struct event) {
+		.value = element_name.buffer,
+		.length = (size_t)element_name.length,
+		.attributes = (uint32_t)batch->attributes_length,
+		.attribute_count = (uint32_t)attributes.length,
+		.type = empty ? EVENT_EMPTY_ELEMENT : EVENT_ELEMENT,
+	};
+	batch->attributes_length = needed;
+	return token;
+}
+
+static void producer_text(
+	struct libadt_const_lptr text,
+	bool is_cdata,
+	void *context
+)
+{
+	struct producer *const producer = context;
+	struct event *const event = append_event(producer);
+	*event = (struct event) {
+		.value = text.buffer,
+		.length = (size_t)text.length,
+		.type = is_cdata ? EVENT_CDATA : EVENT_TEXT,
+	};
+}
+
+static void producer_close(
+	struct producer *producer,
+	struct libadt_const_lptr element_name
+)
+{
+	struct event *const event = append_event(producer);
+	*event = (struct event) {
+		.value = element_name.buffer,
+		.length = (size_t)element_name.length,
+		.type = EVENT_CLOSE,
+	};
+}
+
+static void free_rings(struct ring *rings, unsigned count)
+{
+	for (unsigned i = 0; i < count; i++) {
+		for (size_t j = 0; rings[i].batches && j < rings[i].capacity; j++) {
+			free(rings[i].batches[j].events);
+			free(rings[i].batches[j].attributes);
+		}
+		free(rings[i].batches);
+	}
+	free(rings);
+}
+
+static struct ring *alloc_rings(
+	unsigned count,
+	size_t capacity,
+	size_t batch_events
+)
+{
+	struct ring *const rings = calloc(count, sizeof(struct ring));
+	if (!rings)
+		return NULL;
+
+	for (unsigned i = 0; i < count; i++) {
+		struct ring *const ring = &rings[i];
+		atomic_init(&ring->head, 0);
+		atomic_init(&ring->tail, 0);
+		atomic_init(&ring->done, false);
+		ring->capacity = capacity;
+		ring->batches = calloc(capacity, sizeof(struct batch));
+		if (!ring->batches)
+			goto error;
+
+		for (size_t j = 0; j < capacity; j++) {
+			struct batch *const batch = &ring->batches[j];
+			batch->events = malloc(batch_events * sizeof(struct event));
+			batch->attributes_capacity = batch_events * 2;
+			batch->attributes = malloc(
+				batch->attributes_capacity
+				* sizeof(struct libadt_const_lptr)
+			);
+			if (!batch->events || !batch->attributes)
+				goto error;
+		}
+	}
+	return rings;
+
+error:
+	free_rings(rings, count);
+	return NULL;
+}
+
+static void add_stats(
+	struct descent_xml_pipeline_stage_stats *total,
+	const struct descent_xml_pipeline_stage_stats *stats
+)
+{
+	total->bytes += stats->bytes;
+	total->events += stats->events;
+	total->batches += stats->batches;
+	total->stalls += stats->stalls;
+	total->busy_seconds += stats->busy_seconds;
+	total->wait_seconds += stats->wait_seconds;
+}
+
+static bool stop_token(struct descent_xml_lex token)
+{
+	return token.type == descent_xml_classifier_eof
+		|| token.type == descent_xml_classifier_unexpected
+		|| token.type == descent_xml_parse_error;
+}
+
+struct descent_xml_lex descent_xml_pipeline_run(
+	struct descent_xml_lex xml,
+	const struct descent_xml_pipeline_options *options,
+	const struct descent_xml_pipeline_handlers *handlers,
+	void *context,
+	struct descent_xml_pipeline_stats *stats
+)
+{
+	const double start = now();
+	struct descent_xml_pipeline_options resolved = { 0 };
+	if (options)
+		resolved = *options;
+	if (!resolved.handler_threads)
+		resolved.handler_threads = DEFAULT_HANDLER_THREADS;
+	if (!resolved.queue_batches)
+		resolved.queue_batches = DEFAULT_QUEUE_BATCHES;
+	if (!resolved.batch_events)
+		resolved.batch_events = DEFAULT_BATCH_EVENTS;
+
+	struct producer producer = {
+		.ring_count = resolved.handler_threads,
+		.batch_events = resolved.batch_events,
+		.script = xml.script.buffer,
+		.offset = (size_t)((const char *)_descent_xml_lex_remainder(xml).buffer
+			- (const char *)xml.script.buffer),
+	};
+	producer.published = producer.offset;
+	const size_t first_offset = producer.offset;
+
+	producer.rings = alloc_rings(
+		producer.ring_count,
+		resolved.queue_batches,
+		resolved.batch_events
+	);
+	if (!producer.rings) {
+		xml.type = descent_xml_parse_error;
+		return xml;
+	}
+
+	for (unsigned i = 0; i < producer.ring_count; i++) {
+		struct ring *const ring = &producer.rings[i];
+		ring->handlers = handlers;
+		ring->context = context;
+		if (pthread_create(&ring->thread, NULL, handler_thread, ring)) {
+			producer.error = true;
+			break;
+		}
+		ring->started = true;
+	}
+
+	const double lex_start = now();
+	while (!producer.error && !stop_token(xml)) {
+		xml = descent_xml_parse(
+			xml,
+			producer_element,
+			producer_text,
+			&producer
+		);
+		producer.offset = (size_t)((const char *)_descent_xml_lex_remainder(xml).buffer
+			- producer.script);
+		if (xml.type == descent_xml_classifier_element_close_name)
+			producer_close(&producer, xml.value);
+	}
+	if (producer.batch)
+		publish(&producer);
+	producer.stats.bytes = producer.offset - first_offset;
+	producer.stats.busy_seconds
+		= now() - lex_start - producer.stats.wait_seconds;
+
+	struct descent_xml_pipeline_stage_stats handler_stats = { 0 };
+	for (unsigned i = 0; i < producer.ring_count; i++) {
+		struct ring *const ring = &producer.rings[i];
+		atomic_store_explicit(&ring->done, true, memory_order_release);
+		if (!ring->started)
+			continue;
+		pthread_join(ring->thread, NULL);
+		add_stats(&handler_stats, &ring->stats);
+	}
+
+	free_rings(producer.rings, producer.ring_count);
+
+	if (producer.error)
+		xml.type = descent_xml_parse_error;
+
+	if (stats) {
+		*stats = (struct descent_xml_pipeline_stats) {
+			.lexer = producer.stats,
+			.handlers = handler_stats,
+			.elapsed_seconds = now() - start,
+		};
+	}
+	return xml;
+}
@@ -0,0 +1,787 @@
+#include "descent-xml/read.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#ifdef DESCENT_XML_HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#endif
+
+#define DEFAULT_CHUNK_SIZE ((size_t)64 * 1024)
+#define DEFAULT_QUEUE_DEPTH 8u
+
+static struct descent_xml_read_options resolve_options(
+	const struct descent_xml_read_options *options
+)
+{
+	struct descent_xml_read_options result = { 0 };
+	if (options)
+		result = *options;
+	if (!result.chunk_size)
+		result.chunk_size = DEFAULT_CHUNK_SIZE;
+	if (!result.queue_depth)
+		result.queue_depth = DEFAULT_QUEUE_DEPTH;
+	return result;
+}
+
+static bool is_regular_file(int fd, off_t *size)
+{
+	struct stat st;
+	if (fstat(fd, &st) < 0)
+		return false;
+	*size = st.st_size;
+	return S_ISREG(st.st_mode);
+}
+
+// Reads once at offset, or from the current position if the
+// descriptor isn't seekable. Retries on EINTR.
+static ssize_t read_some(
+	int fd,
+	bool seekable,
+	void *buffer,
+	size_t length,
+	off_t offset
+)
+{
+	ssize_t result;
+	do {
+		result = seekable
+			? pread(fd, buffer, length, offset)
+			: read(fd, buffer, length);
+	} while (result < 0 && errno == EINTR);
+	return result;
+}
+
+static int sync_chunks(
+	int fd,
+	bool seekable,
+	off_t offset,
+	size_t chunk_size,
+	descent_xml_read_chunk_fn *chunk_handler,
+	void *context
+)
+{
+	char *const buffer = malloc(chunk_size);
+	if (!buffer)
+		return -1;
+
+	int result = 0;
+	for (;;) {
+		// fill the whole chunk where we can, so the callback
+		// sees the same chunk boundaries on every path
+		size_t filled = 0;
+		ssize_t amount = 0;
+		while (filled < chunk_size) {
+			amount = read_some(
+				fd,
+				seekable,
+				buffer + filled,
+				chunk_size - filled,
+				offset + (off_t)filled
+			);
+			if (amount <= 0)
+				break;
+			filled += (size_t)amount;
+		}
+
+		if (amount < 0) {
+			result = -1;
+			break;
+		}
+
+		if (filled) {
+			const struct libadt_const_lptr chunk = {
+				.buffer = buffer,
+				.size = 1,
+				.length = (ssize_t)filled,
+			};
+			if (chunk_handler(chunk, context))
+				break;
+		}
+
+		if (filled < chunk_size)
+			break;
+		offset += (off_t)filled;
+	}
+
+	const int error = errno;
+	free(buffer);
+	errno = error;
+	return result;
+}
+
+#ifdef DESCENT_XML_HAVE_IO_URING
+
+struct uring {
+	int fd;
+	unsigned entries;
+	unsigned pending;
+
+	unsigned *sq_tail;
+	unsigned *sq_mask;
+	unsigned *sq_array;
+	struct io_uring_sqe *sqes;
+
+	unsigned *cq_head;
+	unsigned *cq_tail;
+	unsigned *cq_mask;
+	struct io_uring_cqe *cqes;
+
+	void *sq_ring;
+	size_t sq_ring_size;
+	void *cq_ring;
+	size_t cq_ring_size;
+	size_t sqes_size;
+};
+
+static int uring_setup(unsigned entries, struct io_uring_params *params)
+{
+	return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int uring_enter(
+	int fd,
+	unsigned to_submit,
+	unsigned min_complete,
+	unsigned flags
+)
+{
+	return (int)syscall(
+		__NR_io_uring_enter,
+		fd,
+		to_submit,
+		min_complete,
+		flags,
+		NULL,
+		0
+	);
+}
+
+static void uring_free(struct uring *ring)
+{
+	if (ring->sqes && ring->sqes != MAP_FAILED)
+		munmap(ring->sqes, ring->sqes_size);
+	if (ring->cq_ring && ring->cq_ring != ring->sq_ring)
+		munmap(ring->cq_ring, ring->cq_ring_size);
+	if (ring->sq_ring && ring->sq_ring != MAP_FAILED)
+		munmap(ring->sq_ring, ring->sq_ring_size);
+	close(ring->fd);
+}
+
+static int uring_init(struct uring *ring, unsigned entries)
+{
+	struct io_uring_params params = { 0 };
+	*ring = (struct uring) { .fd = uring_setup(entries, &params) };
+	if (ring->fd < 0)
+		return -1;
+
+	ring->entries = params.sq_entries;
+	ring->sq_ring_size = params.sq_off.array
+		+ params.sq_entries * sizeof(unsigned);
+	ring->cq_ring_size = params.cq_off.cqes
+		+ params.cq_entries * sizeof(struct io_uring_cqe);
+
+	const bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+	if (single_mmap && ring->cq_ring_size > ring->sq_ring_size)
+		ring->sq_ring_size = ring->cq_ring_size;
+
+	ring->sq_ring = mmap(
+		NULL,
+		ring->sq_ring_size,
+		PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_POPULATE,
+		ring->fd,
+		IORING_OFF_SQ_RING
+	);
+	if (ring->sq_ring == MAP_FAILED)
+		goto error;
+
+	if (single_mmap) {
+		ring->cq_ring = ring->sq_ring;
+	} else {
+		ring->cq_ring = mmap(
+			NULL,
+			ring->cq_ring_size,
+			PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE,
+			ring->fd,
+			IORING_OFF_CQ_RING
+		);
+		if (ring->cq_ring == MAP_FAILED) {
+			ring->cq_ring = NULL;
+			goto error;
+		}
+	}
+
+	ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+	ring->sqes = mmap(
+		NULL,
+		ring->sqes_size,
+		PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_POPULATE,
+		ring->fd,
+		IORING_OFF_SQES
+	);
+	if (ring->sqes == MAP_FAILED)
+		goto error;
+
+	char *const sq = ring->sq_ring;
+	char *const cq = ring->cq_ring;
+	ring->sq_tail = (unsigned *)(sq + params.sq_off.tail);
+	ring->sq_mask = (unsigned *)(sq + params.sq_off.ring_mask);
+	ring->sq_array = (unsigned *)(sq + params.sq_off.array);
+	ring->cq_head = (unsigned *)(cq + params.cq_off.head);
+	ring->cq_tail = (unsigned *)(cq + params.cq_off.tail);
+	ring->cq_mask = (unsigned *)(cq + params.cq_off.ring_mask);
+	ring->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+	return 0;
+
+error:
+	{
+		const int error = errno;
+		uring_free(ring);
+		errno = error;
+	}
+	return -1;
+}
+
+static void uring_prep_read(
+	struct uring *ring,
+	int fd,
+	void *buffer,
+	size_t length,
+	off_t offset,
+	uint64_t user_data
+)
+{
+	// we never have more than ring->entries requests
+	// outstanding, so there is always a free sqe
+	const unsigned tail = *ring->sq_tail;
+	const unsigned index = tail & *ring->sq_mask;
+	struct io_uring_sqe *const sqe = &ring->sqes[index];
+
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->opcode = IORING_OP_READ;
+	sqe->fd = fd;
+	sqe->addr = (uint64_t)(uintptr_t)buffer;
+	sqe->len = (uint32_t)length;
+	sqe->off = (uint64_t)offset;
+	sqe->user_data = user_data;
+
+	ring->sq_array[index] = index;
+	__atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+	ring->pending++;
+}
+
+// Submits anything pending and waits for a single completion.
+static int uring_wait(struct uring *ring, uint64_t *user_data, int32_t *res)
+{
+	for (;;) {
+		const unsigned head = *ring->cq_head;
+		const unsigned tail
+			= __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+
+		// submit before reaping, so new reads get going
+		// while we work on the ones that have finished
+		if (ring->pending || head == tail) {
+			const int entered = uring_enter(
+				ring->fd,
+				ring->pending,
+				head == tail ? 1 : 0,
+				IORING_ENTER_GETEVENTS
+			);
+			if (entered < 0) {
+				if (errno == EINTR)
+					continue;
+				return -1;
+			}
+			ring->pending -= (unsigned)entered;
+			if (head == tail)
+				continue;
+		}
+
+		const struct io_uring_cqe *const cqe
+			= &ring->cqes[head & *ring->cq_mask];
+		*user_data = cqe->user_data;
+		*res = cqe->res;
+		__atomic_store_n(ring->cq_head, head + 1, __ATOMIC_RELEASE);
+		return 0;
+	}
+}
+
+enum slot_state {
+	SLOT_IDLE,
+	SLOT_IN_FLIGHT,
+	SLOT_DONE,
+};
+
+struct slot {
+	char *buffer;
+	off_t offset;
+	size_t length;
+	size_t filled;
+	enum slot_state state;
+	bool eof;
+};
+
+// Reads [0, limit) of a regular file through an io_uring,
+// handing completed slots to chunk_handler in file order. If dest
+// is non-NULL, each read goes straight into dest at its file offset
+// instead of into a pool buffer.
+//
+// Returns 0 on success, -1 on error, or 1 if the kernel doesn't
+// support the read opcode and nothing was delivered, in which case
+// the caller should fall back to the synchronous path.
+static int uring_chunks(
+	int fd,
+	struct descent_xml_read_options options,
+	char *dest,
+	off_t limit,
+	descent_xml_read_chunk_fn *chunk_handler,
+	void *context,
+	off_t *delivered
+)
+{
+	struct uring ring;
+	if (uring_init(&ring, options.queue_depth) < 0)
+		return 1;
+
+	const unsigned depth = options.queue_depth < ring.entries
+		? options.queue_depth
+		: ring.entries;
+	const size_t chunk_size = options.chunk_size;
+
+	struct slot *const slots = calloc(depth, sizeof(struct slot));
+	char *pool = NULL;
+	if (!slots)
+		goto error;
+	if (!dest) {
+		pool = malloc(chunk_size * depth);
+		if (!pool)
+			goto error;
+	}
+
+	int result = 0;
+	// in_flight counts requests the kernel owns, outstanding
+	// counts slots that have been submitted but not delivered
+	unsigned in_flight = 0;
+	unsigned outstanding = 0;
+	off_t next_offset = 0;
+	*delivered = 0;
+
+	for (unsigned i = 0; i < depth && next_offset < limit; i++) {
+		struct slot *const slot = &slots[i];
+		slot->offset = next_offset;
+		slot->length = (size_t)(limit - next_offset) < chunk_size
+			? (size_t)(limit - next_offset)
+			: chunk_size;
+		slot->buffer = dest ? dest + next_offset : pool + chunk_size * i;
+		slot->state = SLOT_IN_FLIGHT;
+		uring_prep_read(&ring, fd, slot->buffer, slot->length, slot->offset, i);
+		in_flight++;
+		outstanding++;
+		next_offset += (off_t)slot->length;
+	}
+
+	bool stop = false;
+	for (unsigned current = 0; !stop && outstanding;) {
+		struct slot *const slot = &slots[current];
+
+		while (slot->state != SLOT_DONE) {
+			uint64_t user_data = 0;
+			int32_t res = 0;
+			if (uring_wait(&ring, &user_data, &res) < 0) {
+				result = -1;
+				goto drain;
+			}
+			in_flight--;
+
+			struct slot *const done = &slots[user_data];
+			if (res == -EINTR || res == -EAGAIN) {
+				res = 0;
+			} else if (res < 0) {
+				errno = -res;
+				const bool unsupported = (res == -EINVAL
+					|| res == -EOPNOTSUPP)
+					&& *delivered == 0;
+				result = unsupported ? 1 : -1;
+				goto drain;
+			} else if (res == 0) {
+				done->eof = true;
+			}
+
+			done->filled += (size_t)res;
+			if (done->eof || done->filled == done->length) {
+				done->state = SLOT_DONE;
+				continue;
+			}
+
+			// short read: ask for the rest of the slot
+			uring_prep_read(
+				&ring,
+				fd,
+				done->buffer + done->filled,
+				done->length - done->filled,
+				done->offset + (off_t)done->filled,
+				user_data
+			);
+			in_flight++;
+		}
+
+		if (slot->filled) {
+			const struct libadt_const_lptr chunk = {
+				.buffer = slot->buffer,
+				.size = 1,
+				.length = (ssize_t)slot->filled,
+			};
+			*delivered += (off_t)slot->filled;
+			stop = chunk_handler(chunk, context) != 0;
+		}
+		if (slot->eof)
+			break;
+
+		slot->state = SLOT_IDLE;
+		outstanding--;
+		if (!stop && next_offset < limit) {
+			slot->offset = next_offset;
+			slot->length = (size_t)(limit - next_offset) < chunk_size
+				? (size_t)(limit - next_offset)
+				: chunk_size;
+			if (dest)
+				slot->buffer = dest + next_offset;
+			slot->filled = 0;
+			slot->state = SLOT_IN_FLIGHT;
+			uring_prep_read(
+				&ring,
+				fd,
+				slot->buffer,
+				slot->length,
+				slot->offset,
+				current
+			);
+			in_flight++;
+			outstanding++;
+			next_offset += (off_t)slot->length;
+		}
+		current = (current + 1) % depth;
+	}
+
+drain:
+	// the kernel may still be writing into our buffers, so we
+	// can't free them until every request has completed
+	{
+		const int error = errno;
+		while (in_flight) {
+			uint64_t user_data;
+			int32_t res;
+			if (uring_wait(&ring, &user_data, &res) < 0)
+				break;
+			in_flight--;
+		}
+		errno = error;
+	}
+
+	free(pool);
+	free(slots);
+	uring_free(&ring);
+	return result;
+
+error:
+	{
+		const int error = errno;
+		free(pool);
+		free(slots);
+		uring_free(&ring);
+		errno = error;
+	}
+	return -1;
+}
+
+bool descent_xml_read_io_uring_available(void)
+{
+	struct io_uring_params params = { 0 };
+	const int fd = uring_setup(1, &params);
+	if (fd < 0)
+		return false;
+	close(fd);
+	return true;
+}
+
+#else
+
+bool descent_xml_read_io_uring_available(void)
+{
+	return false;
+}
+
+#endif // DESCENT_XML_HAVE_IO_URING
+
+#ifdef DESCENT_XML_HAVE_IO_URING
+struct forward {
+	descent_xml_read_chunk_fn *chunk_handler;
+	void *context;
+	bool stopped;
+};
+
+static int forward_chunk(struct libadt_const_lptr chunk, void *context)
+{
+	struct forward *const forward = context;
+	forward->stopped = forward->chunk_handler(chunk, forward->context) != 0;
+	return forward->stopped;
+}
+#endif
+
+int descent_xml_read_chunks(
+	int fd,
+	const struct descent_xml_read_options *options_p,
+	descent_xml_read_chunk_fn *chunk_handler,
+	void *context
+)
+{
+	const struct descent_xml_read_options options
+		= resolve_options(options_p);
+	off_t size = 0;
+	const bool regular = is_regular_file(fd, &size);
+	off_t offset = 0;
+
+#ifdef DESCENT_XML_HAVE_IO_URING
+	if (regular && size > 0 && !(options.flags & DESCENT_XML_READ_SYNC)) {
+		struct forward forward = { chunk_handler, context, false };
+		const int result = uring_chunks(
+			fd,
+			options,
+			NULL,
+			size,
+			forward_chunk,
+			&forward,
+			&offset
+		);
+		if (result < 0 || forward.stopped)
+			return result;
+		// otherwise, pick up anything written since we
+		// called fstat(), or everything if we fell back
+	}
+#endif
+
+	return sync_chunks(
+		fd,
+		regular,
+		offset,
+		options.chunk_size,
+		chunk_handler,
+		context
+	);
+}
+
+struct collect {
+	struct libadt_lptr result;
+	size_t capacity;
+	bool failed;
+};
+
+static int collect_chunk(struct libadt_const_lptr chunk, void *context)
+{
+	struct collect *const collect = context;
+	const size_t length = (size_t)collect->result.length;
+	const size_t needed = length + (size_t)chunk.length;
+
+	if (needed > collect->capacity) {
+		size_t capacity = collect->capacity ? collect->capacity : 4096;
+		while (capacity < needed)
+			capacity *= 2;
+		char *const buffer = realloc(collect->result.buffer, capacity);
+		if (!buffer) {
+			collect->failed = true;
+			return 1;
+		}
+		collect->result.buffer = buffer;
+		collect->capacity = capacity;
+	}
+
+	memcpy(
+		(char *)collect->result.buffer + length,
+		chunk.buffer,
+		(size_t)chunk.length
+	);
+	collect->result.length = (ssize_t)needed;
+	return 0;
+}
+
+#ifdef DESCENT_XML_HAVE_IO_URING
+static int count_chunk(struct libadt_const_lptr chunk, void *context)
+{
+	(void)chunk;
+	(void)context;
+	return 0;
+}
+#endif
+
+struct libadt_lptr descent_xml_read_fd(
+	int fd,
+	const struct descent_xml_read_options *options_p
+)
+{
+	const struct descent_xml_read_options options
+		= resolve_options(options_p);
+	struct collect collect = {
+		.result = { .buffer = NULL, .size = 1, .length = 0 },
+	};
+	off_t size = 0;
+	const bool regular = is_regular_file(fd, &size);
+	int result = 1;
+
+#ifdef DESCENT_XML_HAVE_IO_URING
+	if (regular && size > 0 && !(options.flags & DESCENT_XML_READ_SYNC)) {
+		collect.result.buffer = malloc((size_t)size);
+		if (!collect.result.buffer)
+			return collect.result;
+		collect.capacity = (size_t)size;
+
+		off_t delivered = 0;
+		result = uring_chunks(
+			fd,
+			options,
+			collect.result.buffer,
+			size,
+			count_chunk,
+			NULL,
+			&delivered
+		);
+		collect.result.length = (ssize_t)delivered;
+	}
+#endif
+
+	if (result > 0) {
+		result = sync_chunks(
+			fd,
+			regular,
+			0,
+			options.chunk_size,
+			collect_chunk,
+			&collect
+		);
+	} else if (result == 0 && collect.result.length == size) {
+		// the file may have grown since we called fstat()
+		result = sync_chunks(
+			fd,
+			true,
+			size,
+			options.chunk_size,
+			collect_chunk,
+			&collect
+		);
+	}
+
+	if (result == 0 && collect.failed) {
+		result = -1;
+		errno = ENOMEM;
+	}
+
+	// an empty file still gets a buffer, so that NULL
+	// always means an error
+	if (result == 0 && !collect.result.buffer) {
+		collect.result.buffer = malloc(1);
+		if (!collect.result.buffer)
+			result = -1;
+		collect.capacity = 1;
+	}
+
+	if (result == 0 && (options.flags & DESCENT_XML_READ_PADDED)) {
+		const size_t length = (size_t)collect.result.length;
+		if (collect.capacity < length + DESCENT_XML_PADDING) {
+			char *const buffer = realloc(
+				collect.result.buffer,
+				length + DESCENT_XML_PADDING
+			);
+			if (buffer)
+				collect.result.buffer = buffer;
+			else
+				result = -1;
+		}
+		if (result == 0)
+			memset((char *)collect.result.buffer + length, 0, DESCENT_XML_PADDING);
+	}
+
+	if (result < 0) {
+		const int error = errno;
+		free(collect.result.buffer);
+		errno = error;
+		return (struct libadt_lptr) { .buffer = NULL, .size = 1 };
+	}
+	return collect.result;
+}
+
+int descent_xml_read_map(int fd, struct descent_xml_read_mapping *mapping)
+{
+	struct stat st;
+	if (fstat(fd, &st) < 0)
+		return -1;
+	if (!S_ISREG(st.st_mode)) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+	const size_t length = (size_t)st.st_size;
+	const size_t readable
+		= (length + DESCENT_XML_PADDING + page - 1) / page * page;
+	const size_t size = readable + page;
+
+	// reserve the lot unreadable, then map the file over the start,
+	// and zero pages over the rest of the padding
+	char *const base = mmap(
+		NULL,
+		size,
+		PROT_NONE,
+		MAP_PRIVATE | MAP_ANONYMOUS,
+		-1,
+		0
+	);
+	if (base == MAP_FAILED)
+		return -1;
+
+	const size_t file_pages = (length + page - 1) / page * page;
+	const bool mapped = (!length || mmap(
+		base,
+		length,
+		PROT_READ,
+		MAP_PRIVATE | MAP_FIXED,
+		fd,
+		0
+	) != MAP_FAILED) && mprotect(
+		base + file_pages,
+		readable - file_pages,
+		PROT_READ
+	) == 0;
+	if (!mapped) {
+		const int error = errno;
+		munmap(base, size);
+		errno = error;
+		return -1;
+	}
+
+	*mapping = (struct descent_xml_read_mapping) {
+		.script = {
+			.buffer = base,
+			.size = 1,
+			.length = (ssize_t)length,
+		},
+		.base = base,
+		.size = size,
+	};
+	return 0;
+}
+
+void descent_xml_read_unmap(struct descent_xml_read_mapping *mapping)
+{
+	if (mapping->base)
+		munmap(mapping->base, mapping->size);
+	*mapping = (struct descent_xml_read_mapping) { .base = NULL };
+}
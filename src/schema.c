@@ -0,0 +1,2238 @@
+#include "descent-xml/schema.h"
+
+#include "automaton.h"
+#include "descent-xml/read.h"
+#include "descent-xml/validate.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <regex.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define NONE _DESCENT_XML_AUTOMATON_NONE
+#define UNBOUNDED SIZE_MAX
+
+// expanding minOccurs and maxOccurs copies the particle, so this
+// bounds how large a single content model can get
+#define MAX_POSITIONS 4096
+
+// how deep element declarations with anonymous types can nest
+#define MAX_NESTING 256
+
+struct descent_xml_schema_validator descent_xml_schema_validator_init(
+	const struct descent_xml_schema *schema
+);
+void descent_xml_schema_validator_free(
+	struct descent_xml_schema_validator *validator
+);
+
+enum builtin {
+	BUILTIN_STRING,
+	BUILTIN_NAME,
+	BUILTIN_NCNAME,
+	BUILTIN_NMTOKEN,
+	BUILTIN_BOOLEAN,
+	BUILTIN_DECIMAL,
+	BUILTIN_INTEGER,
+	BUILTIN_FLOAT,
+	BUILTIN_DATE,
+	BUILTIN_TIME,
+	BUILTIN_DATE_TIME,
+	BUILTIN_LIST,
+};
+
+enum facet {
+	FACET_MIN_INCLUSIVE = 1 << 0,
+	FACET_MAX_INCLUSIVE = 1 << 1,
+	FACET_MIN_EXCLUSIVE = 1 << 2,
+	FACET_MAX_EXCLUSIVE = 1 << 3,
+	FACET_LENGTH = 1 << 4,
+	FACET_MIN_LENGTH = 1 << 5,
+	FACET_MAX_LENGTH = 1 << 6,
+	FACET_PATTERN = 1 << 7,
+};
+
+#define NUMERIC_FACETS ( \
+	FACET_MIN_INCLUSIVE \
+	| FACET_MAX_INCLUSIVE \
+	| FACET_MIN_EXCLUSIVE \
+	| FACET_MAX_EXCLUSIVE \
+)
+
+// a simple type is a chain of restrictions ending in a built-in,
+// and a value has to pass every link
+struct simple_type {
+	size_t base;
+	enum builtin builtin;
+	size_t item;
+	bool collapse;
+
+	unsigned facets;
+	long double min;
+	long double max;
+	size_t length;
+	size_t min_length;
+	size_t max_length;
+	regex_t pattern;
+	struct libadt_const_lptr *enumerations;
+	size_t enumeration_count;
+};
+
+enum complex_content {
+	COMPLEX_ELEMENTS,
+	COMPLEX_ALL,
+	COMPLEX_SIMPLE,
+	COMPLEX_ANY,
+};
+
+struct attribute_use {
+	uint32_t name;
+	size_t type;
+	bool required;
+	bool fixed;
+	struct libadt_const_lptr value;
+};
+
+struct all_member {
+	uint32_t name;
+	size_t element;
+};
+
+struct complex_type {
+	enum complex_content content;
+	bool mixed;
+
+	// COMPLEX_ELEMENTS: state tags are element declarations
+	struct _descent_xml_automaton model;
+
+	// COMPLEX_ALL
+	struct all_member *members;
+	size_t member_count;
+	uint64_t required_members;
+	bool members_optional;
+
+	// COMPLEX_SIMPLE
+	size_t simple;
+
+	// sorted by name
+	struct attribute_use *attributes;
+	size_t attribute_count;
+	size_t required_attributes;
+	bool any_attribute;
+};
+
+enum type_state {
+	TYPE_PENDING,
+	TYPE_COMPILING,
+	TYPE_DONE,
+};
+
+struct type {
+	bool complex;
+	enum type_state state;
+	size_t node;
+	struct simple_type simple;
+	struct complex_type complex_type;
+};
+
+struct element_declaration {
+	uint32_t name;
+	size_t type;
+	size_t node;
+};
+
+struct descent_xml_schema {
+	// our own copy of the schema; names and values point into it
+	char *text;
+
+	// local names of elements and attributes
+	struct _descent_xml_symbols names;
+
+	struct type *types;
+	size_t type_count;
+	size_t type_capacity;
+	size_t any_type;
+
+	struct element_declaration *elements;
+	size_t element_count;
+	size_t element_capacity;
+
+	struct _descent_xml_symbols globals;
+	size_t *global_elements;
+};
+
+// the schema document itself, as a tree of elements
+struct node {
+	struct libadt_const_lptr name;
+	size_t attributes;
+	size_t attribute_count;
+	size_t child;
+	size_t sibling;
+	size_t last_child;
+};
+
+struct builder {
+	struct descent_xml_schema *schema;
+
+	struct node *nodes;
+	size_t node_count;
+	size_t node_capacity;
+
+	struct libadt_const_lptr *attributes;
+	size_t attribute_count;
+	size_t attribute_capacity;
+
+	size_t *stack;
+	size_t depth;
+	size_t stack_capacity;
+	bool error;
+
+	struct _descent_xml_symbols type_names;
+	size_t *named_types;
+	size_t *builtin_types;
+	struct _descent_xml_symbols builtin_names;
+
+	// the element declaration made for each element node
+	size_t *declarations;
+	int nesting;
+};
+
+static bool grow(void **buffer, size_t *capacity, size_t length, size_t size)
+{
+	if (length < *capacity)
+		return true;
+	const size_t new_capacity = *capacity ? *capacity * 2 : 16;
+	void *const grown = realloc(*buffer, new_capacity * size);
+	if (!grown)
+		return false;
+	*buffer = grown;
+	*capacity = new_capacity;
+	return true;
+}
+
+static struct libadt_const_lptr span(const char *start, const char *end)
+{
+	return (struct libadt_const_lptr) {
+		.buffer = start,
+		.size = 1,
+		.length = end - start,
+	};
+}
+
+static struct libadt_const_lptr local_name(struct libadt_const_lptr name)
+{
+	const char *const start = name.buffer;
+	const char *const end = start + name.length;
+	const char *const colon = memchr(start, ':', (size_t)name.length);
+	return colon ? span(colon + 1, end) : name;
+}
+
+static bool lptr_is(struct libadt_const_lptr lptr, const char *literal)
+{
+	const size_t length = strlen(literal);
+	return (size_t)lptr.length == length
+		&& memcmp(lptr.buffer, literal, length) == 0;
+}
+
+static bool is_space(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static struct libadt_const_lptr trim(struct libadt_const_lptr value)
+{
+	const char *start = value.buffer;
+	const char *end = start + value.length;
+	while (start < end && is_space(*start))
+		start++;
+	while (end > start && is_space(end[-1]))
+		end--;
+	return span(start, end);
+}
+
+static struct descent_xml_lex build_element(
+	struct descent_xml_lex token,
+	struct libadt_const_lptr element_name,
+	struct libadt_const_lptr attributes,
+	bool empty,
+	void *context
+)
+{
+	struct builder *const builder = context;
+	const struct libadt_const_lptr *const attrs = attributes.buffer;
+
+	const bool grown = grow(
+		(void **)&builder->nodes,
+		&builder->node_capacity,
+		builder->node_count,
+		sizeof(*builder->nodes)
+	);
+	if (!grown) {
+		builder->error = true;
+		return token;
+	}
+
+	for (ssize_t i = 0; i < attributes.length; i++) {
+		if (!grow(
+			(void **)&builder->attributes,
+			&builder->attribute_capacity,
+			builder->attribute_count,
+			sizeof(*builder->attributes)
+		)) {
+			builder->error = true;
+			return token;
+		}
+		builder->attributes[builder->attribute_count++] = attrs[i];
+	}
+
+	const size_t index = builder->node_count++;
+	builder->nodes[index] = (struct node) {
+		.name = local_name(element_name),
+		.attributes = builder->attribute_count - (size_t)attributes.length,
+		.attribute_count = (size_t)attributes.length / 2,
+		.child = NONE,
+		.sibling = NONE,
+		.last_child = NONE,
+	};
+
+	if (builder->depth > 0) {
+		struct node *const parent
+			= &builder->nodes[builder->stack[builder->depth - 1]];
+		if (parent->last_child == NONE)
+			parent->child = index;
+		else
+			builder->nodes[parent->last_child].sibling = index;
+		parent->last_child = index;
+	}
+
+	if (!empty) {
+		if (!grow(
+			(void **)&builder->stack,
+			&builder->stack_capacity,
+			builder->depth,
+			sizeof(*builder->stack)
+		)) {
+			builder->error = true;
+			return token;
+		}
+		builder->stack[builder->depth++] = index;
+	}
+	return token;
+}
+
+static bool build_tree(struct builder *builder, struct libadt_const_lptr xsd)
+{
+	struct descent_xml_validator validator = descent_xml_validator_init(-1);
+	struct descent_xml_lex token = descent_xml_lex_init(xsd);
+	for (;;) {
+		token = descent_xml_parse_validated(
+			token,
+			&validator,
+			build_element,
+			NULL,
+			builder
+		);
+		if (builder->error)
+			break;
+		if (token.type == descent_xml_classifier_element_close_name)
+			builder->depth--;
+		else if (
+			token.type == descent_xml_classifier_eof
+			|| token.type == descent_xml_classifier_unexpected
+			|| token.type == descent_xml_validate_error
+			|| token.type == descent_xml_parse_error
+		)
+			break;
+	}
+	descent_xml_validator_free(&validator);
+	return !builder->error
+		&& token.type == descent_xml_classifier_eof
+		&& builder->node_count > 0;
+}
+
+static bool attribute(
+	const struct builder *builder,
+	size_t node,
+	const char *name,
+	struct libadt_const_lptr *value
+)
+{
+	const struct node *const n = &builder->nodes[node];
+	for (size_t i = 0; i < n->attribute_count; i++) {
+		const struct libadt_const_lptr *const pair
+			= &builder->attributes[n->attributes + i * 2];
+		if (lptr_is(pair[0], name)) {
+			*value = pair[1];
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool is(const struct builder *builder, size_t node, const char *name)
+{
+	return lptr_is(builder->nodes[node].name, name);
+}
+
+// the children of node, skipping annotations
+static size_t first_child(const struct builder *builder, size_t node)
+{
+	size_t child = builder->nodes[node].child;
+	while (child != NONE && is(builder, child, "annotation"))
+		child = builder->nodes[child].sibling;
+	return child;
+}
+
+static size_t next_child(const struct builder *builder, size_t node)
+{
+	size_t child = builder->nodes[node].sibling;
+	while (child != NONE && is(builder, child, "annotation"))
+		child = builder->nodes[child].sibling;
+	return child;
+}
+
+static bool parse_size(struct libadt_const_lptr value, size_t *result)
+{
+	value = trim(value);
+	if (value.length <= 0 || value.length > 18)
+		return false;
+	size_t parsed = 0;
+	for (ssize_t i = 0; i < value.length; i++) {
+		const char c = ((const char *)value.buffer)[i];
+		if (c < '0' || c > '9')
+			return false;
+		parsed = parsed * 10 + (size_t)(c - '0');
+	}
+	*result = parsed;
+	return true;
+}
+
+static bool parse_number(struct libadt_const_lptr value, long double *result)
+{
+	char buffer[64];
+	value = trim(value);
+	if (value.length <= 0 || (size_t)value.length >= sizeof(buffer))
+		return false;
+	memcpy(buffer, value.buffer, (size_t)value.length);
+	buffer[value.length] = '\0';
+	char *end;
+	*result = strtold(buffer, &end);
+	return *end == '\0';
+}
+
+static size_t add_type(struct descent_xml_schema *schema, struct type type)
+{
+	if (!grow(
+		(void **)&schema->types,
+		&schema->type_capacity,
+		schema->type_count,
+		sizeof(*schema->types)
+	))
+		return NONE;
+	schema->types[schema->type_count] = type;
+	return schema->type_count++;
+}
+
+static size_t add_element(
+	struct descent_xml_schema *schema,
+	struct element_declaration element
+)
+{
+	if (!grow(
+		(void **)&schema->elements,
+		&schema->element_capacity,
+		schema->element_count,
+		sizeof(*schema->elements)
+	))
+		return NONE;
+	schema->elements[schema->element_count] = element;
+	return schema->element_count++;
+}
+
+static const struct {
+	const char *name;
+	enum builtin builtin;
+	bool collapse;
+	unsigned facets;
+	long double min;
+	long double max;
+} builtins[] = {
+	{ "anySimpleType", BUILTIN_STRING, false, 0, 0, 0 },
+	{ "string", BUILTIN_STRING, false, 0, 0, 0 },
+	{ "normalizedString", BUILTIN_STRING, false, 0, 0, 0 },
+	{ "token", BUILTIN_STRING, true, 0, 0, 0 },
+	{ "language", BUILTIN_NMTOKEN, true, 0, 0, 0 },
+	{ "anyURI", BUILTIN_STRING, true, 0, 0, 0 },
+	{ "QName", BUILTIN_NAME, true, 0, 0, 0 },
+	{ "Name", BUILTIN_NAME, true, 0, 0, 0 },
+	{ "NCName", BUILTIN_NCNAME, true, 0, 0, 0 },
+	{ "ID", BUILTIN_NCNAME, true, 0, 0, 0 },
+	{ "IDREF", BUILTIN_NCNAME, true, 0, 0, 0 },
+	{ "NMTOKEN", BUILTIN_NMTOKEN, true, 0, 0, 0 },
+	{ "boolean", BUILTIN_BOOLEAN, true, 0, 0, 0 },
+	{ "decimal", BUILTIN_DECIMAL, true, 0, 0, 0 },
+	{ "float", BUILTIN_FLOAT, true, 0, 0, 0 },
+	{ "double", BUILTIN_FLOAT, true, 0, 0, 0 },
+	{ "integer", BUILTIN_INTEGER, true, 0, 0, 0 },
+	{
+		"long", BUILTIN_INTEGER, true,
+		FACET_MIN_INCLUSIVE | FACET_MAX_INCLUSIVE,
+		-9223372036854775807.0L - 1, 9223372036854775807.0L
+	},
+	{
+		"int", BUILTIN_INTEGER, true,
+		FACET_MIN_INCLUSIVE | FACET_MAX_INCLUSIVE,
+		-2147483648.0L, 2147483647.0L
+	},
+	{
+		"short", BUILTIN_INTEGER, true,
+		FACET_MIN_INCLUSIVE | FACET_MAX_INCLUSIVE,
+		-32768, 32767
+	},
+	{
+		"byte", BUILTIN_INTEGER, true,
+		FACET_MIN_INCLUSIVE | FACET_MAX_INCLUSIVE,
+		-128, 127
+	},
+	{ "nonNegativeInteger", BUILTIN_INTEGER, true, FACET_MIN_INCLUSIVE, 0, 0 },
+	{ "positiveInteger", BUILTIN_INTEGER, true, FACET_MIN_INCLUSIVE, 1, 0 },
+	{ "nonPositiveInteger", BUILTIN_INTEGER, true, FACET_MAX_INCLUSIVE, 0, 0 },
+	{ "negativeInteger", BUILTIN_INTEGER, true, FACET_MAX_INCLUSIVE, 0, -1 },
+	{
+		"unsignedLong", BUILTIN_INTEGER, true,
+		FACET_MIN_INCLUSIVE | FACET_MAX_INCLUSIVE,
+		0, 18446744073709551615.0L
+	},
+	{
+		"unsignedInt", BUILTIN_INTEGER, true,
+		FACET_MIN_INCLUSIVE | FACET_MAX_INCLUSIVE,
+		0, 4294967295.0L
+	},
+	{
+		"unsignedShort", BUILTIN_INTEGER, true,
+		FACET_MIN_INCLUSIVE | FACET_MAX_INCLUSIVE,
+		0, 65535
+	},
+	{
+		"unsignedByte", BUILTIN_INTEGER, true,
+		FACET_MIN_INCLUSIVE | FACET_MAX_INCLUSIVE,
+		0, 255
+	},
+	{ "date", BUILTIN_DATE, true, 0, 0, 0 },
+	{ "time", BUILTIN_TIME, true, 0, 0, 0 },
+	{ "dateTime", BUILTIN_DATE_TIME, true, 0, 0, 0 },
+};
+
+#define BUILTIN_COUNT (sizeof(builtins) / sizeof(builtins[0]))
+
+static bool add_builtins(struct builder *builder)
+{
+	struct descent_xml_schema *const schema = builder->schema;
+	builder->builtin_types = malloc(BUILTIN_COUNT * sizeof(size_t));
+	if (!builder->builtin_types)
+		return false;
+
+	for (size_t i = 0; i < BUILTIN_COUNT; i++) {
+		const size_t type = add_type(schema, (struct type) {
+			.state = TYPE_DONE,
+			.node = NONE,
+			.simple = {
+				.base = NONE,
+				.item = NONE,
+				.builtin = builtins[i].builtin,
+				.collapse = builtins[i].collapse,
+				.facets = builtins[i].facets,
+				.min = builtins[i].min,
+				.max = builtins[i].max,
+			},
+		});
+		const struct libadt_const_lptr name = {
+			.buffer = builtins[i].name,
+			.size = 1,
+			.length = (ssize_t)strlen(builtins[i].name),
+		};
+		if (type == NONE || _descent_xml_symbols_intern(&builder->builtin_names, name) < 0)
+			return false;
+		builder->builtin_types[i] = type;
+	}
+
+	schema->any_type = add_type(schema, (struct type) {
+		.complex = true,
+		.state = TYPE_DONE,
+		.node = NONE,
+		.complex_type = {
+			.content = COMPLEX_ANY,
+			.mixed = true,
+			.any_attribute = true,
+		},
+	});
+	return schema->any_type != NONE;
+}
+
+static bool compile_type(struct builder *builder, size_t type);
+
+static size_t resolve_type(struct builder *builder, struct libadt_const_lptr qname)
+{
+	const struct libadt_const_lptr name = local_name(trim(qname));
+	const int64_t named = _descent_xml_symbols_find(&builder->type_names, name);
+	if (named >= 0) {
+		const size_t type = builder->named_types[named];
+		return compile_type(builder, type) ? type : NONE;
+	}
+	if (lptr_is(name, "anyType"))
+		return builder->schema->any_type;
+	const int64_t builtin = _descent_xml_symbols_find(&builder->builtin_names, name);
+	return builtin >= 0 ? builder->builtin_types[builtin] : NONE;
+}
+
+static size_t compile_anonymous(struct builder *builder, size_t node)
+{
+	const size_t type = add_type(builder->schema, (struct type) {
+		.complex = is(builder, node, "complexType"),
+		.state = TYPE_PENDING,
+		.node = node,
+	});
+	if (type == NONE || !compile_type(builder, type))
+		return NONE;
+	return type;
+}
+
+// translates an XSD regular expression into a POSIX extended one;
+// the two agree on most syntax, but XSD has no anchors and its own
+// character class escapes
+static bool translate_pattern(struct libadt_const_lptr pattern, char *out, size_t size)
+{
+	const char *at = pattern.buffer;
+	const char *const end = at + pattern.length;
+	size_t length = 0;
+	bool bracket = false;
+
+#define EMIT(s) do { \
+	const size_t emit_length = strlen(s); \
+	if (length + emit_length >= size) \
+		return false; \
+	memcpy(out + length, (s), emit_length); \
+	length += emit_length; \
+} while (0)
+
+	while (at < end) {
+		const char c = *at++;
+		char literal[2] = { c, '\0' };
+
+		if (c == '\\') {
+			if (at == end)
+				return false;
+			const char e = *at++;
+			switch (e) {
+				case 'd': EMIT(bracket ? "0-9" : "[0-9]"); break;
+				case 's': EMIT(bracket ? " \t\n\r" : "[ \t\n\r]"); break;
+				case 'w': EMIT(bracket ? "[:alnum:]_" : "[[:alnum:]_]"); break;
+				case 'i': EMIT(bracket ? "_:A-Za-z" : "[_:A-Za-z]"); break;
+				case 'c': EMIT(bracket ? "-._:A-Za-z0-9" : "[-._:A-Za-z0-9]"); break;
+				case 'D':
+				case 'S':
+				case 'W':
+				case 'I':
+				case 'C':
+					// negated classes can't go inside brackets
+					if (bracket)
+						return false;
+					if (e == 'D') EMIT("[^0-9]");
+					if (e == 'S') EMIT("[^ \t\n\r]");
+					if (e == 'W') EMIT("[^[:alnum:]_]");
+					if (e == 'I') EMIT("[^_:A-Za-z]");
+					if (e == 'C') EMIT("[^-._:A-Za-z0-9]");
+					break;
+				case 'n': EMIT("\n"); break;
+				case 'r': EMIT("\r"); break;
+				case 't': EMIT("\t"); break;
+				case 'p':
+				case 'P':
+					return false;
+				default:
+					literal[0] = e;
+					if (!bracket) {
+						EMIT("\\");
+						EMIT(literal);
+					} else if (e == '-' || e == ']' || e == '[' || e == '^') {
+						// backslashes are literal in POSIX
+						// brackets, but collating symbols work
+						EMIT("[.");
+						EMIT(literal);
+						EMIT(".]");
+					} else {
+						EMIT(literal);
+					}
+			}
+			continue;
+		}
+
+		if (bracket) {
+			// character class subtraction
+			if (c == '-' && at < end && *at == '[')
+				return false;
+			if (c == ']')
+				bracket = false;
+			EMIT(literal);
+			continue;
+		}
+
+		switch (c) {
+			case '[':
+				bracket = true;
+				EMIT("[");
+				if (at < end && *at == '^') {
+					EMIT("^");
+					at++;
+				}
+				break;
+			case '^':
+			case '$':
+				EMIT("\\");
+				EMIT(literal);
+				break;
+			default:
+				EMIT(literal);
+		}
+	}
+
+#undef EMIT
+
+	out[length] = '\0';
+	return !bracket;
+}
+
+static bool compile_patterns(
+	struct builder *builder,
+	size_t restriction,
+	struct simple_type *simple
+)
+{
+	// patterns in the same restriction are alternatives
+	size_t size = 16;
+	for (size_t c = first_child(builder, restriction); c != NONE; c = next_child(builder, c)) {
+		struct libadt_const_lptr value;
+		if (is(builder, c, "pattern") && attribute(builder, c, "value", &value))
+			size += (size_t)value.length * 16 + 8;
+	}
+
+	char *const expression = malloc(size);
+	char *const translated = malloc(size);
+	if (!expression || !translated) {
+		free(expression);
+		free(translated);
+		return false;
+	}
+
+	bool valid = true;
+	size_t length = 0;
+	bool first = true;
+	length += (size_t)snprintf(expression, size, "^(");
+	for (size_t c = first_child(builder, restriction); c != NONE && valid; c = next_child(builder, c)) {
+		struct libadt_const_lptr value;
+		if (!is(builder, c, "pattern"))
+			continue;
+		valid = attribute(builder, c, "value", &value)
+			&& translate_pattern(value, translated, size);
+		if (valid)
+			length += (size_t)snprintf(
+				expression + length,
+				size - length,
+				"%s(%s)",
+				first ? "" : "|",
+				translated
+			);
+		first = false;
+	}
+	snprintf(expression + length, size - length, ")$");
+
+	if (valid)
+		valid = regcomp(&simple->pattern, expression, REG_EXTENDED | REG_NOSUB) == 0;
+	if (valid)
+		simple->facets |= FACET_PATTERN;
+	free(expression);
+	free(translated);
+	return valid;
+}
+
+static bool numeric(const struct descent_xml_schema *schema, size_t type)
+{
+	while (schema->types[type].simple.base != NONE)
+		type = schema->types[type].simple.base;
+	const enum builtin builtin = schema->types[type].simple.builtin;
+	return builtin == BUILTIN_DECIMAL
+		|| builtin == BUILTIN_INTEGER
+		|| builtin == BUILTIN_FLOAT;
+}
+
+static bool compile_restriction(
+	struct builder *builder,
+	size_t type,
+	size_t restriction
+)
+{
+	struct descent_xml_schema *const schema = builder->schema;
+	struct libadt_const_lptr value;
+
+	size_t base = NONE;
+	size_t child = first_child(builder, restriction);
+	if (attribute(builder, restriction, "base", &value)) {
+		base = resolve_type(builder, value);
+	} else if (child != NONE && is(builder, child, "simpleType")) {
+		base = compile_anonymous(builder, child);
+		child = next_child(builder, child);
+	}
+	if (base == NONE || schema->types[base].complex)
+		return false;
+
+	struct simple_type simple = {
+		.base = base,
+		.item = NONE,
+		.collapse = schema->types[base].simple.collapse,
+	};
+
+	size_t enumeration_capacity = 0;
+	bool patterns = false;
+	bool valid = true;
+	for (size_t c = child; c != NONE && valid; c = next_child(builder, c)) {
+		if (is(builder, c, "pattern")) {
+			patterns = true;
+			continue;
+		}
+		if (!attribute(builder, c, "value", &value)) {
+			valid = false;
+			break;
+		}
+
+		if (is(builder, c, "enumeration")) {
+			valid = grow(
+				(void **)&simple.enumerations,
+				&enumeration_capacity,
+				simple.enumeration_count,
+				sizeof(*simple.enumerations)
+			);
+			if (valid)
+				simple.enumerations[simple.enumeration_count++] = value;
+		} else if (is(builder, c, "minInclusive")) {
+			simple.facets |= FACET_MIN_INCLUSIVE;
+			valid = parse_number(value, &simple.min);
+		} else if (is(builder, c, "maxInclusive")) {
+			simple.facets |= FACET_MAX_INCLUSIVE;
+			valid = parse_number(value, &simple.max);
+		} else if (is(builder, c, "minExclusive")) {
+			simple.facets |= FACET_MIN_EXCLUSIVE;
+			valid = parse_number(value, &simple.min);
+		} else if (is(builder, c, "maxExclusive")) {
+			simple.facets |= FACET_MAX_EXCLUSIVE;
+			valid = parse_number(value, &simple.max);
+		} else if (is(builder, c, "length")) {
+			simple.facets |= FACET_LENGTH;
+			valid = parse_size(value, &simple.length);
+		} else if (is(builder, c, "minLength")) {
+			simple.facets |= FACET_MIN_LENGTH;
+			valid = parse_size(value, &simple.min_length);
+		} else if (is(builder, c, "maxLength")) {
+			simple.facets |= FACET_MAX_LENGTH;
+			valid = parse_size(value, &simple.max_length);
+		} else if (is(builder, c, "whiteSpace")) {
+			value = trim(value);
+			simple.collapse = lptr_is(value, "collapse");
+			valid = simple.collapse
+				|| lptr_is(value, "preserve")
+				|| lptr_is(value, "replace");
+		} else {
+			valid = false;
+		}
+	}
+
+	if (valid && (simple.facets & NUMERIC_FACETS) && !numeric(schema, base))
+		valid = false;
+	if (valid && patterns)
+		valid = compile_patterns(builder, restriction, &simple);
+	if (!valid) {
+		free(simple.enumerations);
+		return false;
+	}
+
+	schema->types[type].simple = simple;
+	return true;
+}
+
+static bool compile_simple_type(struct builder *builder, size_t type, size_t node)
+{
+	struct descent_xml_schema *const schema = builder->schema;
+	const size_t child = first_child(builder, node);
+	if (child == NONE)
+		return false;
+
+	if (is(builder, child, "restriction"))
+		return compile_restriction(builder, type, child);
+
+	if (is(builder, child, "list")) {
+		struct libadt_const_lptr value;
+		size_t item = NONE;
+		if (attribute(builder, child, "itemType", &value)) {
+			item = resolve_type(builder, value);
+		} else {
+			const size_t inline_type = first_child(builder, child);
+			if (inline_type != NONE && is(builder, inline_type, "simpleType"))
+				item = compile_anonymous(builder, inline_type);
+		}
+		if (item == NONE || schema->types[item].complex)
+			return false;
+
+		schema->types[type].simple = (struct simple_type) {
+			.base = NONE,
+			.builtin = BUILTIN_LIST,
+			.item = item,
+			.collapse = true,
+		};
+		return true;
+	}
+
+	return false;
+}
+
+static int compare_attribute_uses(const void *left_p, const void *right_p)
+{
+	const uint32_t left = ((const struct attribute_use *)left_p)->name;
+	const uint32_t right = ((const struct attribute_use *)right_p)->name;
+	return (left > right) - (left < right);
+}
+
+static bool add_attribute_use(
+	struct builder *builder,
+	struct complex_type *complex,
+	size_t *capacity,
+	size_t node
+)
+{
+	struct descent_xml_schema *const schema = builder->schema;
+	struct libadt_const_lptr value;
+	if (!attribute(builder, node, "name", &value))
+		return false;
+
+	const int64_t name = _descent_xml_symbols_intern(&schema->names, trim(value));
+	if (name < 0)
+		return false;
+
+	struct attribute_use use = { .name = (uint32_t)name };
+	if (attribute(builder, node, "type", &value)) {
+		use.type = resolve_type(builder, value);
+	} else {
+		const size_t inline_type = first_child(builder, node);
+		use.type = inline_type != NONE && is(builder, inline_type, "simpleType")
+			? compile_anonymous(builder, inline_type)
+			: builder->builtin_types[0];
+	}
+	if (use.type == NONE || schema->types[use.type].complex)
+		return false;
+
+	if (attribute(builder, node, "use", &value)) {
+		value = trim(value);
+		// prohibited attributes are left out, and so rejected
+		if (lptr_is(value, "prohibited"))
+			return true;
+		use.required = lptr_is(value, "required");
+		if (!use.required && !lptr_is(value, "optional"))
+			return false;
+	}
+	if (attribute(builder, node, "fixed", &value)) {
+		use.fixed = true;
+		use.value = value;
+	}
+
+	for (size_t i = 0; i < complex->attribute_count; i++)
+		if (complex->attributes[i].name == use.name)
+			return false;
+
+	if (!grow(
+		(void **)&complex->attributes,
+		capacity,
+		complex->attribute_count,
+		sizeof(*complex->attributes)
+	))
+		return false;
+	complex->attributes[complex->attribute_count++] = use;
+	if (use.required)
+		complex->required_attributes++;
+	return true;
+}
+
+static bool read_occurs(
+	const struct builder *builder,
+	size_t node,
+	size_t *min,
+	size_t *max
+)
+{
+	struct libadt_const_lptr value;
+	*min = *max = 1;
+	if (attribute(builder, node, "minOccurs", &value) && !parse_size(value, min))
+		return false;
+	if (attribute(builder, node, "maxOccurs", &value)) {
+		if (lptr_is(trim(value), "unbounded"))
+			*max = UNBOUNDED;
+		else if (!parse_size(value, max))
+			return false;
+	}
+	return *max == UNBOUNDED || *min <= *max;
+}
+
+static size_t element_type(struct builder *builder, size_t node)
+{
+	struct libadt_const_lptr value;
+	if (attribute(builder, node, "type", &value))
+		return resolve_type(builder, value);
+
+	const size_t child = first_child(builder, node);
+	if (
+		child != NONE
+		&& (is(builder, child, "complexType") || is(builder, child, "simpleType"))
+	) {
+		if (builder->nesting >= MAX_NESTING)
+			return NONE;
+		builder->nesting++;
+		const size_t type = compile_anonymous(builder, child);
+		builder->nesting--;
+		return type;
+	}
+	return builder->schema->any_type;
+}
+
+// the declaration a local element or reference stands for
+static size_t declaration(struct builder *builder, size_t node)
+{
+	struct descent_xml_schema *const schema = builder->schema;
+	if (builder->declarations[node] != NONE)
+		return builder->declarations[node];
+
+	struct libadt_const_lptr value;
+	size_t result = NONE;
+	if (attribute(builder, node, "ref", &value)) {
+		const int64_t global
+			= _descent_xml_symbols_find(&schema->globals, local_name(trim(value)));
+		if (global >= 0)
+			result = schema->global_elements[global];
+	} else if (attribute(builder, node, "name", &value)) {
+		const int64_t name = _descent_xml_symbols_intern(&schema->names, trim(value));
+		if (name < 0)
+			return NONE;
+		result = add_element(schema, (struct element_declaration) {
+			.name = (uint32_t)name,
+			.type = NONE,
+			.node = node,
+		});
+		// set before compiling the type, so recursive content
+		// models find it
+		if (result != NONE)
+			builder->declarations[node] = result;
+		const size_t type = result != NONE ? element_type(builder, node) : NONE;
+		if (type == NONE)
+			return NONE;
+		schema->elements[result].type = type;
+	}
+
+	builder->declarations[node] = result;
+	return result;
+}
+
+static size_t build_particle(
+	struct builder *builder,
+	struct _descent_xml_automaton_tree *tree,
+	size_t node
+);
+
+static size_t build_term(
+	struct builder *builder,
+	struct _descent_xml_automaton_tree *tree,
+	size_t node
+)
+{
+	struct descent_xml_schema *const schema = builder->schema;
+
+	if (is(builder, node, "element")) {
+		const size_t element = declaration(builder, node);
+		if (element == NONE)
+			return NONE;
+		return _descent_xml_automaton_add(
+			tree,
+			_DESCENT_XML_AUTOMATON_NAME,
+			schema->elements[element].name,
+			(uint32_t)element
+		);
+	}
+
+	enum _descent_xml_automaton_node_kind kind;
+	if (is(builder, node, "sequence"))
+		kind = _DESCENT_XML_AUTOMATON_SEQUENCE;
+	else if (is(builder, node, "choice"))
+		kind = _DESCENT_XML_AUTOMATON_CHOICE;
+	else
+		return NONE;
+
+	const size_t group = _descent_xml_automaton_add(tree, kind, 0, 0);
+	if (group == NONE)
+		return NONE;
+	for (size_t c = first_child(builder, node); c != NONE; c = next_child(builder, c)) {
+		const size_t particle = build_particle(builder, tree, c);
+		if (particle == NONE)
+			return NONE;
+		_descent_xml_automaton_append(tree, group, particle);
+	}
+
+	// an empty choice matches nothing, which we can't express
+	if (kind == _DESCENT_XML_AUTOMATON_CHOICE && tree->nodes[group].child == NONE)
+		return NONE;
+	return group;
+}
+
+// minOccurs and maxOccurs are expanded into copies of the term,
+// the optional ones as a ? and an unbounded tail as a *
+static size_t build_particle(
+	struct builder *builder,
+	struct _descent_xml_automaton_tree *tree,
+	size_t node
+)
+{
+	size_t min, max;
+	if (!read_occurs(builder, node, &min, &max))
+		return NONE;
+
+	const size_t sequence = _descent_xml_automaton_add(
+		tree,
+		_DESCENT_XML_AUTOMATON_SEQUENCE,
+		0,
+		0
+	);
+	if (sequence == NONE)
+		return NONE;
+
+	const size_t copies = max == UNBOUNDED ? min + 1 : max;
+	if (copies > MAX_POSITIONS)
+		return NONE;
+	for (size_t i = 0; i < copies; i++) {
+		const size_t term = build_term(builder, tree, node);
+		if (term == NONE || tree->positions > MAX_POSITIONS)
+			return NONE;
+		if (i >= min)
+			tree->nodes[term].repeat = max == UNBOUNDED ? '*' : '?';
+		_descent_xml_automaton_append(tree, sequence, term);
+	}
+	return sequence;
+}
+
+static bool compile_all(
+	struct builder *builder,
+	struct complex_type *complex,
+	size_t node
+)
+{
+	struct descent_xml_schema *const schema = builder->schema;
+	size_t min, max;
+	if (!read_occurs(builder, node, &min, &max) || max != 1)
+		return false;
+
+	complex->content = COMPLEX_ALL;
+	complex->members_optional = min == 0;
+	size_t capacity = 0;
+	for (size_t c = first_child(builder, node); c != NONE; c = next_child(builder, c)) {
+		if (!is(builder, c, "element") || complex->member_count == 64)
+			return false;
+		if (!read_occurs(builder, c, &min, &max) || max != 1)
+			return false;
+
+		const size_t element = declaration(builder, c);
+		if (element == NONE)
+			return false;
+		const uint32_t name = schema->elements[element].name;
+		for (size_t i = 0; i < complex->member_count; i++)
+			if (complex->members[i].name == name)
+				return false;
+
+		if (!grow(
+			(void **)&complex->members,
+			&capacity,
+			complex->member_count,
+			sizeof(*complex->members)
+		))
+			return false;
+		if (min == 1)
+			complex->required_members |= 1ull << complex->member_count;
+		complex->members[complex->member_count++] = (struct all_member) {
+			.name = name,
+			.element = element,
+		};
+	}
+	return true;
+}
+
+static bool compile_simple_content(
+	struct builder *builder,
+	struct complex_type *complex,
+	size_t *attribute_capacity,
+	size_t node
+)
+{
+	struct descent_xml_schema *const schema = builder->schema;
+	const size_t derivation = first_child(builder, node);
+	if (derivation == NONE)
+		return false;
+
+	complex->content = COMPLEX_SIMPLE;
+	size_t c = first_child(builder, derivation);
+	if (is(builder, derivation, "extension")) {
+		struct libadt_const_lptr value;
+		if (!attribute(builder, derivation, "base", &value))
+			return false;
+		complex->simple = resolve_type(builder, value);
+	} else if (is(builder, derivation, "restriction")) {
+		// the facets are compiled as an anonymous simple type
+		const size_t type = add_type(schema, (struct type) {
+			.state = TYPE_DONE,
+			.node = derivation,
+		});
+		if (type == NONE || !compile_restriction(builder, type, derivation))
+			return false;
+		complex->simple = type;
+		while (c != NONE && !is(builder, c, "attribute") && !is(builder, c, "anyAttribute"))
+			c = next_child(builder, c);
+	} else {
+		return false;
+	}
+	if (complex->simple == NONE || schema->types[complex->simple].complex)
+		return false;
+
+	for (; c != NONE; c = next_child(builder, c)) {
+		if (is(builder, c, "anyAttribute"))
+			complex->any_attribute = true;
+		else if (!is(builder, c, "attribute"))
+			return false;
+		else if (!add_attribute_use(builder, complex, attribute_capacity, c))
+			return false;
+	}
+	return true;
+}
+
+static bool compile_complex_type(struct builder *builder, size_t type, size_t node)
+{
+	struct descent_xml_schema *const schema = builder->schema;
+	struct complex_type complex = { .content = COMPLEX_ELEMENTS };
+	size_t attribute_capacity = 0;
+	bool valid = true;
+
+	struct libadt_const_lptr value;
+	if (attribute(builder, node, "mixed", &value))
+		complex.mixed = lptr_is(trim(value), "true") || lptr_is(trim(value), "1");
+
+	struct _descent_xml_automaton_tree tree = { 0 };
+	size_t root = NONE;
+	bool content = false;
+	for (size_t c = first_child(builder, node); c != NONE && valid; c = next_child(builder, c)) {
+		if (is(builder, c, "sequence") || is(builder, c, "choice")) {
+			valid = !content;
+			content = true;
+			if (valid)
+				root = build_particle(builder, &tree, c);
+			valid = valid && root != NONE;
+		} else if (is(builder, c, "all")) {
+			valid = !content && compile_all(builder, &complex, c);
+			content = true;
+		} else if (is(builder, c, "simpleContent")) {
+			valid = !content && compile_simple_content(
+				builder,
+				&complex,
+				&attribute_capacity,
+				c
+			);
+			content = true;
+		} else if (is(builder, c, "attribute")) {
+			valid = add_attribute_use(builder, &complex, &attribute_capacity, c);
+		} else if (is(builder, c, "anyAttribute")) {
+			complex.any_attribute = true;
+		} else {
+			valid = false;
+		}
+	}
+
+	if (valid && complex.content == COMPLEX_ELEMENTS) {
+		// no particle at all means empty content
+		if (root == NONE)
+			root = _descent_xml_automaton_add(
+				&tree,
+				_DESCENT_XML_AUTOMATON_SEQUENCE,
+				0,
+				0
+			);
+		valid = root != NONE
+			&& _descent_xml_automaton_compile(&complex.model, &tree, root);
+	}
+	free(tree.nodes);
+
+	if (valid && complex.attributes)
+		qsort(
+			complex.attributes,
+			complex.attribute_count,
+			sizeof(*complex.attributes),
+			compare_attribute_uses
+		);
+
+	// stored even on failure, so it's freed with the schema
+	schema->types[type].complex_type = complex;
+	return valid;
+}
+
+static bool compile_type(struct builder *builder, size_t type)
+{
+	struct descent_xml_schema *const schema = builder->schema;
+	switch (schema->types[type].state) {
+		case TYPE_DONE:
+			return true;
+		case TYPE_COMPILING:
+			// complex types can be recursive through their
+			// elements, which only need the type's index; a
+			// simple type derived from itself is an error
+			return schema->types[type].complex;
+		case TYPE_PENDING:
+			break;
+	}
+
+	schema->types[type].state = TYPE_COMPILING;
+	const size_t node = schema->types[type].node;
+	const bool valid = schema->types[type].complex
+		? compile_complex_type(builder, type, node)
+		: compile_simple_type(builder, type, node);
+	schema->types[type].state = TYPE_DONE;
+	return valid;
+}
+
+static bool compile_schema(struct builder *builder)
+{
+	struct descent_xml_schema *const schema = builder->schema;
+	const size_t root = 0;
+	if (!is(builder, root, "schema"))
+		return false;
+
+	builder->declarations = malloc(builder->node_count * sizeof(size_t));
+	builder->named_types = malloc(builder->node_count * sizeof(size_t));
+	schema->global_elements = malloc(builder->node_count * sizeof(size_t));
+	if (!builder->declarations || !builder->named_types || !schema->global_elements)
+		return false;
+	for (size_t i = 0; i < builder->node_count; i++)
+		builder->declarations[i] = NONE;
+
+	if (!add_builtins(builder))
+		return false;
+
+	// declare every global first, so they can refer to each other
+	// in any order
+	for (size_t c = first_child(builder, root); c != NONE; c = next_child(builder, c)) {
+		struct libadt_const_lptr name;
+		if (!attribute(builder, c, "name", &name))
+			return false;
+		name = trim(name);
+
+		if (is(builder, c, "complexType") || is(builder, c, "simpleType")) {
+			if (_descent_xml_symbols_find(&builder->type_names, name) >= 0)
+				return false;
+			const int64_t id = _descent_xml_symbols_intern(&builder->type_names, name);
+			const size_t type = add_type(schema, (struct type) {
+				.complex = is(builder, c, "complexType"),
+				.state = TYPE_PENDING,
+				.node = c,
+			});
+			if (id < 0 || type == NONE)
+				return false;
+			builder->named_types[id] = type;
+		} else if (is(builder, c, "element")) {
+			if (_descent_xml_symbols_find(&schema->globals, name) >= 0)
+				return false;
+			const int64_t id = _descent_xml_symbols_intern(&schema->globals, name);
+			const int64_t symbol = _descent_xml_symbols_intern(&schema->names, name);
+			const size_t element = add_element(schema, (struct element_declaration) {
+				.name = (uint32_t)symbol,
+				.type = NONE,
+				.node = c,
+			});
+			if (id < 0 || symbol < 0 || element == NONE)
+				return false;
+			schema->global_elements[id] = element;
+			builder->declarations[c] = element;
+		} else {
+			return false;
+		}
+	}
+
+	for (size_t i = 0; i < builder->type_names.length; i++)
+		if (!compile_type(builder, builder->named_types[i]))
+			return false;
+
+	for (size_t i = 0; i < schema->globals.length; i++) {
+		struct element_declaration *const element
+			= &schema->elements[schema->global_elements[i]];
+		const size_t type = element_type(builder, element->node);
+		if (type == NONE)
+			return false;
+		schema->elements[schema->global_elements[i]].type = type;
+	}
+
+	// a simple type derived from itself would never finish
+	for (size_t i = 0; i < schema->type_count; i++) {
+		size_t type = i, steps = 0;
+		while (!schema->types[type].complex && schema->types[type].simple.base != NONE) {
+			type = schema->types[type].simple.base;
+			if (++steps > schema->type_count)
+				return false;
+		}
+	}
+	return true;
+}
+
+struct descent_xml_schema *descent_xml_schema_compile(struct libadt_const_lptr xsd)
+{
+	struct descent_xml_schema *const schema = calloc(1, sizeof(*schema));
+	if (!schema)
+		return NULL;
+
+	const size_t length = xsd.length > 0 ? (size_t)xsd.length : 0;
+	schema->text = malloc(length + 1);
+	if (!schema->text) {
+		free(schema);
+		return NULL;
+	}
+	if (length)
+		memcpy(schema->text, xsd.buffer, length);
+
+	struct builder builder = { .schema = schema };
+	const bool valid = build_tree(&builder, span(schema->text, schema->text + length))
+		&& compile_schema(&builder);
+
+	free(builder.nodes);
+	free(builder.attributes);
+	free(builder.stack);
+	free(builder.named_types);
+	free(builder.builtin_types);
+	free(builder.declarations);
+	_descent_xml_symbols_free(&builder.type_names);
+	_descent_xml_symbols_free(&builder.builtin_names);
+
+	if (!valid) {
+		descent_xml_schema_free(schema);
+		return NULL;
+	}
+	return schema;
+}
+
+struct descent_xml_schema *descent_xml_schema_load(const char *path)
+{
+	const int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return NULL;
+
+	struct libadt_lptr xsd = descent_xml_read_fd(fd, NULL);
+	const int error = errno;
+	close(fd);
+	if (!xsd.buffer) {
+		errno = error;
+		return NULL;
+	}
+
+	struct descent_xml_schema *const schema = descent_xml_schema_compile(
+		(struct libadt_const_lptr) {
+			.buffer = xsd.buffer,
+			.size = 1,
+			.length = xsd.length,
+		}
+	);
+	free(xsd.buffer);
+	return schema;
+}
+
+void descent_xml_schema_free(struct descent_xml_schema *schema)
+{
+	if (!schema)
+		return;
+
+	for (size_t i = 0; i < schema->type_count; i++) {
+		struct type *const type = &schema->types[i];
+		if (type->complex) {
+			_descent_xml_automaton_free(&type->complex_type.model);
+			free(type->complex_type.members);
+			free(type->complex_type.attributes);
+		} else {
+			if (type->simple.facets & FACET_PATTERN)
+				regfree(&type->simple.pattern);
+			free(type->simple.enumerations);
+		}
+	}
+	free(schema->types);
+	free(schema->elements);
+	free(schema->global_elements);
+	_descent_xml_symbols_free(&schema->names);
+	_descent_xml_symbols_free(&schema->globals);
+	free(schema->text);
+	free(schema);
+}
+
+static bool text_reserve(struct descent_xml_schema_validator *validator, size_t more)
+{
+	if (validator->text_length + more + 1 <= validator->text_capacity)
+		return true;
+	size_t capacity = validator->text_capacity ? validator->text_capacity : 256;
+	while (capacity < validator->text_length + more + 1)
+		capacity *= 2;
+	char *const text = descent_xml_reallocate(
+		validator->allocator,
+		validator->text,
+		validator->text_capacity,
+		capacity
+	);
+	if (!text)
+		return false;
+	validator->text = text;
+	validator->text_capacity = capacity;
+	return true;
+}
+
+static size_t encode_utf8(unsigned long code, char *out)
+{
+	if (code < 0x80) {
+		out[0] = (char)code;
+		return 1;
+	}
+	if (code < 0x800) {
+		out[0] = (char)(0xc0 | code >> 6);
+		out[1] = (char)(0x80 | (code & 0x3f));
+		return 2;
+	}
+	if (code < 0x10000) {
+		out[0] = (char)(0xe0 | code >> 12);
+		out[1] = (char)(0x80 | (code >> 6 & 0x3f));
+		out[2] = (char)(0x80 | (code & 0x3f));
+		return 3;
+	}
+	out[0] = (char)(0xf0 | code >> 18);
+	out[1] = (char)(0x80 | (code >> 12 & 0x3f));
+	out[2] = (char)(0x80 | (code >> 6 & 0x3f));
+	out[3] = (char)(0x80 | (code & 0x3f));
+	return 4;
+}
+
+// appends text to the validator's buffer, replacing the predefined
+// entities and character references; anything else is invalid, as
+// schemas don't declare entities
+static bool append_text(
+	struct descent_xml_schema_validator *validator,
+	struct libadt_const_lptr text,
+	bool raw
+)
+{
+	if (text.length <= 0)
+		return true;
+	if (!text_reserve(validator, (size_t)text.length))
+		return false;
+
+	const char *at = text.buffer;
+	const char *const end = at + text.length;
+	char *out = validator->text + validator->text_length;
+	if (raw) {
+		memcpy(out, at, (size_t)text.length);
+		validator->text_length += (size_t)text.length;
+		return true;
+	}
+
+	static const struct {
+		const char *name;
+		char value;
+	} predefined[] = {
+		{ "lt", '<' },
+		{ "gt", '>' },
+		{ "amp", '&' },
+		{ "apos", '\'' },
+		{ "quot", '"' },
+	};
+
+	while (at < end) {
+		if (*at != '&') {
+			*out++ = *at++;
+			continue;
+		}
+
+		const char *const semicolon = memchr(at, ';', (size_t)(end - at));
+		if (!semicolon)
+			return false;
+		const struct libadt_const_lptr name = span(at + 1, semicolon);
+		at = semicolon + 1;
+
+		if (name.length > 1 && *(const char *)name.buffer == '#') {
+			// a reference is never shorter than its encoding
+			const char *digits = (const char *)name.buffer + 1;
+			int base = 10;
+			if (*digits == 'x') {
+				base = 16;
+				digits++;
+			}
+			char *digits_end;
+			const unsigned long code = strtoul(digits, &digits_end, base);
+			if (digits_end != semicolon || code == 0 || code > 0x10ffff)
+				return false;
+			out += encode_utf8(code, out);
+			continue;
+		}
+
+		bool known = false;
+		for (size_t i = 0; i < sizeof(predefined) / sizeof(predefined[0]); i++) {
+			if (lptr_is(name, predefined[i].name)) {
+				*out++ = predefined[i].value;
+				known = true;
+				break;
+			}
+		}
+		if (!known)
+			return false;
+	}
+
+	validator->text_length = (size_t)(out - validator->text);
+	return true;
+}
+
+// collapses whitespace in place, returning the new length
+static size_t collapse(char *value, size_t length)
+{
+	size_t out = 0;
+	bool space = false;
+	for (size_t i = 0; i < length; i++) {
+		if (is_space(value[i])) {
+			space = out > 0;
+			continue;
+		}
+		if (space)
+			value[out++] = ' ';
+		space = false;
+		value[out++] = value[i];
+	}
+	return out;
+}
+
+static bool all_digits(const char *at, const char *end)
+{
+	if (at == end)
+		return false;
+	for (; at < end; at++)
+		if (*at < '0' || *at > '9')
+			return false;
+	return true;
+}
+
+static bool check_decimal(const char *value, bool integer)
+{
+	const char *at = value;
+	if (*at == '+' || *at == '-')
+		at++;
+	const char *const digits = at;
+	while (*at >= '0' && *at <= '9')
+		at++;
+	bool any = at != digits;
+	if (*at == '.' && !integer) {
+		const char *const fraction = ++at;
+		while (*at >= '0' && *at <= '9')
+			at++;
+		any |= at != fraction;
+	}
+	return any && *at == '\0';
+}
+
+static bool check_float(const char *value)
+{
+	if (
+		strcmp(value, "INF") == 0
+		|| strcmp(value, "-INF") == 0
+		|| strcmp(value, "+INF") == 0
+		|| strcmp(value, "NaN") == 0
+	)
+		return true;
+
+	const char *const exponent = strpbrk(value, "eE");
+	if (!exponent)
+		return check_decimal(value, false);
+
+	char mantissa[64];
+	const size_t length = (size_t)(exponent - value);
+	if (length >= sizeof(mantissa))
+		return false;
+	memcpy(mantissa, value, length);
+	mantissa[length] = '\0';
+	return check_decimal(mantissa, false) && check_decimal(exponent + 1, true);
+}
+
+static bool two_digits(const char *at, int *result)
+{
+	if (!all_digits(at, at + 2))
+		return false;
+	*result = (at[0] - '0') * 10 + (at[1] - '0');
+	return true;
+}
+
+static bool check_timezone(const char *at)
+{
+	if (*at == '\0')
+		return true;
+	if (at[0] == 'Z')
+		return at[1] == '\0';
+	int hours, minutes;
+	return (at[0] == '+' || at[0] == '-')
+		&& two_digits(at + 1, &hours)
+		&& at[3] == ':'
+		&& two_digits(at + 4, &minutes)
+		&& at[6] == '\0'
+		&& hours <= 14
+		&& minutes <= 59;
+}
+
+// checks a date, returning where it ends
+static const char *check_date(const char *at)
+{
+	if (*at == '-')
+		at++;
+	const char *const year = at;
+	while (*at >= '0' && *at <= '9')
+		at++;
+	if (at - year < 4 || *at != '-')
+		return NULL;
+
+	long year_value = strtol(year, NULL, 10);
+	int month, day;
+	if (!two_digits(at + 1, &month) || at[3] != '-' || !two_digits(at + 4, &day))
+		return NULL;
+
+	static const int days[] = { 31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+	if (month < 1 || month > 12 || day < 1 || day > days[month - 1])
+		return NULL;
+	const bool leap = (year_value % 4 == 0 && year_value % 100 != 0) || year_value % 400 == 0;
+	if (month == 2 && day == 29 && !leap)
+		return NULL;
+	return at + 6;
+}
+
+static const char *check_time(const char *at)
+{
+	int hours, minutes, seconds;
+	if (
+		!two_digits(at, &hours)
+		|| at[2] != ':'
+		|| !two_digits(at + 3, &minutes)
+		|| at[5] != ':'
+		|| !two_digits(at + 6, &seconds)
+	)
+		return NULL;
+	if (hours > 24 || minutes > 59 || seconds > 59)
+		return NULL;
+	at += 8;
+	if (*at == '.') {
+		const char *const fraction = ++at;
+		while (*at >= '0' && *at <= '9')
+			at++;
+		if (at == fraction)
+			return NULL;
+	}
+	return at;
+}
+
+static bool check_name(const char *value, bool colons, bool first)
+{
+	if (*value == '\0')
+		return false;
+	for (const char *at = value; *at; at++) {
+		const unsigned char c = (unsigned char)*at;
+		const bool start = (c >= 'a' && c <= 'z')
+			|| (c >= 'A' && c <= 'Z')
+			|| c == '_'
+			|| c >= 0x80
+			|| (c == ':' && colons);
+		const bool rest = (c >= '0' && c <= '9') || c == '-' || c == '.';
+		if (!start && !(rest && !(first && at == value)))
+			return false;
+	}
+	return true;
+}
+
+static bool check_builtin(enum builtin builtin, const char *value)
+{
+	const char *end;
+	switch (builtin) {
+		case BUILTIN_STRING:
+			return true;
+		case BUILTIN_NAME:
+			return check_name(value, true, true);
+		case BUILTIN_NCNAME:
+			return check_name(value, false, true);
+		case BUILTIN_NMTOKEN:
+			return check_name(value, true, false);
+		case BUILTIN_BOOLEAN:
+			return strcmp(value, "true") == 0
+				|| strcmp(value, "false") == 0
+				|| strcmp(value, "1") == 0
+				|| strcmp(value, "0") == 0;
+		case BUILTIN_DECIMAL:
+			return check_decimal(value, false);
+		case BUILTIN_INTEGER:
+			return check_decimal(value, true);
+		case BUILTIN_FLOAT:
+			return check_float(value);
+		case BUILTIN_DATE:
+			end = check_date(value);
+			return end && check_timezone(end);
+		case BUILTIN_TIME:
+			end = check_time(value);
+			return end && check_timezone(end);
+		case BUILTIN_DATE_TIME:
+			end = check_date(value);
+			if (!end || *end != 'T')
+				return false;
+			end = check_time(end + 1);
+			return end && check_timezone(end);
+		case BUILTIN_LIST:
+			break;
+	}
+	return false;
+}
+
+static size_t characters(const char *value, size_t length)
+{
+	size_t count = 0;
+	for (size_t i = 0; i < length; i++)
+		count += ((unsigned char)value[i] & 0xc0) != 0x80;
+	return count;
+}
+
+static bool check_simple(
+	const struct descent_xml_schema *schema,
+	size_t type,
+	char *value,
+	size_t length
+);
+
+static bool check_list(
+	const struct descent_xml_schema *schema,
+	size_t item,
+	char *value,
+	size_t length,
+	size_t *count
+)
+{
+	*count = 0;
+	size_t start = 0;
+	while (start < length) {
+		size_t end = start;
+		while (end < length && value[end] != ' ')
+			end++;
+
+		// check_simple wants a terminated string
+		const char saved = value[end];
+		value[end] = '\0';
+		const bool valid = check_simple(schema, item, value + start, end - start);
+		value[end] = saved;
+		if (!valid)
+			return false;
+
+		++*count;
+		start = end + 1;
+	}
+	return true;
+}
+
+// value is terminated and has already had its whitespace handled
+static bool check_facets(
+	const struct descent_xml_schema *schema,
+	const struct simple_type *simple,
+	char *value,
+	size_t length
+)
+{
+	size_t count = 0;
+	if (simple->builtin == BUILTIN_LIST && simple->base == NONE) {
+		if (!check_list(schema, simple->item, value, length, &count))
+			return false;
+	} else if (simple->base == NONE && !check_builtin(simple->builtin, value)) {
+		return false;
+	} else {
+		count = characters(value, length);
+	}
+
+	if (simple->facets & NUMERIC_FACETS) {
+		const long double number = strtold(value, NULL);
+		if (isnan(number))
+			return false;
+		if ((simple->facets & FACET_MIN_INCLUSIVE) && number < simple->min)
+			return false;
+		if ((simple->facets & FACET_MIN_EXCLUSIVE) && number <= simple->min)
+			return false;
+		if ((simple->facets & FACET_MAX_INCLUSIVE) && number > simple->max)
+			return false;
+		if ((simple->facets & FACET_MAX_EXCLUSIVE) && number >= simple->max)
+			return false;
+	}
+
+	if ((simple->facets & FACET_LENGTH) && count != simple->length)
+		return false;
+	if ((simple->facets & FACET_MIN_LENGTH) && count < simple->min_length)
+		return false;
+	if ((simple->facets & FACET_MAX_LENGTH) && count > simple->max_length)
+		return false;
+
+	if (
+		(simple->facets & FACET_PATTERN)
+		&& regexec(&simple->pattern, value, 0, NULL, 0) != 0
+	)
+		return false;
+
+	if (simple->enumeration_count) {
+		const struct libadt_const_lptr string = span(value, value + length);
+		for (size_t i = 0; i < simple->enumeration_count; i++) {
+			const struct libadt_const_lptr option = simple->collapse
+				? trim(simple->enumerations[i])
+				: simple->enumerations[i];
+			if (libadt_const_lptr_equal(string, option))
+				return true;
+		}
+		return false;
+	}
+	return true;
+}
+
+static bool check_simple(
+	const struct descent_xml_schema *schema,
+	size_t type,
+	char *value,
+	size_t length
+)
+{
+	const struct simple_type *simple = &schema->types[type].simple;
+	if (simple->collapse) {
+		length = collapse(value, length);
+		value[length] = '\0';
+	}
+
+	// a list's base is its item type, so counts come from there;
+	// lengths of derived list types count items too
+	size_t list = type;
+	while (schema->types[list].simple.base != NONE)
+		list = schema->types[list].simple.base;
+	if (schema->types[list].simple.builtin == BUILTIN_LIST && list != type) {
+		size_t count;
+		if (!check_list(schema, schema->types[list].simple.item, value, length, &count))
+			return false;
+		for (size_t t = type; t != list; t = schema->types[t].simple.base) {
+			struct simple_type facets = schema->types[t].simple;
+			// only the length and enumeration facets make
+			// sense for the list as a whole
+			if ((facets.facets & FACET_LENGTH) && count != facets.length)
+				return false;
+			if ((facets.facets & FACET_MIN_LENGTH) && count < facets.min_length)
+				return false;
+			if ((facets.facets & FACET_MAX_LENGTH) && count > facets.max_length)
+				return false;
+			if ((facets.facets & FACET_PATTERN)
+				&& regexec(&facets.pattern, value, 0, NULL, 0) != 0)
+				return false;
+		}
+		return true;
+	}
+
+	for (size_t t = type; t != NONE; t = schema->types[t].simple.base)
+		if (!check_facets(schema, &schema->types[t].simple, value, length))
+			return false;
+	return true;
+}
+
+// checks a value held in the validator's buffer from start on, and
+// drops it from the buffer afterwards
+static bool check_buffered(
+	struct descent_xml_schema_validator *validator,
+	size_t type,
+	size_t start
+)
+{
+	if (!text_reserve(validator, 0))
+		return false;
+	validator->text[validator->text_length] = '\0';
+	const bool valid = check_simple(
+		validator->schema,
+		type,
+		validator->text + start,
+		validator->text_length - start
+	);
+	validator->text_length = start;
+	return valid;
+}
+
+static bool ignored_attribute(struct libadt_const_lptr name)
+{
+	const struct libadt_const_lptr
+		xmlns = libadt_str_literal("xmlns"),
+		xmlns_prefix = libadt_str_literal("xmlns:"),
+		xml = libadt_str_literal("xml:"),
+		xsi = libadt_str_literal("xsi:");
+	return libadt_const_lptr_equal(name, xmlns)
+		|| _descent_xml_lex_startswith(name, xmlns_prefix)
+		|| _descent_xml_lex_startswith(name, xml)
+		|| _descent_xml_lex_startswith(name, xsi);
+}
+
+static const struct attribute_use *lookup_attribute(
+	const struct complex_type *complex,
+	int64_t name
+)
+{
+	if (name < 0)
+		return NULL;
+	size_t low = 0, high = complex->attribute_count;
+	while (low < high) {
+		const size_t middle = low + (high - low) / 2;
+		const uint32_t found = complex->attributes[middle].name;
+		if (found < (uint32_t)name)
+			low = middle + 1;
+		else if (found > (uint32_t)name)
+			high = middle;
+		else
+			return &complex->attributes[middle];
+	}
+	return NULL;
+}
+
+static bool check_attributes(
+	struct descent_xml_schema_validator *validator,
+	const struct type *type,
+	struct libadt_const_lptr attributes
+)
+{
+	const struct descent_xml_schema *const schema = validator->schema;
+	const struct libadt_const_lptr *const attrs = attributes.buffer;
+	size_t required = 0;
+
+	for (ssize_t i = 0; i + 1 < attributes.length; i += 2) {
+		if (ignored_attribute(attrs[i]))
+			continue;
+		if (!type->complex)
+			return false;
+
+		const struct complex_type *const complex = &type->complex_type;
+		const struct attribute_use *const use = lookup_attribute(
+			complex,
+			_descent_xml_symbols_find(&schema->names, local_name(attrs[i]))
+		);
+		if (!use) {
+			if (complex->any_attribute)
+				continue;
+			return false;
+		}
+
+		const size_t start = validator->text_length;
+		if (!append_text(validator, attrs[i + 1], false))
+			return false;
+		if (use->fixed) {
+			const struct libadt_const_lptr value = span(
+				validator->text + start,
+				validator->text + validator->text_length
+			);
+			if (!libadt_const_lptr_equal(trim(value), trim(use->value))) {
+				validator->text_length = start;
+				return false;
+			}
+		}
+		if (!check_buffered(validator, use->type, start))
+			return false;
+		required += use->required;
+	}
+
+	return !type->complex || required == type->complex_type.required_attributes;
+}
+
+// checks that an element has everything it needs, as it closes
+static bool complete(
+	struct descent_xml_schema_validator *validator,
+	const struct _descent_xml_schema_frame *frame
+)
+{
+	const struct type *const type = &validator->schema->types[frame->type];
+	if (!type->complex)
+		return check_buffered(validator, frame->type, frame->text);
+
+	const struct complex_type *const complex = &type->complex_type;
+	switch (complex->content) {
+		case COMPLEX_ELEMENTS:
+			return complex->model.accept[frame->state];
+		case COMPLEX_ALL:
+			return (frame->seen & complex->required_members) == complex->required_members
+				|| (frame->seen == 0 && complex->members_optional);
+		case COMPLEX_SIMPLE:
+			return check_buffered(validator, complex->simple, frame->text);
+		case COMPLEX_ANY:
+			return true;
+	}
+	return false;
+}
+
+// finds the declaration for a child element, advancing the parent
+static size_t child_declaration(
+	const struct descent_xml_schema *schema,
+	struct _descent_xml_schema_frame *parent,
+	struct libadt_const_lptr name
+)
+{
+	const struct type *const type = &schema->types[parent->type];
+	if (!type->complex)
+		return NONE;
+
+	const struct complex_type *const complex = &type->complex_type;
+	const int64_t symbol = _descent_xml_symbols_find(&schema->names, name);
+	switch (complex->content) {
+		case COMPLEX_ELEMENTS: {
+			if (symbol < 0)
+				return NONE;
+			const int32_t next = _descent_xml_automaton_step(
+				&complex->model,
+				parent->state,
+				(uint32_t)symbol
+			);
+			if (next < 0)
+				return NONE;
+			parent->state = next;
+			return complex->model.tags[next];
+		}
+		case COMPLEX_ALL:
+			for (size_t i = 0; i < complex->member_count; i++) {
+				if (complex->members[i].name != (uint32_t)symbol)
+					continue;
+				if (parent->seen & 1ull << i)
+					return NONE;
+				parent->seen |= 1ull << i;
+				return complex->members[i].element;
+			}
+			return NONE;
+		case COMPLEX_ANY: {
+			// lax: use the global declaration if there is one
+			const int64_t global = _descent_xml_symbols_find(&schema->globals, name);
+			return global >= 0 ? schema->global_elements[global] : SIZE_MAX - 1;
+		}
+		case COMPLEX_SIMPLE:
+			break;
+	}
+	return NONE;
+}
+
+bool descent_xml_schema_element(
+	struct descent_xml_schema_validator *validator,
+	struct libadt_const_lptr element_name,
+	struct libadt_const_lptr attributes,
+	bool empty
+)
+{
+	const struct descent_xml_schema *const schema = validator->schema;
+	const struct libadt_const_lptr name = local_name(element_name);
+
+	size_t element;
+	if (validator->depth == 0) {
+		const int64_t global = _descent_xml_symbols_find(&schema->globals, name);
+		element = global >= 0 ? schema->global_elements[global] : NONE;
+	} else {
+		element = child_declaration(
+			schema,
+			&validator->frames[validator->depth - 1],
+			name
+		);
+	}
+	if (element == NONE)
+		return false;
+
+	const size_t type = element == SIZE_MAX - 1
+		? schema->any_type
+		: schema->elements[element].type;
+	if (!check_attributes(validator, &schema->types[type], attributes))
+		return false;
+
+	const struct _descent_xml_schema_frame frame = {
+		.type = type,
+		.text = validator->text_length,
+	};
+	if (empty)
+		return complete(validator, &frame);
+
+	if (validator->depth == validator->capacity) {
+		const size_t capacity = validator->capacity
+			? validator->capacity * 2
+			: 16;
+		struct _descent_xml_schema_frame *const frames = descent_xml_reallocate(
+			validator->allocator,
+			validator->frames,
+			validator->capacity * sizeof(*frames),
+			capacity * sizeof(*frames)
+		);
+		if (!frames)
+			return false;
+		validator->frames = frames;
+		validator->capacity = capacity;
+	}
+	validator->frames[validator->depth++] = frame;
+	return true;
+}
+
+bool descent_xml_schema_text(
+	struct descent_xml_schema_validator *validator,
+	struct libadt_const_lptr text,
+	bool is_cdata
+)
+{
+	if (validator->depth == 0)
+		return true;
+
+	const struct _descent_xml_schema_frame *const frame
+		= &validator->frames[validator->depth - 1];
+	const struct type *const type = &validator->schema->types[frame->type];
+	if (!type->complex || type->complex_type.content == COMPLEX_SIMPLE)
+		return append_text(validator, text, is_cdata);
+
+	if (type->complex_type.mixed)
+		return true;
+	return !is_cdata && trim(text).length == 0;
+}
+
+bool descent_xml_schema_close(struct descent_xml_schema_validator *validator)
+{
+	if (validator->depth == 0)
+		return false;
+	const struct _descent_xml_schema_frame frame
+		= validator->frames[--validator->depth];
+	return complete(validator, &frame);
+}
+
+bool descent_xml_schema_validate_document(
+	const struct descent_xml_schema *schema,
+	struct descent_xml_lex token
+)
+{
+	struct descent_xml_schema_validator schema_validator
+		= descent_xml_schema_validator_init(schema);
+	struct descent_xml_validator validator = descent_xml_validator_init(1000);
+	validator.schema = &schema_validator;
+
+	for (;;) {
+		token = descent_xml_parse_validated(token, &validator, NULL, NULL, NULL);
+		if (
+			token.type == descent_xml_classifier_eof
+			|| token.type == descent_xml_classifier_unexpected
+			|| token.type == descent_xml_validate_error
+			|| token.type == descent_xml_parse_error
+		)
+			break;
+	}
+
+	descent_xml_validator_free(&validator);
+	descent_xml_schema_validator_free(&schema_validator);
+	return token.type == descent_xml_classifier_eof;
+}
@@ -0,0 +1,46 @@
+#include "descent-xml/stats.h"
+
+#include "descent-xml/token.h"
+
+#include <string.h>
+
+_Thread_local struct descent_xml_stats _descent_xml_stats;
+
+// slots are token ids, with slot zero for unknown types
+_Static_assert(
+	DESCENT_XML_TOKEN_COUNT <= DESCENT_XML_STATS_TYPES,
+	"DESCENT_XML_STATS_TYPES is too small for every token type"
+);
+
+bool descent_xml_stats_enabled(void)
+{
+#ifdef DESCENT_XML_STATS
+	return true;
+#else
+	return false;
+#endif
+}
+
+struct descent_xml_stats descent_xml_stats_get(void)
+{
+	return _descent_xml_stats;
+}
+
+void descent_xml_stats_reset(void)
+{
+	memset(&_descent_xml_stats, 0, sizeof(_descent_xml_stats));
+}
+
+const char *descent_xml_stats_type_name(size_t slot)
+{
+	if (slot == DESCENT_XML_TOKEN_UNKNOWN)
+		return "other";
+	if (slot >= DESCENT_XML_TOKEN_COUNT)
+		return NULL;
+	return descent_xml_token_name((enum descent_xml_token_id)slot);
+}
+
+size_t descent_xml_stats_type_slot(descent_xml_classifier_fn *type)
+{
+	return descent_xml_token_id(type);
+}
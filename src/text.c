@@ -0,0 +1,543 @@
+#include "descent-xml/text.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+struct descent_xml_lex descent_xml_parse_coalesced(
+	struct descent_xml_lex xml,
+	struct descent_xml_text *text,
+	descent_xml_parse_element_fn *element_handler,
+	descent_xml_parse_text_fn *text_handler,
+	void *context
+);
+struct descent_xml_lex descent_xml_parse_chunked(
+	struct descent_xml_lex xml,
+	struct descent_xml_text *text,
+	descent_xml_parse_element_fn *element_handler,
+	descent_xml_text_chunk_fn *chunk_handler,
+	void *context
+);
+
+static bool reserve(struct descent_xml_text *text, size_t extra)
+{
+	struct libadt_vector *const buffer = &text->buffer;
+	if (buffer->capacity - buffer->length >= extra)
+		return true;
+
+	size_t capacity = buffer->capacity ? buffer->capacity : 64;
+	while (capacity - buffer->length < extra)
+		capacity *= 2;
+	void *const grown = descent_xml_reallocate(
+		text->allocator,
+		buffer->buffer,
+		buffer->capacity,
+		capacity
+	);
+	if (!grown)
+		return false;
+	buffer->buffer = grown;
+	buffer->capacity = capacity;
+	return true;
+}
+
+static size_t encode_utf8(unsigned long code, char *out)
+{
+	if (code < 0x80) {
+		out[0] = (char)code;
+		return 1;
+	}
+	if (code < 0x800) {
+		out[0] = (char)(0xc0 | code >> 6);
+		out[1] = (char)(0x80 | (code & 0x3f));
+		return 2;
+	}
+	if (code < 0x10000) {
+		out[0] = (char)(0xe0 | code >> 12);
+		out[1] = (char)(0x80 | (code >> 6 & 0x3f));
+		out[2] = (char)(0x80 | (code & 0x3f));
+		return 3;
+	}
+	out[0] = (char)(0xf0 | code >> 18);
+	out[1] = (char)(0x80 | (code >> 12 & 0x3f));
+	out[2] = (char)(0x80 | (code >> 6 & 0x3f));
+	out[3] = (char)(0x80 | (code & 0x3f));
+	return 4;
+}
+
+static int digit_value(char c, int base)
+{
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (base == 16 && c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	if (base == 16 && c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	return -1;
+}
+
+// The longest reference replaced, from '&' to ';'. That's room for
+// any character reference, with a few leading zeros, and no more, so
+// looking for the ';' never runs far past a chunk.
+#define REFERENCE_MAX 16
+
+// Writes the replacement for the reference between '&' and ';', and
+// returns its length, or zero if it isn't one to replace. A
+// replacement is never longer than the reference.
+static size_t decode_reference(const char *name, size_t length, char *out)
+{
+	if (length + 2 > REFERENCE_MAX)
+		return 0;
+
+	static const struct {
+		const char *name;
+		size_t length;
+		char value;
+	} predefined[] = {
+		{ "lt", 2, '<' },
+		{ "gt", 2, '>' },
+		{ "amp", 3, '&' },
+		{ "apos", 4, '\'' },
+		{ "quot", 4, '"' },
+	};
+	for (size_t i = 0; i < sizeof(predefined) / sizeof(predefined[0]); i++) {
+		if (
+			length == predefined[i].length
+			&& !memcmp(name, predefined[i].name, length)
+		) {
+			*out = predefined[i].value;
+			return 1;
+		}
+	}
+
+	if (length < 2 || name[0] != '#')
+		return 0;
+	size_t at = 1;
+	int base = 10;
+	if (name[at] == 'x') {
+		base = 16;
+		at++;
+	}
+	if (at == length)
+		return 0;
+	unsigned long code = 0;
+	for (; at < length; at++) {
+		const int digit = digit_value(name[at], base);
+		if (digit < 0)
+			return 0;
+		code = code * (unsigned long)base + (unsigned long)digit;
+		if (code > 0x10ffff)
+			return 0;
+	}
+	if (code == 0 || (code >= 0xd800 && code <= 0xdfff))
+		return 0;
+	return encode_utf8(code, out);
+}
+
+// Writes length bytes of text from at to out, replacing references,
+// and returns the number of bytes written, which is never more than
+// length.
+static size_t decode(const char *at, size_t length, char *out)
+{
+	const char *const end = at + length;
+	char *const start = out;
+	while (at < end) {
+		const char *const amp = memchr(at, '&', (size_t)(end - at));
+		const char *const copy_end = amp ? amp : end;
+		memcpy(out, at, (size_t)(copy_end - at));
+		out += copy_end - at;
+		at = copy_end;
+		if (!amp)
+			break;
+
+		const size_t reach = end - amp < REFERENCE_MAX
+			? (size_t)(end - amp)
+			: REFERENCE_MAX;
+		const char *const semicolon = memchr(amp, ';', reach);
+		const size_t written = semicolon
+			? decode_reference(amp + 1, (size_t)(semicolon - amp - 1), out)
+			: 0;
+		if (written) {
+			out += written;
+			at = semicolon + 1;
+		} else {
+			*out++ = *at++;
+		}
+	}
+	return (size_t)(out - start);
+}
+
+static bool append(
+	struct descent_xml_text *text,
+	struct libadt_const_lptr piece,
+	bool decoding
+)
+{
+	if (piece.length <= 0)
+		return true;
+	if (!reserve(text, (size_t)piece.length))
+		return false;
+
+	char *const out = (char *)text->buffer.buffer + text->buffer.length;
+	if (decoding) {
+		text->buffer.length += decode(piece.buffer, (size_t)piece.length, out);
+	} else {
+		memcpy(out, piece.buffer, (size_t)piece.length);
+		text->buffer.length += (size_t)piece.length;
+	}
+	return true;
+}
+
+static bool needs_decoding(struct libadt_const_lptr piece)
+{
+	return piece.length > 0 && memchr(piece.buffer, '&', (size_t)piece.length);
+}
+
+static bool is_section(struct descent_xml_lex token)
+{
+	return token.type == descent_xml_lex_cdata
+		|| token.type == descent_xml_lex_comment;
+}
+
+// Called for each piece of a node in turn: a run of text, or the
+// content of a CDATA section. blank is set for a run of text that's
+// only whitespace. Returning false stops the walk.
+typedef bool piece_fn(
+	struct libadt_const_lptr piece,
+	bool cdata,
+	bool blank,
+	void *context
+);
+
+// Walks the text node starting at token, skipping comments, and
+// returns its last token, or the token it stopped on.
+static struct descent_xml_lex each_piece(
+	struct descent_xml_lex token,
+	piece_fn *piece,
+	void *context
+)
+{
+	for (;;) {
+		if (token.type == descent_xml_lex_cdata) {
+			if (!piece(_descent_xml_cdata_value(token), true, false, context))
+				return token;
+		} else if (token.type != descent_xml_lex_comment) {
+			const _descent_xml_value_t run = _descent_xml_text_value(token);
+			// whitespace is lexed as one text_space token, which
+			// is the whole run if nothing else follows it
+			const bool blank
+				= token.type == descent_xml_classifier_text_space
+				&& run.token.value.buffer == token.value.buffer;
+			token = run.token;
+			if (!piece(run.value, false, blank, context))
+				return token;
+		}
+
+		// a section is lexed as '<', its body and '>'
+		if (is_section(token)) {
+			const struct descent_xml_lex end = descent_xml_lex_next_raw(token);
+			if (end.type != descent_xml_classifier_element_end)
+				break;
+			token = end;
+		}
+
+		// the node only goes on into a '<' if it opens another section;
+		// that's looked for in the bytes, so that a tag following the
+		// node isn't lexed twice
+		const struct libadt_const_lptr rest = _descent_xml_lex_remainder(token);
+		const char *const at = rest.buffer;
+		if (rest.length >= 2 && at[0] == '<' && at[1] == '!') {
+			struct descent_xml_lex next = descent_xml_lex_next_raw(token);
+			if (next.type != descent_xml_classifier_element)
+				break;
+			next = descent_xml_lex_next_raw(next);
+			if (!is_section(next))
+				break;
+			token = next;
+		} else if (rest.length > 0 && at[0] != '<') {
+			const struct descent_xml_lex next = descent_xml_lex_next_raw(token);
+			if (!_descent_xml_is_text_type(next))
+				break;
+			token = next;
+		} else {
+			break;
+		}
+	}
+	return token;
+}
+
+// Stops at the first piece that isn't blank.
+static bool find_content(
+	struct libadt_const_lptr piece,
+	bool cdata,
+	bool blank,
+	void *context
+)
+{
+	(void)piece;
+	const bool content = cdata || !blank;
+	*(bool *)context = content;
+	return !content;
+}
+
+void descent_xml_text_init(
+	struct descent_xml_text *text,
+	unsigned flags,
+	const struct descent_xml_allocator *allocator
+)
+{
+	*text = (struct descent_xml_text) {
+		.buffer = {
+			.element_size = 1,
+		},
+		.flags = flags,
+		.chunk_size = DESCENT_XML_TEXT_CHUNK_SIZE,
+		.allocator = allocator,
+	};
+}
+
+void descent_xml_text_free(struct descent_xml_text *text)
+{
+	descent_xml_release(
+		text->allocator,
+		text->buffer.buffer,
+		text->buffer.capacity
+	);
+	text->buffer.buffer = NULL;
+	text->buffer.length = text->buffer.capacity = 0;
+}
+
+struct gather {
+	struct descent_xml_text *text;
+	// the node so far, while it's a single piece left in the document
+	struct libadt_const_lptr first;
+	bool pieces;
+	bool copied;
+	bool all_cdata;
+	bool blank;
+	bool failed;
+};
+
+static bool gather_piece(
+	struct libadt_const_lptr piece,
+	bool cdata,
+	bool blank,
+	void *context
+)
+{
+	struct gather *const gather = context;
+	struct descent_xml_text *const text = gather->text;
+	gather->all_cdata = gather->all_cdata && cdata;
+	gather->blank = gather->blank && blank;
+
+	const bool plain = cdata
+		|| !(text->flags & DESCENT_XML_TEXT_DECODE)
+		|| !needs_decoding(piece);
+	if (!gather->pieces && plain) {
+		gather->first = piece;
+	} else {
+		if (!gather->copied && !append(text, gather->first, false))
+			goto error;
+		gather->copied = true;
+		if (!append(text, piece, !plain))
+			goto error;
+	}
+	gather->pieces = true;
+	return true;
+
+error:
+	gather->failed = true;
+	return false;
+}
+
+struct descent_xml_lex descent_xml_text_read(
+	struct descent_xml_lex token,
+	struct descent_xml_text *text,
+	struct libadt_const_lptr *value,
+	bool *is_cdata
+)
+{
+	struct gather gather = {
+		.text = text,
+		.first = libadt_const_lptr_truncate(token.value, 0),
+		.all_cdata = true,
+		.blank = true,
+	};
+	text->buffer.length = 0;
+	token = each_piece(token, gather_piece, &gather);
+	if (gather.failed) {
+		token.type = descent_xml_parse_error;
+		return token;
+	}
+
+	*value = gather.copied
+		? (struct libadt_const_lptr) {
+			.buffer = text->buffer.buffer,
+			.size = 1,
+			.length = (ssize_t)text->buffer.length,
+		}
+		: gather.first;
+	*is_cdata = gather.all_cdata;
+	text->blank = gather.blank;
+	return token;
+}
+
+struct chunks {
+	struct descent_xml_text *text;
+	size_t chunk_size;
+	descent_xml_text_chunk_fn *handler;
+	void *context;
+	// DESCENT_XML_TEXT_CHUNK_BEGIN until the first chunk is passed on
+	unsigned position;
+	// The last chunk is held back until the next one is ready, so
+	// that it can be marked as the end. Decoded chunks alternate
+	// between the two halves of the buffer, so the one held back
+	// isn't overwritten.
+	struct libadt_const_lptr held;
+	bool held_cdata;
+	bool holding;
+	bool half;
+};
+
+static void emit(struct chunks *chunks, struct libadt_const_lptr chunk, bool cdata)
+{
+	if (chunks->holding) {
+		chunks->handler(
+			chunks->held,
+			chunks->position,
+			chunks->held_cdata,
+			chunks->context
+		);
+		chunks->position = 0;
+	}
+	chunks->held = chunk;
+	chunks->held_cdata = cdata;
+	chunks->holding = true;
+}
+
+static struct libadt_const_lptr slice(const char *at, size_t length)
+{
+	return (struct libadt_const_lptr) {
+		.buffer = at,
+		.size = 1,
+		.length = (ssize_t)length,
+	};
+}
+
+// Moves a cut at length back to the start of a UTF-8 sequence, unless
+// that would leave nothing.
+static size_t character_boundary(const char *at, size_t length)
+{
+	size_t cut = length;
+	for (int i = 0; i < 3 && cut > 1 && ((unsigned char)at[cut] & 0xc0) == 0x80; i++)
+		cut--;
+	return ((unsigned char)at[cut] & 0xc0) == 0x80 ? length : cut;
+}
+
+// The offset of the last '&' in the first length bytes at at that
+// isn't followed by a ';' among them, but could be by one after them,
+// or length if there's none.
+static size_t open_reference(const char *at, size_t length)
+{
+	for (size_t i = length; i > 0 && length - i < REFERENCE_MAX - 1; i--) {
+		if (at[i - 1] == ';')
+			return length;
+		if (at[i - 1] == '&')
+			return i - 1;
+	}
+	return length;
+}
+
+static bool chunk_piece(
+	struct libadt_const_lptr piece,
+	bool cdata,
+	bool blank,
+	void *context
+)
+{
+	(void)blank;
+	struct chunks *const chunks = context;
+	const bool decoding = !cdata
+		&& (chunks->text->flags & DESCENT_XML_TEXT_DECODE);
+	const char *at = piece.buffer;
+	size_t remaining = piece.length > 0 ? (size_t)piece.length : 0;
+
+	while (remaining) {
+		size_t length = remaining;
+		if (length > chunks->chunk_size)
+			length = character_boundary(at, chunks->chunk_size);
+		if (decoding && length < remaining) {
+			// don't cut a reference in two
+			const size_t cut = open_reference(at, length);
+			if (cut) {
+				length = cut;
+			} else {
+				// one running past a chunk that starts with it, which
+				// fits in a chunk of its own if it's to be replaced;
+				// without a ';' in reach, the '&' is just a character
+				const size_t reach = remaining < REFERENCE_MAX
+					? remaining
+					: REFERENCE_MAX;
+				const char *const semicolon = memchr(at, ';', reach);
+				if (semicolon)
+					length = (size_t)(semicolon - at) + 1;
+			}
+		}
+
+		if (!decoding || !memchr(at, '&', length)) {
+			emit(chunks, slice(at, length), cdata);
+		} else {
+			char *const out = (char *)chunks->text->buffer.buffer
+				+ chunks->half * chunks->chunk_size;
+			emit(chunks, slice(out, decode(at, length, out)), cdata);
+			chunks->half = !chunks->half;
+		}
+		at += length;
+		remaining -= length;
+	}
+	return true;
+}
+
+struct descent_xml_lex descent_xml_text_read_chunks(
+	struct descent_xml_lex token,
+	struct descent_xml_text *text,
+	descent_xml_text_chunk_fn *chunk_handler,
+	void *context
+)
+{
+	if (text->flags & DESCENT_XML_TEXT_SKIP_SPACE) {
+		// look through the leading whitespace before passing any of
+		// it on, in case that's all there is
+		bool content = false;
+		const struct descent_xml_lex last = each_piece(token, find_content, &content);
+		text->blank = !content;
+		if (!content)
+			return last;
+	}
+
+	struct chunks chunks = {
+		.text = text,
+		.chunk_size = text->chunk_size < 16 ? 16 : text->chunk_size,
+		.handler = chunk_handler,
+		.context = context,
+		.position = DESCENT_XML_TEXT_CHUNK_BEGIN,
+		.held = libadt_const_lptr_truncate(token.value, 0),
+		.held_cdata = token.type == descent_xml_lex_cdata,
+	};
+	if (text->flags & DESCENT_XML_TEXT_DECODE) {
+		text->buffer.length = 0;
+		if (!reserve(text, 2 * chunks.chunk_size)) {
+			token.type = descent_xml_parse_error;
+			return token;
+		}
+	}
+
+	token = each_piece(token, chunk_piece, &chunks);
+	chunk_handler(
+		chunks.held,
+		chunks.position | DESCENT_XML_TEXT_CHUNK_END,
+		chunks.held_cdata,
+		context
+	);
+	return token;
+}
@@ -0,0 +1,148 @@
+#include "descent-xml/token.h"
+
+#include "descent-xml/lex.h"
+#include "descent-xml/parse.h"
+#include "descent-xml/validate.h"
+
+#include <pthread.h>
+
+#define TEXT DESCENT_XML_TOKEN_CATEGORY_TEXT
+#define DATA DESCENT_XML_TOKEN_CATEGORY_DATA
+#define SPACE DESCENT_XML_TOKEN_CATEGORY_SPACE
+#define VALUE DESCENT_XML_TOKEN_CATEGORY_ATTRIBUTE_VALUE
+#define ENTITY DESCENT_XML_TOKEN_CATEGORY_ENTITY
+#define TAG DESCENT_XML_TOKEN_CATEGORY_TAG
+#define CLOSE DESCENT_XML_TOKEN_CATEGORY_CLOSE
+#define MARKUP DESCENT_XML_TOKEN_CATEGORY_MARKUP
+#define END DESCENT_XML_TOKEN_CATEGORY_END
+#define ERROR DESCENT_XML_TOKEN_CATEGORY_ERROR
+
+const uint16_t descent_xml_token_categories[DESCENT_XML_TOKEN_COUNT] = {
+	[DESCENT_XML_TOKEN_TEXT] = TEXT | DATA,
+	[DESCENT_XML_TOKEN_TEXT_SPACE] = TEXT | SPACE,
+	[DESCENT_XML_TOKEN_TEXT_ENTITY_START] = TEXT | DATA | ENTITY,
+	[DESCENT_XML_TOKEN_TEXT_ENTITY] = TEXT | DATA | ENTITY,
+	[DESCENT_XML_TOKEN_ELEMENT] = TAG,
+	[DESCENT_XML_TOKEN_ELEMENT_NAME] = TAG,
+	[DESCENT_XML_TOKEN_ELEMENT_SPACE] = TAG | SPACE,
+	[DESCENT_XML_TOKEN_ELEMENT_EMPTY] = TAG,
+	[DESCENT_XML_TOKEN_ELEMENT_END] = TAG,
+	[DESCENT_XML_TOKEN_ELEMENT_CLOSE] = TAG | CLOSE,
+	[DESCENT_XML_TOKEN_ELEMENT_CLOSE_NAME] = TAG | CLOSE,
+	[DESCENT_XML_TOKEN_ELEMENT_CLOSE_SPACE] = TAG | CLOSE | SPACE,
+	[DESCENT_XML_TOKEN_ATTRIBUTE_NAME] = TAG,
+	[DESCENT_XML_TOKEN_ATTRIBUTE_EXPECT_ASSIGN] = TAG,
+	[DESCENT_XML_TOKEN_ATTRIBUTE_ASSIGN] = TAG,
+	[DESCENT_XML_TOKEN_ATTRIBUTE_VALUE_SINGLE_QUOTE_START] = TAG,
+	[DESCENT_XML_TOKEN_ATTRIBUTE_VALUE_SINGLE_QUOTE] = TAG | VALUE,
+	[DESCENT_XML_TOKEN_ATTRIBUTE_VALUE_SINGLE_QUOTE_ENTITY_START] = TAG | VALUE | ENTITY,
+	[DESCENT_XML_TOKEN_ATTRIBUTE_VALUE_SINGLE_QUOTE_ENTITY] = TAG | VALUE | ENTITY,
+	[DESCENT_XML_TOKEN_ATTRIBUTE_VALUE_SINGLE_QUOTE_END] = TAG,
+	[DESCENT_XML_TOKEN_ATTRIBUTE_VALUE_DOUBLE_QUOTE_START] = TAG,
+	[DESCENT_XML_TOKEN_ATTRIBUTE_VALUE_DOUBLE_QUOTE] = TAG | VALUE,
+	[DESCENT_XML_TOKEN_ATTRIBUTE_VALUE_DOUBLE_QUOTE_ENTITY_START] = TAG | VALUE | ENTITY,
+	[DESCENT_XML_TOKEN_ATTRIBUTE_VALUE_DOUBLE_QUOTE_ENTITY] = TAG | VALUE | ENTITY,
+	[DESCENT_XML_TOKEN_ATTRIBUTE_VALUE_DOUBLE_QUOTE_END] = TAG,
+	[DESCENT_XML_TOKEN_DOCTYPE] = MARKUP,
+	[DESCENT_XML_TOKEN_XMLDECL] = MARKUP,
+	[DESCENT_XML_TOKEN_CDATA] = MARKUP | DATA,
+	[DESCENT_XML_TOKEN_COMMENT] = MARKUP,
+	[DESCENT_XML_TOKEN_EOF] = END,
+	[DESCENT_XML_TOKEN_UNEXPECTED] = END | ERROR,
+	[DESCENT_XML_TOKEN_PARSE_ERROR] = END | ERROR,
+	[DESCENT_XML_TOKEN_VALIDATE_ERROR] = END | ERROR,
+};
+
+const struct _descent_xml_token_slot *_descent_xml_token_table;
+
+size_t _descent_xml_token_hash(descent_xml_classifier_fn *type);
+enum descent_xml_token_id descent_xml_token_id(
+	descent_xml_classifier_fn *type
+);
+bool descent_xml_token_is(
+	struct descent_xml_lex token,
+	unsigned categories
+);
+
+#define TYPE(id, name) [id] = { (descent_xml_classifier_fn *)name, #name }
+
+// eof and unexpected are constants in another file rather than
+// functions, so they're filled in at run time
+static struct {
+	descent_xml_classifier_fn *type;
+	const char *name;
+} types[DESCENT_XML_TOKEN_COUNT] = {
+	TYPE(DESCENT_XML_TOKEN_START, descent_xml_classifier_start),
+	TYPE(DESCENT_XML_TOKEN_TEXT, descent_xml_classifier_text),
+	TYPE(DESCENT_XML_TOKEN_TEXT_SPACE, descent_xml_classifier_text_space),
+	TYPE(DESCENT_XML_TOKEN_TEXT_ENTITY_START, descent_xml_classifier_text_entity_start),
+	TYPE(DESCENT_XML_TOKEN_TEXT_ENTITY, descent_xml_classifier_text_entity),
+	TYPE(DESCENT_XML_TOKEN_ELEMENT, descent_xml_classifier_element),
+	TYPE(DESCENT_XML_TOKEN_ELEMENT_NAME, descent_xml_classifier_element_name),
+	TYPE(DESCENT_XML_TOKEN_ELEMENT_SPACE, descent_xml_classifier_element_space),
+	TYPE(DESCENT_XML_TOKEN_ELEMENT_EMPTY, descent_xml_classifier_element_empty),
+	TYPE(DESCENT_XML_TOKEN_ELEMENT_END, descent_xml_classifier_element_end),
+	TYPE(DESCENT_XML_TOKEN_ELEMENT_CLOSE, descent_xml_classifier_element_close),
+	TYPE(DESCENT_XML_TOKEN_ELEMENT_CLOSE_NAME, descent_xml_classifier_element_close_name),
+	TYPE(DESCENT_XML_TOKEN_ELEMENT_CLOSE_SPACE, descent_xml_classifier_element_close_space),
+	TYPE(DESCENT_XML_TOKEN_ATTRIBUTE_NAME, descent_xml_classifier_attribute_name),
+	TYPE(DESCENT_XML_TOKEN_ATTRIBUTE_EXPECT_ASSIGN, descent_xml_classifier_attribute_expect_assign),
+	TYPE(DESCENT_XML_TOKEN_ATTRIBUTE_ASSIGN, descent_xml_classifier_attribute_assign),
+	TYPE(DESCENT_XML_TOKEN_ATTRIBUTE_VALUE_SINGLE_QUOTE_START, descent_xml_classifier_attribute_value_single_quote_start),
+	TYPE(DESCENT_XML_TOKEN_ATTRIBUTE_VALUE_SINGLE_QUOTE, descent_xml_classifier_attribute_value_single_quote),
+	TYPE(DESCENT_XML_TOKEN_ATTRIBUTE_VALUE_SINGLE_QUOTE_ENTITY_START, descent_xml_classifier_attribute_value_single_quote_entity_start),
+	TYPE(DESCENT_XML_TOKEN_ATTRIBUTE_VALUE_SINGLE_QUOTE_ENTITY, descent_xml_classifier_attribute_value_single_quote_entity),
+	TYPE(DESCENT_XML_TOKEN_ATTRIBUTE_VALUE_SINGLE_QUOTE_END, descent_xml_classifier_attribute_value_single_quote_end),
+	TYPE(DESCENT_XML_TOKEN_ATTRIBUTE_VALUE_DOUBLE_QUOTE_START, descent_xml_classifier_attribute_value_double_quote_start),
+	TYPE(DESCENT_XML_TOKEN_ATTRIBUTE_VALUE_DOUBLE_QUOTE, descent_xml_classifier_attribute_value_double_quote),
+	TYPE(DESCENT_XML_TOKEN_ATTRIBUTE_VALUE_DOUBLE_QUOTE_ENTITY_START, descent_xml_classifier_attribute_value_double_quote_entity_start),
+	TYPE(DESCENT_XML_TOKEN_ATTRIBUTE_VALUE_DOUBLE_QUOTE_ENTITY, descent_xml_classifier_attribute_value_double_quote_entity),
+	TYPE(DESCENT_XML_TOKEN_ATTRIBUTE_VALUE_DOUBLE_QUOTE_END, descent_xml_classifier_attribute_value_double_quote_end),
+	TYPE(DESCENT_XML_TOKEN_DOCTYPE, descent_xml_lex_doctype),
+	TYPE(DESCENT_XML_TOKEN_XMLDECL, descent_xml_lex_xmldecl),
+	TYPE(DESCENT_XML_TOKEN_CDATA, descent_xml_lex_cdata),
+	TYPE(DESCENT_XML_TOKEN_COMMENT, descent_xml_lex_comment),
+	[DESCENT_XML_TOKEN_EOF] = { NULL, "descent_xml_classifier_eof" },
+	[DESCENT_XML_TOKEN_UNEXPECTED] = { NULL, "descent_xml_classifier_unexpected" },
+	TYPE(DESCENT_XML_TOKEN_PARSE_ERROR, descent_xml_parse_error),
+	TYPE(DESCENT_XML_TOKEN_VALIDATE_ERROR, descent_xml_validate_error),
+};
+
+static struct _descent_xml_token_slot slots[_DESCENT_XML_TOKEN_SLOTS];
+static pthread_once_t once = PTHREAD_ONCE_INIT;
+
+static void build_table(void)
+{
+	types[DESCENT_XML_TOKEN_EOF].type = descent_xml_classifier_eof;
+	types[DESCENT_XML_TOKEN_UNEXPECTED].type = descent_xml_classifier_unexpected;
+
+	for (size_t id = 1; id < DESCENT_XML_TOKEN_COUNT; id++) {
+		size_t slot = _descent_xml_token_hash(types[id].type);
+		while (slots[slot].type)
+			slot = (slot + 1) % _DESCENT_XML_TOKEN_SLOTS;
+		slots[slot].type = types[id].type;
+		slots[slot].id = (enum descent_xml_token_id)id;
+	}
+	__atomic_store_n(&_descent_xml_token_table, slots, __ATOMIC_RELEASE);
+}
+
+const struct _descent_xml_token_slot *_descent_xml_token_table_init(void)
+{
+	pthread_once(&once, build_table);
+	return slots;
+}
+
+descent_xml_classifier_fn *descent_xml_token_type(enum descent_xml_token_id id)
+{
+	if (id <= DESCENT_XML_TOKEN_UNKNOWN || id >= DESCENT_XML_TOKEN_COUNT)
+		return NULL;
+	_descent_xml_token_table_init();
+	return types[id].type;
+}
+
+const char *descent_xml_token_name(enum descent_xml_token_id id)
+{
+	if (id <= DESCENT_XML_TOKEN_UNKNOWN || id >= DESCENT_XML_TOKEN_COUNT)
+		return NULL;
+	return types[id].name;
+}
@@ -1,5 +1,23 @@
 #include "descent-xml/validate.h"
 
+#include <stdlib.h>
+
+descent_xml_classifier_void_fn *descent_xml_validate_error(wchar_t c)
+{
+	(void)c;
+	abort();
+	return (descent_xml_classifier_void_fn *)descent_xml_validate_error;
+}
+
+bool _descent_xml_attribute_names_scan(
+	const struct libadt_const_lptr *attributes,
+	size_t count
+);
+uint32_t _descent_xml_name_hash(struct libadt_const_lptr name);
+bool _descent_xml_has_duplicate_attribute(
+	struct libadt_const_lptr attributes,
+	const struct descent_xml_allocator *allocator
+);
 struct descent_xml_lex _descent_xml_validate_element_handler(
 	struct descent_xml_lex token,
 	struct libadt_const_lptr element_name,
@@ -7,6 +25,12 @@ struct descent_xml_lex _descent_xml_validate_element_handler(
 	bool empty,
 	void *context
 );
+_descent_xml_validate_t _descent_xml_validate_element_iterative(
+	struct descent_xml_lex token,
+	int depth,
+	const struct descent_xml_allocator *allocator
+);
+bool _descent_xml_validate_failure(struct descent_xml_lex token);
 bool descent_xml_validate_element_depth(struct descent_xml_lex token, int depth);
 bool descent_xml_validate_element(struct descent_xml_lex token);
 struct descent_xml_lex _descent_xml_validate_prolog_goto_element(
@@ -21,12 +45,61 @@ struct descent_xml_lex _descent_xml_validate_xmldecl(
 struct descent_xml_lex _descent_xml_validate_doctype(
 	struct descent_xml_lex token
 );
+bool _descent_xml_validate_document(
+	struct descent_xml_lex token,
+	int depth,
+	const struct descent_xml_allocator *allocator
+);
 bool descent_xml_validate_document_depth(
 	struct descent_xml_lex token,
 	int depth
 );
 bool descent_xml_validate_document(struct descent_xml_lex token);
+bool descent_xml_validate_document_alloc(
+	struct descent_xml_lex token,
+	int depth,
+	unsigned flags,
+	const struct descent_xml_allocator *allocator
+);
+bool descent_xml_validate_document_flags(
+	struct descent_xml_lex token,
+	int depth,
+	unsigned flags
+);
 bool _descent_xml_non_space_text(struct descent_xml_lex token);
 struct descent_xml_lex _descent_xml_validate_parse_prolog(
 	struct descent_xml_lex token
 );
+struct descent_xml_validator descent_xml_validator_init(int depth);
+void descent_xml_validator_free(struct descent_xml_validator *validator);
+bool _descent_xml_validator_push(
+	struct descent_xml_validator *validator,
+	struct libadt_const_lptr name
+);
+bool _descent_xml_is_xml_space(struct libadt_const_lptr text);
+struct descent_xml_lex _descent_xml_validated_element_handler(
+	struct descent_xml_lex token,
+	struct libadt_const_lptr element_name,
+	struct libadt_const_lptr attributes,
+	bool empty,
+	void *context
+);
+void _descent_xml_validated_text_handler(
+	struct libadt_const_lptr text,
+	bool is_cdata,
+	void *context
+);
+struct descent_xml_lex descent_xml_parse_validated(
+	struct descent_xml_lex xml,
+	struct descent_xml_validator *validator,
+	descent_xml_parse_element_fn *element_handler,
+	descent_xml_parse_text_fn *text_handler,
+	void *context
+);
+struct descent_xml_lex descent_xml_parse_cstr_validated(
+	struct descent_xml_lex xml,
+	struct descent_xml_validator *validator,
+	descent_xml_parse_element_cstr_fn *element_handler,
+	descent_xml_parse_text_cstr_fn *text_handler,
+	void *context
+);
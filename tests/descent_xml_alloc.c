@@ -0,0 +1,309 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "descent-xml/alloc.h"
+#include "descent-xml/bind.h"
+#include "descent-xml/parse.h"
+#include "descent-xml/validate.h"
+
+#include <libadt/str.h>
+
+typedef struct libadt_const_lptr lptr_t;
+
+#define lit libadt_str_literal
+
+#define MAX_BLOCKS 256
+
+// Hands out blocks from malloc(), checking that every size passed
+// back is the size the block was allocated with, and that nothing
+// is left over. A limit makes allocations fail past a point.
+struct tracker {
+	struct {
+		void *pointer;
+		size_t size;
+	} blocks[MAX_BLOCKS];
+	size_t live;
+	size_t allocations;
+	size_t limit;
+};
+
+static size_t find(struct tracker *tracker, void *pointer, size_t size)
+{
+	for (size_t i = 0; i < tracker->live; i++) {
+		if (tracker->blocks[i].pointer == pointer) {
+			assert(tracker->blocks[i].size == size);
+			return i;
+		}
+	}
+	assert(!"released a block that wasn't allocated");
+	return 0;
+}
+
+static void *tracker_allocate(void *context, size_t size)
+{
+	struct tracker *const tracker = context;
+	if (tracker->allocations == tracker->limit)
+		return NULL;
+	assert(tracker->live < MAX_BLOCKS);
+	void *const pointer = malloc(size ? size : 1);
+	if (!pointer)
+		return NULL;
+	tracker->blocks[tracker->live].pointer = pointer;
+	tracker->blocks[tracker->live].size = size;
+	tracker->live++;
+	tracker->allocations++;
+	return pointer;
+}
+
+static void tracker_release(void *context, void *pointer, size_t size)
+{
+	struct tracker *const tracker = context;
+	if (!pointer)
+		return;
+	const size_t i = find(tracker, pointer, size);
+	tracker->blocks[i] = tracker->blocks[--tracker->live];
+	free(pointer);
+}
+
+static void *tracker_reallocate(
+	void *context,
+	void *pointer,
+	size_t old_size,
+	size_t size
+)
+{
+	struct tracker *const tracker = context;
+	if (pointer)
+		find(tracker, pointer, old_size);
+	void *const grown = tracker_allocate(context, size);
+	if (!grown)
+		return NULL;
+	if (pointer) {
+		memcpy(grown, pointer, old_size < size ? old_size : size);
+		tracker_release(context, pointer, old_size);
+	}
+	return grown;
+}
+
+static struct descent_xml_allocator tracking(struct tracker *tracker)
+{
+	*tracker = (struct tracker) { .limit = SIZE_MAX };
+	return (struct descent_xml_allocator) {
+		.allocate = tracker_allocate,
+		.reallocate = tracker_reallocate,
+		.release = tracker_release,
+		.context = tracker,
+	};
+}
+
+static struct descent_xml_lex count_elements(
+	struct descent_xml_lex token,
+	char *element_name,
+	char **attributes,
+	bool empty,
+	void *context
+)
+{
+	(void)element_name;
+	(void)attributes;
+	(void)empty;
+	(*(int *)context)++;
+	return token;
+}
+
+static void count_text(char *text, bool is_cdata, void *context)
+{
+	(void)text;
+	(void)is_cdata;
+	(*(int *)context)++;
+}
+
+static const char many_attributes[] =
+	"<e a='1' b='2' c='3' d='4' e='5' f='6' g='7' h='8' i='9' j='10'>"
+	"text<child x='y'/></e>";
+
+void test_parse_cstr()
+{
+	struct tracker tracker;
+	const struct descent_xml_allocator allocator = tracking(&tracker);
+
+	struct descent_xml_lex token = descent_xml_lex_init(lit(many_attributes));
+	int calls = 0;
+	while (!_descent_xml_end_token(token))
+		token = descent_xml_parse_cstr_alloc(
+			token,
+			&allocator,
+			count_elements,
+			count_text,
+			&calls
+		);
+	assert(token.type == descent_xml_classifier_eof);
+	assert(calls == 3);
+	assert(tracker.allocations > 0);
+	assert(tracker.live == 0);
+}
+
+void test_parse_failure()
+{
+	// each time, fail one allocation further in
+	for (size_t limit = 0;; limit++) {
+		struct tracker tracker;
+		const struct descent_xml_allocator allocator = tracking(&tracker);
+		tracker.limit = limit;
+
+		struct descent_xml_lex token = descent_xml_lex_init(lit(many_attributes));
+		int calls = 0;
+		while (
+			!_descent_xml_end_token(token)
+			&& token.type != descent_xml_parse_error
+		)
+			token = descent_xml_parse_cstr_alloc(
+				token,
+				&allocator,
+				count_elements,
+				count_text,
+				&calls
+			);
+		assert(tracker.live == 0);
+		if (token.type == descent_xml_classifier_eof) {
+			assert(tracker.allocations == limit);
+			break;
+		}
+		assert(token.type == descent_xml_parse_error);
+	}
+}
+
+void test_validate()
+{
+	struct tracker tracker;
+	const struct descent_xml_allocator allocator = tracking(&tracker);
+
+	const struct descent_xml_lex token = descent_xml_lex_init(lit(
+		"<a><b><c><d><e><f><g><h><i><j>"
+		"<k l='1' m='2' n='3' o='4' p='5' q='6' r='7' s='8' t='9' u='10'/>"
+		"</j></i></h></g></f></e></d></c></b></a>"
+	));
+	assert(descent_xml_validate_document_alloc(token, -1, 0, &allocator));
+	assert(tracker.allocations > 0);
+	assert(tracker.live == 0);
+
+	const struct descent_xml_lex duplicate = descent_xml_lex_init(lit(
+		"<a><b a='1' b='2' c='3' d='4' e='5' f='6' g='7' h='8' i='9' a='10'/></a>"
+	));
+	assert(!descent_xml_validate_document_alloc(duplicate, -1, 0, &allocator));
+	assert(tracker.live == 0);
+
+	tracker.limit = tracker.allocations;
+	assert(!descent_xml_validate_document_alloc(token, -1, 0, &allocator));
+	assert(tracker.live == 0);
+}
+
+void test_validator()
+{
+	struct tracker tracker;
+	const struct descent_xml_allocator allocator = tracking(&tracker);
+
+	struct descent_xml_validator validator = descent_xml_validator_init(-1);
+	validator.allocator = &allocator;
+
+	struct descent_xml_lex token = descent_xml_lex_init(lit(
+		"<a><b><c x='1'/></b><b/></a>"
+	));
+	while (
+		!_descent_xml_end_token(token)
+		&& token.type != descent_xml_validate_error
+		&& token.type != descent_xml_parse_error
+	)
+		token = descent_xml_parse_validated(
+			token,
+			&validator,
+			NULL,
+			NULL,
+			NULL
+		);
+	assert(token.type == descent_xml_classifier_eof);
+	assert(tracker.allocations > 0);
+
+	descent_xml_validator_free(&validator);
+	assert(tracker.live == 0);
+}
+
+struct item {
+	uint64_t quantity;
+};
+
+struct basket {
+	struct item *items;
+	size_t item_count;
+	struct item *special;
+};
+
+static const struct descent_xml_bind_field item_fields[] = {
+	DESCENT_XML_BIND_ATTRIBUTE(struct item, quantity, "quantity", DESCENT_XML_BIND_UINT, 0),
+};
+static const struct descent_xml_bind_record item_record
+	= DESCENT_XML_BIND_RECORD_INIT("item", struct item, item_fields);
+
+static const struct descent_xml_bind_field basket_fields[] = {
+	DESCENT_XML_BIND_NESTED_ARRAY(struct basket, items, item_count, "item", &item_record),
+	DESCENT_XML_BIND_NESTED(struct basket, special, "special", &item_record, 0),
+};
+static const struct descent_xml_bind_record basket_record
+	= DESCENT_XML_BIND_RECORD_INIT("basket", struct basket, basket_fields);
+
+void test_bind()
+{
+	struct tracker tracker;
+	const struct descent_xml_allocator allocator = tracking(&tracker);
+
+	struct basket basket;
+	const bool parsed = descent_xml_bind_parse_alloc(
+		&basket_record,
+		lit(
+			"<basket><item quantity='1'/><item quantity='2'/>"
+			"<item quantity='3'/><special quantity='4'/></basket>"
+		),
+		&basket,
+		&allocator
+	);
+	assert(parsed);
+	(void)parsed;
+	assert(basket.item_count == 3);
+	assert(basket.items[2].quantity == 3);
+	assert(basket.special->quantity == 4);
+	assert(tracker.live == 2);
+
+	descent_xml_bind_free_alloc(&basket_record, &basket, &allocator);
+	assert(tracker.live == 0);
+	assert(!basket.items);
+}
+
+int main()
+{
+	test_parse_cstr();
+	test_parse_failure();
+	test_validate();
+	test_validator();
+	test_bind();
+	return 0;
+}
@@ -0,0 +1,283 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "descent-xml/bind.h"
+#include "descent-xml/parse.h"
+
+typedef struct libadt_const_lptr lptr_t;
+
+static lptr_t str(const char *string)
+{
+	return (lptr_t) {
+		.buffer = string,
+		.size = 1,
+		.length = (ssize_t)strlen(string),
+	};
+}
+
+static bool equal(lptr_t value, const char *expected)
+{
+	return value.length == (ssize_t)strlen(expected)
+		&& memcmp(value.buffer, expected, strlen(expected)) == 0;
+}
+
+struct customer {
+	lptr_t name;
+	bool vip;
+};
+
+struct item {
+	lptr_t sku;
+	uint64_t quantity;
+	double price;
+};
+
+struct order {
+	uint64_t id;
+	int64_t adjustment;
+	lptr_t currency;
+	struct customer *customer;
+	struct item *items;
+	size_t item_count;
+	lptr_t *notes;
+	size_t note_count;
+	double total;
+};
+
+static const struct descent_xml_bind_field customer_fields[] = {
+	DESCENT_XML_BIND_ATTRIBUTE(struct customer, vip, "vip", DESCENT_XML_BIND_BOOL, 0),
+	DESCENT_XML_BIND_TEXT(struct customer, name, DESCENT_XML_BIND_STRING, DESCENT_XML_BIND_REQUIRED),
+};
+static const struct descent_xml_bind_record customer_record
+	= DESCENT_XML_BIND_RECORD_INIT("customer", struct customer, customer_fields);
+
+static const struct descent_xml_bind_field item_fields[] = {
+	DESCENT_XML_BIND_ATTRIBUTE(struct item, sku, "sku", DESCENT_XML_BIND_STRING, DESCENT_XML_BIND_REQUIRED),
+	DESCENT_XML_BIND_ATTRIBUTE(struct item, quantity, "quantity", DESCENT_XML_BIND_UINT, 0),
+	DESCENT_XML_BIND_TEXT(struct item, price, DESCENT_XML_BIND_DOUBLE, 0),
+};
+static const struct descent_xml_bind_record item_record
+	= DESCENT_XML_BIND_RECORD_INIT("item", struct item, item_fields);
+
+static const struct descent_xml_bind_field order_fields[] = {
+	DESCENT_XML_BIND_ATTRIBUTE(struct order, id, "id", DESCENT_XML_BIND_UINT, DESCENT_XML_BIND_REQUIRED),
+	DESCENT_XML_BIND_ATTRIBUTE(struct order, currency, "currency", DESCENT_XML_BIND_STRING, 0),
+	DESCENT_XML_BIND_CHILD(struct order, adjustment, "adjustment", DESCENT_XML_BIND_INT, 0),
+	DESCENT_XML_BIND_CHILD(struct order, total, "total", DESCENT_XML_BIND_DOUBLE, 0),
+	DESCENT_XML_BIND_NESTED(struct order, customer, "customer", &customer_record, DESCENT_XML_BIND_REQUIRED),
+	DESCENT_XML_BIND_NESTED_ARRAY(struct order, items, item_count, "item", &item_record),
+	DESCENT_XML_BIND_CHILDREN(struct order, notes, note_count, "note", DESCENT_XML_BIND_STRING),
+};
+static const struct descent_xml_bind_record order_record
+	= DESCENT_XML_BIND_RECORD_INIT("order", struct order, order_fields);
+
+static bool parse(const char *document, struct order *order)
+{
+	return descent_xml_bind_parse(&order_record, str(document), order);
+}
+
+static void must_parse(const char *document, struct order *order)
+{
+	const bool parsed = parse(document, order);
+	assert(parsed);
+	(void)parsed;
+}
+
+void test_parse()
+{
+	struct order order;
+	const char *const document =
+		"<?xml version=\"1.0\"?>\n"
+		"<order id=\"42\" currency=\"EUR\" ignored=\"yes\">\n"
+		"	<customer vip=\"true\">Ada</customer>\n"
+		"	<!-- comments and unknown elements are skipped -->\n"
+		"	<unknown><deeper a=\"b\">text</deeper></unknown>\n"
+		"	<item sku=\"a-1\" quantity=\"3\"> 2.50 </item>\n"
+		"	<item sku=\"b-2\">1e3</item>\n"
+		"	<item sku=\"c-3\" quantity=\"1\"/>\n"
+		"	<note>first</note>\n"
+		"	<note><![CDATA[<second>]]></note>\n"
+		"	<adjustment>-17</adjustment>\n"
+		"	<total>1007.5</total>\n"
+		"</order>\n";
+	must_parse(document, &order);
+
+	assert(order.id == 42);
+	assert(equal(order.currency, "EUR"));
+	assert(order.adjustment == -17);
+	assert(order.total == 1007.5);
+
+	assert(order.customer);
+	assert(order.customer->vip);
+	assert(equal(order.customer->name, "Ada"));
+
+	assert(order.item_count == 3);
+	assert(equal(order.items[0].sku, "a-1"));
+	assert(order.items[0].quantity == 3);
+	assert(order.items[0].price == 2.5);
+	assert(equal(order.items[1].sku, "b-2"));
+	assert(order.items[1].quantity == 0);
+	assert(order.items[1].price == 1000);
+	assert(order.items[2].price == 0);
+
+	assert(order.note_count == 2);
+	assert(equal(order.notes[0], "first"));
+	assert(equal(order.notes[1], "<second>"));
+
+	descent_xml_bind_free(&order_record, &order);
+	assert(!order.items && !order.customer && order.item_count == 0);
+}
+
+void test_many()
+{
+	static char document[64 * 1024];
+	size_t length = (size_t)sprintf(document, "<order id=\"1\"><customer>x</customer>");
+	for (int i = 0; i < 1000; i++)
+		length += (size_t)sprintf(document + length, "<item sku=\"%d\" quantity=\"%d\">%d.25</item>", i, i, i);
+	sprintf(document + length, "</order>");
+
+	struct order order;
+	must_parse(document, &order);
+	assert(order.item_count == 1000);
+	for (size_t i = 0; i < order.item_count; i++) {
+		assert(order.items[i].quantity == i);
+		assert(order.items[i].price == (double)i + 0.25);
+	}
+	descent_xml_bind_free(&order_record, &order);
+}
+
+void test_numbers()
+{
+	struct order order;
+	const char *const prefix = "<order id=\"1\"><customer>x</customer><total>";
+	const char *const cases[] = {
+		"0", "-0.0", "+12", "3.14159", "1e-5", "6.02214076e23",
+		"0.1", "123456789012345678901234567890", "1.7976931348623157e308",
+		"4.9e-324", "0.000000000000000000000000000001", "9007199254740993",
+	};
+	for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+		char document[256];
+		sprintf(document, "%s%s</total></order>", prefix, cases[i]);
+		must_parse(document, &order);
+		assert(order.total == strtod(cases[i], NULL));
+		descent_xml_bind_free(&order_record, &order);
+	}
+
+	must_parse("<order id=\"1\"><customer>x</customer><total>INF</total></order>", &order);
+	assert(isinf(order.total));
+	descent_xml_bind_free(&order_record, &order);
+
+	must_parse("<order id=\"18446744073709551615\"><customer>x</customer></order>", &order);
+	assert(order.id == UINT64_MAX);
+	descent_xml_bind_free(&order_record, &order);
+
+	must_parse("<order id=\"1\"><customer>x</customer><adjustment>-9223372036854775808</adjustment></order>", &order);
+	assert(order.adjustment == INT64_MIN);
+	descent_xml_bind_free(&order_record, &order);
+}
+
+void test_invalid()
+{
+	struct order order;
+	const char *const cases[] = {
+		// wrong root, missing or malformed required fields
+		"<invoice id=\"1\"><customer>x</customer></invoice>",
+		"<order><customer>x</customer></order>",
+		"<order id=\"1\"></order>",
+		"<order id=\"-1\"><customer>x</customer></order>",
+		"<order id=\"18446744073709551616\"><customer>x</customer></order>",
+		"<order id=\"1\"><customer vip=\"yes\">x</customer></order>",
+		"<order id=\"1\"><customer>x</customer><total>1.5.2</total></order>",
+		"<order id=\"1\"><customer>x</customer><total></total></order>",
+		"<order id=\"1\"><customer>x</customer><item quantity=\"1\"/></order>",
+		// single fields can't repeat
+		"<order id=\"1\"><customer>x</customer><customer>y</customer></order>",
+		// text that can't be pointed at in one piece
+		"<order id=\"1\"><customer>x<!-- -->y</customer></order>",
+		// structure
+		"<order id=\"1\"><customer>x</customer></item>",
+		"<order id=\"1\"><customer>x</customer>",
+		"<order id=\"1\"><customer>x</customer></order><order id=\"2\"/>",
+		"",
+	};
+	for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+		memset(&order, 0xff, sizeof(order));
+		assert(!parse(cases[i], &order));
+		assert(!order.items && !order.customer && !order.notes);
+	}
+}
+
+struct wrapper {
+	size_t items;
+	struct descent_xml_bind_target target;
+};
+
+static struct descent_xml_lex count_items(
+	struct descent_xml_lex token,
+	struct libadt_const_lptr element_name,
+	struct libadt_const_lptr attributes,
+	bool empty,
+	void *context
+)
+{
+	struct wrapper *const wrapper = context;
+	if (equal(element_name, "item"))
+		wrapper->items++;
+	return descent_xml_bind_element(token, element_name, attributes, empty, &wrapper->target);
+}
+
+void test_element()
+{
+	// pulls the first customer out of a larger document
+	struct customer customer = { 0 };
+	struct wrapper wrapper = {
+		.target = {
+			.record = &customer_record,
+			.value = &customer,
+		},
+	};
+	const char *const document =
+		"<item/><customer vip=\"0\">first</customer><customer>second</customer><item/>";
+	struct descent_xml_lex token = descent_xml_lex_init(str(document));
+	while (token.type != descent_xml_classifier_eof) {
+		assert(token.type != descent_xml_classifier_unexpected);
+		token = descent_xml_parse(token, count_items, NULL, &wrapper);
+	}
+	assert(wrapper.target.bound && !wrapper.target.error);
+	assert(wrapper.items == 2);
+	assert(equal(customer.name, "first"));
+	assert(!customer.vip);
+	descent_xml_bind_free(&customer_record, &customer);
+}
+
+int main()
+{
+	test_parse();
+	test_many();
+	test_numbers();
+	test_invalid();
+	test_element();
+	return 0;
+}
@@ -0,0 +1,281 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "descent-xml/chars.h"
+#include "descent-xml/cpu.h"
+#include "descent-xml/validate.h"
+
+typedef struct libadt_const_lptr lptr_t;
+
+static lptr_t bytes(const void *buffer, size_t length)
+{
+	return (lptr_t) {
+		.buffer = buffer,
+		.size = 1,
+		.length = (ssize_t)length,
+	};
+}
+
+static lptr_t str(const char *string)
+{
+	return bytes(string, strlen(string));
+}
+
+// A straightforward decoder, checked against the block-at-a-time one.
+static size_t reference(const unsigned char *s, size_t length)
+{
+	size_t i = 0;
+	while (i < length) {
+		uint32_t c = s[i];
+		size_t n;
+		if (c < 0x80) {
+			n = 1;
+		} else if ((c & 0xe0) == 0xc0) {
+			n = 2;
+			c &= 0x1f;
+		} else if ((c & 0xf0) == 0xe0) {
+			n = 3;
+			c &= 0x0f;
+		} else if ((c & 0xf8) == 0xf0) {
+			n = 4;
+			c &= 0x07;
+		} else {
+			return i;
+		}
+		if (length - i < n)
+			return i;
+		for (size_t j = 1; j < n; j++) {
+			if ((s[i + j] & 0xc0) != 0x80)
+				return i;
+			c = c << 6 | (s[i + j] & 0x3f);
+		}
+		static const uint32_t minimum[] = { 0, 0, 0x80, 0x800, 0x10000 };
+		if (c < minimum[n])
+			return i;
+		const bool is_char = c == 0x9 || c == 0xa || c == 0xd
+			|| (c >= 0x20 && c <= 0xd7ff)
+			|| (c >= 0xe000 && c <= 0xfffd)
+			|| (c >= 0x10000 && c <= 0x10ffff);
+		if (!is_char)
+			return i;
+		i += n;
+	}
+	return length;
+}
+
+void test_chars()
+{
+	assert(descent_xml_chars_valid(str("")));
+	assert(descent_xml_chars_valid(str("<a b=\"c\">\tline\r\n</a>")));
+	assert(descent_xml_chars_valid(str("caf\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80 \xef\xbf\xbd")));
+	// C1 controls are allowed in XML 1.0
+	assert(descent_xml_chars_valid(str("\xc2\x85")));
+
+	struct {
+		const char *script;
+		size_t bad;
+	} invalid[] = {
+		{ "ab\x01", 2 },
+		{ "\x7f\x1f", 1 },
+		{ "0123456789abcdef0123456789\x0b", 26 },
+		{ "0123456789abcdef0123456789abcdef\x1b", 32 },
+		// overlong, surrogate, U+FFFE, U+FFFF, past U+10FFFF
+		{ "a\xc0\xaf", 1 },
+		{ "a\xe0\x80\xaf", 1 },
+		{ "a\xed\xa0\x80", 1 },
+		{ "a\xef\xbf\xbe", 1 },
+		{ "a\xef\xbf\xbf", 1 },
+		{ "a\xf4\x90\x80\x80", 1 },
+		{ "a\xf8\x88\x80\x80\x80", 1 },
+		// stray continuation, truncated at the end or mid-block
+		{ "0123456789abcde\x80", 15 },
+		{ "0123456789abcdef\xe2\x82", 16 },
+		{ "0123456789abcd\xe2\x82xyzzyzzyzzyzzy", 14 },
+	};
+	for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+		assert(descent_xml_chars_check(str(invalid[i].script)) == invalid[i].bad);
+		assert(!descent_xml_chars_valid(str(invalid[i].script)));
+	}
+
+	// a NUL byte isn't a Char either
+	assert(descent_xml_chars_check(bytes("ab\0cd", 5)) == 2);
+}
+
+void test_random()
+{
+	// mostly ASCII with sequences, both valid and not, at every
+	// alignment
+	static const char *const pieces[] = {
+		"a", "<", "\n", "\t", " ", "\xc3\xa9", "\xe2\x82\xac",
+		"\xf0\x9f\x98\x80", "\xef\xbf\xbd", "\xee\x80\x80",
+		"\x01", "\x80", "\xed\xa0\x80", "\xef\xbf\xbf", "\xe2\x82",
+		"\xf4\x90\x80\x80", "\xc1\xbf",
+	};
+	const size_t piece_count = sizeof(pieces) / sizeof(pieces[0]);
+	unsigned char buffer[512 + DESCENT_XML_PADDING];
+	srand(1);
+	for (int round = 0; round < 20000; round++) {
+		size_t length = 0;
+		const bool clean = round % 2;
+		while (length < sizeof(buffer) - DESCENT_XML_PADDING - 8) {
+			size_t piece = (size_t)rand() % (clean ? 10 : piece_count);
+			// keep most of the dirty inputs long enough to reach the
+			// block path before the first bad byte
+			if (!clean && piece >= 10 && rand() % 32)
+				piece = 0;
+			const size_t n = strlen(pieces[piece]);
+			memcpy(buffer + length, pieces[piece], n);
+			length += n;
+			if (rand() % 64 == 0)
+				break;
+		}
+		const size_t expected = reference(buffer, length);
+		assert(descent_xml_chars_check(bytes(buffer, length)) == expected);
+		// the padding holds bytes that would fail the check
+		memset(buffer + length, round % 3 ? 0x01 : 0x80, DESCENT_XML_PADDING);
+		assert(descent_xml_chars_check_padded(bytes(buffer, length)) == expected);
+		if (clean)
+			assert(expected == length);
+	}
+}
+
+void test_multibyte()
+{
+	// mostly multi-byte text, so the vector kernels see sequences
+	// running across every block boundary, with a bad sequence put
+	// at every offset and the script cut off at every length
+	static const char *const bad[] = {
+		"\x80", "\xc1\xbf", "\xe0\x9f\xbf", "\xed\xb0\x80",
+		"\xef\xbf\xbe", "\xf4\x90\x80\x80", "\xf8", "\x01", "\xe2\x82",
+		"\xf0\x9f\x98", "\xc3",
+	};
+	unsigned char buffer[260 + DESCENT_XML_PADDING];
+	// é € 😀 a, ten bytes, so boundaries fall everywhere in a block
+	static const char piece[] = "\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80""a";
+	for (size_t i = 0; i < sizeof(buffer); i++)
+		buffer[i] = (unsigned char)piece[i % (sizeof(piece) - 1)];
+
+	for (size_t length = 0; length <= 256; length++) {
+		const size_t expected = reference(buffer, length);
+		assert(descent_xml_chars_check(bytes(buffer, length)) == expected);
+		assert(descent_xml_chars_check_padded(bytes(buffer, length)) == expected);
+	}
+
+	for (size_t b = 0; b < sizeof(bad) / sizeof(bad[0]); b++) {
+		for (size_t at = 0; at < 200; at++) {
+			unsigned char copy[sizeof(buffer)];
+			memcpy(copy, buffer, sizeof(copy));
+			memcpy(copy + at, bad[b], strlen(bad[b]));
+			const size_t expected = reference(copy, 256);
+			assert(expected < 256);
+			assert(descent_xml_chars_check(bytes(copy, 256)) == expected);
+			assert(descent_xml_chars_check_padded(bytes(copy, 256)) == expected);
+		}
+	}
+}
+
+void test_spaces()
+{
+	assert(descent_xml_chars_spaces(str("")) == 0);
+	assert(descent_xml_chars_spaces(str("a  ")) == 0);
+	assert(descent_xml_chars_spaces(str(" \t\r\n<a/>")) == 4);
+	assert(descent_xml_chars_spaces(str("  \n  ")) == 5);
+	// only the `S` production: no vertical tabs, form feeds or NULs
+	assert(descent_xml_chars_spaces(str("  \v")) == 2);
+	assert(descent_xml_chars_spaces(str("  \f")) == 2);
+	assert(descent_xml_chars_spaces(bytes("  \0 ", 4)) == 2);
+	// nor bytes that would equal a space in the low seven bits
+	assert(descent_xml_chars_spaces(str("\t\xa0")) == 1);
+
+	// runs of every length, ended by every kind of byte, at every
+	// alignment, with whitespace past the end that mustn't be counted
+	static const char ends[] = { 'a', '<', '\0', '\x0b', '\x89', '\xa0' };
+	static const char space[] = " \t\r\n";
+	unsigned char buffer[256];
+	for (size_t offset = 0; offset < 8; offset++) {
+		for (size_t run = 0; run < 160; run++) {
+			for (size_t e = 0; e < sizeof(ends); e++) {
+				memset(buffer, ' ', sizeof(buffer));
+				for (size_t i = 0; i < run; i++)
+					buffer[offset + i] = (unsigned char)space[(i * 7 + run) % 4];
+				buffer[offset + run] = (unsigned char)ends[e];
+				assert(descent_xml_chars_spaces(bytes(buffer + offset, run + 1)) == run);
+				assert(descent_xml_chars_spaces(bytes(buffer + offset, run)) == run);
+			}
+		}
+	}
+}
+
+void test_validate()
+{
+	const char *const good = "<?xml version=\"1.0\"?><a>\tcafe\r\n</a>";
+	const char *const control = "<a>bell\x07</a>";
+	const char *const surrogate = "<a b=\"\xed\xb0\x80\"/>";
+
+	const struct descent_xml_lex token = descent_xml_lex_init(str(good));
+	assert(descent_xml_validate_document_flags(token, -1, DESCENT_XML_VALIDATE_CHARS));
+
+	assert(descent_xml_validate_document_flags(descent_xml_lex_init(str(control)), -1, 0));
+	assert(!descent_xml_validate_document_flags(
+		descent_xml_lex_init(str(control)),
+		-1,
+		DESCENT_XML_VALIDATE_CHARS
+	));
+	assert(!descent_xml_validate_document_flags(
+		descent_xml_lex_init(str(surrogate)),
+		-1,
+		DESCENT_XML_VALIDATE_CHARS
+	));
+
+	// padded, with bytes past the end that would fail the check
+	char padded[64 + DESCENT_XML_PADDING];
+	memset(padded, 0x01, sizeof(padded));
+	memcpy(padded, good, strlen(good));
+	const unsigned flags = DESCENT_XML_VALIDATE_CHARS | DESCENT_XML_VALIDATE_PADDED;
+	assert(descent_xml_validate_document_flags(
+		descent_xml_lex_init(bytes(padded, strlen(good))),
+		-1,
+		flags
+	));
+	memcpy(padded, control, strlen(control));
+	assert(!descent_xml_validate_document_flags(
+		descent_xml_lex_init(bytes(padded, strlen(control))),
+		-1,
+		flags
+	));
+}
+
+int main()
+{
+	// every kernel this machine can run
+	const enum descent_xml_simd supported = descent_xml_simd_supported();
+	for (int level = DESCENT_XML_SIMD_SCALAR; level <= (int)supported; level++) {
+		assert(descent_xml_simd_set_level(level) == (enum descent_xml_simd)level);
+		test_chars();
+		test_random();
+		test_multibyte();
+		test_spaces();
+		test_validate();
+	}
+	return 0;
+}
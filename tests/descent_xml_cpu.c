@@ -0,0 +1,70 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "descent-xml/chars.h"
+#include "descent-xml/cpu.h"
+
+#include <libadt/str.h>
+
+void test_environment()
+{
+	// read once, before the first kernel runs
+	assert(descent_xml_simd_level() == DESCENT_XML_SIMD_SCALAR);
+	assert(descent_xml_chars_valid(libadt_str_literal("<a>scalar</a>")));
+	setenv("DESCENT_XML_SIMD", "avx512", 1);
+	assert(descent_xml_simd_level() == DESCENT_XML_SIMD_SCALAR);
+}
+
+void test_set_level()
+{
+	const enum descent_xml_simd supported = descent_xml_simd_supported();
+	assert(supported < DESCENT_XML_SIMD_COUNT);
+#if !(defined(__x86_64__) || defined(__i386__))
+	assert(supported == DESCENT_XML_SIMD_SCALAR);
+#endif
+
+	for (int level = 0; level < DESCENT_XML_SIMD_COUNT; level++) {
+		// capped at what the CPU supports
+		const enum descent_xml_simd set = descent_xml_simd_set_level(level);
+		assert(set == ((enum descent_xml_simd)level < supported ? (enum descent_xml_simd)level : supported));
+		assert(descent_xml_simd_level() == set);
+		assert(descent_xml_chars_valid(libadt_str_literal("<a>\tline\r\n</a>")));
+	}
+}
+
+void test_names()
+{
+	assert(strcmp(descent_xml_simd_name(DESCENT_XML_SIMD_SCALAR), "scalar") == 0);
+	assert(strcmp(descent_xml_simd_name(DESCENT_XML_SIMD_SSE2), "sse2") == 0);
+	assert(strcmp(descent_xml_simd_name(DESCENT_XML_SIMD_AVX2), "avx2") == 0);
+	assert(strcmp(descent_xml_simd_name(DESCENT_XML_SIMD_AVX512), "avx512") == 0);
+	assert(!descent_xml_simd_name(DESCENT_XML_SIMD_COUNT));
+}
+
+int main()
+{
+	setenv("DESCENT_XML_SIMD", "scalar", 1);
+	test_environment();
+	test_set_level();
+	test_names();
+	return 0;
+}
@@ -0,0 +1,283 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "descent-xml/cursor.h"
+
+#include <libadt/str.h>
+
+typedef struct libadt_const_lptr lptr_t;
+
+#define lit libadt_str_literal
+
+static inline bool lptr_is(lptr_t value, const char *expected)
+{
+	return value.length == (ssize_t)strlen(expected)
+		&& memcmp(value.buffer, expected, (size_t)value.length) == 0;
+}
+
+static const char library[] =
+	"<?xml version=\"1.0\" ?>\n"
+	"<!-- a few books -->\n"
+	"<library>\n"
+	"	<book type=\"non-fiction\">\n"
+	"		<title>The Pragmatic Programmer</title>\n"
+	"		<author>David Thomas</author>\n"
+	"		<author>Andrew Hunt</author>\n"
+	"	</book>\n"
+	"	<book type=\"fiction\">\n"
+	"		<title>Magician</title>\n"
+	"		<author>Raymond E. Feist</author>\n"
+	"	</book>\n"
+	"	<shelf/>\n"
+	"	<book type=\"fiction\">\n"
+	"		<title><![CDATA[Stormbreaker]]></title>\n"
+	"		<author>Anthony Horowitz</author>\n"
+	"	</book>\n"
+	"</library>\n";
+
+void test_walk()
+{
+	struct descent_xml_cursor cursor;
+	descent_xml_cursor_init(&cursor, lit(library), NULL);
+	assert(cursor.depth == 0);
+
+	assert(descent_xml_cursor_first_child(&cursor));
+	assert(lptr_is(cursor.name, "library"));
+	assert(cursor.depth == 1);
+	assert(cursor.attributes.length == 0);
+
+	assert(descent_xml_cursor_first_child(&cursor));
+	assert(lptr_is(cursor.name, "book"));
+	assert(cursor.depth == 2);
+	assert(cursor.attributes.length == 2);
+	const lptr_t *attributes = cursor.attributes.buffer;
+	assert(lptr_is(attributes[0], "type"));
+	assert(lptr_is(attributes[1], "non-fiction"));
+
+	assert(descent_xml_cursor_first_child(&cursor));
+	assert(lptr_is(cursor.name, "title"));
+	assert(cursor.depth == 3);
+
+	lptr_t text;
+	assert(descent_xml_cursor_text(&cursor, &text));
+	assert(lptr_is(text, "The Pragmatic Programmer"));
+	// the content has been read now
+	assert(!descent_xml_cursor_text(&cursor, &text));
+	assert(!descent_xml_cursor_first_child(&cursor));
+
+	assert(descent_xml_cursor_next_sibling(&cursor));
+	assert(lptr_is(cursor.name, "author"));
+	assert(descent_xml_cursor_next_sibling(&cursor));
+	assert(lptr_is(cursor.name, "author"));
+	assert(descent_xml_cursor_text(&cursor, &text));
+	assert(lptr_is(text, "Andrew Hunt"));
+
+	// no more children: back up on the book, past </book>
+	assert(!descent_xml_cursor_next_sibling(&cursor));
+	assert(!descent_xml_cursor_failed(&cursor));
+	assert(lptr_is(cursor.name, "book"));
+	assert(cursor.depth == 2);
+	assert(cursor.attributes.length == 0);
+
+	// the second book is skipped without looking inside
+	assert(descent_xml_cursor_next_sibling(&cursor));
+	assert(lptr_is(cursor.name, "book"));
+	attributes = cursor.attributes.buffer;
+	assert(lptr_is(attributes[1], "fiction"));
+	assert(descent_xml_cursor_skip(&cursor));
+	assert(lptr_is(cursor.name, "book"));
+	assert(cursor.attributes.length == 2);
+
+	assert(descent_xml_cursor_next_sibling(&cursor));
+	assert(lptr_is(cursor.name, "shelf"));
+	assert(cursor.empty);
+	assert(!descent_xml_cursor_first_child(&cursor));
+	assert(descent_xml_cursor_text(&cursor, &text));
+	assert(text.length == 0);
+
+	assert(descent_xml_cursor_next_sibling(&cursor));
+	assert(descent_xml_cursor_first_child(&cursor));
+	assert(descent_xml_cursor_text(&cursor, &text));
+	assert(lptr_is(text, "Stormbreaker"));
+
+	// up past </book>, then past </library>
+	assert(descent_xml_cursor_parent_end(&cursor));
+	assert(lptr_is(cursor.name, "book"));
+	assert(cursor.depth == 2);
+	assert(descent_xml_cursor_parent_end(&cursor));
+	assert(lptr_is(cursor.name, "library"));
+	assert(cursor.depth == 1);
+
+	assert(!descent_xml_cursor_next_sibling(&cursor));
+	assert(cursor.depth == 0);
+	assert(cursor.token.type == descent_xml_classifier_eof);
+	assert(!descent_xml_cursor_failed(&cursor));
+	assert(!descent_xml_cursor_next_sibling(&cursor));
+	assert(!descent_xml_cursor_first_child(&cursor));
+
+	descent_xml_cursor_free(&cursor);
+}
+
+void test_fiction_authors()
+{
+	// the books example from the third tutorial, without the
+	// handlers
+	const char *const expected[] = { "Raymond E. Feist", "Anthony Horowitz" };
+	size_t found = 0;
+
+	struct descent_xml_cursor cursor;
+	descent_xml_cursor_init(&cursor, lit(library), NULL);
+	assert(descent_xml_cursor_first_child(&cursor));
+	assert(descent_xml_cursor_first_child(&cursor));
+	do {
+		const lptr_t *const attributes = cursor.attributes.buffer;
+		const bool fiction = cursor.attributes.length == 2
+			&& lptr_is(attributes[1], "fiction");
+		if (!fiction || !descent_xml_cursor_first_child(&cursor))
+			continue;
+		do {
+			lptr_t text;
+			if (
+				lptr_is(cursor.name, "author")
+				&& descent_xml_cursor_text(&cursor, &text)
+			) {
+				assert(found < 2);
+				assert(lptr_is(text, expected[found]));
+				found++;
+			}
+		} while (descent_xml_cursor_next_sibling(&cursor));
+	} while (descent_xml_cursor_next_sibling(&cursor));
+
+	assert(found == 2);
+	assert(lptr_is(cursor.name, "library"));
+	assert(!descent_xml_cursor_failed(&cursor));
+	descent_xml_cursor_free(&cursor);
+}
+
+void test_skip_document()
+{
+	struct descent_xml_cursor cursor;
+	descent_xml_cursor_init(&cursor, lit(library), NULL);
+	assert(descent_xml_cursor_skip(&cursor));
+	assert(cursor.depth == 0);
+	assert(cursor.token.type == descent_xml_classifier_eof);
+	assert(!descent_xml_cursor_first_child(&cursor));
+	descent_xml_cursor_free(&cursor);
+}
+
+static bool walk_all(lptr_t script, struct descent_xml_cursor *cursor)
+{
+	descent_xml_cursor_init(cursor, script, NULL);
+	// visits every element without recursion
+	for (;;) {
+		if (descent_xml_cursor_first_child(cursor))
+			continue;
+		while (!descent_xml_cursor_next_sibling(cursor)) {
+			if (descent_xml_cursor_failed(cursor))
+				return false;
+			if (cursor->depth == 0)
+				return true;
+		}
+	}
+}
+
+void test_mismatched()
+{
+	struct descent_xml_cursor cursor;
+
+	assert(!walk_all(lit("<a><b></a></b>"), &cursor));
+	assert(cursor.token.type == descent_xml_validate_error);
+	descent_xml_cursor_free(&cursor);
+
+	assert(!walk_all(lit("<a><b></b>"), &cursor));
+	assert(cursor.token.type == descent_xml_validate_error);
+	descent_xml_cursor_free(&cursor);
+
+	assert(!walk_all(lit("<a><b x='1></b></a>"), &cursor));
+	assert(cursor.token.type == descent_xml_classifier_unexpected);
+	descent_xml_cursor_free(&cursor);
+
+	// skipping checks nesting too
+	descent_xml_cursor_init(&cursor, lit("<a><b><c></b></c></a>"), NULL);
+	assert(descent_xml_cursor_first_child(&cursor));
+	assert(!descent_xml_cursor_skip(&cursor));
+	assert(descent_xml_cursor_failed(&cursor));
+	assert(cursor.token.type == descent_xml_validate_error);
+	// and nothing moves once it has failed
+	assert(!descent_xml_cursor_next_sibling(&cursor));
+	assert(!descent_xml_cursor_first_child(&cursor));
+	assert(!descent_xml_cursor_parent_end(&cursor));
+	descent_xml_cursor_free(&cursor);
+
+	assert(walk_all(lit("<a><b/><c><d></d></c></a>"), &cursor));
+	descent_xml_cursor_free(&cursor);
+}
+
+void test_deep()
+{
+	const size_t depth = 100000;
+	char *const document = malloc(depth * 7 + 1);
+	assert(document);
+	char *end = document;
+	for (size_t i = 0; i < depth; i++)
+		end += sprintf(end, "<a>");
+	for (size_t i = 0; i < depth; i++)
+		end += sprintf(end, "</a>");
+	const lptr_t script = {
+		.buffer = document,
+		.size = 1,
+		.length = end - document,
+	};
+
+	struct descent_xml_cursor cursor;
+	descent_xml_cursor_init(&cursor, script, NULL);
+	size_t deepest = 0;
+	while (descent_xml_cursor_first_child(&cursor))
+		deepest = cursor.depth;
+	assert(deepest == depth);
+	while (descent_xml_cursor_parent_end(&cursor))
+		;
+	assert(!descent_xml_cursor_failed(&cursor));
+	assert(cursor.depth == 0);
+	descent_xml_cursor_free(&cursor);
+
+	// and skipping the lot from the root
+	descent_xml_cursor_init(&cursor, script, NULL);
+	assert(descent_xml_cursor_first_child(&cursor));
+	assert(descent_xml_cursor_skip(&cursor));
+	assert(!descent_xml_cursor_next_sibling(&cursor));
+	assert(cursor.token.type == descent_xml_classifier_eof);
+	descent_xml_cursor_free(&cursor);
+
+	free(document);
+}
+
+int main()
+{
+	test_walk();
+	test_fiction_authors();
+	test_skip_document();
+	test_mismatched();
+	test_deep();
+	return 0;
+}
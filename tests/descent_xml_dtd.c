@@ -0,0 +1,393 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "descent-xml/dtd.h"
+#include "descent-xml/validate.h"
+
+#include <libadt/str.h>
+
+typedef struct descent_xml_lex lex_t;
+typedef struct libadt_const_lptr lptr_t;
+
+#define lex descent_xml_lex_init
+#define lit libadt_str_literal
+
+static bool lptr_is(lptr_t lptr, const char *expected)
+{
+	return (size_t)lptr.length == strlen(expected)
+		&& memcmp(lptr.buffer, expected, (size_t)lptr.length) == 0;
+}
+
+static lex_t next_doctype(lex_t token)
+{
+	while (token.type != descent_xml_lex_doctype) {
+		assert(token.type != descent_xml_classifier_eof);
+		assert(token.type != descent_xml_classifier_unexpected);
+		token = descent_xml_lex_next_raw(token);
+	}
+	return token;
+}
+
+void test_doctype(void)
+{
+	{
+		lex_t doctype = next_doctype(lex(lit(
+			"<!DOCTYPE note [\n"
+			"  <!ELEMENT note (#PCDATA)>\n"
+			"  <!-- a ] in a comment -->\n"
+			"  <!ATTLIST note kind CDATA \"a]b\">\n"
+			"]>\n"
+			"<note/>"
+		)));
+		assert(lptr_is(descent_xml_doctype_name(doctype), "note"));
+		assert(lptr_is(
+			descent_xml_doctype_subset(doctype),
+			"\n"
+			"  <!ELEMENT note (#PCDATA)>\n"
+			"  <!-- a ] in a comment -->\n"
+			"  <!ATTLIST note kind CDATA \"a]b\">\n"
+		));
+		assert(descent_xml_lex_next_raw(doctype).type == descent_xml_classifier_element_end);
+	}
+
+	{
+		lex_t doctype = next_doctype(lex(lit(
+			"<!DOCTYPE html SYSTEM \"about:[legacy]\" [<!ELEMENT html EMPTY>]><html/>"
+		)));
+		assert(lptr_is(descent_xml_doctype_name(doctype), "html"));
+		assert(lptr_is(descent_xml_doctype_subset(doctype), "<!ELEMENT html EMPTY>"));
+	}
+
+	{
+		lex_t doctype = next_doctype(lex(lit("<!DOCTYPE html>\n<html></html>")));
+		assert(lptr_is(descent_xml_doctype_name(doctype), "html"));
+		assert(descent_xml_doctype_subset(doctype).length == 0);
+	}
+
+	{
+		lex_t unterminated = lex(lit("<!DOCTYPE html [<!ELEMENT html EMPTY>><html/>"));
+		assert(!descent_xml_validate_document(unterminated));
+	}
+}
+
+void test_compile(void)
+{
+	const lptr_t valid[] = {
+		lit(""),
+		lit("<!ELEMENT a EMPTY>"),
+		lit("<!ELEMENT a ANY>"),
+		lit("<!ELEMENT a (#PCDATA)>"),
+		lit("<!ELEMENT a (#PCDATA)*>"),
+		lit("<!ELEMENT a (#PCDATA | b | c)*>"),
+		lit("<!ELEMENT a ((b, c?) | (d+, e*))+>"),
+		lit("<!ELEMENT a (b)><!ATTLIST a x (one|two) 'one' y CDATA #FIXED \"1\">"),
+		lit("<!ENTITY e 'value'><!ENTITY logo SYSTEM 'logo.png' NDATA png>"),
+		lit("<!ENTITY % p 'x'><!NOTATION png SYSTEM 'image/png'><?pi x?>"),
+	};
+	for (size_t i = 0; i < sizeof(valid) / sizeof(valid[0]); i++) {
+		struct descent_xml_dtd *const dtd = descent_xml_dtd_compile(valid[i]);
+		assert(dtd);
+		descent_xml_dtd_free(dtd);
+	}
+
+	const lptr_t invalid[] = {
+		lit("<!ELEMENT a EMPTY"),
+		lit("<!ELEMENT a (b, c | d)>"),
+		lit("<!ELEMENT a (#PCDATA | b)>"),
+		lit("<!ELEMENT a EMPTY><!ELEMENT a ANY>"),
+		lit("<!ELEMENT a ()>"),
+		lit("<!ATTLIST a x BOGUS #IMPLIED>"),
+		lit("%p;"),
+		lit("<!-- unterminated"),
+	};
+	for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++)
+		assert(!descent_xml_dtd_compile(invalid[i]));
+}
+
+void test_content_models(void)
+{
+	struct descent_xml_dtd *const dtd = descent_xml_dtd_compile(lit(
+		"<!ELEMENT book (title, author+, (chapter | appendix)*, index?)>"
+		"<!ELEMENT title (#PCDATA)>"
+		"<!ELEMENT author (#PCDATA | em)*>"
+		"<!ELEMENT em (#PCDATA)>"
+		"<!ELEMENT chapter ANY>"
+		"<!ELEMENT appendix EMPTY>"
+		"<!ELEMENT index EMPTY>"
+	));
+	assert(dtd);
+
+	const lptr_t valid[] = {
+		lit("<book><title>T</title><author>A</author></book>"),
+		lit(
+			"<book>\n"
+			"  <title>T</title>\n"
+			"  <author>A <em>B</em></author>\n"
+			"  <author/>\n"
+			"  <chapter>any <title>thing</title></chapter>\n"
+			"  <appendix/>\n"
+			"  <chapter/>\n"
+			"  <index></index>\n"
+			"</book>"
+		),
+		lit("<!DOCTYPE book><book><title/><author/><index/></book>"),
+	};
+	for (size_t i = 0; i < sizeof(valid) / sizeof(valid[0]); i++)
+		assert(descent_xml_dtd_validate_document(dtd, lex(valid[i])));
+
+	const lptr_t invalid[] = {
+		// missing a required child
+		lit("<book><title>T</title></book>"),
+		lit("<book/>"),
+		// out of order
+		lit("<book><author>A</author><title>T</title></book>"),
+		// index has to be last
+		lit("<book><title/><author/><index/><chapter/></book>"),
+		// text in element content
+		lit("<book>text<title/><author/></book>"),
+		lit("<book><![CDATA[ ]]><title/><author/></book>"),
+		// an element in a text-only element
+		lit("<book><title><em>T</em></title><author/></book>"),
+		// anything at all in an EMPTY element
+		lit("<book><title/><author/><appendix> </appendix></book>"),
+		// undeclared elements
+		lit("<book><title/><author/><preface/></book>"),
+		lit("<novel/>"),
+		// root doesn't match the DOCTYPE
+		lit("<!DOCTYPE title><book><title/><author/></book>"),
+		// not well-formed
+		lit("<book><title/><author/></novel>"),
+	};
+	for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++)
+		assert(!descent_xml_dtd_validate_document(dtd, lex(invalid[i])));
+
+	descent_xml_dtd_free(dtd);
+
+	// not deterministic, which XML forbids, but we can still
+	// build an automaton for it
+	struct descent_xml_dtd *const ambiguous = descent_xml_dtd_compile(lit(
+		"<!ELEMENT a ((b, c) | (b, d))>"
+		"<!ELEMENT b EMPTY><!ELEMENT c EMPTY><!ELEMENT d EMPTY>"
+	));
+	assert(ambiguous);
+	assert(descent_xml_dtd_validate_document(ambiguous, lex(lit("<a><b/><c/></a>"))));
+	assert(descent_xml_dtd_validate_document(ambiguous, lex(lit("<a><b/><d/></a>"))));
+	assert(!descent_xml_dtd_validate_document(ambiguous, lex(lit("<a><b/></a>"))));
+	descent_xml_dtd_free(ambiguous);
+}
+
+static lptr_t chars(const char *string)
+{
+	lptr_t result = lit("");
+	result.buffer = string;
+	result.length = (ssize_t)strlen(string);
+	return result;
+}
+
+void test_wide_models(void)
+{
+	// content models naming enough elements for the table of them
+	// to grow while the declaration is being read
+	enum { WIDTH = 100 };
+	static char subset[WIDTH * 32 + 64];
+	for (int mixed = 0; mixed < 2; mixed++) {
+		char *at = subset;
+		at += sprintf(at, mixed ? "<!ELEMENT a (#PCDATA" : "<!ELEMENT a (e0");
+		for (int i = mixed ? 0 : 1; i < WIDTH; i++)
+			at += sprintf(at, "|e%d", i);
+		at += sprintf(at, ")*>");
+		for (int i = 0; i < WIDTH; i++)
+			at += sprintf(at, "<!ELEMENT e%d EMPTY>", i);
+
+		struct descent_xml_dtd *const dtd = descent_xml_dtd_compile(chars(subset));
+		assert(dtd);
+		assert(descent_xml_dtd_validate_document(
+			dtd,
+			lex(lit("<a><e0/><e99/><e42/></a>"))
+		));
+		assert(!descent_xml_dtd_validate_document(
+			dtd,
+			lex(lit("<a><e100/></a>"))
+		));
+		descent_xml_dtd_free(dtd);
+	}
+}
+
+void test_attributes(void)
+{
+	struct descent_xml_dtd *const dtd = descent_xml_dtd_compile(lit(
+		"<!ELEMENT a (#PCDATA)>"
+		"<!ATTLIST a\n"
+		"  id ID #REQUIRED\n"
+		"  kind (big | small) 'small'\n"
+		"  version CDATA #FIXED '1.0'\n"
+		"  refs IDREFS #IMPLIED\n"
+		"  tokens NMTOKENS #IMPLIED\n"
+		"  picture ENTITY #IMPLIED\n"
+		"  note CDATA #IMPLIED>\n"
+		"<!ATTLIST a kind CDATA #IMPLIED>\n"
+		"<!ENTITY company 'Example Ltd'>\n"
+		"<!ENTITY logo SYSTEM 'logo.png' NDATA png>\n"
+	));
+	assert(dtd);
+
+	const lptr_t valid[] = {
+		lit("<a id='x'/>"),
+		lit("<a id='x' kind='big' version='1.0'/>"),
+		lit("<a id=' x ' kind=' small ' refs='y z' tokens='1 2-3 .4'/>"),
+		lit("<a id='x' picture='logo' note='&company; &amp; &#169;'>&company;</a>"),
+	};
+	for (size_t i = 0; i < sizeof(valid) / sizeof(valid[0]); i++)
+		assert(descent_xml_dtd_validate_document(dtd, lex(valid[i])));
+
+	const lptr_t invalid[] = {
+		// missing required attribute
+		lit("<a/>"),
+		lit("<a kind='big'/>"),
+		// undeclared attribute
+		lit("<a id='x' colour='red'/>"),
+		// not in the enumeration; the first ATTLIST wins
+		lit("<a id='x' kind='medium'/>"),
+		// fixed value
+		lit("<a id='x' version='2.0'/>"),
+		// not names or tokens
+		lit("<a id='1x'/>"),
+		lit("<a id='x y'/>"),
+		lit("<a id='x' refs=''/>"),
+		lit("<a id='x' tokens='a b!'/>"),
+		// not an unparsed entity
+		lit("<a id='x' picture='company'/>"),
+		// undeclared and unparsed entity references
+		lit("<a id='x' note='&nobody;'/>"),
+		lit("<a id='x'>&nobody;</a>"),
+		lit("<a id='x'>&logo;</a>"),
+	};
+	for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++)
+		assert(!descent_xml_dtd_validate_document(dtd, lex(invalid[i])));
+
+	descent_xml_dtd_free(dtd);
+}
+
+void test_internal_subset(void)
+{
+	const lptr_t document = lit(
+		"<?xml version=\"1.0\"?>\n"
+		"<!DOCTYPE list [\n"
+		"  <!ELEMENT list (item*)>\n"
+		"  <!ELEMENT item (#PCDATA)>\n"
+		"  <!ATTLIST item n NMTOKEN #REQUIRED>\n"
+		"]>\n"
+		"<list><item n='1'>one</item><item n='2'>two</item></list>\n"
+	);
+	assert(descent_xml_dtd_validate_document(NULL, lex(document)));
+	assert(!descent_xml_dtd_validate_document(NULL, lex(lit(
+		"<!DOCTYPE list [<!ELEMENT list (item*)><!ELEMENT item EMPTY>]>"
+		"<list><item>text</item></list>"
+	))));
+
+	// nothing to validate against
+	assert(!descent_xml_dtd_validate_document(NULL, lex(lit("<list/>"))));
+	assert(!descent_xml_dtd_validate_document(NULL, lex(lit("<!DOCTYPE list><list/>"))));
+
+	// the well-formedness validator skips over the subset
+	assert(descent_xml_validate_document(lex(document)));
+}
+
+static int element_count;
+
+static lex_t count_element(
+	lex_t token,
+	lptr_t name,
+	lptr_t attributes,
+	bool empty,
+	void *context
+)
+{
+	(void)name;
+	(void)attributes;
+	(void)empty;
+	(void)context;
+	element_count++;
+	return token;
+}
+
+void test_reuse(void)
+{
+	// compile once, then validate many documents while parsing them
+	struct descent_xml_dtd *const dtd = descent_xml_dtd_compile(lit(
+		"<!ELEMENT message (header, body)>"
+		"<!ELEMENT header EMPTY>"
+		"<!ATTLIST header seq NMTOKEN #REQUIRED>"
+		"<!ELEMENT body (#PCDATA)>"
+	));
+	assert(dtd);
+
+	const lptr_t messages[] = {
+		lit("<message><header seq='1'/><body>hello</body></message>"),
+		lit("<message><header seq='2'/></message>"),
+		lit("<message><header seq='3'/><body/></message>"),
+	};
+	const bool expected[] = { true, false, true };
+
+	for (int round = 0; round < 100; round++) {
+		for (size_t i = 0; i < sizeof(messages) / sizeof(messages[0]); i++) {
+			struct descent_xml_dtd_validator dtd_validator
+				= descent_xml_dtd_validator_init(dtd);
+			struct descent_xml_validator validator
+				= descent_xml_validator_init(-1);
+			validator.dtd = &dtd_validator;
+
+			lex_t token = lex(messages[i]);
+			while (
+				token.type != descent_xml_classifier_eof
+				&& token.type != descent_xml_classifier_unexpected
+				&& token.type != descent_xml_validate_error
+			)
+				token = descent_xml_parse_validated(
+					token,
+					&validator,
+					count_element,
+					NULL,
+					NULL
+				);
+			assert((token.type == descent_xml_classifier_eof) == expected[i]);
+
+			descent_xml_validator_free(&validator);
+			descent_xml_dtd_validator_free(&dtd_validator);
+		}
+	}
+	assert(element_count == 100 * (3 + 2 + 3));
+
+	descent_xml_dtd_free(dtd);
+}
+
+int main()
+{
+	test_doctype();
+	test_compile();
+	test_content_models();
+	test_wide_models();
+	test_attributes();
+	test_internal_subset();
+	test_reuse();
+}
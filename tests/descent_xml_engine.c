@@ -0,0 +1,196 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <locale.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "descent-xml/lex.h"
+#include "descent-xml/token.h"
+
+#include <libadt/str.h>
+
+#include "pathological.h"
+
+// The engine in src/engine.c against the generic one, which calls the
+// classifier state function for each character
+
+// characters to combine, one string each, as encoded in UTF-8
+static const char *const extra_characters[] = {
+	"\xc3\xa9", // é, a name start character
+	"\xc2\xb7", // middle dot, a name character
+	"\xef\xbb\xbf", // byte order mark
+	"\xe2\x80\x83", // em space, text
+	"\xc3", // truncated
+	"\xff", // never valid
+};
+
+#define ASCII_COUNT 128
+#define CHARACTER_COUNT (ASCII_COUNT + sizeof(extra_characters) / sizeof(extra_characters[0]))
+
+static void character(size_t i, char *out, size_t *length)
+{
+	if (i < ASCII_COUNT) {
+		out[0] = (char)i;
+		*length = 1;
+		return;
+	}
+	const char *const string = extra_characters[i - ASCII_COUNT];
+	*length = strlen(string);
+	memcpy(out, string, *length);
+}
+
+static void assert_same_run(
+	struct libadt_const_lptr script,
+	descent_xml_classifier_fn *state
+)
+{
+	const _descent_xml_lex_read_t
+		expected = _descent_xml_lex_run_generic(script, state),
+		actual = _descent_xml_lex_run(script, state);
+	assert(actual.type == expected.type);
+	assert(actual.amount == expected.amount);
+	assert(actual.script.buffer == expected.script.buffer);
+	assert(actual.script.length == expected.script.length);
+}
+
+static bool is_engine_state(enum descent_xml_token_id id)
+{
+	// states that can't be lexed from abort(), and the errors are
+	// only ever made by the parser and validators
+	return id != DESCENT_XML_TOKEN_UNKNOWN
+		&& !(descent_xml_token_categories[id] & DESCENT_XML_TOKEN_CATEGORY_END);
+}
+
+void test_states()
+{
+	// every state, given every pair of characters as a, b, b, a
+	for (int id = 0; id < DESCENT_XML_TOKEN_COUNT; id++) {
+		if (!is_engine_state(id))
+			continue;
+		descent_xml_classifier_fn *const state = descent_xml_token_type(id);
+
+		for (size_t a = 0; a < CHARACTER_COUNT; a++) {
+			for (size_t b = 0; b < CHARACTER_COUNT; b++) {
+				char buffer[16], first[4], second[4];
+				size_t first_length, second_length, length = 0;
+				character(a, first, &first_length);
+				character(b, second, &second_length);
+				memcpy(buffer + length, first, first_length);
+				length += first_length;
+				memcpy(buffer + length, second, second_length);
+				length += second_length;
+				memcpy(buffer + length, second, second_length);
+				length += second_length;
+				memcpy(buffer + length, first, first_length);
+				length += first_length;
+
+				// and every prefix, so runs stop at the end of
+				// the script too
+				for (size_t prefix = 0; prefix <= length; prefix++) {
+					const struct libadt_const_lptr script = {
+						.buffer = buffer,
+						.size = 1,
+						.length = (ssize_t)prefix,
+					};
+					assert_same_run(script, state);
+				}
+			}
+		}
+	}
+}
+
+static void assert_same_tokens(const char *document, size_t length)
+{
+	struct descent_xml_lex token = descent_xml_lex_init((struct libadt_const_lptr) {
+		.buffer = document,
+		.size = 1,
+		.length = (ssize_t)length,
+	});
+	while (
+		token.type != descent_xml_classifier_eof
+		&& token.type != descent_xml_classifier_unexpected
+	) {
+		assert_same_run(_descent_xml_lex_remainder(token), token.type);
+		token = descent_xml_lex_next_raw(token);
+	}
+}
+
+void test_documents()
+{
+	static const char *const documents[] = {
+		"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+		"<!DOCTYPE catalogue SYSTEM \"catalogue.dtd\">\n"
+		"<catalogue xmlns:x='urn:x' x:id=\"1\">\n"
+		"\t<!-- a comment -->\n"
+		"\t<item sku='a&amp;b' name = \"caf\xc3\xa9\">fish &amp; chips &#38;</item>\n"
+		"\t<empty/><empty a='1' />\n"
+		"\t<![CDATA[<not markup>]]>\n"
+		"</catalogue >\n",
+		"\xef\xbb\xbf  <a>\xc3\xa9\xc2\xb7</a>",
+		"<a>text > more</a>",
+		"<a b='<'/>",
+		"<a>&;</a>",
+		"<a>\xff</a>",
+		"<a></a",
+	};
+	for (size_t i = 0; i < sizeof(documents) / sizeof(documents[0]); i++)
+		assert_same_tokens(documents[i], strlen(documents[i]));
+
+	for (size_t i = 0; i < pathological_input_count; i++) {
+		size_t length;
+		char *const document = pathological_generate(&pathological_inputs[i], 64, &length);
+		assert(document);
+		assert_same_tokens(document, length);
+		free(document);
+	}
+}
+
+static descent_xml_classifier_void_fn *user_classifier(wchar_t input)
+{
+	if (input == L'a')
+		return (descent_xml_classifier_void_fn *)user_classifier;
+	return (descent_xml_classifier_void_fn *)descent_xml_classifier_text;
+}
+
+void test_user_state()
+{
+	// states the engine doesn't know are handed to the generic one
+	static const char script[] = "aab";
+	const _descent_xml_lex_read_t read
+		= _descent_xml_lex_run(libadt_str_literal(script), user_classifier);
+	assert(read.type == user_classifier);
+	assert(read.amount == 2);
+	assert(read.script.length == 1);
+}
+
+int main()
+{
+	test_states();
+	test_documents();
+	test_user_state();
+
+	// again with multibyte characters decoded
+	if (setlocale(LC_CTYPE, "C.UTF-8")) {
+		test_states();
+		test_documents();
+	}
+	return 0;
+}
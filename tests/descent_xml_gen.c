@@ -0,0 +1,146 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <stdbool.h>
+#include <string.h>
+
+// generated from descent_xml_gen.desc and descent_xml_gen.dtd
+#include "catalogue.h"
+#include "order_feed.h"
+
+#include <libadt/str.h>
+
+typedef struct libadt_const_lptr lptr_t;
+
+#define lit libadt_str_literal
+
+static bool lptr_is(lptr_t lptr, const char *expected)
+{
+	return (size_t)lptr.length == strlen(expected)
+		&& memcmp(lptr.buffer, expected, (size_t)lptr.length) == 0;
+}
+
+void test_descriptor(void)
+{
+	struct order_feed_order order;
+	assert(order_feed_parse(lit(
+		"<?xml version=\"1.0\"?>\n"
+		"<order id=\"42\" currency=\"EUR\" priority=\"-3\" unknown=\"x\">\n"
+		"  <customer vip=\"true\">Ann &amp; Co</customer>\n"
+		"  <item sku=\"a-1\" quantity=\"2\">1.5</item>\n"
+		"  <!-- skipped -->\n"
+		"  <extra><nested>skipped</nested></extra>\n"
+		"  <item sku=\"b-2\" quantity=\"10\"> 20 </item>\n"
+		"  <item sku=\"c-3\" quantity=\"1\"><![CDATA[3.25]]></item>\n"
+		"  <total>34.75</total>\n"
+		"  <tag>new</tag><tag/><tag>gift</tag>\n"
+		"</order>\n"
+	), &order));
+
+	assert(order.id == 42);
+	assert(lptr_is(order.currency, "EUR"));
+	assert(order.has_priority && order.priority == -3);
+	assert(!order.has_express);
+	assert(order.customer);
+	assert(order.customer->has_vip && order.customer->vip);
+	assert(lptr_is(order.customer->text, "Ann &amp; Co"));
+	assert(order.item_count == 3);
+	assert(lptr_is(order.item[0].sku, "a-1"));
+	assert(order.item[0].quantity == 2 && order.item[0].text == 1.5);
+	assert(order.item[1].quantity == 10 && order.item[1].text == 20);
+	assert(order.item[2].text == 3.25);
+	assert(!order.note.buffer);
+	assert(order.has_total && order.total == 34.75);
+	assert(order.tag_count == 3);
+	assert(lptr_is(order.tag[0], "new"));
+	assert(lptr_is(order.tag[1], ""));
+	assert(lptr_is(order.tag[2], "gift"));
+	order_feed_free(&order);
+
+	const lptr_t invalid[] = {
+		// the id is required
+		lit("<order><customer/></order>"),
+		// so is the customer
+		lit("<order id='1'><item sku='a' quantity='1'>1</item></order>"),
+		// and only one of them
+		lit("<order id='1'><customer/><customer/></order>"),
+		// bad values
+		lit("<order id='-1'><customer/></order>"),
+		lit("<order id='18446744073709551616'><customer/></order>"),
+		lit("<order id='1' express='maybe'><customer/></order>"),
+		lit("<order id='1'><customer/><item sku='a' quantity='1'>x</item></order>"),
+		lit("<order id='1'><customer/><total>1 2</total></order>"),
+		// text split around a comment
+		lit("<order id='1'><customer>a<!-- -->b</customer></order>"),
+		// not the root, or not well-formed
+		lit("<item sku='a' quantity='1'>1</item>"),
+		lit("<order id='1'><customer></order>"),
+		lit("<order id='1'><customer/></order><order id='2'><customer/></order>"),
+		lit("<order id='1'><customer/>"),
+	};
+	for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+		assert(!order_feed_parse(invalid[i], &order));
+		assert(!order.customer && !order.item);
+	}
+}
+
+void test_dtd(void)
+{
+	struct catalogue_library library;
+	assert(catalogue_parse(lit(
+		"<library>"
+		"<book type='fiction' isbn='0-00-0'>"
+		"<title>Magician</title><author>Raymond E. Feist</author>"
+		"<note>An <em>early</em> <em>favourite</em></note>"
+		"</book>"
+		"<book type='non-fiction'>"
+		"<title>The Pragmatic Programmer</title>"
+		"<author>David Thomas</author><author>Andrew Hunt</author>"
+		"</book>"
+		"</library>"
+	), &library));
+
+	assert(library.book_count == 2);
+	assert(lptr_is(library.book[0].type, "fiction"));
+	assert(lptr_is(library.book[0].isbn, "0-00-0"));
+	assert(lptr_is(library.book[0].title, "Magician"));
+	assert(library.book[0].author_count == 1);
+	assert(library.book[0].note);
+	assert(library.book[0].note->em_count == 2);
+	assert(lptr_is(library.book[0].note->em[1], "favourite"));
+	assert(!library.book[1].isbn.buffer);
+	assert(library.book[1].author_count == 2);
+	assert(lptr_is(library.book[1].author[1], "Andrew Hunt"));
+	assert(!library.book[1].note);
+	catalogue_free(&library);
+
+	// type is #REQUIRED, and title isn't optional
+	assert(!catalogue_parse(lit("<library><book><title/><author/></book></library>"), &library));
+	assert(!catalogue_parse(lit("<library><book type='fiction'><author/></book></library>"), &library));
+	assert(catalogue_parse(lit("<library/>"), &library));
+	assert(library.book_count == 0);
+	catalogue_free(&library);
+}
+
+int main()
+{
+	test_descriptor();
+	test_dtd();
+	return 0;
+}
@@ -128,6 +128,43 @@ void test_element_attributes(void)
 	}
 }
 
+lex_t count_callback(
+	lex_t token,
+	lptr_t name,
+	lptr_t attributes,
+	bool empty,
+	void *context
+)
+{
+	(void)name;
+	(void)attributes;
+	(void)empty;
+	(*(int*)context)++;
+	return token;
+}
+
+void test_truncated_attributes(void)
+{
+	const lptr_t scripts[] = {
+		lit("<element attr"),
+		lit("<element attr="),
+		lit("<element attr='"),
+		lit("<element attr=\"value"),
+		lit("<element attr='value"),
+		lit("<element attr='&amp"),
+		lit("<element attr='value'"),
+	};
+
+	for (size_t i = 0; i < sizeof(scripts) / sizeof(scripts[0]); i++) {
+		lex_t xml = lex(scripts[i]);
+		int run_times = 0;
+		while (!stop_token(xml))
+			xml = descent_xml_parse(xml, count_callback, NULL, &run_times);
+		assert(run_times == 0);
+		assert(xml.type == err);
+	}
+}
+
 void text_callback(
 	lptr_t text,
 	bool is_cdata,
@@ -317,6 +354,7 @@ int main()
 {
 	test_empty_element_no_attributes();
 	test_element_attributes();
+	test_truncated_attributes();
 	test_attribute_entities();
 	test_text_node();
 	test_text_entities();
@@ -0,0 +1,231 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "descent-xml/parser.h"
+
+#include <libadt/str.h>
+
+typedef struct libadt_const_lptr lptr_t;
+
+#define lit libadt_str_literal
+
+struct counts {
+	struct descent_xml_parser *parser;
+	int elements;
+	int texts;
+};
+
+static bool done(struct descent_xml_lex token)
+{
+	return token.type == descent_xml_classifier_eof
+		|| token.type == descent_xml_classifier_unexpected
+		|| token.type == descent_xml_parse_error
+		|| token.type == descent_xml_validate_error;
+}
+
+static void count_text(char *text, bool is_cdata, void *context)
+{
+	(void)is_cdata;
+	struct counts *const counts = context;
+	assert(text[0]);
+	counts->texts++;
+}
+
+// Parses the children with a nested call, so the attribute lists and
+// strings pile up on the arena as the document gets deeper.
+static struct descent_xml_lex count_element(
+	struct descent_xml_lex token,
+	char *element_name,
+	char **attributes,
+	bool empty,
+	void *context
+)
+{
+	(void)attributes;
+	struct counts *const counts = context;
+	counts->elements++;
+	if (empty)
+		return token;
+
+	while (token.type != descent_xml_classifier_element_close_name) {
+		if (done(token))
+			return token;
+		token = descent_xml_parser_parse_cstr(
+			counts->parser,
+			token,
+			count_element,
+			count_text,
+			counts
+		);
+	}
+	assert(strlen(element_name) == (size_t)token.value.length);
+	return descent_xml_parse(token, NULL, NULL, NULL);
+}
+
+static struct descent_xml_lex parse(
+	struct descent_xml_parser *parser,
+	lptr_t script,
+	struct counts *counts
+)
+{
+	*counts = (struct counts) { .parser = parser };
+	struct descent_xml_lex token = descent_xml_parser_start(parser, script);
+	while (!done(token))
+		token = descent_xml_parser_parse_cstr(
+			parser,
+			token,
+			count_element,
+			count_text,
+			counts
+		);
+	return token;
+}
+
+static const char document[] =
+	"<?xml version='1.0'?>"
+	"<orders region='eu'>"
+	"<order id='1' a='1' b='2' c='3' d='4' e='5' f='6' g='7' h='8' i='9'>"
+	"<item sku='x'>one</item><item sku='y'>two</item></order>"
+	"<order id='2'><item sku='z'>three</item></order>"
+	"</orders>";
+
+void test_reuse()
+{
+	struct descent_xml_parser parser;
+	const bool initialised = descent_xml_parser_init(&parser, 0);
+	assert(initialised);
+	(void)initialised;
+	assert(parser.capacity == 0);
+
+	struct counts counts;
+	struct descent_xml_lex token = parse(&parser, lit(document), &counts);
+	assert(token.type == descent_xml_classifier_eof);
+	assert(counts.elements == 6);
+	assert(counts.texts == 3);
+
+	// blocks are released in order, so everything has been given back
+	assert(parser.used == 0 && parser.used_before == 0);
+	assert(parser.peak > 0);
+
+	// and later documents don't need any more memory
+	const size_t capacity = parser.capacity;
+	for (int i = 0; i < 10; i++) {
+		token = parse(&parser, lit(document), &counts);
+		assert(token.type == descent_xml_classifier_eof);
+		assert(counts.elements == 6);
+		assert(parser.capacity == capacity);
+	}
+
+	descent_xml_parser_free(&parser);
+}
+
+void test_growth()
+{
+	// too small for the first document, so it spills into more
+	// chunks, which a reset merges
+	struct descent_xml_parser parser;
+	descent_xml_parser_init(&parser, 64);
+
+	char big[8192] = "<root";
+	size_t length = strlen(big);
+	for (int i = 0; i < 300; i++) {
+		const int written = snprintf(big + length, sizeof(big) - length, " a%d='%d'", i, i);
+		length += (size_t)written;
+	}
+	strcpy(big + length, "><child/></root>");
+	length += strlen("><child/></root>");
+	const lptr_t script = { .buffer = big, .size = 1, .length = (ssize_t)length };
+
+	struct counts counts;
+	struct descent_xml_lex token = parse(&parser, script, &counts);
+	assert(token.type == descent_xml_classifier_eof);
+	assert(counts.elements == 2);
+	assert(parser.used_before > 0);
+
+	const size_t capacity = parser.capacity;
+	descent_xml_parser_reset(&parser);
+	assert(parser.capacity == capacity);
+	assert(parser.capacity >= parser.peak);
+
+	// the merged chunk holds the whole document
+	token = parse(&parser, script, &counts);
+	assert(token.type == descent_xml_classifier_eof);
+	assert(parser.used_before == 0);
+	assert(parser.capacity == capacity);
+
+	descent_xml_parser_free(&parser);
+}
+
+void test_validate()
+{
+	struct descent_xml_parser parser;
+	descent_xml_parser_init(&parser, 1024);
+
+	assert(descent_xml_parser_validate(&parser, lit(document), 0));
+	assert(!descent_xml_parser_validate(&parser, lit("<a><b></a>"), 0));
+	assert(!descent_xml_parser_validate(&parser, lit("<a x='1' x='2'/>"), 0));
+
+	parser.validator.max_depth = 2;
+	assert(!descent_xml_parser_validate(&parser, lit("<a><b><c/></b></a>"), 0));
+	assert(descent_xml_parser_validate(&parser, lit("<a><b/></a>"), 0));
+
+	descent_xml_parser_free(&parser);
+}
+
+void test_parse_validated()
+{
+	struct descent_xml_parser parser;
+	descent_xml_parser_init(&parser, 0);
+
+	const lptr_t documents[] = {
+		lit("<a><b/><c>text</c></a>"),
+		lit("<a><b></c></a>"),
+		lit("<a/>"),
+	};
+	const bool valid[] = { true, false, true };
+
+	for (int round = 0; round < 2; round++) {
+		for (size_t i = 0; i < sizeof(documents) / sizeof(documents[0]); i++) {
+			struct descent_xml_lex token = descent_xml_parser_start(&parser, documents[i]);
+			while (!done(token))
+				token = descent_xml_parser_parse_validated(
+					&parser,
+					token,
+					NULL,
+					NULL,
+					NULL
+				);
+			assert((token.type == descent_xml_classifier_eof) == valid[i]);
+		}
+	}
+
+	descent_xml_parser_free(&parser);
+}
+
+int main()
+{
+	test_reuse();
+	test_growth();
+	test_validate();
+	test_parse_validated();
+	return 0;
+}
@@ -0,0 +1,213 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "descent-xml/pipeline.h"
+
+#include <libadt/str.h>
+
+typedef struct descent_xml_lex lex_t;
+typedef struct libadt_const_lptr lptr_t;
+typedef struct descent_xml_pipeline_options options_t;
+typedef struct descent_xml_pipeline_handlers handlers_t;
+typedef struct descent_xml_pipeline_stats stats_t;
+
+#define lex descent_xml_lex_init
+#define lit libadt_str_literal
+#define eof descent_xml_classifier_eof
+#define err descent_xml_classifier_unexpected
+
+struct log {
+	char buffer[4096];
+	size_t length;
+};
+
+static void log_append(struct log *log, const char *prefix, lptr_t value)
+{
+	log->length += (size_t)snprintf(
+		log->buffer + log->length,
+		sizeof(log->buffer) - log->length,
+		"%s%.*s;",
+		prefix,
+		(int)value.length,
+		(const char *)value.buffer
+	);
+}
+
+static void log_element(lptr_t name, lptr_t attributes, bool empty, void *context)
+{
+	log_append(context, empty ? "empty:" : "open:", name);
+	const lptr_t *const attrs = attributes.buffer;
+	for (ssize_t i = 0; i < attributes.length; i++)
+		log_append(context, "attr:", attrs[i]);
+}
+
+static void log_close(lptr_t name, void *context)
+{
+	log_append(context, "close:", name);
+}
+
+static void log_text(lptr_t text, bool is_cdata, void *context)
+{
+	log_append(context, is_cdata ? "cdata:" : "text:", text);
+}
+
+static const handlers_t log_handlers = {
+	.element_handler = log_element,
+	.close_handler = log_close,
+	.text_handler = log_text,
+};
+
+void test_pipeline_order(void)
+{
+	const lptr_t xml = lit(
+		"<?xml version=\"1.0\"?>"
+		"<root a=\"1\" b='2'>"
+		"<child>text &amp; more</child>"
+		"<empty/>"
+		"<![CDATA[raw]]>"
+		"</root>"
+	);
+	const char *const expected =
+		"open:root;attr:a;attr:1;attr:b;attr:2;"
+		"open:child;text:text &amp; more;close:child;"
+		"empty:empty;"
+		"cdata:raw;"
+		"close:root;";
+
+	// tiny batches and a tiny queue, so we exercise the
+	// backpressure path as well as the happy one
+	const options_t options[] = {
+		{ 0 },
+		{ .batch_events = 1, .queue_batches = 1 },
+		{ .batch_events = 2, .queue_batches = 2 },
+	};
+
+	for (size_t i = 0; i < sizeof(options) / sizeof(options[0]); i++) {
+		static struct log log;
+		log = (struct log) { 0 };
+		stats_t stats;
+		lex_t result = descent_xml_pipeline_run(
+			lex(xml),
+			&options[i],
+			&log_handlers,
+			&log,
+			&stats
+		);
+		assert(result.type == eof);
+		assert(strcmp(log.buffer, expected) == 0);
+		assert(stats.lexer.events == 7);
+		assert(stats.handlers.events == 7);
+		assert(stats.lexer.batches == stats.handlers.batches);
+		assert(stats.lexer.bytes == (size_t)xml.length);
+		assert(stats.handlers.bytes == (size_t)xml.length);
+	}
+}
+
+void test_pipeline_error(void)
+{
+	static struct log log;
+	log = (struct log) { 0 };
+	lex_t result = descent_xml_pipeline_run(
+		lex(lit("<root><child></child><")),
+		NULL,
+		&log_handlers,
+		&log,
+		NULL
+	);
+	assert(result.type == err);
+	assert(strcmp(log.buffer, "open:root;open:child;close:child;") == 0);
+}
+
+static void count_element(lptr_t name, lptr_t attributes, bool empty, void *context)
+{
+	(void)name;
+	(void)empty;
+	atomic_size_t *const counts = context;
+	atomic_fetch_add(&counts[0], 1);
+	atomic_fetch_add(&counts[1], (size_t)attributes.length);
+}
+
+static void count_text(lptr_t text, bool is_cdata, void *context)
+{
+	(void)text;
+	(void)is_cdata;
+	atomic_size_t *const counts = context;
+	atomic_fetch_add(&counts[2], 1);
+}
+
+void test_pipeline_threads(void)
+{
+	static char xml[200000];
+	size_t length = (size_t)snprintf(xml, sizeof(xml), "<root>");
+	for (int i = 0; i < 1000; i++)
+		length += (size_t)snprintf(
+			xml + length,
+			sizeof(xml) - length,
+			"<item n=\"%d\">%d</item>",
+			i,
+			i
+		);
+
+	// more attributes than a batch holds by default
+	length += (size_t)snprintf(xml + length, sizeof(xml) - length, "<wide");
+	for (int i = 0; i < 1000; i++)
+		length += (size_t)snprintf(
+			xml + length,
+			sizeof(xml) - length,
+			" a%d='%d'",
+			i,
+			i
+		);
+	length += (size_t)snprintf(xml + length, sizeof(xml) - length, "/></root>");
+
+	const lptr_t script = { .buffer = xml, .size = 1, .length = (ssize_t)length };
+	const handlers_t handlers = {
+		.element_handler = count_element,
+		.text_handler = count_text,
+	};
+	const options_t options = { .handler_threads = 3, .batch_events = 16 };
+
+	atomic_size_t counts[3] = { 0 };
+	stats_t stats;
+	lex_t result = descent_xml_pipeline_run(
+		lex(script),
+		&options,
+		&handlers,
+		counts,
+		&stats
+	);
+	assert(result.type == eof);
+	assert(atomic_load(&counts[0]) == 1002);
+	assert(atomic_load(&counts[1]) == 1000 * 2 + 1000 * 2);
+	assert(atomic_load(&counts[2]) == 1000);
+	assert(stats.handlers.events == stats.lexer.events);
+	assert(stats.handlers.bytes == length);
+}
+
+int main()
+{
+	test_pipeline_order();
+	test_pipeline_error();
+	test_pipeline_threads();
+}
@@ -0,0 +1,246 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "descent-xml/read.h"
+
+#define SYNC DESCENT_XML_READ_SYNC
+
+typedef struct descent_xml_read_options options_t;
+
+static char script[100000];
+
+static int temp_file(const char *contents, size_t length)
+{
+	char name[] = "/tmp/descent_xml_readXXXXXX";
+	const int fd = mkstemp(name);
+	assert(fd >= 0);
+	unlink(name);
+	assert(write(fd, contents, length) == (ssize_t)length);
+	return fd;
+}
+
+static void fill_script(void)
+{
+	// something that isn't a multiple of any chunk size
+	// we use, and where misordered chunks would show
+	for (size_t i = 0; i < sizeof(script); i++)
+		script[i] = (char)('a' + (i * 7 + i / 13) % 26);
+}
+
+struct collect {
+	char buffer[sizeof(script)];
+	size_t length;
+	size_t chunks;
+	size_t stop_after;
+};
+
+static int collect_chunk(struct libadt_const_lptr chunk, void *context)
+{
+	struct collect *const collect = context;
+	assert(collect->length + (size_t)chunk.length <= sizeof(collect->buffer));
+	memcpy(collect->buffer + collect->length, chunk.buffer, (size_t)chunk.length);
+	collect->length += (size_t)chunk.length;
+	collect->chunks++;
+	return collect->stop_after && collect->chunks >= collect->stop_after;
+}
+
+void test_read_fd(void)
+{
+	const int fd = temp_file(script, sizeof(script));
+
+	const int flags[] = { 0, SYNC };
+	for (size_t i = 0; i < sizeof(flags) / sizeof(flags[0]); i++) {
+		const options_t options = { .chunk_size = 4096, .flags = flags[i] };
+		struct libadt_lptr result = descent_xml_read_fd(fd, &options);
+		assert(result.buffer);
+		assert(result.length == sizeof(script));
+		assert(memcmp(result.buffer, script, sizeof(script)) == 0);
+		free(result.buffer);
+	}
+
+	struct libadt_lptr result = descent_xml_read_fd(fd, NULL);
+	assert(result.buffer);
+	assert(result.length == sizeof(script));
+	free(result.buffer);
+
+	close(fd);
+}
+
+void test_read_chunks_in_order(void)
+{
+	const int fd = temp_file(script, sizeof(script));
+
+	const int flags[] = { 0, SYNC };
+	for (size_t i = 0; i < sizeof(flags) / sizeof(flags[0]); i++) {
+		const options_t options = {
+			.chunk_size = 333,
+			.queue_depth = 3,
+			.flags = flags[i],
+		};
+		static struct collect collect;
+		collect = (struct collect) { 0 };
+		assert(descent_xml_read_chunks(fd, &options, collect_chunk, &collect) == 0);
+		assert(collect.length == sizeof(script));
+		assert(collect.chunks == (sizeof(script) + 332) / 333);
+		assert(memcmp(collect.buffer, script, sizeof(script)) == 0);
+	}
+
+	close(fd);
+}
+
+void test_read_chunks_stop(void)
+{
+	const int fd = temp_file(script, sizeof(script));
+
+	const int flags[] = { 0, SYNC };
+	for (size_t i = 0; i < sizeof(flags) / sizeof(flags[0]); i++) {
+		const options_t options = {
+			.chunk_size = 1000,
+			.queue_depth = 4,
+			.flags = flags[i],
+		};
+		static struct collect collect;
+		collect = (struct collect) { .stop_after = 2 };
+		assert(descent_xml_read_chunks(fd, &options, collect_chunk, &collect) == 0);
+		assert(collect.chunks == 2);
+		assert(collect.length == 2000);
+		assert(memcmp(collect.buffer, script, 2000) == 0);
+	}
+
+	close(fd);
+}
+
+void test_read_empty(void)
+{
+	const int fd = temp_file("", 0);
+
+	struct libadt_lptr result = descent_xml_read_fd(fd, NULL);
+	assert(result.buffer);
+	assert(result.length == 0);
+	free(result.buffer);
+
+	static struct collect collect;
+	collect = (struct collect) { 0 };
+	assert(descent_xml_read_chunks(fd, NULL, collect_chunk, &collect) == 0);
+	assert(collect.chunks == 0);
+
+	close(fd);
+}
+
+void test_read_pipe(void)
+{
+	int fds[2];
+	assert(pipe(fds) == 0);
+	const char xml[] = "<root>text</root>";
+	assert(write(fds[1], xml, sizeof(xml) - 1) == sizeof(xml) - 1);
+	close(fds[1]);
+
+	struct libadt_lptr result = descent_xml_read_fd(fds[0], NULL);
+	assert(result.buffer);
+	assert(result.length == sizeof(xml) - 1);
+	assert(memcmp(result.buffer, xml, sizeof(xml) - 1) == 0);
+	free(result.buffer);
+
+	close(fds[0]);
+}
+
+static bool zeroes(const void *buffer, size_t length)
+{
+	const unsigned char *const bytes = buffer;
+	for (size_t i = 0; i < length; i++)
+		if (bytes[i])
+			return false;
+	return true;
+}
+
+void test_read_padded(void)
+{
+	const int fd = temp_file(script, sizeof(script));
+
+	const int flags[] = { DESCENT_XML_READ_PADDED, SYNC | DESCENT_XML_READ_PADDED };
+	for (size_t i = 0; i < sizeof(flags) / sizeof(flags[0]); i++) {
+		const options_t options = { .chunk_size = 4096, .flags = flags[i] };
+		struct libadt_lptr result = descent_xml_read_fd(fd, &options);
+		assert(result.buffer);
+		assert(result.length == sizeof(script));
+		assert(memcmp(result.buffer, script, sizeof(script)) == 0);
+		assert(zeroes((char *)result.buffer + sizeof(script), DESCENT_XML_PADDING));
+		free(result.buffer);
+	}
+	close(fd);
+
+	const int empty = temp_file("", 0);
+	const options_t options = { .flags = DESCENT_XML_READ_PADDED };
+	struct libadt_lptr result = descent_xml_read_fd(empty, &options);
+	assert(result.buffer);
+	assert(result.length == 0);
+	assert(zeroes(result.buffer, DESCENT_XML_PADDING));
+	free(result.buffer);
+	close(empty);
+}
+
+void test_read_map(void)
+{
+	const long page = sysconf(_SC_PAGESIZE);
+	// short of a page, a page exactly, and past a page by less than
+	// the padding
+	const size_t lengths[] = { 0, 17, (size_t)page - 1, (size_t)page, sizeof(script) };
+	for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+		const int fd = temp_file(script, lengths[i]);
+		struct descent_xml_read_mapping mapping;
+		assert(descent_xml_read_map(fd, &mapping) == 0);
+		close(fd);
+
+		assert(mapping.script.length == (ssize_t)lengths[i]);
+		assert(memcmp(mapping.script.buffer, script, lengths[i]) == 0);
+		assert(zeroes((const char *)mapping.script.buffer + lengths[i], DESCENT_XML_PADDING));
+		// the guard page is the last one
+		assert(mapping.size % (size_t)page == 0);
+		assert(mapping.size - (size_t)page >= lengths[i] + DESCENT_XML_PADDING);
+
+		descent_xml_read_unmap(&mapping);
+		assert(!mapping.base);
+	}
+
+	int fds[2];
+	assert(pipe(fds) == 0);
+	struct descent_xml_read_mapping mapping;
+	assert(descent_xml_read_map(fds[0], &mapping) == -1);
+	assert(errno == EINVAL);
+	close(fds[0]);
+	close(fds[1]);
+}
+
+int main()
+{
+	fill_script();
+	test_read_fd();
+	test_read_chunks_in_order();
+	test_read_chunks_stop();
+	test_read_empty();
+	test_read_pipe();
+	test_read_padded();
+	test_read_map();
+}
@@ -0,0 +1,124 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "descent-xml/stats.h"
+
+#include "pathological.h"
+
+// Quadratic growth over a 16x range in size would show as 2; this
+// leaves room for cache effects and a noisy machine.
+#define MAX_GROWTH 1.5
+
+// The bytes looked at don't depend on the machine, so only the fixed
+// cost of the prefix and suffix needs room.
+#define MAX_WORK_GROWTH 1.05
+
+// Aim for documents of 8 KiB up to 128 KiB.
+#define SMALL_SIZE 8192
+#define STEPS 4
+
+static size_t repeat_count(const struct pathological_input *input)
+{
+	const size_t unit = strlen(input->repeat)
+		+ (input->repeat_after ? strlen(input->repeat_after) : 0);
+	return SMALL_SIZE / unit + 1;
+}
+
+void test_generated_documents()
+{
+	for (size_t i = 0; i < pathological_input_count; i++) {
+		const struct pathological_input *const input
+			= &pathological_inputs[i];
+		size_t length;
+		char *const document = pathological_generate(input, 100, &length);
+		assert(document);
+		assert(length == strlen(document));
+
+		bool valid;
+		const size_t tokens = pathological_scan(document, length, &valid);
+		assert(tokens > 0);
+		if (valid != input->valid)
+			fprintf(stderr, "%s: expected %s\n", input->name, input->valid ? "valid" : "invalid");
+		assert(valid == input->valid);
+		free(document);
+	}
+}
+
+void test_linear_work()
+{
+	for (size_t i = 0; i < pathological_input_count; i++) {
+		const struct pathological_input *const input
+			= &pathological_inputs[i];
+		const double growth
+			= pathological_work_growth(input, repeat_count(input), STEPS);
+		assert(growth >= 0);
+		if (growth > MAX_WORK_GROWTH)
+			fprintf(stderr, "%s: work grows as size^%.2f\n", input->name, growth);
+		assert(growth <= MAX_WORK_GROWTH);
+	}
+}
+
+void test_linear_growth()
+{
+	for (size_t i = 0; i < pathological_input_count; i++) {
+		const struct pathological_input *const input
+			= &pathological_inputs[i];
+		const size_t count = repeat_count(input);
+
+		// a timing test can be unlucky, so only fail if it's
+		// superlinear three times running
+		double growth = 0;
+		for (int attempt = 0; attempt < 3; attempt++) {
+			growth = pathological_growth(input, count, STEPS, 5);
+			assert(growth >= 0);
+			if (growth <= MAX_GROWTH)
+				break;
+		}
+		if (growth > MAX_GROWTH)
+			fprintf(stderr, "%s: time grows as size^%.2f\n", input->name, growth);
+		assert(growth <= MAX_GROWTH);
+	}
+}
+
+// The timing check only runs when asked for with a "timing" argument,
+// which the DESCENT_XML_TIMING_TESTS option does, as it can fail on a
+// loaded machine.
+//
+// The work check needs the counters from descent-xml/stats.h, which
+// tests/CMakeLists.txt links in; without them, the test reports itself
+// skipped with exit status 77 rather than passing unchecked.
+int main(int argc, char **argv)
+{
+	if (argc > 1 && strcmp(argv[1], "timing") == 0) {
+		test_linear_growth();
+		return 0;
+	}
+
+	test_generated_documents();
+	if (!descent_xml_stats_enabled()) {
+		fprintf(stderr, "skipped: descent-xml was built without DESCENT_XML_STATS\n");
+		return 77;
+	}
+	test_linear_work();
+	return 0;
+}
@@ -0,0 +1,445 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "descent-xml/schema.h"
+#include "descent-xml/validate.h"
+
+#include <libadt/str.h>
+
+typedef struct descent_xml_lex lex_t;
+typedef struct libadt_const_lptr lptr_t;
+
+#define lex descent_xml_lex_init
+#define lit libadt_str_literal
+
+#define XSD(body) \
+	"<?xml version=\"1.0\"?>\n" \
+	"<xs:schema xmlns:xs=\"http://www.w3.org/2001/XMLSchema\">\n" \
+	body \
+	"</xs:schema>\n"
+
+static lptr_t str(const char *string)
+{
+	return (lptr_t) {
+		.buffer = string,
+		.size = 1,
+		.length = (ssize_t)strlen(string),
+	};
+}
+
+static struct descent_xml_schema *compile(const char *xsd)
+{
+	return descent_xml_schema_compile(str(xsd));
+}
+
+static bool valid(const struct descent_xml_schema *schema, const char *document)
+{
+	return descent_xml_schema_validate_document(schema, lex(str(document)));
+}
+
+void test_compile(void)
+{
+	{
+		struct descent_xml_schema *schema = compile(XSD(
+			"<xs:element name=\"note\" type=\"xs:string\"/>\n"
+		));
+		assert(schema);
+		assert(valid(schema, "<note>anything &amp; more</note>"));
+		assert(valid(schema, "<note/>"));
+		assert(!valid(schema, "<other/>"));
+		assert(!valid(schema, "<note><b/></note>"));
+		assert(!valid(schema, "<note>not well-formed</other>"));
+		assert(!valid(schema, "<note kind=\"x\"/>"));
+		assert(valid(schema, "<note xmlns=\"urn:x\" xsi:nil=\"false\"/>"));
+		descent_xml_schema_free(schema);
+	}
+
+	// malformed, or outside the subset
+	assert(!compile("<xs:schema>"));
+	assert(!compile("<notaschema/>"));
+	assert(!compile(XSD("<xs:element name=\"a\" type=\"undeclared\"/>")));
+	assert(!compile(XSD("<xs:group name=\"g\"/>")));
+	assert(!compile(XSD(
+		"<xs:complexType name=\"t\"><xs:sequence><xs:any/></xs:sequence></xs:complexType>"
+	)));
+	assert(!compile(XSD(
+		"<xs:simpleType name=\"t\"><xs:union memberTypes=\"xs:int xs:date\"/></xs:simpleType>"
+	)));
+	assert(!compile(XSD(
+		"<xs:simpleType name=\"t\">"
+		"<xs:restriction base=\"xs:string\"><xs:totalDigits value=\"3\"/></xs:restriction>"
+		"</xs:simpleType>"
+	)));
+	assert(!compile(XSD(
+		"<xs:simpleType name=\"t\">"
+		"<xs:restriction base=\"xs:string\"><xs:minInclusive value=\"3\"/></xs:restriction>"
+		"</xs:simpleType>"
+	)));
+	assert(!compile(XSD(
+		"<xs:simpleType name=\"a\"><xs:restriction base=\"b\"/></xs:simpleType>"
+		"<xs:simpleType name=\"b\"><xs:restriction base=\"a\"/></xs:simpleType>"
+	)));
+	// not deterministic: which b is this?
+	assert(!compile(XSD(
+		"<xs:element name=\"a\"><xs:complexType><xs:choice>"
+		"<xs:sequence><xs:element name=\"b\"/><xs:element name=\"c\"/></xs:sequence>"
+		"<xs:sequence><xs:element name=\"b\" type=\"xs:int\"/></xs:sequence>"
+		"</xs:choice></xs:complexType></xs:element>"
+	)));
+	assert(!compile(XSD(
+		"<xs:element name=\"a\"><xs:complexType><xs:sequence>"
+		"<xs:element name=\"b\" maxOccurs=\"1000000\"/>"
+		"</xs:sequence></xs:complexType></xs:element>"
+	)));
+}
+
+void test_content_models(void)
+{
+	struct descent_xml_schema *schema = compile(XSD(
+		"<xs:element name=\"order\">\n"
+		"  <xs:complexType>\n"
+		"    <xs:sequence>\n"
+		"      <xs:element name=\"id\" type=\"xs:positiveInteger\"/>\n"
+		"      <xs:choice>\n"
+		"        <xs:element name=\"person\" type=\"xs:string\"/>\n"
+		"        <xs:element name=\"company\" type=\"xs:string\"/>\n"
+		"      </xs:choice>\n"
+		"      <xs:element ref=\"item\" minOccurs=\"1\" maxOccurs=\"unbounded\"/>\n"
+		"      <xs:element name=\"note\" type=\"xs:string\" minOccurs=\"0\" maxOccurs=\"2\"/>\n"
+		"      <xs:element name=\"address\" type=\"address\" minOccurs=\"0\"/>\n"
+		"    </xs:sequence>\n"
+		"  </xs:complexType>\n"
+		"</xs:element>\n"
+		"<xs:element name=\"item\" type=\"xs:string\"/>\n"
+		"<xs:complexType name=\"address\">\n"
+		"  <xs:all>\n"
+		"    <xs:element name=\"street\" type=\"xs:string\"/>\n"
+		"    <xs:element name=\"city\" type=\"xs:string\"/>\n"
+		"    <xs:element name=\"zip\" type=\"xs:string\" minOccurs=\"0\"/>\n"
+		"  </xs:all>\n"
+		"</xs:complexType>\n"
+	));
+	assert(schema);
+
+	assert(valid(schema,
+		"<order>\n"
+		"  <id>7</id>\n"
+		"  <person>Ann</person>\n"
+		"  <item>a</item>\n"
+		"</order>"
+	));
+	assert(valid(schema,
+		"<order><id>7</id><company>Acme</company><item/><item/><item/>"
+		"<note>x</note><note>y</note></order>"
+	));
+	assert(valid(schema,
+		"<order><id>7</id><company>Acme</company><item/>"
+		"<address><city>Oslo</city><street>Main</street></address></order>"
+	));
+	assert(valid(schema,
+		"<order><id>7</id><company>Acme</company><item/>"
+		"<address><zip>1</zip><street>Main</street><city>Oslo</city></address></order>"
+	));
+
+	// the item is missing
+	assert(!valid(schema, "<order><id>7</id><person>Ann</person></order>"));
+	// both sides of the choice
+	assert(!valid(schema,
+		"<order><id>7</id><person>Ann</person><company>Acme</company><item/></order>"
+	));
+	// out of order
+	assert(!valid(schema, "<order><person>Ann</person><id>7</id><item/></order>"));
+	// too many notes
+	assert(!valid(schema,
+		"<order><id>7</id><person>Ann</person><item/>"
+		"<note/><note/><note/></order>"
+	));
+	// text in element-only content
+	assert(!valid(schema, "<order>text<id>7</id><person>Ann</person><item/></order>"));
+	// only global elements can be the root
+	assert(!valid(schema, "<id>7</id>"));
+	assert(valid(schema, "<item>alone</item>"));
+	// all: missing a required member, or repeating one
+	assert(!valid(schema,
+		"<order><id>7</id><person>Ann</person><item/>"
+		"<address><city>Oslo</city></address></order>"
+	));
+	assert(!valid(schema,
+		"<order><id>7</id><person>Ann</person><item/>"
+		"<address><city>Oslo</city><street>a</street><city>Oslo</city></address></order>"
+	));
+	// the id's type still applies
+	assert(!valid(schema, "<order><id>0</id><person>Ann</person><item/></order>"));
+
+	descent_xml_schema_free(schema);
+}
+
+void test_recursive(void)
+{
+	struct descent_xml_schema *schema = compile(XSD(
+		"<xs:element name=\"tree\" type=\"node\"/>\n"
+		"<xs:complexType name=\"node\" mixed=\"true\">\n"
+		"  <xs:sequence>\n"
+		"    <xs:element name=\"node\" type=\"node\" minOccurs=\"0\" maxOccurs=\"unbounded\"/>\n"
+		"  </xs:sequence>\n"
+		"  <xs:attribute name=\"id\" type=\"xs:ID\" use=\"required\"/>\n"
+		"</xs:complexType>\n"
+	));
+	assert(schema);
+	assert(valid(schema,
+		"<tree id=\"r\">root<node id=\"a\">a<node id=\"b\"/></node><node id=\"c\"/></tree>"
+	));
+	assert(!valid(schema, "<tree id=\"r\"><node/></tree>"));
+	assert(!valid(schema, "<tree id=\"r\"><leaf id=\"x\"/></tree>"));
+	descent_xml_schema_free(schema);
+}
+
+void test_simple_types(void)
+{
+	struct descent_xml_schema *schema = compile(XSD(
+		"<xs:element name=\"v\">\n"
+		"  <xs:complexType><xs:choice maxOccurs=\"unbounded\">\n"
+		"    <xs:element name=\"int\" type=\"xs:int\"/>\n"
+		"    <xs:element name=\"byte\" type=\"xs:byte\"/>\n"
+		"    <xs:element name=\"decimal\" type=\"xs:decimal\"/>\n"
+		"    <xs:element name=\"double\" type=\"xs:double\"/>\n"
+		"    <xs:element name=\"bool\" type=\"xs:boolean\"/>\n"
+		"    <xs:element name=\"date\" type=\"xs:date\"/>\n"
+		"    <xs:element name=\"dateTime\" type=\"xs:dateTime\"/>\n"
+		"    <xs:element name=\"name\" type=\"xs:NCName\"/>\n"
+		"    <xs:element name=\"percent\" type=\"percent\"/>\n"
+		"    <xs:element name=\"code\" type=\"code\"/>\n"
+		"    <xs:element name=\"color\" type=\"color\"/>\n"
+		"    <xs:element name=\"short\" type=\"short\"/>\n"
+		"    <xs:element name=\"sizes\" type=\"sizes\"/>\n"
+		"    <xs:element name=\"pair\" type=\"pair\"/>\n"
+		"  </xs:choice></xs:complexType>\n"
+		"</xs:element>\n"
+		"<xs:simpleType name=\"percent\">\n"
+		"  <xs:restriction base=\"xs:decimal\">\n"
+		"    <xs:minInclusive value=\"0\"/>\n"
+		"    <xs:maxExclusive value=\"100\"/>\n"
+		"  </xs:restriction>\n"
+		"</xs:simpleType>\n"
+		"<xs:simpleType name=\"code\">\n"
+		"  <xs:restriction base=\"xs:token\">\n"
+		"    <xs:pattern value=\"[A-Z]{2}-\\d{3}\"/>\n"
+		"    <xs:pattern value=\"X\\.\\w+\"/>\n"
+		"  </xs:restriction>\n"
+		"</xs:simpleType>\n"
+		"<xs:simpleType name=\"color\">\n"
+		"  <xs:restriction base=\"xs:string\">\n"
+		"    <xs:enumeration value=\"red\"/>\n"
+		"    <xs:enumeration value=\"green\"/>\n"
+		"  </xs:restriction>\n"
+		"</xs:simpleType>\n"
+		"<xs:simpleType name=\"short\">\n"
+		"  <xs:restriction base=\"xs:string\">\n"
+		"    <xs:minLength value=\"2\"/>\n"
+		"    <xs:maxLength value=\"3\"/>\n"
+		"  </xs:restriction>\n"
+		"</xs:simpleType>\n"
+		"<xs:simpleType name=\"sizes\">\n"
+		"  <xs:list itemType=\"xs:unsignedByte\"/>\n"
+		"</xs:simpleType>\n"
+		"<xs:simpleType name=\"pair\">\n"
+		"  <xs:restriction base=\"sizes\"><xs:length value=\"2\"/></xs:restriction>\n"
+		"</xs:simpleType>\n"
+	));
+	assert(schema);
+
+	const struct {
+		const char *document;
+		bool valid;
+	} cases[] = {
+		{ "<v><int> -2147483648 </int></v>", true },
+		{ "<v><int>2147483648</int></v>", false },
+		{ "<v><int>1.5</int></v>", false },
+		{ "<v><int></int></v>", false },
+		{ "<v><byte>-128</byte><byte>127</byte></v>", true },
+		{ "<v><byte>128</byte></v>", false },
+		{ "<v><decimal>-.5</decimal><decimal>+12.</decimal></v>", true },
+		{ "<v><decimal>1e3</decimal></v>", false },
+		{ "<v><double>1e3</double><double>-INF</double><double>NaN</double></v>", true },
+		{ "<v><double>e3</double></v>", false },
+		{ "<v><bool>true</bool><bool>0</bool></v>", true },
+		{ "<v><bool>yes</bool></v>", false },
+		{ "<v><date>2024-02-29</date><date>2025-01-31Z</date></v>", true },
+		{ "<v><date>2023-02-29</date></v>", false },
+		{ "<v><date>2023-13-01</date></v>", false },
+		{ "<v><dateTime>2025-01-31T23:59:59.5+01:00</dateTime></v>", true },
+		{ "<v><dateTime>2025-01-31 23:59:59</dateTime></v>", false },
+		{ "<v><name>a-b.c</name></v>", true },
+		{ "<v><name>a:b</name></v>", false },
+		{ "<v><name>1a</name></v>", false },
+		{ "<v><percent>0</percent><percent>99.99</percent></v>", true },
+		{ "<v><percent>100</percent></v>", false },
+		{ "<v><percent>-1</percent></v>", false },
+		{ "<v><code> AB-123 </code><code>X.a_1</code></v>", true },
+		{ "<v><code>AB-12</code></v>", false },
+		{ "<v><code>xAB-123</code></v>", false },
+		{ "<v><code>X.</code></v>", false },
+		{ "<v><color>red</color><color><![CDATA[green]]></color></v>", true },
+		{ "<v><color>blue</color></v>", false },
+		{ "<v><color> red</color></v>", false },
+		{ "<v><short>ab</short><short>&#xe9;&#233;&lt;</short></v>", true },
+		{ "<v><short>a</short></v>", false },
+		{ "<v><short>abcd</short></v>", false },
+		{ "<v><short>&unknown;</short></v>", false },
+		{ "<v><sizes> 1  2 255 </sizes><sizes/></v>", true },
+		{ "<v><sizes>1 256</sizes></v>", false },
+		{ "<v><pair>1 2</pair></v>", true },
+		{ "<v><pair>1 2 3</pair></v>", false },
+		{ "<v><pair>1 x</pair></v>", false },
+	};
+	for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+		assert(valid(schema, cases[i].document) == cases[i].valid);
+
+	descent_xml_schema_free(schema);
+}
+
+void test_attributes(void)
+{
+	struct descent_xml_schema *schema = compile(XSD(
+		"<xs:element name=\"price\">\n"
+		"  <xs:complexType>\n"
+		"    <xs:simpleContent>\n"
+		"      <xs:extension base=\"xs:decimal\">\n"
+		"        <xs:attribute name=\"currency\" use=\"required\">\n"
+		"          <xs:simpleType>\n"
+		"            <xs:restriction base=\"xs:string\">\n"
+		"              <xs:pattern value=\"[A-Z]{3}\"/>\n"
+		"            </xs:restriction>\n"
+		"          </xs:simpleType>\n"
+		"        </xs:attribute>\n"
+		"        <xs:attribute name=\"version\" type=\"xs:int\" fixed=\"2\"/>\n"
+		"        <xs:attribute name=\"note\" type=\"xs:string\"/>\n"
+		"      </xs:extension>\n"
+		"    </xs:simpleContent>\n"
+		"  </xs:complexType>\n"
+		"</xs:element>\n"
+	));
+	assert(schema);
+
+	assert(valid(schema, "<price currency=\"EUR\">9.99</price>"));
+	assert(valid(schema, "<p:price xmlns:p=\"urn:p\" currency=\"EUR\" version=\"2\">1</p:price>"));
+	assert(valid(schema, "<price currency=\"EUR\" note=\"a &amp; b\">1</price>"));
+	assert(!valid(schema, "<price>9.99</price>"));
+	assert(!valid(schema, "<price currency=\"euro\">9.99</price>"));
+	assert(!valid(schema, "<price currency=\"EUR\" version=\"3\">9.99</price>"));
+	assert(!valid(schema, "<price currency=\"EUR\" other=\"x\">9.99</price>"));
+	assert(!valid(schema, "<price currency=\"EUR\">cheap</price>"));
+	assert(!valid(schema, "<price currency=\"EUR\"><b/></price>"));
+
+	descent_xml_schema_free(schema);
+}
+
+void test_load(void)
+{
+	char path[] = "/tmp/descent_xml_schema_XXXXXX";
+	const int fd = mkstemp(path);
+	assert(fd >= 0);
+	const char xsd[] = XSD("<xs:element name=\"a\" type=\"xs:int\"/>");
+	assert(write(fd, xsd, sizeof(xsd) - 1) == (ssize_t)(sizeof(xsd) - 1));
+	close(fd);
+
+	struct descent_xml_schema *schema = descent_xml_schema_load(path);
+	unlink(path);
+	assert(schema);
+	assert(valid(schema, "<a>1</a>"));
+	assert(!valid(schema, "<a>a</a>"));
+	descent_xml_schema_free(schema);
+
+	assert(!descent_xml_schema_load("/nonexistent/schema.xsd"));
+}
+
+static int element_count;
+
+static lex_t count_element(
+	lex_t token,
+	lptr_t name,
+	lptr_t attributes,
+	bool empty,
+	void *context
+)
+{
+	(void)name;
+	(void)attributes;
+	(void)empty;
+	(void)context;
+	element_count++;
+	return token;
+}
+
+void test_fused(void)
+{
+	struct descent_xml_schema *schema = compile(XSD(
+		"<xs:element name=\"list\"><xs:complexType><xs:sequence>"
+		"<xs:element name=\"n\" type=\"xs:int\" maxOccurs=\"unbounded\"/>"
+		"</xs:sequence></xs:complexType></xs:element>"
+	));
+	assert(schema);
+
+	// the same schema, and so validator, is reused for every
+	// document
+	for (int round = 0; round < 3; round++) {
+		struct descent_xml_schema_validator schema_validator
+			= descent_xml_schema_validator_init(schema);
+		struct descent_xml_validator validator = descent_xml_validator_init(-1);
+		validator.schema = &schema_validator;
+
+		element_count = 0;
+		lex_t token = lex(lit("<list><n>1</n><n>2</n><n>x</n><n>4</n></list>"));
+		while (!_descent_xml_end_token(token) && token.type != descent_xml_validate_error)
+			token = descent_xml_parse_validated(
+				token,
+				&validator,
+				count_element,
+				NULL,
+				NULL
+			);
+
+		// the closing tag of the third n is where it fails
+		assert(token.type == descent_xml_validate_error);
+		assert(element_count == 4);
+
+		descent_xml_validator_free(&validator);
+		descent_xml_schema_validator_free(&schema_validator);
+	}
+
+	descent_xml_schema_free(schema);
+}
+
+int main()
+{
+	test_compile();
+	test_content_models();
+	test_recursive();
+	test_simple_types();
+	test_attributes();
+	test_load();
+	test_fused();
+	return 0;
+}
@@ -0,0 +1,103 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <assert.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "descent-xml/parse.h"
+#include "descent-xml/stats.h"
+
+#include <libadt/str.h>
+
+#define lit libadt_str_literal
+
+static struct descent_xml_lex ignore_element(
+	struct descent_xml_lex token,
+	char *element_name,
+	char **attributes,
+	bool empty,
+	void *context
+)
+{
+	(void)element_name;
+	(void)attributes;
+	(void)empty;
+	(void)context;
+	return token;
+}
+
+static void parse_cstr(struct libadt_const_lptr script)
+{
+	struct descent_xml_lex token = descent_xml_lex_init(script);
+	while (token.type != descent_xml_classifier_eof) {
+		assert(token.type != descent_xml_classifier_unexpected);
+		token = descent_xml_parse_cstr(token, ignore_element, NULL, NULL);
+	}
+}
+
+void test_names()
+{
+	assert(strcmp(descent_xml_stats_type_name(0), "other") == 0);
+	const size_t slot = descent_xml_stats_type_slot(descent_xml_classifier_element_name);
+	assert(slot > 0);
+	assert(strcmp(descent_xml_stats_type_name(slot), "descent_xml_classifier_element_name") == 0);
+	assert(descent_xml_stats_type_slot(descent_xml_classifier_eof) != slot);
+	assert(!descent_xml_stats_type_name(DESCENT_XML_STATS_TYPES));
+}
+
+void test_counts()
+{
+	descent_xml_stats_reset();
+	parse_cstr(lit("<?xml version=\"1.0\"?><a b=\"1\" c=\"2\" d=\"3\" e=\"4\" f=\"5\"><!-- c --></a>"));
+	const struct descent_xml_stats stats = descent_xml_stats_get();
+
+	if (!descent_xml_stats_enabled()) {
+		const struct descent_xml_stats zero = { 0 };
+		assert(memcmp(&stats, &zero, sizeof(stats)) == 0);
+		return;
+	}
+
+	const size_t names = descent_xml_stats_type_slot(descent_xml_classifier_element_name);
+	const size_t comments = descent_xml_stats_type_slot(descent_xml_lex_comment);
+	assert(stats.tokens[names] == 1);
+	assert(stats.token_bytes[names] == 1);
+	assert(stats.tokens[comments] == 1);
+	assert(stats.mbrtowc_calls > 0);
+	assert(stats.decoded_bytes > 0);
+	// at least the comment's body is scanned for its end
+	assert(stats.compared_bytes >= sizeof(" c ") - 1);
+	// five names and values grow the vector from nothing, a few
+	// times depending on libadt's growth policy
+	assert(stats.vector_allocations > 0 && stats.vector_allocations <= 10);
+	// the element name, and five names and values
+	assert(stats.strndup_calls == 11);
+	// the prolog and comment are only found after trying the other
+	// alternatives first
+	assert(stats.or_backtracks + stats.optional_backtracks > 0);
+
+	descent_xml_stats_reset();
+	const struct descent_xml_stats reset = descent_xml_stats_get();
+	assert(reset.tokens[names] == 0 && reset.mbrtowc_calls == 0);
+}
+
+int main()
+{
+	test_names();
+	test_counts();
+	return 0;
+}
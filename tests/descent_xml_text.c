@@ -0,0 +1,583 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <locale.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "descent-xml/text.h"
+
+#include <libadt/str.h>
+
+typedef struct libadt_const_lptr lptr_t;
+
+#define lit libadt_str_literal
+
+static inline bool lptr_is(lptr_t value, const char *expected)
+{
+	return value.length == (ssize_t)strlen(expected)
+		&& memcmp(value.buffer, expected, (size_t)value.length) == 0;
+}
+
+#define MAX_NODES 16
+
+struct collected {
+	char *text[MAX_NODES];
+	bool is_cdata[MAX_NODES];
+	bool in_document[MAX_NODES];
+	size_t count;
+	lptr_t document;
+	struct descent_xml_text *state;
+};
+
+static void collect_text(lptr_t text, bool is_cdata, void *context)
+{
+	struct collected *const collected = context;
+	assert(collected->count < MAX_NODES);
+	const size_t i = collected->count++;
+	collected->text[i] = strndup(text.buffer, (size_t)text.length);
+	collected->is_cdata[i] = is_cdata;
+	const char *const start = collected->document.buffer;
+	collected->in_document[i] = (const char *)text.buffer >= start
+		&& (const char *)text.buffer < start + collected->document.length;
+}
+
+static struct descent_xml_lex collect_element(
+	struct descent_xml_lex token,
+	lptr_t name,
+	lptr_t attributes,
+	bool empty,
+	void *context
+)
+{
+	(void)name;
+	(void)attributes;
+	struct collected *const collected = context;
+	if (empty)
+		return token;
+	do {
+		token = descent_xml_parse_coalesced(
+			token,
+			collected->state,
+			collect_element,
+			collect_text,
+			context
+		);
+	} while (
+		token.type != descent_xml_classifier_element_close_name
+		&& !_descent_xml_end_token(token)
+		&& token.type != descent_xml_classifier_unexpected
+	);
+	return token;
+}
+
+static struct descent_xml_lex parse_all(
+	const char *document,
+	unsigned flags,
+	struct collected *collected
+)
+{
+	struct descent_xml_text text;
+	descent_xml_text_init(&text, flags, NULL);
+	*collected = (struct collected) {
+		.document = libadt_str_literal(document),
+		.state = &text,
+	};
+	collected->document.length = (ssize_t)strlen(document);
+
+	struct descent_xml_lex token = descent_xml_lex_init(collected->document);
+	do {
+		token = descent_xml_parse_coalesced(
+			token,
+			&text,
+			collect_element,
+			collect_text,
+			collected
+		);
+	} while (
+		!_descent_xml_end_token(token)
+		&& token.type != descent_xml_classifier_unexpected
+	);
+	descent_xml_text_free(&text);
+	return token;
+}
+
+static void collected_free(struct collected *collected)
+{
+	for (size_t i = 0; i < collected->count; i++)
+		free(collected->text[i]);
+}
+
+void test_single_piece()
+{
+	struct collected collected;
+	const struct descent_xml_lex token = parse_all(
+		"<a>plain text</a><b><![CDATA[<raw>]]></b>",
+		0,
+		&collected
+	);
+	assert(token.type == descent_xml_classifier_eof);
+	assert(collected.count == 2);
+
+	// one piece is passed straight from the document
+	assert(!strcmp(collected.text[0], "plain text"));
+	assert(!collected.is_cdata[0]);
+	assert(collected.in_document[0]);
+	assert(!strcmp(collected.text[1], "<raw>"));
+	assert(collected.is_cdata[1]);
+	assert(collected.in_document[1]);
+	collected_free(&collected);
+}
+
+void test_joined()
+{
+	struct collected collected;
+	const struct descent_xml_lex token = parse_all(
+		"<a>one <![CDATA[<two>]]> three<!-- skipped --> four</a>"
+		"<b><![CDATA[x]]><![CDATA[y]]></b>",
+		0,
+		&collected
+	);
+	assert(token.type == descent_xml_classifier_eof);
+	assert(collected.count == 2);
+
+	assert(!strcmp(collected.text[0], "one <two> three four"));
+	assert(!collected.is_cdata[0]);
+	assert(!collected.in_document[0]);
+
+	assert(!strcmp(collected.text[1], "xy"));
+	assert(collected.is_cdata[1]);
+	collected_free(&collected);
+}
+
+void test_decode()
+{
+	struct collected collected;
+	const struct descent_xml_lex token = parse_all(
+		"<a>1 &lt; 2 &amp;&amp; &quot;q&apos; &#65;&#x42;&#xe9;&#x1F600;</a>"
+		"<b>&unknown; &#0; &#xd800; &#12a; &#x; &lt;<![CDATA[&lt;]]></b>"
+		"<c>no references</c>",
+		DESCENT_XML_TEXT_DECODE,
+		&collected
+	);
+	assert(token.type == descent_xml_classifier_eof);
+	assert(collected.count == 3);
+
+	assert(!strcmp(collected.text[0], "1 < 2 && \"q' AB\xc3\xa9\xf0\x9f\x98\x80"));
+	assert(!collected.in_document[0]);
+
+	// unknown and malformed references are left alone, as is CDATA
+	assert(!strcmp(
+		collected.text[1],
+		"&unknown; &#0; &#xd800; &#12a; &#x; <&lt;"
+	));
+	assert(!collected.is_cdata[1]);
+
+	// and text with nothing to replace isn't copied
+	assert(!strcmp(collected.text[2], "no references"));
+	assert(collected.in_document[2]);
+	collected_free(&collected);
+
+	// without the flag, references pass through
+	parse_all("<a>&lt;<![CDATA[x]]></a>", 0, &collected);
+	assert(collected.count == 1);
+	assert(!strcmp(collected.text[0], "&lt;x"));
+	collected_free(&collected);
+
+	// references too long to be worth looking for the end of are
+	// left alone too
+	parse_all("<a>&#x0000000000041;&#x000000000041;</a>", DESCENT_XML_TEXT_DECODE, &collected);
+	assert(!strcmp(collected.text[0], "&#x0000000000041;A"));
+	collected_free(&collected);
+}
+
+// the first text or CDATA token in document
+static struct descent_xml_lex first_text(lptr_t document)
+{
+	struct descent_xml_lex token = descent_xml_lex_init(document);
+	do
+		token = descent_xml_lex_next_raw(token);
+	while (
+		!_descent_xml_is_text_type(token)
+		&& token.type != descent_xml_lex_cdata
+	);
+	return token;
+}
+
+void test_skip_space()
+{
+	static const char document[] =
+		"<feed>\n"
+		"  <item>one</item>\n"
+		"  <!-- between -->\n"
+		"  <item>  </item>\n"
+		"  <item><![CDATA[ ]]></item>\n"
+		"  <item> two <!-- c --> </item>\n"
+		"</feed>\n";
+
+	struct collected collected;
+	parse_all(document, 0, &collected);
+	assert(collected.count == 10);
+	collected_free(&collected);
+
+	const struct descent_xml_lex token
+		= parse_all(document, DESCENT_XML_TEXT_SKIP_SPACE, &collected);
+	assert(token.type == descent_xml_classifier_eof);
+	// whitespace in CDATA, or around other text, is kept
+	assert(collected.count == 3);
+	assert(!strcmp(collected.text[0], "one"));
+	assert(!strcmp(collected.text[1], " "));
+	assert(collected.is_cdata[1]);
+	assert(!strcmp(collected.text[2], " two  "));
+	collected_free(&collected);
+}
+
+void test_read()
+{
+	// descent_xml_text_read() stops on the last token of the node
+	struct descent_xml_text text;
+	descent_xml_text_init(&text, 0, NULL);
+
+	const struct descent_xml_lex first
+		= first_text(lit("<r>a<![CDATA[b]]>c<d/></r>"));
+	lptr_t value;
+	bool is_cdata;
+	const struct descent_xml_lex last
+		= descent_xml_text_read(first, &text, &value, &is_cdata);
+	assert(lptr_is(value, "abc"));
+	assert(!is_cdata);
+	assert(descent_xml_lex_next_raw(last).type
+		== descent_xml_classifier_element);
+
+	// the buffer is reused for the next node
+	const void *const buffer = text.buffer.buffer;
+	descent_xml_text_read(first, &text, &value, &is_cdata);
+	assert(lptr_is(value, "abc"));
+	assert(text.buffer.buffer == buffer);
+
+	descent_xml_text_free(&text);
+	assert(text.buffer.buffer == NULL);
+}
+
+// Joins the chunks of each node, checking their flags and sizes.
+struct joined {
+	char *text[MAX_NODES];
+	size_t count;
+	size_t chunks;
+	size_t largest;
+	bool cdata_chunks;
+	bool split_character;
+	bool open;
+	size_t chunk_size;
+	struct descent_xml_text *state;
+};
+
+static void join_chunk(lptr_t chunk, unsigned position, bool is_cdata, void *context)
+{
+	struct joined *const joined = context;
+	assert(!(position & DESCENT_XML_TEXT_CHUNK_BEGIN) == joined->open);
+	if (position & DESCENT_XML_TEXT_CHUNK_BEGIN) {
+		assert(joined->count < MAX_NODES);
+		joined->text[joined->count++] = calloc(1, 1);
+		joined->open = true;
+	}
+	char **const text = &joined->text[joined->count - 1];
+	const size_t length = strlen(*text);
+	*text = realloc(*text, length + (size_t)chunk.length + 1);
+	memcpy(*text + length, chunk.buffer, (size_t)chunk.length);
+	(*text)[length + (size_t)chunk.length] = '\0';
+
+	joined->chunks++;
+	if ((size_t)chunk.length > joined->largest)
+		joined->largest = (size_t)chunk.length;
+	joined->cdata_chunks |= is_cdata;
+	if (chunk.length && (*(const unsigned char *)chunk.buffer & 0xc0) == 0x80)
+		joined->split_character = true;
+	if (position & DESCENT_XML_TEXT_CHUNK_END)
+		joined->open = false;
+}
+
+static struct descent_xml_lex join_element(
+	struct descent_xml_lex token,
+	lptr_t name,
+	lptr_t attributes,
+	bool empty,
+	void *context
+)
+{
+	(void)name;
+	(void)attributes;
+	struct joined *const joined = context;
+	if (empty)
+		return token;
+	do {
+		token = descent_xml_parse_chunked(
+			token,
+			joined->state,
+			join_element,
+			join_chunk,
+			context
+		);
+	} while (
+		token.type != descent_xml_classifier_element_close_name
+		&& !_descent_xml_end_token(token)
+		&& token.type != descent_xml_classifier_unexpected
+	);
+	return token;
+}
+
+static struct descent_xml_lex parse_chunked(
+	const char *document,
+	unsigned flags,
+	size_t chunk_size,
+	struct joined *joined
+)
+{
+	struct descent_xml_text text;
+	descent_xml_text_init(&text, flags, NULL);
+	text.chunk_size = chunk_size;
+	*joined = (struct joined) {
+		.chunk_size = chunk_size,
+		.state = &text,
+	};
+
+	lptr_t script = lit("");
+	script.buffer = document;
+	script.length = (ssize_t)strlen(document);
+	struct descent_xml_lex token = descent_xml_lex_init(script);
+	do {
+		token = descent_xml_parse_chunked(
+			token,
+			&text,
+			join_element,
+			join_chunk,
+			joined
+		);
+	} while (
+		!_descent_xml_end_token(token)
+		&& token.type != descent_xml_classifier_unexpected
+	);
+	descent_xml_text_free(&text);
+	assert(!joined->open);
+	return token;
+}
+
+static void joined_free(struct joined *joined)
+{
+	for (size_t i = 0; i < joined->count; i++)
+		free(joined->text[i]);
+}
+
+static char *repeat(const char *prefix, const char *piece, size_t times, const char *suffix)
+{
+	const size_t length = strlen(piece);
+	char *const result = malloc(strlen(prefix) + length * times + strlen(suffix) + 1);
+	strcpy(result, prefix);
+	char *at = result + strlen(prefix);
+	for (size_t i = 0; i < times; i++, at += length)
+		memcpy(at, piece, length);
+	strcpy(at, suffix);
+	return result;
+}
+
+void test_chunks()
+{
+	struct joined joined;
+
+	// a small node is one chunk, both beginning and end
+	struct descent_xml_lex token = parse_chunked("<a>small</a>", 0, 4096, &joined);
+	assert(token.type == descent_xml_classifier_eof);
+	assert(joined.count == 1 && joined.chunks == 1);
+	assert(!strcmp(joined.text[0], "small"));
+	joined_free(&joined);
+
+	// a large payload comes in bounded chunks
+	char *const payload = repeat("<data>", "QUJDRA==", 64 * 1024, "</data>");
+	token = parse_chunked(payload, 0, 4096, &joined);
+	assert(token.type == descent_xml_classifier_eof);
+	assert(joined.count == 1);
+	assert(joined.chunks == 8 * 64 * 1024 / 4096);
+	assert(joined.largest == 4096);
+	assert(strlen(joined.text[0]) == 8 * 64 * 1024);
+	assert(!strncmp(joined.text[0], payload + strlen("<data>"), 8 * 64 * 1024));
+	joined_free(&joined);
+	free(payload);
+
+	// pieces come in order, with CDATA marked and comments left out
+	token = parse_chunked(
+		"<a>one <![CDATA[<two>]]> three<!-- skipped --> four</a>"
+		"<b><![CDATA[]]></b>",
+		0,
+		16,
+		&joined
+	);
+	assert(token.type == descent_xml_classifier_eof);
+	assert(joined.count == 2);
+	assert(!strcmp(joined.text[0], "one <two> three four"));
+	assert(joined.cdata_chunks);
+	// an empty node is still passed on
+	assert(!strcmp(joined.text[1], ""));
+	joined_free(&joined);
+
+	// in UTF-8, characters aren't split
+	if (setlocale(LC_CTYPE, "C.UTF-8")) {
+		char *const accents = repeat("<a>", "\xc3\xa9", 1000, "</a>");
+		parse_chunked(accents, 0, 17, &joined);
+		assert(joined.count == 1);
+		assert(strlen(joined.text[0]) == 2000);
+		assert(!joined.split_character);
+		assert(joined.largest <= 17);
+		joined_free(&joined);
+		free(accents);
+		setlocale(LC_CTYPE, "C");
+	}
+}
+
+void test_chunks_decode()
+{
+	struct joined joined;
+
+	// references aren't cut in two, whatever the alignment
+	char *const references = repeat("<a>x", "a&amp;&#x1F600;", 200, "</a>");
+	for (size_t chunk_size = 16; chunk_size < 40; chunk_size++) {
+		parse_chunked(references, DESCENT_XML_TEXT_DECODE, chunk_size, &joined);
+		assert(joined.count == 1);
+		assert(joined.largest <= chunk_size);
+		assert(strlen(joined.text[0]) == 1 + 200 * 6);
+		for (size_t i = 0; i < 200; i++)
+			assert(!memcmp(joined.text[0] + 1 + i * 6, "a&\xf0\x9f\x98\x80", 6));
+		joined_free(&joined);
+	}
+	free(references);
+
+	// a reference too long to replace is left as it is, in chunks
+	const char *const long_reference
+		= "<a>&a_particularly_long_entity_name; &amp;</a>";
+	parse_chunked(long_reference, DESCENT_XML_TEXT_DECODE, 16, &joined);
+	assert(!strcmp(joined.text[0], "&a_particularly_long_entity_name; &"));
+	assert(joined.largest <= 16);
+	joined_free(&joined);
+
+	// as is a bare '&' with a ';' only far after it, which doesn't
+	// stretch the chunk it's cut at
+	char *const bare = repeat("<r>", "y", 1000, "&");
+	char *const far = repeat(bare, "x", 200000, ";</r>");
+	parse_chunked(far, DESCENT_XML_TEXT_DECODE, 65536, &joined);
+	assert(joined.count == 1);
+	assert(joined.largest <= 65536);
+	assert(strlen(joined.text[0]) == 1000 + 1 + 200000 + 1);
+	assert(joined.text[0][1000] == '&');
+	joined_free(&joined);
+	free(far);
+	free(bare);
+
+	// enough leading zeros make a reference too long to replace
+	parse_chunked("<a>&#x0000000000041;&#x0041;</a>", DESCENT_XML_TEXT_DECODE, 4096, &joined);
+	assert(!strcmp(joined.text[0], "&#x0000000000041;A"));
+	joined_free(&joined);
+}
+
+void test_chunks_skip_space()
+{
+	struct joined joined;
+	parse_chunked(
+		"<feed>\n"
+		"  <!-- c -->\n"
+		"  <item>  <!-- c -->  x</item>\n"
+		"  <item><![CDATA[ ]]></item>\n"
+		"</feed>\n",
+		DESCENT_XML_TEXT_SKIP_SPACE,
+		16,
+		&joined
+	);
+	assert(joined.count == 2);
+	// whitespace before content is kept
+	assert(!strcmp(joined.text[0], "    x"));
+	assert(!strcmp(joined.text[1], " "));
+	joined_free(&joined);
+}
+
+static void *no_allocate(void *context, size_t size)
+{
+	(void)context;
+	(void)size;
+	return NULL;
+}
+
+static void *no_reallocate(void *context, void *pointer, size_t old_size, size_t size)
+{
+	(void)context;
+	(void)pointer;
+	(void)old_size;
+	(void)size;
+	return NULL;
+}
+
+void test_failure()
+{
+	const struct descent_xml_allocator allocator = {
+		.allocate = no_allocate,
+		.reallocate = no_reallocate,
+	};
+	struct descent_xml_text text;
+	descent_xml_text_init(&text, 0, &allocator);
+
+	// one piece needs no memory
+	const struct descent_xml_lex single = first_text(lit("<r>abc<d/></r>"));
+	lptr_t value;
+	bool is_cdata;
+	struct descent_xml_lex token
+		= descent_xml_text_read(single, &text, &value, &is_cdata);
+	assert(token.type != descent_xml_parse_error);
+	assert(lptr_is(value, "abc"));
+
+	const struct descent_xml_lex joined
+		= first_text(lit("<r>a<![CDATA[b]]></r>"));
+	token = descent_xml_text_read(joined, &text, &value, &is_cdata);
+	assert(token.type == descent_xml_parse_error);
+
+	// nor does chunking, unless it's decoding
+	struct joined chunks = { .state = &text };
+	token = descent_xml_text_read_chunks(joined, &text, join_chunk, &chunks);
+	assert(token.type != descent_xml_parse_error);
+	assert(chunks.count == 1 && !strcmp(chunks.text[0], "ab"));
+	joined_free(&chunks);
+	text.flags = DESCENT_XML_TEXT_DECODE;
+	chunks = (struct joined) { .state = &text };
+	token = descent_xml_text_read_chunks(joined, &text, join_chunk, &chunks);
+	assert(token.type == descent_xml_parse_error);
+	assert(chunks.count == 0);
+	descent_xml_text_free(&text);
+}
+
+int main()
+{
+	test_single_piece();
+	test_joined();
+	test_decode();
+	test_skip_space();
+	test_chunks();
+	test_chunks_decode();
+	test_chunks_skip_space();
+	test_read();
+	test_failure();
+	return 0;
+}
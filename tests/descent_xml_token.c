@@ -0,0 +1,132 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <assert.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "descent-xml/token.h"
+#include "descent-xml/parse.h"
+#include "descent-xml/validate.h"
+
+#include <libadt/str.h>
+
+#define lit libadt_str_literal
+
+#define CATEGORY(id) descent_xml_token_categories[id]
+
+static descent_xml_classifier_void_fn *user_classifier(wchar_t input)
+{
+	(void)input;
+	return (descent_xml_classifier_void_fn *)user_classifier;
+}
+
+void test_round_trip()
+{
+	for (int id = DESCENT_XML_TOKEN_UNKNOWN + 1; id < DESCENT_XML_TOKEN_COUNT; id++) {
+		descent_xml_classifier_fn *const type = descent_xml_token_type(id);
+		assert(type);
+		assert(descent_xml_token_id(type) == (enum descent_xml_token_id)id);
+		assert(descent_xml_token_name(id));
+	}
+
+	assert(descent_xml_token_id(descent_xml_classifier_eof) == DESCENT_XML_TOKEN_EOF);
+	assert(descent_xml_token_id(descent_xml_classifier_unexpected) == DESCENT_XML_TOKEN_UNEXPECTED);
+	assert(descent_xml_token_id(descent_xml_classifier_text) == DESCENT_XML_TOKEN_TEXT);
+	assert(descent_xml_token_id(descent_xml_parse_error) == DESCENT_XML_TOKEN_PARSE_ERROR);
+	assert(descent_xml_token_id(descent_xml_validate_error) == DESCENT_XML_TOKEN_VALIDATE_ERROR);
+	assert(strcmp(descent_xml_token_name(DESCENT_XML_TOKEN_ELEMENT_NAME), "descent_xml_classifier_element_name") == 0);
+
+	assert(descent_xml_token_id(user_classifier) == DESCENT_XML_TOKEN_UNKNOWN);
+	assert(descent_xml_token_id(NULL) == DESCENT_XML_TOKEN_UNKNOWN);
+	assert(!descent_xml_token_type(DESCENT_XML_TOKEN_UNKNOWN));
+	assert(!descent_xml_token_type(DESCENT_XML_TOKEN_COUNT));
+	assert(!descent_xml_token_name(DESCENT_XML_TOKEN_COUNT));
+	assert(CATEGORY(DESCENT_XML_TOKEN_UNKNOWN) == 0);
+}
+
+void test_categories()
+{
+	assert(CATEGORY(DESCENT_XML_TOKEN_TEXT) & DESCENT_XML_TOKEN_CATEGORY_DATA);
+	assert(!(CATEGORY(DESCENT_XML_TOKEN_TEXT_SPACE) & DESCENT_XML_TOKEN_CATEGORY_DATA));
+	assert(CATEGORY(DESCENT_XML_TOKEN_TEXT_SPACE) & DESCENT_XML_TOKEN_CATEGORY_TEXT);
+	assert(CATEGORY(DESCENT_XML_TOKEN_CDATA) & DESCENT_XML_TOKEN_CATEGORY_DATA);
+	assert(!(CATEGORY(DESCENT_XML_TOKEN_CDATA) & DESCENT_XML_TOKEN_CATEGORY_TEXT));
+	assert(CATEGORY(DESCENT_XML_TOKEN_ATTRIBUTE_VALUE_DOUBLE_QUOTE_ENTITY) & DESCENT_XML_TOKEN_CATEGORY_ATTRIBUTE_VALUE);
+	assert(!(CATEGORY(DESCENT_XML_TOKEN_ATTRIBUTE_VALUE_DOUBLE_QUOTE_END) & DESCENT_XML_TOKEN_CATEGORY_ATTRIBUTE_VALUE));
+	assert(CATEGORY(DESCENT_XML_TOKEN_EOF) == DESCENT_XML_TOKEN_CATEGORY_END);
+	for (int id = DESCENT_XML_TOKEN_UNEXPECTED; id <= DESCENT_XML_TOKEN_VALIDATE_ERROR; id++)
+		assert(CATEGORY(id) == (DESCENT_XML_TOKEN_CATEGORY_END | DESCENT_XML_TOKEN_CATEGORY_ERROR));
+
+	// the parser's own type tests compare pointers, and have to agree
+	for (int id = DESCENT_XML_TOKEN_UNKNOWN + 1; id < DESCENT_XML_TOKEN_COUNT; id++) {
+		const struct descent_xml_lex token = { .type = descent_xml_token_type(id) };
+		assert(_descent_xml_is_text_type(token) == !!(CATEGORY(id) & DESCENT_XML_TOKEN_CATEGORY_TEXT));
+		assert(_descent_xml_non_space_text(token) == !!(CATEGORY(id) & DESCENT_XML_TOKEN_CATEGORY_DATA));
+		assert(_descent_xml_is_attribute_value_type(token) == !!(CATEGORY(id) & DESCENT_XML_TOKEN_CATEGORY_ATTRIBUTE_VALUE));
+		assert(_descent_xml_end_token(token) == !!(CATEGORY(id) & DESCENT_XML_TOKEN_CATEGORY_END));
+	}
+}
+
+void test_lexed()
+{
+	// every token the lexer produces has an id, and the categories
+	// agree with the type
+	static const char document[] =
+		"<?xml version='1.0'?>\n"
+		"<!DOCTYPE a>\n"
+		"<!-- comment -->\n"
+		"<a x='1 &amp; 2' y = \"&lt;\">"
+		"text &amp; more <![CDATA[data]]> <b/>"
+		"</a >";
+
+	unsigned seen[DESCENT_XML_TOKEN_COUNT] = { 0 };
+	struct descent_xml_lex token = descent_xml_lex_init(lit(document));
+	while (!descent_xml_token_is(token, DESCENT_XML_TOKEN_CATEGORY_END)) {
+		token = descent_xml_lex_next_raw(token);
+		const enum descent_xml_token_id id = descent_xml_token_id(token.type);
+		assert(id != DESCENT_XML_TOKEN_UNKNOWN);
+		assert(descent_xml_token_type(id) == token.type);
+		seen[id]++;
+
+		const bool text = token.type == descent_xml_classifier_text
+			|| token.type == descent_xml_classifier_text_space
+			|| token.type == descent_xml_classifier_text_entity_start
+			|| token.type == descent_xml_classifier_text_entity;
+		assert(descent_xml_token_is(token, DESCENT_XML_TOKEN_CATEGORY_TEXT) == text);
+	}
+	assert(token.type == descent_xml_classifier_eof);
+
+	assert(seen[DESCENT_XML_TOKEN_XMLDECL] == 1);
+	assert(seen[DESCENT_XML_TOKEN_DOCTYPE] == 1);
+	assert(seen[DESCENT_XML_TOKEN_COMMENT] == 1);
+	assert(seen[DESCENT_XML_TOKEN_CDATA] == 1);
+	assert(seen[DESCENT_XML_TOKEN_ELEMENT_NAME] == 2);
+	assert(seen[DESCENT_XML_TOKEN_ELEMENT_CLOSE_NAME] == 1);
+	assert(seen[DESCENT_XML_TOKEN_TEXT_ENTITY] == 1);
+	assert(seen[DESCENT_XML_TOKEN_ATTRIBUTE_VALUE_SINGLE_QUOTE_ENTITY] == 1);
+	assert(seen[DESCENT_XML_TOKEN_ATTRIBUTE_VALUE_DOUBLE_QUOTE_ENTITY] == 1);
+	assert(seen[DESCENT_XML_TOKEN_EOF] == 1);
+}
+
+int main()
+{
+	test_round_trip();
+	test_categories();
+	test_lexed();
+	return 0;
+}
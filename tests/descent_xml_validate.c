@@ -18,6 +18,7 @@
 
 #include <assert.h>
 #include <stdbool.h>
+#include <stdio.h>
 #include "descent-xml/validate.h"
 
 #include <libadt/str.h>
@@ -83,6 +84,15 @@ void test_valid(void)
 		));
 		assert(descent_xml_validate_document(valid));
 	}
+
+	{
+		lex_t valid = lex(lit(
+			"<root></root>\n"
+			"<!-- A trailing comment -->\n"
+			"<!-- and another -->"
+		));
+		assert(descent_xml_validate_document(valid));
+	}
 }
 
 void test_invalid(void)
@@ -144,8 +154,262 @@ void test_invalid(void)
 	}
 }
 
+static lptr_t nested(char *buffer, size_t size, int depth, const char *leaf)
+{
+	size_t length = 0;
+	for (int i = 0; i < depth; i++)
+		length += (size_t)snprintf(buffer + length, size - length, "<e%d>", i % 10);
+	length += (size_t)snprintf(buffer + length, size - length, "%s", leaf);
+	for (int i = depth - 1; i >= 0; i--)
+		length += (size_t)snprintf(buffer + length, size - length, "</e%d>", i % 10);
+	return (lptr_t) { .buffer = buffer, .size = 1, .length = (ssize_t)length };
+}
+
+void test_depth(void)
+{
+	static char buffer[2000000];
+
+	{
+		// far deeper than any thread stack would survive
+		// with a frame per level
+		lex_t valid = lex(nested(buffer, sizeof(buffer), 200000, "text"));
+		assert(descent_xml_validate_element_depth(valid, -1));
+		assert(descent_xml_validate_document_depth(valid, -1));
+		assert(!descent_xml_validate_document(valid));
+	}
+
+	{
+		lex_t valid = lex(nested(buffer, sizeof(buffer), 3, "<leaf/>"));
+		assert(descent_xml_validate_element_depth(valid, 4));
+		assert(!descent_xml_validate_element_depth(valid, 3));
+		assert(descent_xml_validate_document_depth(valid, 4));
+		assert(!descent_xml_validate_document_depth(valid, 3));
+	}
+
+	{
+		lex_t invalid = lex(nested(buffer, sizeof(buffer), 100000, "<e0></e1>"));
+		assert(!descent_xml_validate_element_depth(invalid, -1));
+		assert(!descent_xml_validate_document_depth(invalid, -1));
+	}
+}
+
+static lptr_t wide(char *buffer, size_t size, int count, int duplicate)
+{
+	size_t length = (size_t)snprintf(buffer, size, "<root><wide");
+	for (int i = 0; i < count; i++)
+		length += (size_t)snprintf(buffer + length, size - length, " a%d='%d'", i, i);
+	if (duplicate >= 0)
+		length += (size_t)snprintf(buffer + length, size - length, " a%d='x'", duplicate);
+	length += (size_t)snprintf(buffer + length, size - length, "/></root>");
+	return (lptr_t) { .buffer = buffer, .size = 1, .length = (ssize_t)length };
+}
+
+void test_duplicate_attributes(void)
+{
+	static char buffer[100000];
+
+	assert(descent_xml_validate_document(lex(lit("<root a='1' b='2'/>"))));
+	assert(!descent_xml_validate_document(lex(lit("<root a='1' a='2'/>"))));
+	assert(!descent_xml_validate_document(lex(lit("<root><x a='1' b='' a=''></x></root>"))));
+	// prefixes are part of the name until namespaces are resolved
+	assert(descent_xml_validate_document(lex(lit("<root a='1' x:a='2'/>"))));
+
+	// through the hash table, including the heap-allocated one
+	const int counts[] = { 9, 100, 300, 2000 };
+	for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+		assert(descent_xml_validate_document(
+			lex(wide(buffer, sizeof(buffer), counts[i], -1))
+		));
+		assert(!descent_xml_validate_document(
+			lex(wide(buffer, sizeof(buffer), counts[i], 0))
+		));
+		assert(!descent_xml_validate_document(
+			lex(wide(buffer, sizeof(buffer), counts[i], counts[i] - 1))
+		));
+	}
+}
+
+struct counts {
+	struct descent_xml_validator *validator;
+	int elements;
+	int texts;
+};
+
+static lex_t count_element(
+	lex_t token,
+	lptr_t name,
+	lptr_t attributes,
+	bool empty,
+	void *context
+)
+{
+	(void)name;
+	(void)attributes;
+	(void)empty;
+	struct counts *const counts = context;
+	counts->elements++;
+	return token;
+}
+
+static void count_text(lptr_t text, bool is_cdata, void *context)
+{
+	(void)text;
+	(void)is_cdata;
+	struct counts *const counts = context;
+	counts->texts++;
+}
+
+static descent_xml_classifier_fn *parse_validated(lptr_t xml, struct counts *counts)
+{
+	struct descent_xml_validator validator = descent_xml_validator_init(1000);
+	lex_t token = lex(xml);
+	while (
+		token.type != descent_xml_classifier_eof
+		&& token.type != descent_xml_classifier_unexpected
+		&& token.type != descent_xml_validate_error
+	)
+		token = descent_xml_parse_validated(
+			token,
+			&validator,
+			count_element,
+			count_text,
+			counts
+		);
+	descent_xml_validator_free(&validator);
+	return token.type;
+}
+
+void test_parse_validated(void)
+{
+	const lptr_t valid[] = {
+		lit("<foo><foo></foo><bar></bar></foo>"),
+		lit("<foo />"),
+		lit("<?xml version=\"1.0\"?>\n<foo>text</foo>\n"),
+		lit("<!DOCTYPE html>\n<html></html>"),
+		lit("<root></root>\n<!-- trailing comment -->\n"),
+		lit("<root>a<![CDATA[b]]>c</root>"),
+		lit("<?xml version=\"1.0\"?><!-- a --><!DOCTYPE r><!-- b --><r/>"),
+	};
+	for (size_t i = 0; i < sizeof(valid) / sizeof(valid[0]); i++) {
+		struct counts counts = { 0 };
+		assert(parse_validated(valid[i], &counts) == descent_xml_classifier_eof);
+		assert(descent_xml_validate_document(lex(valid[i])));
+	}
+
+	const lptr_t invalid[] = {
+		lit("<foo></bar>"),
+		lit("<foo><bar></bar>"),
+		lit("<foo><bar></bar></bar>"),
+		lit("<root></root>foo"),
+		lit("<root></root><![CDATA[foo]]>"),
+		lit("<foo></foo><bar></bar>"),
+		lit("<foo/><bar/>"),
+		lit("<?xml version=\"1.0\" ?><root></root>&gt;"),
+		lit("<root></root><!DOCTYPE root>"),
+		lit("<root><x a='1' a='2'/></root>"),
+		lit("<!DOCTYPE a><!DOCTYPE b><a/>"),
+		lit("<?xml version=\"1.0\"?><?xml version=\"1.0\"?><a/>"),
+		lit("<!DOCTYPE a><?xml version=\"1.0\"?><a/>"),
+		lit("<!-- a --><?xml version=\"1.0\"?><a/>"),
+	};
+	for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+		struct counts counts = { 0 };
+		assert(parse_validated(invalid[i], &counts) == descent_xml_validate_error);
+		// the fused mode must agree with the separate pass
+		assert(!descent_xml_validate_document(lex(invalid[i])));
+	}
+
+	{
+		// handlers still see everything up to the error
+		struct counts counts = { 0 };
+		assert(parse_validated(
+			lit("<a><b>text</b><c/></d>"),
+			&counts
+		) == descent_xml_validate_error);
+		assert(counts.elements == 3);
+		assert(counts.texts == 1);
+	}
+}
+
+static lex_t skip_children(
+	lex_t token,
+	lptr_t name,
+	lptr_t attributes,
+	bool empty,
+	void *context
+)
+{
+	(void)name;
+	(void)attributes;
+	struct counts *const counts = context;
+	counts->elements++;
+	if (empty)
+		return token;
+
+	// the nested pattern from the tutorials, with every call
+	// going through the same validator
+	while (token.type != descent_xml_classifier_element_close_name) {
+		if (
+			token.type == descent_xml_classifier_eof
+			|| token.type == descent_xml_classifier_unexpected
+			|| token.type == descent_xml_validate_error
+		)
+			return token;
+		token = descent_xml_parse_validated(
+			token,
+			counts->validator,
+			skip_children,
+			NULL,
+			counts
+		);
+	}
+	return descent_xml_parse_validated(token, counts->validator, NULL, NULL, NULL);
+}
+
+void test_parse_validated_recursive(void)
+{
+	struct descent_xml_validator validator = descent_xml_validator_init(-1);
+	struct counts counts = { .validator = &validator };
+	lex_t token = lex(lit("<a><b><c/></b><d>text</d></a>"));
+	while (
+		token.type != descent_xml_classifier_eof
+		&& token.type != descent_xml_validate_error
+	)
+		token = descent_xml_parse_validated(
+			token,
+			&validator,
+			skip_children,
+			NULL,
+			&counts
+		);
+	assert(token.type == descent_xml_classifier_eof);
+	assert(counts.elements == 4);
+	descent_xml_validator_free(&validator);
+
+	validator = descent_xml_validator_init(-1);
+	counts = (struct counts) { .validator = &validator };
+	token = lex(lit("<a><b><c/></d></a>"));
+	while (
+		token.type != descent_xml_classifier_eof
+		&& token.type != descent_xml_validate_error
+	)
+		token = descent_xml_parse_validated(
+			token,
+			&validator,
+			skip_children,
+			NULL,
+			&counts
+		);
+	assert(token.type == descent_xml_validate_error);
+	descent_xml_validator_free(&validator);
+}
+
 int main()
 {
 	test_valid();
 	test_invalid();
+	test_depth();
+	test_duplicate_attributes();
+	test_parse_validated();
+	test_parse_validated_recursive();
 }
@@ -0,0 +1,328 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "pathological.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "descent-xml/lex.h"
+#include "descent-xml/stats.h"
+#include "descent-xml/validate.h"
+
+const struct pathological_input pathological_inputs[] = {
+	{
+		.name = "attribute_value",
+		.prefix = "<a v=\"",
+		.repeat = "x",
+		.middle = "\"/>",
+		.suffix = "",
+		.valid = true,
+	},
+	{
+		.name = "unterminated_attribute",
+		.prefix = "<a v=\"",
+		.repeat = "x",
+		.middle = "",
+		.suffix = "",
+		.valid = false,
+	},
+	{
+		.name = "attributes",
+		.prefix = "<a",
+		.repeat = " a%zu=\"1\"",
+		.middle = "/>",
+		.suffix = "",
+		.valid = true,
+	},
+	{
+		.name = "tag_space",
+		.prefix = "<a",
+		.repeat = " ",
+		.middle = "/>",
+		.suffix = "",
+		.valid = true,
+	},
+	{
+		.name = "long_name",
+		.prefix = "<",
+		.repeat = "n",
+		.middle = "></",
+		.repeat_after = "n",
+		.suffix = ">",
+		.valid = true,
+	},
+	{
+		.name = "nesting",
+		.prefix = "",
+		.repeat = "<a>",
+		.middle = "",
+		.repeat_after = "</a>",
+		.suffix = "",
+		.valid = true,
+	},
+	{
+		.name = "comments",
+		.prefix = "<a>",
+		.repeat = "<!-- c -->",
+		.middle = "</a>",
+		.suffix = "",
+		.valid = true,
+	},
+	{
+		.name = "comment",
+		.prefix = "<a><!--",
+		.repeat = "-x",
+		.middle = "--></a>",
+		.suffix = "",
+		.valid = true,
+	},
+	{
+		.name = "unterminated_comment",
+		.prefix = "<a><!--",
+		.repeat = "-x",
+		.middle = "",
+		.suffix = "",
+		.valid = false,
+	},
+	{
+		.name = "cdata",
+		.prefix = "<a><![CDATA[",
+		.repeat = "]x",
+		.middle = "]]></a>",
+		.suffix = "",
+		.valid = true,
+	},
+	{
+		.name = "unterminated_cdata",
+		.prefix = "<a><![CDATA[",
+		.repeat = "]x",
+		.middle = "",
+		.suffix = "",
+		.valid = false,
+	},
+	{
+		.name = "entities",
+		.prefix = "<a>",
+		.repeat = "&amp;",
+		.middle = "</a>",
+		.suffix = "",
+		.valid = true,
+	},
+	{
+		.name = "xmldecl_attributes",
+		.prefix = "<?xml version=\"1.0\"",
+		.repeat = " a%zu=\"b\"",
+		.middle = "?><a/>",
+		.suffix = "",
+		.valid = true,
+	},
+	{
+		.name = "unterminated_xmldecl",
+		.prefix = "<?xml version=\"1.0\"",
+		.repeat = " a%zu=\"b\"",
+		.middle = "",
+		.suffix = "",
+		.valid = false,
+	},
+	{
+		.name = "doctype_subset",
+		.prefix = "<!DOCTYPE a [",
+		.repeat = "<!-- ] -->",
+		.middle = "]><a/>",
+		.suffix = "",
+		.valid = true,
+	},
+};
+
+const size_t pathological_input_count
+	= sizeof(pathological_inputs) / sizeof(pathological_inputs[0]);
+
+static bool append(
+	char **data,
+	size_t *length,
+	size_t *capacity,
+	const char *format,
+	size_t index
+)
+{
+	for (;;) {
+		const int needed = snprintf(
+			*data + *length,
+			*capacity - *length,
+			format,
+			index
+		);
+		if (needed < 0)
+			return false;
+		if (*length + (size_t)needed < *capacity) {
+			*length += (size_t)needed;
+			return true;
+		}
+
+		char *const grown = realloc(*data, *capacity * 2);
+		if (!grown)
+			return false;
+		*data = grown;
+		*capacity *= 2;
+	}
+}
+
+char *pathological_generate(
+	const struct pathological_input *input,
+	size_t count,
+	size_t *length
+)
+{
+	size_t capacity = 4096;
+	char *data = malloc(capacity);
+	if (!data)
+		return NULL;
+
+	*length = 0;
+	bool ok = append(&data, length, &capacity, input->prefix, 0);
+	for (size_t i = 0; ok && i < count; i++)
+		ok = append(&data, length, &capacity, input->repeat, i);
+	ok = ok && append(&data, length, &capacity, input->middle, 0);
+	for (size_t i = 0; ok && input->repeat_after && i < count; i++)
+		ok = append(&data, length, &capacity, input->repeat_after, i);
+	ok = ok && append(&data, length, &capacity, input->suffix, 0);
+
+	if (!ok) {
+		free(data);
+		return NULL;
+	}
+	return data;
+}
+
+size_t pathological_scan(const char *document, size_t length, bool *valid)
+{
+	const struct libadt_const_lptr script = {
+		.buffer = document,
+		.size = 1,
+		.length = (ssize_t)length,
+	};
+
+	size_t tokens = 0;
+	struct descent_xml_lex token = descent_xml_lex_init(script);
+	do {
+		token = descent_xml_lex_next_raw(token);
+		tokens++;
+	} while (
+		token.type != descent_xml_classifier_eof
+		&& token.type != descent_xml_classifier_unexpected
+	);
+
+	const bool result = descent_xml_validate_document_depth(
+		descent_xml_lex_init(script),
+		-1
+	);
+	if (valid)
+		*valid = result;
+	return tokens;
+}
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+double pathological_time(const char *document, size_t length, int runs)
+{
+	double best = 0;
+	for (int i = 0; i < runs; i++) {
+		const double start = now();
+		volatile size_t tokens = pathological_scan(document, length, NULL);
+		(void)tokens;
+		const double elapsed = now() - start;
+		if (i == 0 || elapsed < best)
+			best = elapsed;
+	}
+	return best;
+}
+
+double pathological_growth(
+	const struct pathological_input *input,
+	size_t count,
+	int steps,
+	int runs
+)
+{
+	size_t small_length, large_length;
+	char *const small = pathological_generate(input, count, &small_length);
+	char *const large = pathological_generate(
+		input,
+		count << steps,
+		&large_length
+	);
+
+	double growth = -1;
+	if (small && large) {
+		const double
+			small_time = pathological_time(small, small_length, runs),
+			large_time = pathological_time(large, large_length, runs);
+		growth = log(large_time / small_time)
+			/ log((double)large_length / (double)small_length);
+	}
+
+	free(small);
+	free(large);
+	return growth;
+}
+
+// The bytes decoded or compared while scanning a document, counting
+// those looked at again after backtracking.
+static size_t work(const char *document, size_t length)
+{
+	descent_xml_stats_reset();
+	pathological_scan(document, length, NULL);
+	const struct descent_xml_stats stats = descent_xml_stats_get();
+	return stats.decoded_bytes + stats.compared_bytes;
+}
+
+double pathological_work_growth(
+	const struct pathological_input *input,
+	size_t count,
+	int steps
+)
+{
+	size_t small_length, large_length;
+	char *const small = pathological_generate(input, count, &small_length);
+	char *const large = pathological_generate(
+		input,
+		count << steps,
+		&large_length
+	);
+
+	double growth = -1;
+	if (small && large) {
+		const double
+			small_work = (double)work(small, small_length),
+			large_work = (double)work(large, large_length);
+		growth = log(large_work / small_work)
+			/ log((double)large_length / (double)small_length);
+	}
+
+	free(small);
+	free(large);
+	return growth;
+}
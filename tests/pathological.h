@@ -0,0 +1,125 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef DESCENT_XML_TESTS_PATHOLOGICAL
+#define DESCENT_XML_TESTS_PATHOLOGICAL
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * \file
+ *
+ * Inputs built by repeating one construct any number of times, for
+ * checking that the cost of lexing and validating grows linearly with
+ * the size of the document. Each targets a loop in the lexer or
+ * validator that could go quadratic: backtracking in
+ * descent_xml_lex_or(), the byte-at-a-time scans for the end of
+ * comments and CDATA sections, the XML declaration's attribute loop,
+ * and so on.
+ *
+ * Shared by the scaling test and benchmark.
+ */
+
+/**
+ * \brief A construct to repeat.
+ *
+ * A document is prefix, then repeat count times, then middle, then
+ * repeat_after count times, then suffix. The repeated strings are
+ * printf() formats, given the repetition's index as a size_t.
+ */
+struct pathological_input {
+	const char *name;
+	const char *prefix;
+	const char *repeat;
+	const char *middle;
+
+	/**
+	 * \brief Can be a NULL pointer.
+	 */
+	const char *repeat_after;
+	const char *suffix;
+
+	/**
+	 * \brief Whether descent_xml_validate_document_depth() accepts
+	 * 	the document. Invalid inputs are still timed, as the time
+	 * 	to find the error should be linear too.
+	 */
+	bool valid;
+};
+
+extern const struct pathological_input pathological_inputs[];
+extern const size_t pathological_input_count;
+
+/**
+ * \brief Builds a document repeating an input's construct count times.
+ *
+ * \returns The document, to be released with free(), with its length
+ * 	in *length, or a NULL pointer if memory couldn't be allocated.
+ */
+char *pathological_generate(
+	const struct pathological_input *input,
+	size_t count,
+	size_t *length
+);
+
+/**
+ * \brief Lexes a document to the end, then validates it.
+ *
+ * \param valid Set to the validation result. Can be a NULL pointer.
+ *
+ * \returns The number of tokens lexed.
+ */
+size_t pathological_scan(const char *document, size_t length, bool *valid);
+
+/**
+ * \brief Times pathological_scan() on a document.
+ *
+ * \returns The fastest of runs runs, in nanoseconds.
+ */
+double pathological_time(const char *document, size_t length, int runs);
+
+/**
+ * \brief Estimates how the cost of scanning an input grows with its
+ * 	size, by timing it with count and count << steps repetitions.
+ *
+ * \returns The exponent k in time = c * length^k, so about 1 for
+ * 	linear growth and 2 for quadratic, or a negative number if memory
+ * 	couldn't be allocated.
+ */
+double pathological_growth(
+	const struct pathological_input *input,
+	size_t count,
+	int steps,
+	int runs
+);
+
+/**
+ * \brief pathological_growth(), measuring the bytes the lexer decodes
+ * 	or compares, backtracking included, rather than the time taken.
+ *
+ * Unlike the timing, this gives the same answer on every run, but it
+ * needs the library built with `DESCENT_XML_STATS`; see
+ * descent_xml_stats_enabled().
+ */
+double pathological_work_growth(
+	const struct pathological_input *input,
+	size_t count,
+	int steps
+);
+
+#endif // DESCENT_XML_TESTS_PATHOLOGICAL
@@ -0,0 +1,31 @@
+# descent_xml_generate(<prefix> <input> [ROOT <element>])
+#
+# Generates a specialised parser from a descriptor file or a DTD with
+# descent-xml-gen, as <prefix>.h and <prefix>.c in the current binary
+# directory, and sets <prefix>_SOURCES to both. Add them to a target,
+# along with the current binary directory as an include directory.
+function(descent_xml_generate prefix input)
+	cmake_parse_arguments(PARSE_ARGV 2 arg "" "ROOT" "")
+
+	if (TARGET descent-xml-gen)
+		set(generator descent-xml-gen)
+	else()
+		find_program(generator descent-xml-gen REQUIRED)
+	endif()
+
+	get_filename_component(input ${input} ABSOLUTE)
+	set(options -p ${prefix} -o ${CMAKE_CURRENT_BINARY_DIR})
+	if (arg_ROOT)
+		list(APPEND options -r ${arg_ROOT})
+	endif()
+
+	set(header ${CMAKE_CURRENT_BINARY_DIR}/${prefix}.h)
+	set(source ${CMAKE_CURRENT_BINARY_DIR}/${prefix}.c)
+	add_custom_command(
+		OUTPUT ${header} ${source}
+		COMMAND ${generator} ${options} ${input}
+		DEPENDS ${generator} ${input}
+		COMMENT "Generating the ${prefix} parser from ${input}"
+		VERBATIM)
+	set(${prefix}_SOURCES ${header} ${source} PARENT_SCOPE)
+endfunction()
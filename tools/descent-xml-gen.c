@@ -0,0 +1,1651 @@
+/*
+ * XMLTree - An XML Parser-Helper Library
+ * Copyright (C) 2025  Marcus Harrison
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Generates a parser specialised to one document format, from a
+// descriptor file or a DTD. The generated parser is built on
+// descent_xml_parse(), dispatches child elements and attributes with
+// switches on the name's length and first byte instead of chains of
+// strcmp(), and decodes straight into generated structs.
+//
+// Usage: descent-xml-gen [-p prefix] [-r root] [-o directory] input
+//
+// Inputs ending in .dtd are read as DTDs, anything else as a
+// descriptor:
+//
+// 	# comments run to the end of the line
+// 	prefix feed
+// 	root order
+//
+// 	element order
+// 		attribute id uint required
+// 		attribute currency string
+// 		child customer
+// 		child item repeated
+// 		value note string optional
+//
+// 	element item
+// 		attribute sku string required
+// 		text double
+//
+// An element's `attribute`s, `child` elements with structs of their
+// own, `value`s (child elements holding just a scalar) and `text`
+// become members of its struct. Children and values are required
+// unless marked `optional` or `repeated`. Types are string, int,
+// uint, double and bool.
+
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "descent-xml/dtd.h"
+
+#include <libadt/lptr.h>
+
+enum kind {
+	KIND_NONE,
+	KIND_STRING,
+	KIND_INT,
+	KIND_UINT,
+	KIND_DOUBLE,
+	KIND_BOOL,
+};
+
+enum occurs {
+	OCCURS_ONE,
+	OCCURS_OPTIONAL,
+	OCCURS_REPEATED,
+};
+
+struct attribute {
+	char *name;
+	char *ident;
+	enum kind kind;
+	bool required;
+};
+
+struct member {
+	char *name;
+	char *ident;
+	// a value holds the child's text; otherwise the child has a
+	// struct of its own
+	bool value;
+	enum kind kind;
+	enum occurs occurs;
+	size_t element;
+};
+
+struct element {
+	char *name;
+	char *ident;
+	struct attribute *attributes;
+	size_t attribute_count;
+	struct member *members;
+	size_t member_count;
+	enum kind text;
+	// whether the root reaches this element as a struct
+	bool used;
+};
+
+struct spec {
+	const char *path;
+	char *prefix;
+	char *root;
+	struct element *elements;
+	size_t element_count;
+};
+
+static const char *program = "descent-xml-gen";
+
+static void die(const char *format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	fprintf(stderr, "%s: ", program);
+	vfprintf(stderr, format, args);
+	fputc('\n', stderr);
+	va_end(args);
+	exit(1);
+}
+
+static void *grow(void *buffer, size_t count, size_t size)
+{
+	// grows at powers of two, so the count is all we need to keep
+	if (count & (count - 1))
+		return buffer;
+	void *const grown = realloc(buffer, (count ? count * 2 : 1) * size);
+	if (!grown)
+		die("out of memory");
+	return grown;
+}
+
+static char *copy(const char *start, size_t length)
+{
+	char *const result = malloc(length + 1);
+	if (!result)
+		die("out of memory");
+	memcpy(result, start, length);
+	result[length] = '\0';
+	return result;
+}
+
+static const char *const keywords[] = {
+	"auto", "bool", "break", "case", "char", "const", "continue",
+	"default", "do", "double", "else", "enum", "extern", "float", "for",
+	"goto", "if", "inline", "int", "long", "register", "restrict",
+	"return", "short", "signed", "sizeof", "static", "struct", "switch",
+	"typedef", "union", "unsigned", "void", "volatile", "while", "text",
+};
+
+// turns an XML name into a C identifier
+static char *identifier(const char *name)
+{
+	const size_t length = strlen(name);
+	char *const result = malloc(length + 2);
+	if (!result)
+		die("out of memory");
+	for (size_t i = 0; i < length; i++) {
+		const unsigned char c = (unsigned char)name[i];
+		result[i] = isalnum(c) || c == '_' ? (char)c : '_';
+	}
+	result[length] = '\0';
+	if (isdigit((unsigned char)result[0]))
+		result[0] = '_';
+	for (size_t i = 0; i < sizeof(keywords) / sizeof(keywords[0]); i++) {
+		if (strcmp(result, keywords[i]) == 0) {
+			result[length] = '_';
+			result[length + 1] = '\0';
+		}
+	}
+	return result;
+}
+
+static ssize_t find_element(const struct spec *spec, const char *name)
+{
+	for (size_t i = 0; i < spec->element_count; i++)
+		if (strcmp(spec->elements[i].name, name) == 0)
+			return (ssize_t)i;
+	return -1;
+}
+
+static struct element *add_element(struct spec *spec, const char *name, int line)
+{
+	if (find_element(spec, name) >= 0)
+		die("%s:%d: element %s is declared twice", spec->path, line, name);
+	spec->elements = grow(spec->elements, spec->element_count, sizeof(*spec->elements));
+	struct element *const element = &spec->elements[spec->element_count++];
+	*element = (struct element) {
+		.name = copy(name, strlen(name)),
+		.ident = identifier(name),
+	};
+	return element;
+}
+
+static void add_attribute(
+	struct element *element,
+	const char *name,
+	enum kind kind,
+	bool required
+)
+{
+	element->attributes = grow(
+		element->attributes,
+		element->attribute_count,
+		sizeof(*element->attributes)
+	);
+	element->attributes[element->attribute_count++] = (struct attribute) {
+		.name = copy(name, strlen(name)),
+		.ident = identifier(name),
+		.kind = kind,
+		.required = required,
+	};
+}
+
+static void add_member(
+	struct element *element,
+	const char *name,
+	bool value,
+	enum kind kind,
+	enum occurs occurs
+)
+{
+	element->members = grow(
+		element->members,
+		element->member_count,
+		sizeof(*element->members)
+	);
+	element->members[element->member_count++] = (struct member) {
+		.name = copy(name, strlen(name)),
+		.ident = identifier(name),
+		.value = value,
+		.kind = kind,
+		.occurs = occurs,
+	};
+}
+
+static enum kind parse_kind(const char *word)
+{
+	static const struct {
+		const char *name;
+		enum kind kind;
+	} kinds[] = {
+		{ "string", KIND_STRING },
+		{ "int", KIND_INT },
+		{ "uint", KIND_UINT },
+		{ "double", KIND_DOUBLE },
+		{ "bool", KIND_BOOL },
+	};
+	for (size_t i = 0; i < sizeof(kinds) / sizeof(kinds[0]); i++)
+		if (word && strcmp(word, kinds[i].name) == 0)
+			return kinds[i].kind;
+	return KIND_NONE;
+}
+
+static char *read_file(const char *path, size_t *length)
+{
+	FILE *const file = fopen(path, "rb");
+	if (!file)
+		die("can't open %s", path);
+
+	size_t size = 0, capacity = 4096;
+	char *buffer = malloc(capacity + 1);
+	for (;;) {
+		if (!buffer)
+			die("out of memory");
+		size += fread(buffer + size, 1, capacity - size, file);
+		if (size < capacity)
+			break;
+		capacity *= 2;
+		buffer = realloc(buffer, capacity + 1);
+	}
+	if (ferror(file))
+		die("can't read %s", path);
+	fclose(file);
+
+	buffer[size] = '\0';
+	*length = size;
+	return buffer;
+}
+
+static void parse_descriptor(struct spec *spec, char *text)
+{
+	struct element *element = NULL;
+	int line = 0;
+	for (char *next = text; next; ) {
+		char *const start = next;
+		next = strchr(start, '\n');
+		if (next)
+			*next++ = '\0';
+		line++;
+
+		char *const comment = strchr(start, '#');
+		if (comment)
+			*comment = '\0';
+
+		char *words[5] = { 0 };
+		size_t count = 0;
+		for (char *word = strtok(start, " \t\r"); word; word = strtok(NULL, " \t\r")) {
+			if (count == sizeof(words) / sizeof(words[0]))
+				die("%s:%d: too many words", spec->path, line);
+			words[count++] = word;
+		}
+		if (count == 0)
+			continue;
+
+		const char *const keyword = words[0];
+		if (strcmp(keyword, "prefix") == 0 && count == 2) {
+			if (!spec->prefix)
+				spec->prefix = copy(words[1], strlen(words[1]));
+			continue;
+		}
+		if (strcmp(keyword, "root") == 0 && count == 2) {
+			if (!spec->root)
+				spec->root = copy(words[1], strlen(words[1]));
+			continue;
+		}
+		if (strcmp(keyword, "element") == 0 && count == 2) {
+			element = add_element(spec, words[1], line);
+			continue;
+		}
+
+		if (!element)
+			die("%s:%d: %s outside of an element", spec->path, line, keyword);
+
+		if (strcmp(keyword, "attribute") == 0 && (count == 3 || count == 4)) {
+			const enum kind kind = parse_kind(words[2]);
+			const bool required = count == 4 && strcmp(words[3], "required") == 0;
+			if (kind == KIND_NONE || (count == 4 && !required))
+				die("%s:%d: expected attribute <name> <type> [required]", spec->path, line);
+			add_attribute(element, words[1], kind, required);
+		} else if (strcmp(keyword, "text") == 0 && count == 2) {
+			element->text = parse_kind(words[1]);
+			if (element->text == KIND_NONE)
+				die("%s:%d: unknown type %s", spec->path, line, words[1]);
+		} else if (
+			(strcmp(keyword, "child") == 0 && (count == 2 || count == 3))
+			|| (strcmp(keyword, "value") == 0 && (count == 3 || count == 4))
+		) {
+			const bool value = keyword[0] == 'v';
+			const enum kind kind = value ? parse_kind(words[2]) : KIND_NONE;
+			const char *const modifier = words[value ? 3 : 2];
+			enum occurs occurs = OCCURS_ONE;
+			if (modifier && strcmp(modifier, "optional") == 0)
+				occurs = OCCURS_OPTIONAL;
+			else if (modifier && strcmp(modifier, "repeated") == 0)
+				occurs = OCCURS_REPEATED;
+			else if (modifier)
+				die("%s:%d: expected optional or repeated", spec->path, line);
+			if (value && kind == KIND_NONE)
+				die("%s:%d: unknown type %s", spec->path, line, words[2]);
+			add_member(element, words[1], value, kind, occurs);
+		} else {
+			die("%s:%d: can't make sense of %s", spec->path, line, keyword);
+		}
+	}
+}
+
+// DTDs
+
+struct cursor {
+	const char *at;
+	const char *end;
+};
+
+static void skip_space(struct cursor *cursor)
+{
+	while (cursor->at < cursor->end && isspace((unsigned char)*cursor->at))
+		cursor->at++;
+}
+
+static bool is_name_char(char c)
+{
+	return isalnum((unsigned char)c)
+		|| c == '_' || c == ':' || c == '-' || c == '.'
+		|| (unsigned char)c >= 0x80;
+}
+
+static char *read_name(struct cursor *cursor)
+{
+	skip_space(cursor);
+	const char *const start = cursor->at;
+	while (cursor->at < cursor->end && is_name_char(*cursor->at))
+		cursor->at++;
+	return cursor->at > start ? copy(start, (size_t)(cursor->at - start)) : NULL;
+}
+
+// skips to just past the '>' ending a declaration
+static void skip_declaration(struct cursor *cursor)
+{
+	char quote = '\0';
+	for (; cursor->at < cursor->end; cursor->at++) {
+		const char c = *cursor->at;
+		if (quote) {
+			if (c == quote)
+				quote = '\0';
+		} else if (c == '"' || c == '\'') {
+			quote = c;
+		} else if (c == '>') {
+			cursor->at++;
+			return;
+		}
+	}
+}
+
+// How often each name in a content model can occur, as a minimum
+// and a maximum where 2 stands for "more than once".
+struct counts {
+	unsigned char *min;
+	unsigned char *max;
+};
+
+struct model {
+	char **names;
+	size_t name_count;
+	bool pcdata;
+};
+
+static size_t model_name(struct model *model, char *name)
+{
+	for (size_t i = 0; i < model->name_count; i++) {
+		if (strcmp(model->names[i], name) == 0) {
+			free(name);
+			return i;
+		}
+	}
+	model->names = grow(model->names, model->name_count, sizeof(*model->names));
+	model->names[model->name_count] = name;
+	return model->name_count++;
+}
+
+static unsigned char saturate(unsigned value)
+{
+	return value > 2 ? 2 : (unsigned char)value;
+}
+
+static void apply_modifier(struct cursor *cursor, struct counts *counts, size_t n)
+{
+	if (cursor->at == cursor->end)
+		return;
+	const char modifier = *cursor->at;
+	if (modifier != '?' && modifier != '*' && modifier != '+')
+		return;
+	cursor->at++;
+	for (size_t i = 0; i < n; i++) {
+		if (modifier != '+')
+			counts->min[i] = 0;
+		if (modifier != '?' && counts->max[i])
+			counts->max[i] = 2;
+	}
+}
+
+// Content models are at most as large as the DTD, so the counts are
+// sized to the largest possible number of names.
+static struct counts parse_particle(
+	struct cursor *cursor,
+	struct model *model,
+	size_t capacity
+);
+
+static struct counts new_counts(size_t capacity)
+{
+	struct counts counts = {
+		.min = calloc(capacity, 1),
+		.max = calloc(capacity, 1),
+	};
+	if (!counts.min || !counts.max)
+		die("out of memory");
+	return counts;
+}
+
+static struct counts parse_group(
+	struct cursor *cursor,
+	struct model *model,
+	size_t capacity
+)
+{
+	struct counts result = new_counts(capacity);
+	char separator = '\0';
+	bool first = true;
+	for (;;) {
+		skip_space(cursor);
+		struct counts particle = parse_particle(cursor, model, capacity);
+		skip_space(cursor);
+
+		for (size_t i = 0; i < capacity; i++) {
+			if (first) {
+				result.min[i] = particle.min[i];
+				result.max[i] = particle.max[i];
+			} else if (separator == '|') {
+				if (particle.min[i] < result.min[i])
+					result.min[i] = particle.min[i];
+				if (particle.max[i] > result.max[i])
+					result.max[i] = particle.max[i];
+			} else {
+				result.min[i] = saturate((unsigned)result.min[i] + particle.min[i]);
+				result.max[i] = saturate((unsigned)result.max[i] + particle.max[i]);
+			}
+		}
+		free(particle.min);
+		free(particle.max);
+		first = false;
+
+		if (cursor->at == cursor->end)
+			die("unterminated content model");
+		const char c = *cursor->at++;
+		if (c == ')')
+			break;
+		if (c != '|' && c != ',')
+			die("unexpected %c in content model", c);
+		separator = c;
+	}
+	skip_space(cursor);
+	apply_modifier(cursor, &result, capacity);
+	return result;
+}
+
+static struct counts parse_particle(
+	struct cursor *cursor,
+	struct model *model,
+	size_t capacity
+)
+{
+	if (cursor->at < cursor->end && *cursor->at == '(') {
+		cursor->at++;
+		return parse_group(cursor, model, capacity);
+	}
+
+	struct counts counts = new_counts(capacity);
+	if (cursor->end - cursor->at >= 7 && memcmp(cursor->at, "#PCDATA", 7) == 0) {
+		cursor->at += 7;
+		model->pcdata = true;
+		return counts;
+	}
+
+	char *const name = read_name(cursor);
+	if (!name)
+		die("expected a name in content model");
+	const size_t index = model_name(model, name);
+	counts.min[index] = counts.max[index] = 1;
+	apply_modifier(cursor, &counts, capacity);
+	return counts;
+}
+
+static void parse_dtd(struct spec *spec, const char *text, size_t length)
+{
+	const struct libadt_const_lptr dtd = {
+		.buffer = text,
+		.size = 1,
+		.length = (ssize_t)length,
+	};
+	struct descent_xml_dtd *const compiled = descent_xml_dtd_compile(dtd);
+	if (!compiled)
+		die("%s: not a valid DTD", spec->path);
+	descent_xml_dtd_free(compiled);
+
+	// the DTD is known to be valid, so this can be lax
+	// in the same order as spec->elements
+	struct {
+		struct model model;
+		struct counts counts;
+	} *declared = NULL;
+	size_t declared_count = 0;
+
+	struct cursor cursor = { text, text + length };
+	while (cursor.at < cursor.end) {
+		const char *const declaration = strchr(cursor.at, '<');
+		if (!declaration)
+			break;
+		cursor.at = declaration;
+
+		if (strncmp(cursor.at, "<!--", 4) == 0) {
+			const char *const end = strstr(cursor.at, "-->");
+			cursor.at = end ? end + 3 : cursor.end;
+			continue;
+		}
+		if (strncmp(cursor.at, "<?", 2) == 0) {
+			const char *const end = strstr(cursor.at, "?>");
+			cursor.at = end ? end + 2 : cursor.end;
+			continue;
+		}
+
+		if (strncmp(cursor.at, "<!ELEMENT", 9) == 0) {
+			cursor.at += 9;
+			char *const name = read_name(&cursor);
+			declared = grow(declared, declared_count, sizeof(*declared));
+			declared[declared_count].model = (struct model) { 0 };
+			struct model *const model = &declared[declared_count].model;
+			skip_space(&cursor);
+
+			// every name in the model is a separate byte of it
+			const size_t capacity = length + 1;
+			if (*cursor.at == '(') {
+				cursor.at++;
+				declared[declared_count].counts = parse_group(&cursor, model, capacity);
+			} else {
+				declared[declared_count].counts = new_counts(1);
+			}
+			struct element *const element = add_element(spec, name, 0);
+			if (model->pcdata)
+				element->text = KIND_STRING;
+			declared_count++;
+			free(name);
+		} else if (strncmp(cursor.at, "<!ATTLIST", 9) == 0) {
+			cursor.at += 9;
+			char *const element_name = read_name(&cursor);
+			const ssize_t index = find_element(spec, element_name);
+			if (index < 0)
+				die("%s: attributes of %s are declared before it", spec->path, element_name);
+			free(element_name);
+			struct element *const element = &spec->elements[index];
+
+			for (;;) {
+				char *const name = read_name(&cursor);
+				if (!name)
+					break;
+
+				// the type, then the default; both are
+				// skipped over, as every attribute is kept
+				// as a string
+				skip_space(&cursor);
+				if (*cursor.at == '(') {
+					while (cursor.at < cursor.end && *cursor.at != ')')
+						cursor.at++;
+					cursor.at++;
+				} else {
+					free(read_name(&cursor));
+					skip_space(&cursor);
+					if (*cursor.at == '(') {
+						while (cursor.at < cursor.end && *cursor.at != ')')
+							cursor.at++;
+						cursor.at++;
+					}
+				}
+				skip_space(&cursor);
+				bool required = false;
+				if (*cursor.at == '#') {
+					cursor.at++;
+					char *const default_kind = read_name(&cursor);
+					required = strcmp(default_kind, "REQUIRED") == 0;
+					const bool fixed = strcmp(default_kind, "FIXED") == 0;
+					free(default_kind);
+					skip_space(&cursor);
+					if (!fixed)
+						goto added;
+				}
+				const char quote = *cursor.at;
+				cursor.at++;
+				while (cursor.at < cursor.end && *cursor.at != quote)
+					cursor.at++;
+				cursor.at++;
+			added:
+				add_attribute(element, name, KIND_STRING, required);
+				free(name);
+			}
+		}
+		skip_declaration(&cursor);
+	}
+
+	// Children that hold nothing but text become values of their
+	// parent, rather than structs of their own.
+	for (size_t i = 0; i < declared_count; i++) {
+		const struct model *const model = &declared[i].model;
+		struct element *const element = &spec->elements[i];
+		for (size_t n = 0; n < model->name_count; n++) {
+			const ssize_t child = find_element(spec, model->names[n]);
+			if (child < 0)
+				die("%s: %s has an undeclared child %s", spec->path, element->name, model->names[n]);
+
+			enum occurs occurs = OCCURS_ONE;
+			if (declared[i].counts.max[n] > 1)
+				occurs = OCCURS_REPEATED;
+			else if (declared[i].counts.min[n] == 0)
+				occurs = OCCURS_OPTIONAL;
+			// names in mixed content can come in any number
+			if (model->pcdata)
+				occurs = OCCURS_REPEATED;
+
+			const struct element *const target = &spec->elements[child];
+			const bool value = target->text == KIND_STRING
+				&& target->attribute_count == 0
+				&& declared[child].model.name_count == 0;
+			add_member(element, model->names[n], value, KIND_STRING, occurs);
+		}
+	}
+
+	for (size_t i = 0; i < declared_count; i++) {
+		for (size_t n = 0; n < declared[i].model.name_count; n++)
+			free(declared[i].model.names[n]);
+		free(declared[i].model.names);
+		free(declared[i].counts.min);
+		free(declared[i].counts.max);
+	}
+	free(declared);
+}
+
+static void mark_used(struct spec *spec, size_t index)
+{
+	struct element *const element = &spec->elements[index];
+	if (element->used)
+		return;
+	element->used = true;
+	for (size_t m = 0; m < element->member_count; m++)
+		if (!element->members[m].value)
+			mark_used(spec, element->members[m].element);
+}
+
+static void resolve(struct spec *spec)
+{
+	if (spec->element_count == 0)
+		die("%s: no elements declared", spec->path);
+	if (!spec->root)
+		spec->root = copy(spec->elements[0].name, strlen(spec->elements[0].name));
+	if (find_element(spec, spec->root) < 0)
+		die("%s: the root element %s isn't declared", spec->path, spec->root);
+
+	for (size_t e = 0; e < spec->element_count; e++) {
+		struct element *const element = &spec->elements[e];
+		if (element->attribute_count > 64 || element->member_count > 64)
+			die("%s: %s has more than 64 attributes or children", spec->path, element->name);
+
+		for (size_t m = 0; m < element->member_count; m++) {
+			struct member *const member = &element->members[m];
+			if (!member->value) {
+				const ssize_t child = find_element(spec, member->name);
+				if (child < 0)
+					die("%s: %s has an undeclared child %s", spec->path, element->name, member->name);
+				member->element = (size_t)child;
+			}
+		}
+
+		// every member needs its own name in the struct
+		const size_t count = element->attribute_count + element->member_count;
+		for (size_t i = 0; i < count; i++) {
+			const char *const left = i < element->attribute_count
+				? element->attributes[i].ident
+				: element->members[i - element->attribute_count].ident;
+			for (size_t j = i + 1; j < count; j++) {
+				const char *const right = j < element->attribute_count
+					? element->attributes[j].ident
+					: element->members[j - element->attribute_count].ident;
+				if (strcmp(left, right) == 0)
+					die("%s: %s has two members called %s", spec->path, element->name, left);
+			}
+		}
+	}
+
+	mark_used(spec, (size_t)find_element(spec, spec->root));
+}
+
+// Code generation
+
+static const char *c_type(enum kind kind)
+{
+	switch (kind) {
+		case KIND_STRING: return "struct libadt_const_lptr";
+		case KIND_INT: return "int64_t";
+		case KIND_UINT: return "uint64_t";
+		case KIND_DOUBLE: return "double";
+		case KIND_BOOL: return "bool";
+		case KIND_NONE: break;
+	}
+	return "void";
+}
+
+static const char *kind_name(enum kind kind)
+{
+	switch (kind) {
+		case KIND_STRING: return "string";
+		case KIND_INT: return "int";
+		case KIND_UINT: return "uint";
+		case KIND_DOUBLE: return "double";
+		case KIND_BOOL: return "bool";
+		case KIND_NONE: break;
+	}
+	return "none";
+}
+
+static void emit_header(FILE *out, const struct spec *spec, const char *guard)
+{
+	const char *const p = spec->prefix;
+	const struct element *const root = &spec->elements[find_element(spec, spec->root)];
+
+	fprintf(out,
+		"// Generated by descent-xml-gen from %s. Do not edit.\n"
+		"\n"
+		"#ifndef %s\n"
+		"#define %s\n"
+		"\n"
+		"#ifdef __cplusplus\n"
+		"extern \"C\" {\n"
+		"#endif\n"
+		"\n"
+		"#include <stdbool.h>\n"
+		"#include <stddef.h>\n"
+		"#include <stdint.h>\n"
+		"\n"
+		"#include <libadt/lptr.h>\n"
+		"\n",
+		spec->path, guard, guard
+	);
+
+	for (size_t e = 0; e < spec->element_count; e++)
+		if (spec->elements[e].used)
+			fprintf(out, "struct %s_%s;\n", p, spec->elements[e].ident);
+	fputc('\n', out);
+
+	for (size_t e = 0; e < spec->element_count; e++) {
+		const struct element *const element = &spec->elements[e];
+		if (!element->used)
+			continue;
+		fprintf(out, "// <%s>\nstruct %s_%s {\n", element->name, p, element->ident);
+		for (size_t a = 0; a < element->attribute_count; a++) {
+			const struct attribute *const attribute = &element->attributes[a];
+			fprintf(out, "\t%s %s;\n", c_type(attribute->kind), attribute->ident);
+			if (!attribute->required && attribute->kind != KIND_STRING)
+				fprintf(out, "\tbool has_%s;\n", attribute->ident);
+		}
+		for (size_t m = 0; m < element->member_count; m++) {
+			const struct member *const member = &element->members[m];
+			char type[256];
+			if (member->value)
+				snprintf(type, sizeof(type), "%s", c_type(member->kind));
+			else
+				snprintf(type, sizeof(type), "struct %s_%s", p, spec->elements[member->element].ident);
+
+			if (member->occurs == OCCURS_REPEATED) {
+				fprintf(out, "\t%s *%s;\n", type, member->ident);
+				fprintf(out, "\tsize_t %s_count;\n", member->ident);
+			} else if (!member->value) {
+				fprintf(out, "\t%s *%s;\n", type, member->ident);
+			} else {
+				fprintf(out, "\t%s %s;\n", type, member->ident);
+				if (member->occurs == OCCURS_OPTIONAL && member->kind != KIND_STRING)
+					fprintf(out, "\tbool has_%s;\n", member->ident);
+			}
+		}
+		if (element->text != KIND_NONE)
+			fprintf(out, "\t%s text;\n", c_type(element->text));
+		fprintf(out, "};\n\n");
+	}
+
+	fprintf(out,
+		"/**\n"
+		" * \\brief Parses a <%s> document into result.\n"
+		" *\n"
+		" * Strings point into document, which has to outlive result, and\n"
+		" * are not entity-decoded. Unknown elements and attributes are\n"
+		" * skipped.\n"
+		" *\n"
+		" * \\returns True on success. On failure, result is left empty.\n"
+		" */\n"
+		"bool %s_parse(struct libadt_const_lptr document, struct %s_%s *result);\n"
+		"\n"
+		"/**\n"
+		" * \\brief Releases the memory held by a parsed document.\n"
+		" */\n"
+		"void %s_free(struct %s_%s *value);\n"
+		"\n"
+		"#ifdef __cplusplus\n"
+		"} // extern \"C\"\n"
+		"#endif\n"
+		"\n"
+		"#endif // %s\n",
+		root->name,
+		p, p, root->ident,
+		p, p, root->ident,
+		guard
+	);
+}
+
+// Emits a switch mapping a name to its index in names, on its length
+// and then its first byte, so most lookups do one memcmp() at most.
+static void emit_dispatch(
+	FILE *out,
+	const char *function,
+	char *const *names,
+	size_t count
+)
+{
+	fprintf(out,
+		"static int %s(struct libadt_const_lptr name)\n"
+		"{\n"
+		"\tconst char *const s = name.buffer;\n"
+		"\tswitch (name.length) {\n",
+		function
+	);
+
+	bool *const done = calloc(count + 1, sizeof(bool));
+	if (!done)
+		die("out of memory");
+	for (size_t i = 0; i < count; i++) {
+		if (done[i])
+			continue;
+		const size_t length = strlen(names[i]);
+		fprintf(out, "\t\tcase %zu:\n\t\t\tswitch (s[0]) {\n", length);
+
+		bool *const first_done = calloc(count + 1, sizeof(bool));
+		if (!first_done)
+			die("out of memory");
+		for (size_t j = i; j < count; j++) {
+			if (done[j] || strlen(names[j]) != length || first_done[j])
+				continue;
+			const char first = names[j][0];
+			if (isalnum((unsigned char)first) || first == '_')
+				fprintf(out, "\t\t\t\tcase '%c':\n", first);
+			else
+				fprintf(out, "\t\t\t\tcase (char)0x%02x:\n", (unsigned char)first);
+			for (size_t k = j; k < count; k++) {
+				if (done[k] || strlen(names[k]) != length || names[k][0] != first)
+					continue;
+				fprintf(out,
+					"\t\t\t\t\tif (memcmp(s + 1, \"%s\", %zu) == 0)\n"
+					"\t\t\t\t\t\treturn %zu;\n",
+					names[k] + 1,
+					length - 1,
+					k
+				);
+				first_done[k] = true;
+				done[k] = true;
+			}
+			fprintf(out, "\t\t\t\t\tbreak;\n");
+		}
+		free(first_done);
+		fprintf(out, "\t\t\t}\n\t\t\tbreak;\n");
+	}
+	free(done);
+
+	fprintf(out, "\t}\n\treturn -1;\n}\n\n");
+}
+
+static const char runtime[] =
+	"struct P__context {\n"
+	"\tvoid *value;\n"
+	"\tuint64_t seen;\n"
+	"\tstruct libadt_const_lptr text;\n"
+	"\tbool has_text;\n"
+	"\tbool error;\n"
+	"};\n"
+	"\n"
+	"static inline bool P__end(struct descent_xml_lex token)\n"
+	"{\n"
+	"\treturn token.type == descent_xml_classifier_eof\n"
+	"\t\t|| token.type == descent_xml_classifier_unexpected;\n"
+	"}\n"
+	"\n"
+	"static inline bool P__is_space(struct libadt_const_lptr text)\n"
+	"{\n"
+	"\tconst char *const s = text.buffer;\n"
+	"\tfor (ssize_t i = 0; i < text.length; i++)\n"
+	"\t\tif (s[i] != ' ' && s[i] != '\\t' && s[i] != '\\r' && s[i] != '\\n')\n"
+	"\t\t\treturn false;\n"
+	"\treturn true;\n"
+	"}\n"
+	"\n"
+	"static inline struct libadt_const_lptr P__trim(struct libadt_const_lptr text)\n"
+	"{\n"
+	"\tconst char *s = text.buffer;\n"
+	"\twhile (text.length > 0 && (*s == ' ' || *s == '\\t' || *s == '\\r' || *s == '\\n')) {\n"
+	"\t\ts++;\n"
+	"\t\ttext.length--;\n"
+	"\t}\n"
+	"\twhile (text.length > 0) {\n"
+	"\t\tconst char c = s[text.length - 1];\n"
+	"\t\tif (c != ' ' && c != '\\t' && c != '\\r' && c != '\\n')\n"
+	"\t\t\tbreak;\n"
+	"\t\ttext.length--;\n"
+	"\t}\n"
+	"\ttext.buffer = s;\n"
+	"\treturn text;\n"
+	"}\n"
+	"\n"
+	"static inline bool P__string(struct libadt_const_lptr text, struct libadt_const_lptr *out)\n"
+	"{\n"
+	"\t*out = text;\n"
+	"\treturn true;\n"
+	"}\n"
+	"\n"
+	"static inline bool P__uint(struct libadt_const_lptr text, uint64_t *out)\n"
+	"{\n"
+	"\ttext = P__trim(text);\n"
+	"\tconst char *const s = text.buffer;\n"
+	"\tssize_t i = text.length > 0 && s[0] == '+';\n"
+	"\tif (i == text.length)\n"
+	"\t\treturn false;\n"
+	"\tuint64_t value = 0;\n"
+	"\tfor (; i < text.length; i++) {\n"
+	"\t\tconst unsigned digit = (unsigned)(s[i] - '0');\n"
+	"\t\tif (digit > 9 || value > (UINT64_MAX - digit) / 10)\n"
+	"\t\t\treturn false;\n"
+	"\t\tvalue = value * 10 + digit;\n"
+	"\t}\n"
+	"\t*out = value;\n"
+	"\treturn true;\n"
+	"}\n"
+	"\n"
+	"static inline bool P__int(struct libadt_const_lptr text, int64_t *out)\n"
+	"{\n"
+	"\ttext = P__trim(text);\n"
+	"\tconst bool negative = text.length > 0 && *(const char *)text.buffer == '-';\n"
+	"\tif (negative) {\n"
+	"\t\ttext.buffer = (const char *)text.buffer + 1;\n"
+	"\t\ttext.length--;\n"
+	"\t\tif (text.length > 0 && *(const char *)text.buffer == '+')\n"
+	"\t\t\treturn false;\n"
+	"\t}\n"
+	"\tuint64_t magnitude;\n"
+	"\tif (!P__uint(text, &magnitude))\n"
+	"\t\treturn false;\n"
+	"\tif (magnitude > (uint64_t)INT64_MAX + negative)\n"
+	"\t\treturn false;\n"
+	"\t*out = negative ? (int64_t)(0 - magnitude) : (int64_t)magnitude;\n"
+	"\treturn true;\n"
+	"}\n"
+	"\n"
+	"static inline bool P__double(struct libadt_const_lptr text, double *out)\n"
+	"{\n"
+	"\tchar buffer[64];\n"
+	"\ttext = P__trim(text);\n"
+	"\tif (text.length <= 0 || (size_t)text.length >= sizeof(buffer))\n"
+	"\t\treturn false;\n"
+	"\tmemcpy(buffer, text.buffer, (size_t)text.length);\n"
+	"\tbuffer[text.length] = '\\0';\n"
+	"\tchar *end;\n"
+	"\t*out = strtod(buffer, &end);\n"
+	"\treturn *end == '\\0';\n"
+	"}\n"
+	"\n"
+	"static inline bool P__bool(struct libadt_const_lptr text, bool *out)\n"
+	"{\n"
+	"\ttext = P__trim(text);\n"
+	"\tconst char *const s = text.buffer;\n"
+	"\tif ((text.length == 4 && memcmp(s, \"true\", 4) == 0) || (text.length == 1 && s[0] == '1'))\n"
+	"\t\t*out = true;\n"
+	"\telse if ((text.length == 5 && memcmp(s, \"false\", 5) == 0) || (text.length == 1 && s[0] == '0'))\n"
+	"\t\t*out = false;\n"
+	"\telse\n"
+	"\t\treturn false;\n"
+	"\treturn true;\n"
+	"}\n"
+	"\n"
+	"// grows at powers of two, so the count is all we need to keep\n"
+	"static inline void *P__append(void *array, size_t *count, size_t size)\n"
+	"{\n"
+	"\tif (*count && (*count & (*count - 1)) == 0) {\n"
+	"\t\tvoid *const grown = realloc(array, *count * 2 * size);\n"
+	"\t\tif (!grown)\n"
+	"\t\t\treturn NULL;\n"
+	"\t\tarray = grown;\n"
+	"\t} else if (!*count) {\n"
+	"\t\tarray = malloc(size);\n"
+	"\t\tif (!array)\n"
+	"\t\t\treturn NULL;\n"
+	"\t}\n"
+	"\tmemset((char *)array + *count * size, 0, size);\n"
+	"\t++*count;\n"
+	"\treturn array;\n"
+	"}\n"
+	"\n"
+	"// Text split up by comments or CDATA sections can't be pointed\n"
+	"// at as one string, so only whitespace may surround the piece\n"
+	"// that's kept.\n"
+	"static inline void P__text(struct libadt_const_lptr text, bool is_cdata, void *context_p)\n"
+	"{\n"
+	"\tstruct P__context *const context = context_p;\n"
+	"\tif (!context->has_text || (!is_cdata && P__is_space(context->text))) {\n"
+	"\t\tcontext->text = text;\n"
+	"\t\tcontext->has_text = true;\n"
+	"\t} else if (is_cdata || !P__is_space(text)) {\n"
+	"\t\tcontext->error = true;\n"
+	"\t}\n"
+	"}\n"
+	"\n"
+	"// Parses the content of an element until its closing tag, and past\n"
+	"// it.\n"
+	"static struct descent_xml_lex P__content(\n"
+	"\tstruct descent_xml_lex token,\n"
+	"\tstruct libadt_const_lptr name,\n"
+	"\tdescent_xml_parse_element_fn *element_handler,\n"
+	"\tdescent_xml_parse_text_fn *text_handler,\n"
+	"\tstruct P__context *context\n"
+	")\n"
+	"{\n"
+	"\twhile (token.type != descent_xml_classifier_element_close_name) {\n"
+	"\t\tif (context->error || P__end(token)) {\n"
+	"\t\t\tcontext->error = true;\n"
+	"\t\t\treturn token;\n"
+	"\t\t}\n"
+	"\t\ttoken = descent_xml_parse(token, element_handler, text_handler, context);\n"
+	"\t}\n"
+	"\tif (!libadt_const_lptr_equal(token.value, name))\n"
+	"\t\tcontext->error = true;\n"
+	"\treturn descent_xml_parse(token, NULL, NULL, NULL);\n"
+	"}\n"
+	"\n"
+	"static struct descent_xml_lex P__skip(\n"
+	"\tstruct descent_xml_lex token,\n"
+	"\tstruct libadt_const_lptr name,\n"
+	"\tstruct libadt_const_lptr attributes,\n"
+	"\tbool empty,\n"
+	"\tvoid *context_p\n"
+	")\n"
+	"{\n"
+	"\t(void)attributes;\n"
+	"\tstruct P__context *const parent = context_p;\n"
+	"\tif (empty)\n"
+	"\t\treturn token;\n"
+	"\tstruct P__context context = { 0 };\n"
+	"\ttoken = P__content(token, name, P__skip, NULL, &context);\n"
+	"\tparent->error |= context.error;\n"
+	"\treturn token;\n"
+	"}\n"
+	"\n"
+	"// Reads the text of an element that holds nothing else.\n"
+	"static inline struct descent_xml_lex P__value(\n"
+	"\tstruct descent_xml_lex token,\n"
+	"\tstruct libadt_const_lptr name,\n"
+	"\tbool empty,\n"
+	"\tstruct P__context *parent,\n"
+	"\tstruct libadt_const_lptr *text\n"
+	")\n"
+	"{\n"
+	"\t*text = (struct libadt_const_lptr) { .buffer = \"\", .size = 1, .length = 0 };\n"
+	"\tif (empty)\n"
+	"\t\treturn token;\n"
+	"\tstruct P__context context = { 0 };\n"
+	"\ttoken = P__content(token, name, P__skip, P__text, &context);\n"
+	"\tparent->error |= context.error;\n"
+	"\tif (context.has_text)\n"
+	"\t\t*text = context.text;\n"
+	"\treturn token;\n"
+	"}\n"
+	"\n";
+
+static void emit_runtime(FILE *out, const char *prefix)
+{
+	for (const char *at = runtime; *at; at++) {
+		if (at[0] == 'P' && at[1] == '_' && at[2] == '_') {
+			fputs(prefix, out);
+			continue;
+		}
+		fputc(*at, out);
+	}
+}
+
+static void emit_free(FILE *out, const struct spec *spec, const struct element *element)
+{
+	const char *const p = spec->prefix;
+	fprintf(out,
+		"static void %s__%s_free(struct %s_%s *value)\n{\n",
+		p, element->ident, p, element->ident
+	);
+	for (size_t m = 0; m < element->member_count; m++) {
+		const struct member *const member = &element->members[m];
+		const char *const child = member->value ? NULL : spec->elements[member->element].ident;
+		if (member->occurs == OCCURS_REPEATED) {
+			if (child)
+				fprintf(out,
+					"\tfor (size_t i = 0; i < value->%s_count; i++)\n"
+					"\t\t%s__%s_free(&value->%s[i]);\n",
+					member->ident, p, child, member->ident
+				);
+			fprintf(out, "\tfree(value->%s);\n", member->ident);
+		} else if (child) {
+			fprintf(out,
+				"\tif (value->%s)\n"
+				"\t\t%s__%s_free(value->%s);\n"
+				"\tfree(value->%s);\n",
+				member->ident, p, child, member->ident, member->ident
+			);
+		}
+	}
+	fprintf(out, "\t*value = (struct %s_%s) { 0 };\n}\n\n", p, element->ident);
+}
+
+static void emit_attributes(FILE *out, const struct spec *spec, const struct element *element)
+{
+	const char *const p = spec->prefix;
+	char function[512];
+	uint64_t required = 0;
+
+	if (element->attribute_count) {
+		char **const names = malloc(element->attribute_count * sizeof(char *));
+		if (!names)
+			die("out of memory");
+		for (size_t a = 0; a < element->attribute_count; a++) {
+			names[a] = element->attributes[a].name;
+			if (element->attributes[a].required)
+				required |= 1ull << a;
+		}
+		snprintf(function, sizeof(function), "%s__%s_attribute", p, element->ident);
+		emit_dispatch(out, function, names, element->attribute_count);
+		free(names);
+	}
+
+	fprintf(out,
+		"static bool %s__%s_attributes(struct %s_%s *value, struct libadt_const_lptr attributes)\n"
+		"{\n",
+		p, element->ident, p, element->ident
+	);
+	if (!element->attribute_count) {
+		fprintf(out, "\t(void)value;\n\t(void)attributes;\n\treturn true;\n}\n\n");
+		return;
+	}
+	fprintf(out,
+		"\tconst struct libadt_const_lptr *const pairs = attributes.buffer;\n"
+		"%s"
+		"\tfor (ssize_t i = 0; i + 1 < attributes.length; i += 2) {\n"
+		"\t\tconst int index = %s__%s_attribute(pairs[i]);\n"
+		"\t\tswitch (index) {\n",
+		required ? "\tuint64_t seen = 0;\n" : "",
+		p, element->ident
+	);
+	for (size_t a = 0; a < element->attribute_count; a++) {
+		const struct attribute *const attribute = &element->attributes[a];
+		fprintf(out,
+			"\t\t\tcase %zu:\n"
+			"\t\t\t\tif (!%s__%s(pairs[i + 1], &value->%s))\n"
+			"\t\t\t\t\treturn false;\n",
+			a, p, kind_name(attribute->kind), attribute->ident
+		);
+		if (!attribute->required && attribute->kind != KIND_STRING)
+			fprintf(out, "\t\t\t\tvalue->has_%s = true;\n", attribute->ident);
+		fprintf(out, "\t\t\t\tbreak;\n");
+	}
+	fprintf(out,
+		"\t\t\tdefault:\n"
+		"\t\t\t\tcontinue;\n"
+		"\t\t}\n"
+		"%s"
+		"\t}\n",
+		required ? "\t\tseen |= 1ull << index;\n" : ""
+	);
+	if (required)
+		fprintf(out,
+			"\treturn (seen & 0x%llxull) == 0x%llxull;\n}\n\n",
+			(unsigned long long)required,
+			(unsigned long long)required
+		);
+	else
+		fprintf(out, "\treturn true;\n}\n\n");
+}
+
+static void emit_element(FILE *out, const struct spec *spec, const struct element *element)
+{
+	const char *const p = spec->prefix;
+	const char *const e = element->ident;
+
+	uint64_t required = 0, once = 0;
+	for (size_t m = 0; m < element->member_count; m++) {
+		if (element->members[m].occurs == OCCURS_ONE)
+			required |= 1ull << m;
+		if (element->members[m].occurs != OCCURS_REPEATED)
+			once |= 1ull << m;
+	}
+
+	if (element->member_count) {
+		char **const names = malloc(element->member_count * sizeof(char *));
+		if (!names)
+			die("out of memory");
+		for (size_t m = 0; m < element->member_count; m++)
+			names[m] = element->members[m].name;
+		char function[512];
+		snprintf(function, sizeof(function), "%s__%s_child", p, e);
+		emit_dispatch(out, function, names, element->member_count);
+		free(names);
+
+		fprintf(out,
+			"static struct descent_xml_lex %s__%s_element(\n"
+			"\tstruct descent_xml_lex token,\n"
+			"\tstruct libadt_const_lptr name,\n"
+			"\tstruct libadt_const_lptr attributes,\n"
+			"\tbool empty,\n"
+			"\tvoid *context_p\n"
+			")\n"
+			"{\n"
+			"\tstruct %s__context *const context = context_p;\n"
+			"\tstruct %s_%s *const value = context->value;\n"
+			"\tconst int index = %s__%s_child(name);\n"
+			"\tif (index < 0)\n"
+			"\t\treturn %s__skip(token, name, attributes, empty, context);\n"
+			"\n"
+			"\t// only repeated children can be seen twice\n"
+			"\tconst uint64_t bit = 1ull << index;\n"
+			"\tif (context->seen & bit & 0x%llxull) {\n"
+			"\t\tcontext->error = true;\n"
+			"\t\treturn token;\n"
+			"\t}\n"
+			"\tcontext->seen |= bit;\n"
+			"\n",
+			p, e, p, p, e, p, e, p,
+			(unsigned long long)once
+		);
+		for (size_t m = 0; m < element->member_count; m++) {
+			if (element->members[m].value) {
+				fprintf(out, "\tstruct libadt_const_lptr text;\n");
+				break;
+			}
+		}
+		fprintf(out, "\tswitch (index) {\n");
+	}
+
+	for (size_t m = 0; m < element->member_count; m++) {
+		const struct member *const member = &element->members[m];
+		fprintf(out, "\t\tcase %zu: {\n", m);
+		if (member->value) {
+			fprintf(out, "\t\t\ttoken = %s__value(token, name, empty, context, &text);\n", p);
+			if (member->occurs == OCCURS_REPEATED) {
+				fprintf(out,
+					"\t\t\t%s *const array = %s__append(value->%s, &value->%s_count, sizeof(*value->%s));\n"
+					"\t\t\tif (!array) {\n"
+					"\t\t\t\tcontext->error = true;\n"
+					"\t\t\t\treturn token;\n"
+					"\t\t\t}\n"
+					"\t\t\tvalue->%s = array;\n"
+					"\t\t\tif (!%s__%s(text, &array[value->%s_count - 1]))\n"
+					"\t\t\t\tcontext->error = true;\n",
+					c_type(member->kind), p, member->ident, member->ident, member->ident,
+					member->ident,
+					p, kind_name(member->kind), member->ident
+				);
+			} else {
+				fprintf(out,
+					"\t\t\tif (!%s__%s(text, &value->%s))\n"
+					"\t\t\t\tcontext->error = true;\n",
+					p, kind_name(member->kind), member->ident
+				);
+				if (member->occurs == OCCURS_OPTIONAL && member->kind != KIND_STRING)
+					fprintf(out, "\t\t\tvalue->has_%s = true;\n", member->ident);
+			}
+			fprintf(out, "\t\t\treturn token;\n\t\t}\n");
+			continue;
+		}
+
+		const char *const child = spec->elements[member->element].ident;
+		if (member->occurs == OCCURS_REPEATED) {
+			fprintf(out,
+				"\t\t\tstruct %s_%s *const array = %s__append(value->%s, &value->%s_count, sizeof(*value->%s));\n"
+				"\t\t\tif (!array) {\n"
+				"\t\t\t\tcontext->error = true;\n"
+				"\t\t\t\treturn token;\n"
+				"\t\t\t}\n"
+				"\t\t\tvalue->%s = array;\n"
+				"\t\t\treturn %s__%s_parse(token, name, attributes, empty, context, &array[value->%s_count - 1]);\n"
+				"\t\t}\n",
+				p, child, p, member->ident, member->ident, member->ident,
+				member->ident,
+				p, child, member->ident
+			);
+		} else {
+			fprintf(out,
+				"\t\t\tvalue->%s = calloc(1, sizeof(*value->%s));\n"
+				"\t\t\tif (!value->%s) {\n"
+				"\t\t\t\tcontext->error = true;\n"
+				"\t\t\t\treturn token;\n"
+				"\t\t\t}\n"
+				"\t\t\treturn %s__%s_parse(token, name, attributes, empty, context, value->%s);\n"
+				"\t\t}\n",
+				member->ident, member->ident,
+				member->ident,
+				p, child, member->ident
+			);
+		}
+	}
+	if (element->member_count)
+		fprintf(out, "\t}\n\treturn token;\n}\n\n");
+
+	char element_handler[512], text_handler[512];
+	if (element->member_count)
+		snprintf(element_handler, sizeof(element_handler), "%s__%s_element", p, e);
+	else
+		snprintf(element_handler, sizeof(element_handler), "%s__skip", p);
+	if (element->text != KIND_NONE)
+		snprintf(text_handler, sizeof(text_handler), "%s__text", p);
+	else
+		snprintf(text_handler, sizeof(text_handler), "NULL");
+
+	fprintf(out,
+		"static struct descent_xml_lex %s__%s_parse(\n"
+		"\tstruct descent_xml_lex token,\n"
+		"\tstruct libadt_const_lptr name,\n"
+		"\tstruct libadt_const_lptr attributes,\n"
+		"\tbool empty,\n"
+		"\tstruct %s__context *parent,\n"
+		"\tstruct %s_%s *value\n"
+		")\n"
+		"{\n"
+		"\tif (!%s__%s_attributes(value, attributes)) {\n"
+		"\t\tparent->error = true;\n"
+		"\t\treturn token;\n"
+		"\t}\n"
+		"\n"
+		"\tstruct %s__context context = { .value = value };\n"
+		"\tif (!empty)\n"
+		"\t\ttoken = %s__content(token, name, %s, %s, &context);\n",
+		p, e, p, p, e, p, e, p, p, element_handler, text_handler
+	);
+	if (element->text != KIND_NONE) {
+		fprintf(out,
+			"\tif (!context.has_text)\n"
+			"\t\tcontext.text = (struct libadt_const_lptr) { .buffer = \"\", .size = 1, .length = 0 };\n"
+			"\tif (!context.error && !%s__%s(context.text, &value->text))\n"
+			"\t\tcontext.error = true;\n",
+			p, kind_name(element->text)
+		);
+	}
+	if (required)
+		fprintf(out,
+			"\tif ((context.seen & 0x%llxull) != 0x%llxull)\n"
+			"\t\tcontext.error = true;\n",
+			(unsigned long long)required,
+			(unsigned long long)required
+		);
+	fprintf(out,
+		"\tparent->error |= context.error;\n"
+		"\treturn token;\n"
+		"}\n\n"
+	);
+}
+
+static void emit_source(FILE *out, const struct spec *spec, const char *header)
+{
+	const char *const p = spec->prefix;
+	const struct element *const root = &spec->elements[find_element(spec, spec->root)];
+
+	fprintf(out,
+		"// Generated by descent-xml-gen from %s. Do not edit.\n"
+		"\n"
+		"#include \"%s\"\n"
+		"\n"
+		"#include <stdlib.h>\n"
+		"#include <string.h>\n"
+		"\n"
+		"#include <descent-xml/parse.h>\n"
+		"\n",
+		spec->path, header
+	);
+	emit_runtime(out, p);
+
+	for (size_t e = 0; e < spec->element_count; e++) {
+		const struct element *const element = &spec->elements[e];
+		if (!element->used)
+			continue;
+		fprintf(out,
+			"static struct descent_xml_lex %s__%s_parse(\n"
+			"\tstruct descent_xml_lex token,\n"
+			"\tstruct libadt_const_lptr name,\n"
+			"\tstruct libadt_const_lptr attributes,\n"
+			"\tbool empty,\n"
+			"\tstruct %s__context *parent,\n"
+			"\tstruct %s_%s *value\n"
+			");\n"
+			"static void %s__%s_free(struct %s_%s *value);\n",
+			p, element->ident, p, p, element->ident,
+			p, element->ident, p, element->ident
+		);
+	}
+	fputc('\n', out);
+
+	for (size_t e = 0; e < spec->element_count; e++) {
+		if (!spec->elements[e].used)
+			continue;
+		emit_free(out, spec, &spec->elements[e]);
+		emit_attributes(out, spec, &spec->elements[e]);
+		emit_element(out, spec, &spec->elements[e]);
+	}
+
+	const size_t root_length = strlen(root->name);
+	fprintf(out,
+		"static struct descent_xml_lex %s__root(\n"
+		"\tstruct descent_xml_lex token,\n"
+		"\tstruct libadt_const_lptr name,\n"
+		"\tstruct libadt_const_lptr attributes,\n"
+		"\tbool empty,\n"
+		"\tvoid *context_p\n"
+		")\n"
+		"{\n"
+		"\tstruct %s__context *const context = context_p;\n"
+		"\tconst bool root = name.length == %zu && memcmp(name.buffer, \"%s\", %zu) == 0;\n"
+		"\tif (!root || context->seen) {\n"
+		"\t\tcontext->error = true;\n"
+		"\t\treturn token;\n"
+		"\t}\n"
+		"\tcontext->seen = 1;\n"
+		"\treturn %s__%s_parse(token, name, attributes, empty, context, context->value);\n"
+		"}\n"
+		"\n"
+		"bool %s_parse(struct libadt_const_lptr document, struct %s_%s *result)\n"
+		"{\n"
+		"\t*result = (struct %s_%s) { 0 };\n"
+		"\tstruct %s__context context = { .value = result };\n"
+		"\tstruct descent_xml_lex token = descent_xml_lex_init(document);\n"
+		"\twhile (token.type != descent_xml_classifier_eof) {\n"
+		"\t\tif (context.error || token.type == descent_xml_classifier_unexpected) {\n"
+		"\t\t\t%s__%s_free(result);\n"
+		"\t\t\treturn false;\n"
+		"\t\t}\n"
+		"\t\ttoken = descent_xml_parse(token, %s__root, NULL, &context);\n"
+		"\t}\n"
+		"\tif (!context.seen || context.error) {\n"
+		"\t\t%s__%s_free(result);\n"
+		"\t\treturn false;\n"
+		"\t}\n"
+		"\treturn true;\n"
+		"}\n"
+		"\n"
+		"void %s_free(struct %s_%s *value)\n"
+		"{\n"
+		"\t%s__%s_free(value);\n"
+		"}\n",
+		p,
+		p,
+		root_length, root->name, root_length,
+		p, root->ident,
+		p, p, root->ident,
+		p, root->ident,
+		p,
+		p, root->ident,
+		p,
+		p, root->ident,
+		p, p, root->ident,
+		p, root->ident
+	);
+}
+
+static FILE *create(const char *directory, const char *name, char **path)
+{
+	const size_t length = strlen(directory) + strlen(name) + 2;
+	*path = malloc(length);
+	if (!*path)
+		die("out of memory");
+	snprintf(*path, length, "%s/%s", directory, name);
+	FILE *const file = fopen(*path, "w");
+	if (!file)
+		die("can't create %s", *path);
+	return file;
+}
+
+static void finish(FILE *file, const char *path)
+{
+	if (ferror(file) | fclose(file)) {
+		remove(path);
+		die("can't write %s", path);
+	}
+}
+
+static void free_spec(struct spec *spec)
+{
+	for (size_t e = 0; e < spec->element_count; e++) {
+		struct element *const element = &spec->elements[e];
+		for (size_t a = 0; a < element->attribute_count; a++) {
+			free(element->attributes[a].name);
+			free(element->attributes[a].ident);
+		}
+		for (size_t m = 0; m < element->member_count; m++) {
+			free(element->members[m].name);
+			free(element->members[m].ident);
+		}
+		free(element->attributes);
+		free(element->members);
+		free(element->name);
+		free(element->ident);
+	}
+	free(spec->elements);
+	free(spec->prefix);
+	free(spec->root);
+}
+
+static void usage(void)
+{
+	fprintf(stderr, "usage: %s [-p prefix] [-r root] [-o directory] input\n", program);
+	exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	struct spec spec = { 0 };
+	const char *directory = ".";
+	const char *input = NULL;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-p") == 0 && i + 1 < argc)
+			spec.prefix = copy(argv[i + 1], strlen(argv[i + 1])), i++;
+		else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+			spec.root = copy(argv[i + 1], strlen(argv[i + 1])), i++;
+		else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+			directory = argv[++i];
+		else if (argv[i][0] == '-' || input)
+			usage();
+		else
+			input = argv[i];
+	}
+	if (!input)
+		usage();
+	spec.path = input;
+
+	size_t length;
+	char *const text = read_file(input, &length);
+	const size_t input_length = strlen(input);
+	if (input_length > 4 && strcmp(input + input_length - 4, ".dtd") == 0)
+		parse_dtd(&spec, text, length);
+	else
+		parse_descriptor(&spec, text);
+	free(text);
+	resolve(&spec);
+
+	if (!spec.prefix) {
+		const char *base = strrchr(input, '/');
+		base = base ? base + 1 : input;
+		const char *const dot = strchr(base, '.');
+		spec.prefix = copy(base, dot ? (size_t)(dot - base) : strlen(base));
+	}
+	char *const prefix = identifier(spec.prefix);
+	free(spec.prefix);
+	spec.prefix = prefix;
+
+	const size_t name_length = strlen(prefix) + 3;
+	char *const header_name = malloc(name_length);
+	char *const source_name = malloc(name_length);
+	char *const guard = malloc(name_length);
+	if (!header_name || !source_name || !guard)
+		die("out of memory");
+	snprintf(header_name, name_length, "%s.h", prefix);
+	snprintf(source_name, name_length, "%s.c", prefix);
+	for (size_t i = 0; prefix[i]; i++)
+		guard[i] = (char)toupper((unsigned char)prefix[i]);
+	snprintf(guard + strlen(prefix), 3, "_H");
+
+	char *header_path, *source_path;
+	FILE *const header = create(directory, header_name, &header_path);
+	emit_header(header, &spec, guard);
+	finish(header, header_path);
+
+	FILE *const source = create(directory, source_name, &source_path);
+	emit_source(source, &spec, header_name);
+	finish(source, source_path);
+
+	free(header_path);
+	free(source_path);
+	free(header_name);
+	free(source_name);
+	free(guard);
+	free_spec(&spec);
+	return 0;
+}